@@ -0,0 +1,283 @@
+#ifndef REDSP_BENCHHARNESS_HEADERGUARD
+#define REDSP_BENCHHARNESS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../source/internal/simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define REDSP_BENCH_HAS_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define REDSP_BENCH_HAS_TSC 1
+#else
+#define REDSP_BENCH_HAS_TSC 0
+#endif
+
+#pragma once
+
+/**
+ * Timing for the benchmarks: warmup, calibration to a fixed time per repetition, and statistics over repetitions, in
+ * ns and in reference cycles (the timestamp counter, on x86 only) per sample. Results are collected into a report
+ * that prints as a table and serializes to JSON, so runs can be compared between releases (see compare_bench.h).
+ */
+struct BenchHarness
+{
+    struct Settings
+    {
+        int repetitions = 15;
+        double msPerRepetition = 2.0;
+        double warmupMs = 20.0;
+        juce::String filter;
+    };
+
+    //! per sample, over the repetitions
+    struct Measurement
+    {
+        double nsMedian = 0, nsMin = 0, nsMean = 0, nsStdDev = 0, cyclesMedian = 0;
+        int repetitions = 0;
+        std::int64_t callsPerRepetition = 0;
+    };
+
+    struct Result
+    {
+        juce::String name, type;
+        int block = 0, channels = 0;
+        Measurement measurement;
+    };
+
+    static std::uint64_t cycles()
+    {
+#if REDSP_BENCH_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    //! keeps the compiler from optimizing away a result nobody reads
+    template <typename T>
+    static void keep(T const& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile T sink;
+        sink = value;
+#endif
+    }
+
+    /**
+     * Times `@param f`, which processes `@param samplesPerCall` samples each call: runs it for the warmup time,
+     * calibrates how many calls make up a repetition, then times the repetitions.
+     */
+    template <typename F>
+    static Measurement measure(F&& f, double samplesPerCall, Settings const& settings)
+    {
+        using clock = std::chrono::steady_clock;
+        auto const elapsedMs = [](clock::time_point since)
+        {
+            return std::chrono::duration<double, std::milli>(clock::now() - since).count();
+        };
+
+        // warm up (caches, branch predictors, clocks), counting calls to estimate the cost of one
+        std::int64_t warmupCalls = 0;
+        auto const warmupStart = clock::now();
+        do
+        {
+            f();
+            ++warmupCalls;
+        } while (elapsedMs(warmupStart) < settings.warmupMs);
+        auto const msPerCall = elapsedMs(warmupStart) / static_cast<double>(warmupCalls);
+        auto const calls = std::max<std::int64_t>(1, static_cast<std::int64_t>(settings.msPerRepetition / msPerCall));
+
+        std::vector<double> ns, cyc;
+        for (int rep = 0; rep < std::max(settings.repetitions, 1); ++rep)
+        {
+            auto const start = clock::now();
+            auto const startCycles = cycles();
+            for (std::int64_t i = 0; i < calls; ++i) { f(); }
+            auto const endCycles = cycles();
+            auto const end = clock::now();
+
+            auto const samples = static_cast<double>(calls) * samplesPerCall;
+            ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / samples);
+            cyc.push_back(static_cast<double>(endCycles - startCycles) / samples);
+        }
+
+        Measurement m;
+        m.repetitions = static_cast<int>(ns.size());
+        m.callsPerRepetition = calls;
+        m.nsMedian = median(ns);
+        m.cyclesMedian = median(cyc);
+        m.nsMin = *std::min_element(ns.begin(), ns.end());
+        for (auto v : ns) { m.nsMean += v; }
+        m.nsMean /= static_cast<double>(ns.size());
+        for (auto v : ns) { m.nsStdDev += (v - m.nsMean) * (v - m.nsMean); }
+        m.nsStdDev = ns.size() > 1 ? std::sqrt(m.nsStdDev / static_cast<double>(ns.size() - 1)) : 0.0;
+        return m;
+    }
+
+    static double median(std::vector<double> v)
+    {
+        std::sort(v.begin(), v.end());
+        auto const n = v.size();
+        return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+    }
+
+    //! whether `@param name` passes `@param filter`: one or more texts split by '|', any of which the name may contain
+    static bool matches(juce::String const& filter, juce::String const& name)
+    {
+        if (filter.isEmpty()) { return true; }
+        for (auto const& part : juce::StringArray::fromTokens(filter, "|", ""))
+        {
+            if (part.isNotEmpty() && name.containsIgnoreCase(part)) { return true; }
+        }
+        return false;
+    }
+
+    template <typename T>
+    static char const* typeName() { return std::is_same<T, float>::value ? "float" : "double"; }
+
+    /**
+     * Collects results, printing each as it comes in, and writes them out as JSON.
+     */
+    struct Report
+    {
+        Settings settings;
+        std::vector<Result> results;
+
+        explicit Report(Settings s) : settings(s)
+        {
+            std::printf("%s, %d repetitions of %.1fms%s\n", simdName(), settings.repetitions, settings.msPerRepetition,
+                        REDSP_BENCH_HAS_TSC ? "" : " (no cycle counter on this platform)");
+            std::printf("%-40s %6s %6s %8s | %9s %9s %8s %9s\n", "benchmark", "type", "block", "channels", "ns/sample",
+                        "min", "stddev", "cycles");
+        }
+
+        //! whether `@param name` passes the filter, i.e. is worth setting up
+        bool wants(juce::String const& name) const { return matches(settings.filter, name); }
+
+        /**
+         * Times `@param f` as benchmark `@param name`, if it passes the filter. `@param f` processes `@param block`
+         * samples on each of `@param channels` channels per call.
+         */
+        template <typename T, typename F>
+        void run(juce::String const& name, int block, int channels, F&& f)
+        {
+            if (! wants(name)) { return; }
+            Result r { name, typeName<T>(), block, channels,
+                       measure(f, static_cast<double>(block) * channels, settings) };
+            std::printf("%-40s %6s %6d %8d | %9.3f %9.3f %8.3f %9.2f\n", r.name.toRawUTF8(), r.type.toRawUTF8(),
+                        r.block, r.channels, r.measurement.nsMedian, r.measurement.nsMin, r.measurement.nsStdDev,
+                        r.measurement.cyclesMedian);
+            std::fflush(stdout);
+            results.push_back(r);
+        }
+
+        juce::var toVar() const
+        {
+            juce::Array<juce::var> list;
+            for (auto const& r : results)
+            {
+                auto* o = new juce::DynamicObject();
+                o->setProperty("key", key(r));
+                o->setProperty("name", r.name);
+                o->setProperty("type", r.type);
+                o->setProperty("block", r.block);
+                o->setProperty("channels", r.channels);
+                o->setProperty("ns_per_sample", r.measurement.nsMedian);
+                o->setProperty("ns_min", r.measurement.nsMin);
+                o->setProperty("ns_mean", r.measurement.nsMean);
+                o->setProperty("ns_stddev", r.measurement.nsStdDev);
+                o->setProperty("cycles_per_sample", r.measurement.cyclesMedian);
+                o->setProperty("repetitions", r.measurement.repetitions);
+                o->setProperty("calls_per_repetition", static_cast<juce::int64>(r.measurement.callsPerRepetition));
+                list.add(juce::var(o));
+            }
+
+            auto* root = new juce::DynamicObject();
+            root->setProperty("format", "redsp_bench/1");
+            root->setProperty("simd", simdName());
+            root->setProperty("compiler", compilerName());
+            root->setProperty("cpu", juce::SystemStats::getCpuModel());
+            root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+            root->setProperty("has_cycle_counter", REDSP_BENCH_HAS_TSC != 0);
+            root->setProperty("results", list);
+            return juce::var(root);
+        }
+
+        bool writeJson(juce::File const& file) const
+        {
+            return file.replaceWithText(juce::JSON::toString(toVar()));
+        }
+    };
+
+    /**
+     * Reads back the results a Report wrote to `@param file`, into `@param results`. False if the file can't be read
+     * or isn't a redsp_bench result file.
+     */
+    static bool readJson(juce::File const& file, std::vector<Result>& results)
+    {
+        auto const root = juce::JSON::parse(file);
+        if (root.getProperty("format", {}).toString() != "redsp_bench/1") { return false; }
+        auto const* list = root.getProperty("results", {}).getArray();
+        if (list == nullptr) { return false; }
+
+        results.clear();
+        for (auto const& o : *list)
+        {
+            Result r;
+            r.name = o.getProperty("name", {}).toString();
+            r.type = o.getProperty("type", {}).toString();
+            r.block = o.getProperty("block", 0);
+            r.channels = o.getProperty("channels", 0);
+            r.measurement.nsMedian = o.getProperty("ns_per_sample", 0.0);
+            r.measurement.nsMin = o.getProperty("ns_min", 0.0);
+            r.measurement.nsMean = o.getProperty("ns_mean", 0.0);
+            r.measurement.nsStdDev = o.getProperty("ns_stddev", 0.0);
+            r.measurement.cyclesMedian = o.getProperty("cycles_per_sample", 0.0);
+            r.measurement.repetitions = o.getProperty("repetitions", 0);
+            r.measurement.callsPerRepetition = static_cast<juce::int64>(o.getProperty("calls_per_repetition", 0));
+            results.push_back(r);
+        }
+        return true;
+    }
+
+    //! what identifies a benchmark between runs
+    static juce::String key(Result const& r)
+    {
+        return r.name + "/" + r.type + "/" + juce::String(r.block) + "/" + juce::String(r.channels);
+    }
+
+    static char const* simdName()
+    {
+#if REDSP_SIMD_SSE2
+        return "sse2";
+#elif REDSP_SIMD_NEON
+        return "neon";
+#else
+        return "scalar";
+#endif
+    }
+
+    static juce::String compilerName()
+    {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + juce::String(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+};
+
+#endif // REDSP_BENCHHARNESS_HEADERGUARD
@@ -0,0 +1,188 @@
+#ifndef REDSP_COMPAREBENCH_HEADERGUARD
+#define REDSP_COMPAREBENCH_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+#include "bench_harness.h"
+
+#pragma once
+
+/**
+ * Compares two sets of BenchHarness results, a baseline and a candidate, benchmark by benchmark, and calls a change
+ * only where it stands out of the noise: the medians must differ by more than `sigmas` standard errors of their
+ * difference, estimated from each run's spread over its repetitions, and by more than `tolerance` of the baseline,
+ * since repetitions within one run share the same clock speed, cache state and neighbours, and so understate how much
+ * two runs differ. A benchmark that doesn't appear in both is reported, but never counts as a regression.
+ */
+struct CompareBench
+{
+    struct Settings
+    {
+        double sigmas = 3.0;
+        double tolerance = 0.05;
+    };
+
+    enum class Verdict { unchanged, faster, slower, missing, added };
+
+    struct Comparison
+    {
+        juce::String key;
+        Verdict verdict = Verdict::unchanged;
+        //! ns per sample, and the least difference that would have counted as a change
+        double baseline = 0, current = 0, threshold = 0;
+
+        double ratio() const { return baseline > 0 ? current / baseline : 0.0; }
+    };
+
+    struct Summary
+    {
+        std::vector<Comparison> comparisons;
+        int regressions = 0, improvements = 0, missing = 0, added = 0;
+    };
+
+    /**
+     * Standard error of the median of `@param m`'s repetitions, sqrt(pi / 2) times that of the mean for normally
+     * distributed timings.
+     */
+    static double standardError(BenchHarness::Measurement const& m)
+    {
+        return m.repetitions > 0 ? 1.2533 * m.nsStdDev / std::sqrt(static_cast<double>(m.repetitions)) : 0.0;
+    }
+
+    static Comparison compare(BenchHarness::Result const& baseline, BenchHarness::Result const& current,
+                              Settings const& settings)
+    {
+        Comparison c;
+        c.key = BenchHarness::key(current);
+        c.baseline = baseline.measurement.nsMedian;
+        c.current = current.measurement.nsMedian;
+
+        auto const b = standardError(baseline.measurement), k = standardError(current.measurement);
+        c.threshold = std::max(settings.sigmas * std::sqrt(b * b + k * k), settings.tolerance * c.baseline);
+        auto const difference = c.current - c.baseline;
+        c.verdict = difference > c.threshold ? Verdict::slower
+                  : -difference > c.threshold ? Verdict::faster
+                  : Verdict::unchanged;
+        return c;
+    }
+
+    //! compares every benchmark in `@param current` with the one of the same key in `@param baseline`
+    static Summary compare(std::vector<BenchHarness::Result> const& baseline,
+                           std::vector<BenchHarness::Result> const& current, Settings const& settings)
+    {
+        std::map<juce::String, BenchHarness::Result const*> before;
+        for (auto const& r : baseline) { before[BenchHarness::key(r)] = &r; }
+
+        Summary s;
+        std::map<juce::String, bool> seen;
+        for (auto const& r : current)
+        {
+            auto const key = BenchHarness::key(r);
+            seen[key] = true;
+            auto const found = before.find(key);
+            if (found == before.end())
+            {
+                Comparison c;
+                c.key = key;
+                c.verdict = Verdict::added;
+                c.current = r.measurement.nsMedian;
+                s.comparisons.push_back(c);
+                ++s.added;
+                continue;
+            }
+
+            s.comparisons.push_back(compare(*found->second, r, settings));
+            if (s.comparisons.back().verdict == Verdict::slower) { ++s.regressions; }
+            if (s.comparisons.back().verdict == Verdict::faster) { ++s.improvements; }
+        }
+        for (auto const& r : baseline)
+        {
+            if (seen.count(BenchHarness::key(r)) == 0)
+            {
+                Comparison c;
+                c.key = BenchHarness::key(r);
+                c.verdict = Verdict::missing;
+                c.baseline = r.measurement.nsMedian;
+                s.comparisons.push_back(c);
+                ++s.missing;
+            }
+        }
+        return s;
+    }
+
+    static char const* verdictName(Verdict v)
+    {
+        switch (v)
+        {
+            case Verdict::unchanged: return "";
+            case Verdict::faster: return "faster";
+            case Verdict::slower: return "SLOWER";
+            case Verdict::missing: return "missing";
+            case Verdict::added: return "new";
+        }
+        return "";
+    }
+
+    //! prints the changes, or every comparison if `@param all`
+    static void print(Summary const& s, bool all)
+    {
+        std::printf("%-56s %10s %10s %8s %10s\n", "benchmark", "baseline", "current", "ratio", "threshold");
+        for (auto const& c : s.comparisons)
+        {
+            if (! all && c.verdict == Verdict::unchanged) { continue; }
+            if (c.verdict == Verdict::missing || c.verdict == Verdict::added)
+            {
+                std::printf("%-56s %10.3f %10.3f %8s %10s %s\n", c.key.toRawUTF8(), c.baseline, c.current, "", "",
+                            verdictName(c.verdict));
+                continue;
+            }
+            std::printf("%-56s %10.3f %10.3f %8.3f %10.3f %s\n", c.key.toRawUTF8(), c.baseline, c.current, c.ratio(),
+                        c.threshold, verdictName(c.verdict));
+        }
+        std::printf("%d compared: %d slower, %d faster, %d missing from the current run, %d new\n",
+                    static_cast<int>(s.comparisons.size()) - s.missing - s.added, s.regressions, s.improvements,
+                    s.missing, s.added);
+    }
+
+    /**
+     * Compares the result files named by the two arguments after the command, baseline first, and fails (exits
+     * non-zero) on any regression. Options: --sigmas=<n>, --tolerance=<fraction> (see Settings), --all (print every
+     * comparison, not just the changes).
+     */
+    static void run(juce::ArgumentList const& args)
+    {
+        juce::StringArray files;
+        for (int i = 1; i < args.size(); ++i)
+        {
+            if (! args[i].isOption()) { files.add(args[i].text); }
+        }
+        if (files.size() != 2) { juce::ConsoleApplication::fail("expected a baseline and a current result file"); }
+
+        std::vector<BenchHarness::Result> baseline, current;
+        auto const read = [](juce::String const& name, std::vector<BenchHarness::Result>& results)
+        {
+            if (! BenchHarness::readJson(juce::File::getCurrentWorkingDirectory().getChildFile(name), results))
+            {
+                juce::ConsoleApplication::fail("couldn't read " + name);
+            }
+        };
+        read(files[0], baseline);
+        read(files[1], current);
+
+        Settings settings;
+        if (args.containsOption("--sigmas")) { settings.sigmas = args.getValueForOption("--sigmas").getDoubleValue(); }
+        if (args.containsOption("--tolerance")) { settings.tolerance = args.getValueForOption("--tolerance").getDoubleValue(); }
+
+        auto const summary = compare(baseline, current, settings);
+        print(summary, args.containsOption("--all"));
+        if (summary.regressions > 0)
+        {
+            juce::ConsoleApplication::fail(juce::String(summary.regressions) + " benchmarks got slower", 2);
+        }
+    }
+};
+
+#endif // REDSP_COMPAREBENCH_HEADERGUARD
@@ -0,0 +1,163 @@
+#ifndef REDSP_DENORMALBENCH_HEADERGUARD
+#define REDSP_DENORMALBENCH_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <vector>
+#include "bench_harness.h"
+#include "../source/redsp.h"
+
+#pragma once
+
+/**
+ * What a tail of silence costs the recursive filters, and what each way of keeping them out of denormals buys back.
+ * Every call starts a fresh filter on one block of noise and follows it with a couple of seconds of silence, block by
+ * block, like a host after the note ends. Three modes per filter:
+ *  - plain: as is, so the state decays into denormals and stays there,
+ *  - ftz: inside a redsp::scoped_denormal_disable,
+ *  - flush: with the filter's set_denormal_flush(), which zeroes the state at a block boundary instead.
+ * ns per sample is over the whole call, noise and silence together, and includes zeroing each block before it's
+ * processed in place (around 0.1ns per sample).
+ */
+struct DenormalBench
+{
+    struct Settings
+    {
+        int block = 256;
+        //! of silence after the noise, at 48kHz
+        double seconds = 2.0;
+    };
+
+    template <typename T>
+    struct Buffers
+    {
+        std::vector<std::vector<T>> noise, data;
+        std::vector<T*> pointers;
+
+        Buffers(int channels, int block, juce::Random& random)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                std::vector<T> x(static_cast<size_t>(block));
+                for (auto& v : x) { v = static_cast<T>(random.nextDouble() - 0.5); }
+                noise.push_back(x);
+            }
+            data = noise;
+            for (auto& d : data) { pointers.push_back(d.data()); }
+        }
+
+        void fill(bool silent)
+        {
+            for (size_t c = 0; c < data.size(); ++c)
+            {
+                if (silent) { std::fill(data[c].begin(), data[c].end(), T(0)); }
+                else { std::copy(noise[c].begin(), noise[c].end(), data[c].begin()); }
+            }
+        }
+
+        T** io() { return pointers.data(); }
+    };
+
+    /**
+     * Times filter `@param name` in each mode. `@param make` returns a fresh filter, set up, and `@param process`
+     * runs it in place on (filter&, T** samples, int count).
+     */
+    template <typename T, typename Make, typename Process>
+    static void modes(BenchHarness::Report& report, Settings const& settings, int channels, juce::String const& name,
+                      Make&& make, Process&& process)
+    {
+        if (! report.wants(name)) { return; }
+
+        juce::Random random(3);
+        Buffers<T> b(channels, settings.block, random);
+        auto const blocks = static_cast<int>(settings.seconds * 48000.0 / settings.block);
+        auto const tail = [&](bool flush)
+        {
+            auto f = make();
+            f.set_denormal_flush(flush);
+            b.fill(false);
+            process(f, b.io(), settings.block);
+            for (int i = 0; i < blocks; ++i)
+            {
+                b.fill(true);
+                process(f, b.io(), settings.block);
+            }
+            BenchHarness::keep(b.data);
+        };
+        auto const length = settings.block * (blocks + 1);
+
+        report.run<T>(name + "/plain", length, channels, [&] { tail(false); });
+        report.run<T>(name + "/ftz", length, channels, [&] {
+            redsp::scoped_denormal_disable ftz;
+            tail(false);
+        });
+        report.run<T>(name + "/flush", length, channels, [&] { tail(true); });
+    }
+
+    template <typename T, size_t Channels>
+    static void filters(BenchHarness::Report& report, Settings const& settings)
+    {
+        constexpr auto channels = static_cast<int>(Channels);
+        modes<T>(report, settings, channels, "silence/biquad", [] {
+            redsp::biquad<T, T, Channels> f;
+            f.calc_lp(T(0.01), T(0.7));
+            f.reset();
+            return f;
+        }, [](auto& f, T** x, int count) { f.process_optimized(x, count); });
+        modes<T>(report, settings, channels, "silence/svf", [] {
+            redsp::svf<T, Channels, T> f(T(48000));
+            f.calc_unsafe(T(500), T(0.7));
+            return f;
+        }, [](auto& f, T** x, int count) { f.template process<redsp::svf<T, Channels, T>::SVFType::Lowpass>(x, count); });
+        modes<T>(report, settings, channels, "silence/ladder", [] {
+            redsp::ladder<T, Channels> f;
+            f.set_cutoff(T(0.01));
+            f.set_resonance(T(0.5));
+            return f;
+        }, [](auto& f, T** x, int count) { f.process(x, count); });
+        modes<T>(report, settings, channels, "silence/tpt_one_pole", [] {
+            redsp::tpt_one_pole<T, Channels> f;
+            f.set_cutoff(T(0.01));
+            return f;
+        }, [](auto& f, T** x, int count) { f.process(x, count); });
+    }
+
+    /**
+     * Runs the benchmark. Options: --quick (fewer, shorter repetitions), --block=<n> (samples per call, 256 by
+     * default), --filter=<text> (only benchmarks whose name contains it), --json=<file> (write the results there, in
+     * the --suite format, for --compare).
+     */
+    static void run(juce::ArgumentList const& args)
+    {
+        BenchHarness::Settings harness;
+        harness.repetitions = 7;
+        harness.msPerRepetition = 100.0;
+        harness.warmupMs = 50.0;
+        Settings settings;
+        if (args.containsOption("--quick"))
+        {
+            harness.repetitions = 3;
+            harness.msPerRepetition = 20.0;
+            harness.warmupMs = 10.0;
+            settings.seconds = 0.5;
+        }
+        if (args.containsOption("--filter")) { harness.filter = args.getValueForOption("--filter"); }
+        if (args.containsOption("--block")) { settings.block = juce::jmax(1, args.getValueForOption("--block").getIntValue()); }
+
+        std::printf("a block of noise then %.1fs of silence per call, in blocks of %d%s\n", settings.seconds, settings.block,
+                    redsp::scoped_denormal_disable::supported ? "" : " (ftz does nothing on this platform)");
+        BenchHarness::Report report(harness);
+        filters<float, 1>(report, settings);
+        filters<float, 8>(report, settings);
+        filters<double, 1>(report, settings);
+        filters<double, 8>(report, settings);
+
+        if (args.containsOption("--json"))
+        {
+            auto const file = args.getFileForOption("--json");
+            if (! report.writeJson(file)) { juce::ConsoleApplication::fail("couldn't write " + file.getFullPathName()); }
+            std::printf("wrote %d results to %s\n", static_cast<int>(report.results.size()), file.getFullPathName().toRawUTF8());
+        }
+    }
+};
+
+#endif // REDSP_DENORMALBENCH_HEADERGUARD
@@ -0,0 +1,70 @@
+#ifndef REDSP_FFTBENCH_HEADERGUARD
+#define REDSP_FFTBENCH_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <chrono>
+#include "../source/fft/fft.h"
+
+#pragma once
+
+/**
+ * Times redsp::fft against juce::dsp::FFT for complex and real forward transforms from 32 to 65536 points, and
+ * prints ns per transform for each along with redsp's speedup.
+ */
+struct FFTBench
+{
+    template <typename F>
+    static double nsPerCall(F&& f, int calls)
+    {
+        for (int i = 0; i < calls / 8 + 1; ++i) { f(); } // warm up
+
+        auto best = std::numeric_limits<double>::max();
+        for (int rep = 0; rep < 5; ++rep)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < calls; ++i) { f(); }
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / calls);
+        }
+        return best;
+    }
+
+    static void run()
+    {
+        std::printf("%8s | %12s %12s %8s | %12s %12s %8s\n", "size", "redsp cplx", "juce cplx", "speedup",
+                    "redsp real", "juce real", "speedup");
+
+        juce::Random random;
+        for (int order = redsp::fft<float>::min_order; order <= redsp::fft<float>::max_order; ++order)
+        {
+            auto const n = 1 << order;
+            auto calls = std::max(4, (1 << 22) / n / order);
+
+            redsp::fft<float> ours(order);
+            juce::dsp::FFT theirs(order);
+
+            std::vector<std::complex<float>> in(static_cast<size_t>(n)), out(static_cast<size_t>(n));
+            std::vector<float> real(static_cast<size_t>(n)), juceReal(static_cast<size_t>(n) * 2);
+            std::vector<float> re(static_cast<size_t>(n / 2 + 1)), im(static_cast<size_t>(n / 2 + 1));
+            for (auto& v : in) { v = { random.nextFloat(), random.nextFloat() }; }
+            for (auto& v : real) { v = random.nextFloat(); }
+
+            auto oursComplex = nsPerCall([&] { ours.forward(in.data(), out.data()); }, calls);
+            auto theirsComplex = nsPerCall([&] { theirs.perform(reinterpret_cast<juce::dsp::Complex<float>*>(in.data()),
+                                                                reinterpret_cast<juce::dsp::Complex<float>*>(out.data()),
+                                                                false); }, calls);
+            auto oursReal = nsPerCall([&] { ours.forward_real(real.data(), re.data(), im.data()); }, calls);
+            auto theirsReal = nsPerCall([&] {
+                std::copy(real.begin(), real.end(), juceReal.begin());
+                theirs.performRealOnlyForwardTransform(juceReal.data(), true);
+            }, calls);
+
+            std::printf("%8d | %12.1f %12.1f %7.2fx | %12.1f %12.1f %7.2fx\n", n,
+                        oursComplex, theirsComplex, theirsComplex / oursComplex,
+                        oursReal, theirsReal, theirsReal / oursReal);
+        }
+    }
+};
+
+#endif // REDSP_FFTBENCH_HEADERGUARD
@@ -0,0 +1,102 @@
+#ifndef REDSP_LADDERBENCH_HEADERGUARD
+#define REDSP_LADDERBENCH_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <chrono>
+#include <cstdint>
+#include "bench_harness.h"
+#include "../source/filters/ladder.h"
+
+#pragma once
+
+/**
+ * Times redsp::ladder_voices for 1 to 64 voices, modulated and not, against a bank of scalar redsp::ladder, and
+ * prints the cost per voice per sample in ns and in reference cycles (the timestamp counter, on x86 only).
+ */
+struct LadderBench
+{
+    struct cost { double ns, cycles; };
+
+    //! best of 5 runs of `@param calls` calls, after a warmup
+    template <typename F>
+    static cost perCall(F&& f, int calls)
+    {
+        for (int i = 0; i < calls / 8 + 1; ++i) { f(); }
+
+        cost best { std::numeric_limits<double>::max(), 0 };
+        for (int rep = 0; rep < 5; ++rep)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto const startCycles = cycles();
+            for (int i = 0; i < calls; ++i) { f(); }
+            auto const endCycles = cycles();
+            auto end = std::chrono::steady_clock::now();
+
+            auto ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+            if (ns < best.ns) { best = { ns, static_cast<double>(endCycles - startCycles) / calls }; }
+        }
+        return best;
+    }
+
+    static std::uint64_t cycles() { return BenchHarness::cycles(); }
+
+    template <size_t Voices>
+    static void row(juce::Random& random)
+    {
+        int const block = 256;
+        auto const samples = static_cast<double>(block) * Voices;
+        auto const calls = std::max(16, (1 << 21) / static_cast<int>(samples));
+
+        std::vector<float> frames(static_cast<size_t>(block) * Voices), cutoff(frames.size()), resonance(frames.size());
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            frames[i] = random.nextFloat() * 2.0f - 1.0f;
+            cutoff[i] = 0.01f + 0.2f * random.nextFloat();
+            resonance[i] = random.nextFloat();
+        }
+        auto input = frames;
+
+        redsp::ladder_voices<float, Voices> bank;
+        for (size_t v = 0; v < Voices; ++v) { bank.set_cutoff(v, cutoff[v]); bank.set_resonance(v, resonance[v]); }
+        auto simd = perCall([&] { frames = input; bank.process(frames.data(), block); }, calls);
+        auto modulated = perCall([&] {
+            frames = input;
+            bank.process(frames.data(), cutoff.data(), resonance.data(), block);
+        }, calls);
+
+        // the same voices one scalar filter at a time, on planar buffers
+        redsp::ladder<float, Voices> scalar;
+        scalar.set_cutoff(cutoff[0]);
+        scalar.set_resonance(resonance[0]);
+        auto scalarCost = perCall([&] {
+            frames = input;
+            for (size_t v = 0; v < Voices; ++v)
+            {
+                scalar.process(frames.data() + v * block, block, static_cast<int>(v));
+            }
+        }, calls);
+
+        std::printf("%6d | %9.2f %9.2f | %9.2f %9.2f | %9.2f %9.2f | %7.2fx\n", static_cast<int>(Voices),
+                    simd.ns / samples, simd.cycles / samples, modulated.ns / samples, modulated.cycles / samples,
+                    scalarCost.ns / samples, scalarCost.cycles / samples, scalarCost.ns / simd.ns);
+    }
+
+    static void run()
+    {
+        std::printf("per voice per sample, float, blocks of 256%s\n",
+                    REDSP_BENCH_HAS_TSC ? "" : " (no cycle counter on this platform)");
+        std::printf("%6s | %9s %9s | %9s %9s | %9s %9s | %8s\n", "voices", "simd ns", "cycles", "mod ns", "cycles",
+                    "scalar ns", "cycles", "speedup");
+
+        juce::Random random;
+        row<1>(random);
+        row<2>(random);
+        row<4>(random);
+        row<8>(random);
+        row<16>(random);
+        row<32>(random);
+        row<64>(random);
+    }
+};
+
+#endif // REDSP_LADDERBENCH_HEADERGUARD
@@ -0,0 +1,112 @@
+#ifndef REDSP_LATENCYBENCH_HEADERGUARD
+#define REDSP_LATENCYBENCH_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+#include "latency_profile.h"
+#include "../source/redsp.h"
+
+#pragma once
+
+/**
+ * Profiles the per-call latency of the processors with state that carries on after the input stops (the ones a tail of
+ * silence can push into denormals) through LatencyProfile.
+ */
+struct LatencyBench
+{
+    struct TanhShape { template <typename T> T operator()(T x) const { return redsp::math::tanh_fast(x); } };
+
+    //! a maker for LatencyProfile::run(): a fresh default-constructed P, set up by `@param setup`, processing in place
+    template <typename P, typename Setup>
+    static auto fresh(Setup setup)
+    {
+        return [setup]
+        {
+            auto p = std::make_shared<P>();
+            setup(*p);
+            return [p](typename P::sample_type** x, int count) { p->process(x, count); };
+        };
+    }
+
+    template <typename T, size_t Channels>
+    static void processors(LatencyProfile& profile, int block)
+    {
+        constexpr auto channels = static_cast<int>(Channels);
+        profile.run<T>("biquad/process", block, channels, fresh<redsp::biquad<T, T, Channels>>([](auto& f) {
+            f.calc_lp(T(0.01), T(0.7));
+            f.reset();
+        }));
+        profile.run<T>("biquad/process_optimized", block, channels, [] {
+            auto f = std::make_shared<redsp::biquad<T, T, Channels>>();
+            f->calc_lp(T(0.01), T(0.7));
+            f->reset();
+            return [f](T** x, int count) { f->process_optimized(x, count); };
+        });
+        profile.run<T>("svf/lowpass", block, channels, [] {
+            using svf_type = redsp::svf<T, Channels, T>;
+            auto f = std::make_shared<svf_type>(T(48000));
+            f->calc_unsafe(T(500), T(0.7));
+            return [f](T** x, int count) { f->template process<svf_type::SVFType::Lowpass>(x, count); };
+        });
+        profile.run<T>("ladder", block, channels, fresh<redsp::ladder<T, Channels>>([](auto& f) {
+            f.set_cutoff(T(0.01));
+            f.set_resonance(T(0.5));
+        }));
+        profile.run<T>("tpt_one_pole", block, channels, fresh<redsp::tpt_one_pole<T, Channels>>([](auto& f) {
+            f.set_cutoff(T(0.001));
+        }));
+        profile.run<T>("dc_blocker", block, channels, fresh<redsp::dc_blocker<T, Channels>>([](auto&) { }));
+        profile.run<T>("envelope_follower", block, channels, fresh<redsp::envelope_follower<T, Channels>>([](auto& f) {
+            f.set_times(0.001, 0.5, 48000.0);
+        }));
+        profile.run<T>("compressor", block, channels, fresh<redsp::compressor<T, Channels>>([block](auto& f) {
+            f.prepare(48000.0, block);
+            f.set_threshold(T(-20));
+        }));
+        profile.run<T>("oversampled/4x_tanh_fast", block, channels,
+                       fresh<redsp::oversampled<redsp::waveshaper<T, TanhShape, Channels>, 4>>([block](auto& f) {
+            f.prepare(block);
+        }));
+    }
+
+    template <typename T>
+    static void all(LatencyProfile& profile, int block)
+    {
+        processors<T, 1>(profile, block);
+        processors<T, 8>(profile, block);
+        profile.run<T>("fdn_reverb", block, 2, fresh<redsp::fdn_reverb<T>>([block](auto& f) {
+            f.prepare(48000.0, block);
+        }));
+    }
+
+    /**
+     * Runs the profile. Options: --quick (fewer calls), --block=<n> (samples per call, 256 by default),
+     * --filter=<text> (only processors whose name contains it, or any of several texts split by '|'), --json=<file>
+     * (write the histograms there).
+     */
+    static void run(juce::ArgumentList const& args)
+    {
+        LatencyProfile::Settings settings;
+        if (args.containsOption("--quick"))
+        {
+            settings.calls = 1000;
+            settings.cold_calls = 64;
+        }
+        if (args.containsOption("--filter")) { settings.filter = args.getValueForOption("--filter"); }
+        auto const block = args.containsOption("--block") ? juce::jmax(1, args.getValueForOption("--block").getIntValue()) : 256;
+
+        LatencyProfile profile(settings);
+        all<float>(profile, block);
+        all<double>(profile, block);
+
+        if (args.containsOption("--json"))
+        {
+            auto const file = args.getFileForOption("--json");
+            if (! profile.writeJson(file)) { juce::ConsoleApplication::fail("couldn't write " + file.getFullPathName()); }
+            std::printf("wrote %d profiles to %s\n", static_cast<int>(profile.entries.size()), file.getFullPathName().toRawUTF8());
+        }
+    }
+};
+
+#endif // REDSP_LATENCYBENCH_HEADERGUARD
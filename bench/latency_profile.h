@@ -0,0 +1,284 @@
+#ifndef REDSP_LATENCYPROFILE_HEADERGUARD
+#define REDSP_LATENCYPROFILE_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "bench_harness.h"
+#include "../source/internal/denormals.h"
+
+#pragma once
+
+/**
+ * Times every call rather than averaging over many, since it's the slowest block, not the typical one, that drops
+ * out. Each call's duration goes into a histogram, which gives the tail (p99, p99.9, max) as well as the median.
+ * Each processor runs three times from fresh, on a burst of noise followed by silence, the input that lets recursive
+ * filters decay into denormals:
+ *  - warm: as it would run in a host,
+ *  - flushed: with denormals flushed to zero, so a much worse tail when warm points at denormals,
+ *  - cold: flushed too, but with the caches evicted before each call, so a much worse median than flushed points at
+ *    cache misses (flushing keeps denormals out of that comparison).
+ */
+struct LatencyProfile
+{
+    /**
+     * Log-linear histogram of durations in ns, after HdrHistogram: values below 2 * sub_count are exact, and above that
+     * each power of two is split into sub_count buckets, so any value is known to within 1 / sub_count (about 3%).
+     */
+    struct Histogram
+    {
+        static constexpr int sub_bits = 5, sub_count = 1 << sub_bits;
+
+        Histogram() : counts(static_cast<size_t>((64 - sub_bits + 1) * sub_count), 0) { }
+
+        void record(std::uint64_t ns)
+        {
+            ++counts[static_cast<size_t>(index(ns))];
+            ++total;
+            sum += static_cast<double>(ns);
+            smallest = std::min(smallest, ns);
+            largest = std::max(largest, ns);
+        }
+
+        std::uint64_t count() const { return total; }
+        std::uint64_t min() const { return total ? smallest : 0; }
+        std::uint64_t max() const { return largest; }
+        double mean() const { return total ? sum / static_cast<double>(total) : 0.0; }
+
+        //! the largest value the bucket holding the `@param q` quantile could hold, at most max()
+        std::uint64_t percentile(double q) const
+        {
+            if (total == 0) { return 0; }
+            auto const rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total))));
+            std::uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank) { return std::min(upper(static_cast<int>(i)), largest); }
+            }
+            return largest;
+        }
+
+        static int index(std::uint64_t v)
+        {
+            if (v < 2 * sub_count) { return static_cast<int>(v); }
+            int msb = 63;
+            while ((v >> msb) == 0) { --msb; }
+            auto const shift = msb - sub_bits;
+            return (shift + 1) * sub_count + static_cast<int>((v >> shift) - sub_count);
+        }
+
+        static std::uint64_t lower(int i)
+        {
+            if (i < 2 * sub_count) { return static_cast<std::uint64_t>(i); }
+            auto const shift = i / sub_count - 1;
+            return static_cast<std::uint64_t>(i % sub_count + sub_count) << shift;
+        }
+
+        static std::uint64_t upper(int i)
+        {
+            return i < 2 * sub_count ? lower(i) : lower(i) + (std::uint64_t(1) << (i / sub_count - 1)) - 1;
+        }
+
+        juce::var toVar() const
+        {
+            auto* o = new juce::DynamicObject();
+            o->setProperty("count", static_cast<juce::int64>(total));
+            o->setProperty("min_ns", static_cast<juce::int64>(min()));
+            o->setProperty("mean_ns", mean());
+            o->setProperty("p50_ns", static_cast<juce::int64>(percentile(0.5)));
+            o->setProperty("p90_ns", static_cast<juce::int64>(percentile(0.9)));
+            o->setProperty("p99_ns", static_cast<juce::int64>(percentile(0.99)));
+            o->setProperty("p999_ns", static_cast<juce::int64>(percentile(0.999)));
+            o->setProperty("max_ns", static_cast<juce::int64>(max()));
+
+            // the non-empty buckets, as [lowest, highest, count]
+            juce::Array<juce::var> buckets;
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                if (counts[i] == 0) { continue; }
+                buckets.add(juce::Array<juce::var> { static_cast<juce::int64>(lower(static_cast<int>(i))),
+                                                     static_cast<juce::int64>(upper(static_cast<int>(i))),
+                                                     static_cast<juce::int64>(counts[i]) });
+            }
+            o->setProperty("buckets", buckets);
+            return juce::var(o);
+        }
+
+    private:
+        std::vector<std::uint64_t> counts;
+        std::uint64_t total = 0, smallest = ~std::uint64_t(0), largest = 0;
+        double sum = 0;
+    };
+
+    struct Settings
+    {
+        //! calls per run (warm and flushed), the first burst_fraction of them on noise and the rest on silence
+        int calls = 4000;
+        double burst_fraction = 1.0 / 16.0;
+        //! calls in the cold run, fewer since evicting the caches takes a while
+        int cold_calls = 256;
+        size_t evict_bytes = size_t(8) << 20;
+        //! calls slower than this many medians are outliers
+        double outlier_factor = 10.0;
+        //! how much worse the warm run's tail than flushed, or cold's median than flushed, must be to blame denormals or
+        //! the caches
+        double blame_factor = 2.0;
+        juce::String filter;
+    };
+
+    struct Entry
+    {
+        juce::String name, type;
+        int block = 0, channels = 0;
+        Histogram warm, flushed, cold;
+        //! warm calls over outlier_factor medians, and the slowest warm call's index
+        int outliers = 0, worst_call = 0;
+        bool denormals = false, cache = false;
+    };
+
+    Settings settings;
+    std::vector<Entry> entries;
+
+    explicit LatencyProfile(Settings s) : settings(s)
+    {
+        std::printf("%d calls per run, noise for the first %d then silence%s\n", settings.calls,
+                    static_cast<int>(settings.calls * settings.burst_fraction),
+                    redsp::scoped_denormal_disable::supported ? "" : " (can't flush denormals on this platform)");
+        std::printf("%-28s %6s %6s %8s | %8s %8s %8s %9s %8s | %8s %8s %8s | %s\n", "processor", "type", "block", "channels",
+                    "p50 ns", "p99", "p99.9", "max", "outliers", "ftz p50", "ftz p99", "cold p50", "blame");
+    }
+
+    bool wants(juce::String const& name) const { return BenchHarness::matches(settings.filter, name); }
+
+    /**
+     * Profiles processor `@param name`, if it passes the filter. Each run gets a fresh processor from `@param make`,
+     * which returns something callable as (T** samples, int count) that processes `@param channels` channels of
+     * `@param block` samples in place.
+     */
+    template <typename T, typename Make>
+    void run(juce::String const& name, int block, int channels, Make&& make)
+    {
+        if (! wants(name)) { return; }
+
+        Entry e;
+        e.name = name;
+        e.type = BenchHarness::typeName<T>();
+        e.block = block;
+        e.channels = channels;
+
+        std::vector<std::vector<T>> data(static_cast<size_t>(channels), std::vector<T>(static_cast<size_t>(block)));
+        std::vector<T*> pointers;
+        for (auto& d : data) { pointers.push_back(d.data()); }
+        juce::Random random(7);
+        std::vector<std::uint64_t> warm;
+
+        auto const profile = [&](Histogram& h, int calls, bool evict, std::vector<std::uint64_t>* each)
+        {
+            using clock = std::chrono::steady_clock;
+            auto process = make();
+            auto const burst = std::max(1, static_cast<int>(calls * settings.burst_fraction));
+            for (int i = 0; i < calls; ++i)
+            {
+                for (auto& d : data)
+                {
+                    for (auto& v : d) { v = i < burst ? static_cast<T>(random.nextDouble() - 0.5) : T(0); }
+                }
+                if (evict) { this->evict(); }
+
+                auto const start = clock::now();
+                process(pointers.data(), block);
+                auto const end = clock::now();
+                BenchHarness::keep(data);
+
+                auto const ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                h.record(ns);
+                if (each != nullptr) { each->push_back(ns); }
+            }
+        };
+
+        profile(e.warm, settings.calls, false, &warm);
+        {
+            redsp::scoped_denormal_disable ftz;
+            profile(e.flushed, settings.calls, false, nullptr);
+            profile(e.cold, settings.cold_calls, true, nullptr);
+        }
+
+        auto const median = static_cast<double>(e.warm.percentile(0.5));
+        for (size_t i = 0; i < warm.size(); ++i)
+        {
+            if (static_cast<double>(warm[i]) > settings.outlier_factor * median) { ++e.outliers; }
+            if (warm[i] > warm[static_cast<size_t>(e.worst_call)]) { e.worst_call = static_cast<int>(i); }
+        }
+        e.denormals = redsp::scoped_denormal_disable::supported
+                      && static_cast<double>(e.warm.percentile(0.99)) > settings.blame_factor * static_cast<double>(e.flushed.percentile(0.99));
+        e.cache = static_cast<double>(e.cold.percentile(0.5)) > settings.blame_factor * static_cast<double>(e.flushed.percentile(0.5));
+
+        std::printf("%-28s %6s %6d %8d | %8llu %8llu %8llu %9llu %8d | %8llu %8llu %8llu | %s%s\n", e.name.toRawUTF8(),
+                    e.type.toRawUTF8(), e.block, e.channels,
+                    static_cast<unsigned long long>(e.warm.percentile(0.5)),
+                    static_cast<unsigned long long>(e.warm.percentile(0.99)),
+                    static_cast<unsigned long long>(e.warm.percentile(0.999)),
+                    static_cast<unsigned long long>(e.warm.max()), e.outliers,
+                    static_cast<unsigned long long>(e.flushed.percentile(0.5)),
+                    static_cast<unsigned long long>(e.flushed.percentile(0.99)),
+                    static_cast<unsigned long long>(e.cold.percentile(0.5)),
+                    e.denormals ? "denormals " : "", e.cache ? "cache" : "");
+        std::fflush(stdout);
+        entries.push_back(std::move(e));
+    }
+
+    juce::var toVar() const
+    {
+        juce::Array<juce::var> list;
+        for (auto const& e : entries)
+        {
+            auto* o = new juce::DynamicObject();
+            o->setProperty("name", e.name);
+            o->setProperty("type", e.type);
+            o->setProperty("block", e.block);
+            o->setProperty("channels", e.channels);
+            o->setProperty("warm", e.warm.toVar());
+            o->setProperty("flushed", e.flushed.toVar());
+            o->setProperty("cold", e.cold.toVar());
+            o->setProperty("outliers", e.outliers);
+            o->setProperty("worst_call", e.worst_call);
+            o->setProperty("denormals", e.denormals);
+            o->setProperty("cache", e.cache);
+            list.add(juce::var(o));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("format", "redsp_latency/1");
+        root->setProperty("simd", BenchHarness::simdName());
+        root->setProperty("compiler", BenchHarness::compilerName());
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+        root->setProperty("calls", settings.calls);
+        root->setProperty("burst_calls", static_cast<int>(settings.calls * settings.burst_fraction));
+        root->setProperty("cold_calls", settings.cold_calls);
+        root->setProperty("processors", list);
+        return juce::var(root);
+    }
+
+    bool writeJson(juce::File const& file) const
+    {
+        return file.replaceWithText(juce::JSON::toString(toVar()));
+    }
+
+private:
+    std::vector<char> eviction;
+
+    //! writes over a buffer bigger than the caches, pushing the processor's state and coefficients out
+    void evict()
+    {
+        if (eviction.size() != settings.evict_bytes) { eviction.assign(settings.evict_bytes, 0); }
+        for (size_t i = 0; i < eviction.size(); i += 64) { ++eviction[i]; }
+        BenchHarness::keep(eviction);
+    }
+};
+
+#endif // REDSP_LATENCYPROFILE_HEADERGUARD
@@ -0,0 +1,37 @@
+#include <juce_core/juce_core.h>
+#include "../source/redsp.h"
+#include "fft_bench.h"
+#include "ladder_bench.h"
+#include "processor_bench.h"
+#include "compare_bench.h"
+#include "latency_bench.h"
+#include "denormal_bench.h"
+
+int main(int argc, char** argv)
+{
+  juce::ConsoleApplication app;
+
+  app.addHelpCommand("--help|-h", "use", true);
+  app.addCommand({"--fft|-f", "Benchmarks redsp::fft against juce::dsp::FFT", "Benchmarks redsp::fft against juce::dsp::FFT", "", [](const juce::ArgumentList&){ FFTBench::run(); } });
+  app.addCommand({"--ladder|-l", "Benchmarks redsp::ladder_voices per voice count", "Benchmarks redsp::ladder_voices per voice count", "", [](const juce::ArgumentList&){ LadderBench::run(); } });
+  app.addCommand({"--suite|-s", "--suite [--quick] [--filter=<text>] [--json=<file>]",
+                  "Benchmarks every processor and the math approximations over types, channel counts and block sizes",
+                  "Reports ns and cycles per sample (median of repetitions, after warmup) and optionally writes them as JSON.",
+                  [](const juce::ArgumentList& args){ ProcessorBench::run(args); } });
+  app.addCommand({"--compare|-c", "--compare <baseline.json> <current.json> [--sigmas=<n>] [--tolerance=<fraction>] [--all]",
+                  "Compares two --suite result files and exits non-zero if any benchmark got significantly slower",
+                  "A benchmark counts as slower when its median grew by more than --sigmas (3) standard errors, from the spread "
+                  "over repetitions, and by more than --tolerance (0.05) of the baseline.",
+                  [](const juce::ArgumentList& args){ CompareBench::run(args); } });
+  app.addCommand({"--latency|-t", "--latency [--quick] [--block=<n>] [--filter=<text>] [--json=<file>]",
+                  "Profiles the time of every process call: p50, p99, p99.9 and max, and whether denormals or cache misses cause the tail",
+                  "Each processor runs on a burst of noise and then silence: warm, with denormals flushed to zero, and with the "
+                  "caches evicted before each call. The histograms can be written as JSON.",
+                  [](const juce::ArgumentList& args){ LatencyBench::run(args); } });
+  app.addCommand({"--denormals|-d", "--denormals [--quick] [--block=<n>] [--filter=<text>] [--json=<file>]",
+                  "Benchmarks the recursive filters through a tail of silence: as is, under scoped_denormal_disable, and with state flushing",
+                  "Each call runs a fresh filter on a block of noise and then 2s of silence, which is where the state decays into "
+                  "denormals unless something stops it. The results can be written as JSON in the --suite format.",
+                  [](const juce::ArgumentList& args){ DenormalBench::run(args); } });
+  return app.findAndRunCommand(argc, argv);
+}
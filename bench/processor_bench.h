@@ -0,0 +1,267 @@
+#ifndef REDSP_PROCESSORBENCH_HEADERGUARD
+#define REDSP_PROCESSORBENCH_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <vector>
+#include "bench_harness.h"
+#include "../source/redsp.h"
+
+#pragma once
+
+/**
+ * Times every redsp processor, and the math approximations against the standard library, across float and double,
+ * 1 to 64 channels and a range of block sizes, reporting ns and cycles per sample (per channel) through
+ * BenchHarness::Report.
+ * In-place processors get a fresh copy of the same noise each call, so recursive and nonlinear ones stay at the same
+ * operating point (and out of denormals) however long they run; the copy is timed with them, and costs around
+ * 0.1ns per sample.
+ */
+struct ProcessorBench
+{
+    template <typename T>
+    struct Buffers
+    {
+        std::vector<std::vector<T>> input, data, output;
+        std::vector<T*> pointers, outputs;
+
+        Buffers(int channels, int block, juce::Random& random)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                std::vector<T> x(static_cast<size_t>(block));
+                for (auto& v : x) { v = static_cast<T>(random.nextDouble() - 0.5); }
+                input.push_back(x);
+            }
+            data = input;
+            output = input;
+            for (auto& d : data) { pointers.push_back(d.data()); }
+            for (auto& o : output) { outputs.push_back(o.data()); }
+        }
+
+        //! puts the input back into the in-place buffers
+        void refresh()
+        {
+            for (size_t c = 0; c < input.size(); ++c) { std::copy(input[c].begin(), input[c].end(), data[c].begin()); }
+        }
+
+        T** io() { return pointers.data(); }
+        T const* const* in() const { return const_cast<T const* const*>(pointers.data()); }
+    };
+
+    struct TanhShape { template <typename T> T operator()(T x) const { return redsp::math::tanh_fast(x); } };
+    struct Tanh { template <typename T> T operator()(T x) const { return std::tanh(x); } };
+    struct LogCosh { template <typename T> T operator()(T x) const { return std::log(std::cosh(x)); } };
+
+    //! every processor that takes Channels as a parameter, at one channel count
+    template <typename T, size_t Channels>
+    static void processors(BenchHarness::Report& report, std::vector<int> const& blocks, juce::Random& random)
+    {
+        constexpr auto channels = static_cast<int>(Channels);
+        for (auto block : blocks)
+        {
+            Buffers<T> b(channels, block, random);
+            auto const perChannel = [&](auto&& f) { for (int c = 0; c < channels; ++c) { f(c); } };
+
+            {
+                redsp::biquad<T, T, Channels> f;
+                f.calc_lp(T(0.1), T(0.7));
+                f.reset();
+                report.run<T>("biquad/process", block, channels, [&] {
+                    b.refresh();
+                    perChannel([&](int c) { f.process(b.data[static_cast<size_t>(c)].data(), block, c); });
+                });
+                if (block >= 2)
+                {
+                    report.run<T>("biquad/process_optimized", block, channels, [&] {
+                        b.refresh();
+                        f.process_optimized(b.io(), block);
+                    });
+                    report.run<T>("biquad/process_optimized_out", block, channels, [&] {
+                        f.process_optimized(b.io(), b.outputs.data(), block);
+                    });
+                }
+            }
+            {
+                using svf_type = redsp::svf<T, Channels, T>;
+                svf_type f(T(48000));
+                f.calc_unsafe(T(1000), T(0.7));
+                report.run<T>("svf/lowpass", block, channels, [&] {
+                    b.refresh();
+                    f.template process<svf_type::SVFType::Lowpass>(b.io(), block);
+                });
+            }
+            {
+                redsp::fir<T, 32, Channels> f;
+                f.set_coefficients(redsp::kaiser_lowpass<T>(32, 0.2));
+                report.run<T>("fir/32", block, channels, [&] {
+                    perChannel([&](int c) { f.process(b.data[static_cast<size_t>(c)].data(), b.outputs[static_cast<size_t>(c)], block, c); });
+                });
+            }
+            {
+                redsp::ladder<T, Channels> f;
+                f.set_cutoff(T(0.05));
+                f.set_resonance(T(0.5));
+                report.run<T>("ladder", block, channels, [&] { b.refresh(); f.process(b.io(), block); });
+            }
+            {
+                redsp::tpt_one_pole<T, Channels> f;
+                report.run<T>("tpt_one_pole", block, channels, [&] { b.refresh(); f.process(b.io(), block); });
+            }
+            {
+                redsp::dc_blocker<T, Channels> f;
+                report.run<T>("dc_blocker", block, channels, [&] { b.refresh(); f.process(b.io(), block); });
+            }
+            {
+                redsp::delay_line<T, redsp::delay_interpolation::linear, Channels> d;
+                d.prepare(4096, block);
+                d.set_delay(T(1000.5));
+                report.run<T>("delay_line/linear", block, channels, [&] { b.refresh(); d.process(b.io(), block); });
+            }
+            {
+                redsp::envelope_follower<T, Channels> f;
+                report.run<T>("envelope_follower", block, channels, [&] { b.refresh(); f.process(b.io(), block); });
+            }
+            {
+                redsp::compressor<T, Channels> comp;
+                comp.prepare(48000.0, block);
+                comp.set_threshold(T(-20));
+                report.run<T>("compressor", block, channels, [&] { b.refresh(); comp.process(b.io(), block); });
+            }
+            {
+                redsp::waveshaper<T, TanhShape, Channels> shaper;
+                report.run<T>("waveshaper/tanh_fast", block, channels, [&] { b.refresh(); shaper.process(b.io(), block); });
+
+                redsp::oversampled<redsp::waveshaper<T, TanhShape, Channels>, 4> oversampled;
+                oversampled.prepare(block);
+                report.run<T>("oversampled/4x_tanh_fast", block, channels, [&] { b.refresh(); oversampled.process(b.io(), block); });
+            }
+            {
+                redsp::adaa<T, Tanh, LogCosh, redsp::no_antiderivative, Channels> f;
+                report.run<T>("adaa/tanh", block, channels, [&] { b.refresh(); f.process(b.io(), block); });
+            }
+            {
+                redsp::loudness_meter<T, Channels> meter;
+                report.run<T>("loudness_meter", block, channels, [&] { meter.process(b.in(), block); });
+                redsp::true_peak_meter<T, Channels> peak;
+                report.run<T>("true_peak_meter", block, channels, [&] { peak.process(b.in(), block); });
+            }
+        }
+    }
+
+    //! processors with a fixed channel layout
+    template <typename T>
+    static void fixedLayout(BenchHarness::Report& report, std::vector<int> const& blocks, juce::Random& random)
+    {
+        for (auto block : blocks)
+        {
+            {
+                Buffers<T> b(2, block, random);
+                redsp::fdn_reverb<T> reverb;
+                reverb.prepare(48000.0, block);
+                report.run<T>("fdn_reverb", block, 2, [&] { b.refresh(); reverb.process(b.io(), block); });
+            }
+            {
+                Buffers<T> b(1, block, random);
+                std::vector<T> ir(4096);
+                for (auto& v : ir) { v = static_cast<T>(random.nextDouble() - 0.5); }
+                redsp::uniform_convolver<T> conv;
+                if (report.wants("uniform_convolver/4096"))
+                {
+                    conv.prepare(ir.data(), static_cast<int>(ir.size()), block);
+                    report.run<T>("uniform_convolver/4096", block, 1, [&] { conv.process(b.input[0].data(), b.outputs[0], block); });
+                }
+
+                redsp::resampler<T> resampler;
+                std::vector<T> out(static_cast<size_t>(block) * 2);
+                if (report.wants("resampler/48k_44k1"))
+                {
+                    resampler.prepare(48000.0, 44100.0, block);
+                    report.run<T>("resampler/48k_44k1", block, 1, [&] {
+                        resampler.process(b.input[0].data(), block, out.data(), static_cast<int>(out.size()));
+                    });
+                }
+            }
+        }
+    }
+
+    //! the approximations in remath against the standard library, on arguments from their documented domains
+    template <typename T>
+    static void math(BenchHarness::Report& report, juce::Random& random)
+    {
+        int const count = 1024;
+        std::vector<T> x(count), y(count);
+        auto const fill = [&](double low, double high)
+        {
+            for (auto& v : x) { v = static_cast<T>(low + (high - low) * random.nextDouble()); }
+        };
+        auto const time = [&](char const* name, auto&& f)
+        {
+            report.run<T>(name, count, 1, [&] {
+                for (int i = 0; i < count; ++i) { y[static_cast<size_t>(i)] = f(x[static_cast<size_t>(i)]); }
+                BenchHarness::keep(y);
+            });
+        };
+
+        fill(-1.45, 1.45);
+        time("math/std::tan", [](T v) { return std::tan(v); });
+        time("math/tan_fast", [](T v) { return redsp::math::tan_fast(v); });
+        time("math/tan_faster", [](T v) { return redsp::math::tan_faster(v); });
+        fill(-4.0, 4.0);
+        time("math/std::tanh", [](T v) { return std::tanh(v); });
+        time("math/tanh_fast", [](T v) { return redsp::math::tanh_fast(v); });
+        time("math/tanh_faster", [](T v) { return redsp::math::tanh_faster(v); });
+        fill(-3.14, 3.14);
+        time("math/std::sin", [](T v) { return std::sin(v); });
+        time("math/sin_fast", [](T v) { return redsp::math::sin_fast(v); });
+        fill(1.0e-6, 1.0e6);
+        time("math/std::log2", [](T v) { return std::log2(v); });
+        time("math/log_fast", [](T v) { return redsp::math::log_fast(v); });
+        fill(-60.0, 60.0);
+        time("math/std::exp2", [](T v) { return std::exp2(v); });
+        time("math/exp2_fast", [](T v) { return redsp::math::exp2_fast(v); });
+    }
+
+    template <typename T>
+    static void all(BenchHarness::Report& report, std::vector<int> const& blocks, juce::Random& random)
+    {
+        math<T>(report, random);
+        processors<T, 1>(report, blocks, random);
+        processors<T, 2>(report, blocks, random);
+        processors<T, 8>(report, blocks, random);
+        processors<T, 64>(report, blocks, random);
+        fixedLayout<T>(report, blocks, random);
+    }
+
+    /**
+     * Runs the suite. Options: --quick (fewer, shorter repetitions and one block size), --filter=<text> (only
+     * benchmarks whose name contains it, or any of several texts split by '|'), --json=<file> (write the results there).
+     */
+    static void run(juce::ArgumentList const& args)
+    {
+        BenchHarness::Settings settings;
+        std::vector<int> blocks { 32, 128, 512, 2048 };
+        if (args.containsOption("--quick"))
+        {
+            settings.repetitions = 5;
+            settings.msPerRepetition = 1.0;
+            settings.warmupMs = 5.0;
+            blocks = { 256 };
+        }
+        if (args.containsOption("--filter")) { settings.filter = args.getValueForOption("--filter"); }
+
+        BenchHarness::Report report(settings);
+        juce::Random random(42);
+        all<float>(report, blocks, random);
+        all<double>(report, blocks, random);
+
+        if (args.containsOption("--json"))
+        {
+            auto const file = args.getFileForOption("--json");
+            if (! report.writeJson(file)) { juce::ConsoleApplication::fail("couldn't write " + file.getFullPathName()); }
+            std::printf("wrote %d results to %s\n", static_cast<int>(report.results.size()), file.getFullPathName().toRawUTF8());
+        }
+    }
+};
+
+#endif // REDSP_PROCESSORBENCH_HEADERGUARD
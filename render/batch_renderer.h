@@ -0,0 +1,248 @@
+#ifndef REDSP_BATCHRENDERER_HEADERGUARD
+#define REDSP_BATCHRENDERER_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "render_chain.h"
+#include "render_io.h"
+#include "render_pool.h"
+#include "renderer.h"
+
+#pragma once
+
+/**
+ * Renders a whole list of files on every core. Each channel of each file is a task of its own: it maps the input a
+ * window at a time, runs its channel's chain over the window and writes the result into its place in the output
+ * through a MappedSink, so channels of the same file run on different threads. Every window is read into a scratch
+ * buffer leased from a RenderPool, and unmapped before the lease goes back, so however many files there are, audio
+ * never takes more than Settings::memoryBytes: each of the pool's slots is a scratch buffer plus an input and an
+ * output window, windowBytes each (and up to a page more for the mapping's alignment).
+ */
+struct BatchRenderer
+{
+    struct Settings
+    {
+        juce::String chain;
+        //! 0 for one per core
+        int threads = 0;
+        int block = 1024;
+        std::int64_t memoryBytes = std::int64_t(256) << 20;
+        std::int64_t windowBytes = std::int64_t(4) << 20;
+        RenderFormat::Encoding encoding = RenderFormat::Encoding::float32;
+        //! the format of inputs that aren't WAV files, whose channels and sample rate are taken from it too
+        RenderFormat raw;
+    };
+
+    struct Item
+    {
+        juce::File input, output;
+        int channels = 0;
+        Renderer::Stats stats;
+        juce::String error;
+
+        bool ok() const { return error.isEmpty(); }
+    };
+
+    struct Summary
+    {
+        std::vector<Item> items;
+        std::int64_t frames = 0;
+        double seconds = 0, elapsed = 0;
+        int threads = 0, failures = 0;
+        size_t slots = 0, peakSlots = 0;
+
+        //! seconds of audio rendered per second of wall-clock time, over every file
+        double realtime() const { return elapsed > 0 ? seconds / elapsed : 0.0; }
+    };
+
+    /**
+     * Renders each of `@param inputs` to the file of the same name in `@param directory`, WAV files to WAV and anything
+     * else (read as settings.raw) to headerless files. Files that fail are reported in their Item and don't stop the
+     * rest.
+     */
+    static Summary render(juce::Array<juce::File> const& inputs, juce::File const& directory, Settings const& settings)
+    {
+        auto const slotBytes = 3 * std::max<std::int64_t>(settings.windowBytes, 64);
+        RenderPool pool(static_cast<size_t>(std::max<std::int64_t>(1, settings.memoryBytes / slotBytes)),
+                        static_cast<size_t>(slotBytes / 3) / sizeof(float));
+
+        std::vector<std::unique_ptr<Job>> jobs;
+        std::vector<Task> tasks;
+        for (auto const& input : inputs)
+        {
+            jobs.push_back(std::make_unique<Job>());
+            auto& job = *jobs.back();
+            job.item.input = input;
+            job.item.output = directory.getChildFile(input.getFileName());
+            job.wav = isWav(input);
+            if (job.item.output == input)
+            {
+                job.item.error = input.getFileName() + ": would overwrite itself";
+                continue;
+            }
+            if (! job.open(job.header, settings)) { continue; }
+
+            job.out = job.header.getFormat();
+            job.out.encoding = settings.encoding;
+            job.item.channels = job.out.channels;
+            job.item.stats.sampleRate = job.out.sampleRate;
+            job.item.stats.frames = job.header.lengthInFrames();
+            job.frames = framesPerWindow(job.header.getFormat(), job.out, pool.floatsPerSlot(), settings.block);
+            if (! job.chain.parse(settings.chain, job.out.sampleRate, job.out.channels))
+            {
+                job.item.error = job.chain.error;
+                continue;
+            }
+            job.remaining = job.out.channels;
+            for (int c = 0; c < job.out.channels; ++c) { tasks.push_back({ &job, c }); }
+        }
+
+        Summary summary;
+        summary.threads = settings.threads > 0 ? settings.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        summary.slots = pool.slots();
+
+        using clock = std::chrono::steady_clock;
+        std::atomic<size_t> next { 0 };
+        auto const start = clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < summary.threads; ++t)
+        {
+            workers.emplace_back([&]
+            {
+                redsp::scoped_denormal_disable ftz;
+                for (auto i = next++; i < tasks.size(); i = next++) { run(tasks[i], pool, settings); }
+            });
+        }
+        for (auto& w : workers) { w.join(); }
+        summary.elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        summary.peakSlots = pool.peakInUse();
+
+        for (auto& job : jobs)
+        {
+            auto item = job->item;
+            if (item.ok())
+            {
+                summary.frames += item.stats.frames;
+                summary.seconds += item.stats.seconds();
+            }
+            else
+            {
+                ++summary.failures;
+            }
+            summary.items.push_back(item);
+        }
+        return summary;
+    }
+
+    static bool isWav(juce::File const& f) { return f.hasFileExtension("wav;wave"); }
+
+private:
+    //! one file: what every task on it shares
+    struct Job
+    {
+        Item item;
+        bool wav = false;
+        MappedSource header;
+        RenderFormat out;
+        RenderChain chain;
+        MappedSink sink;
+        int frames = 0;
+        std::once_flag created;
+        bool ready = false;
+        //! guards item, remaining and begun
+        std::mutex mutex;
+        int remaining = 0;
+        std::chrono::steady_clock::time_point begun;
+
+        //! opens the input in `@param source`, or fails the job
+        bool open(MappedSource& source, Settings const& settings)
+        {
+            if (wav ? source.openWav(item.input) : source.openRaw(item.input, settings.raw)) { return true; }
+            fail(source.error);
+            return false;
+        }
+
+        void fail(juce::String const& why)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (item.error.isEmpty()) { item.error = why; }
+        }
+
+        bool failed()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return item.error.isNotEmpty();
+        }
+    };
+
+    struct Task
+    {
+        Job* job;
+        int channel;
+    };
+
+    /**
+     * Frames per window: as many as fit in a slot's scratch and in windowBytes of input and of output, rounded down
+     * to whole blocks so the chain sees the same blocks as it would rendering the file on its own.
+     */
+    static int framesPerWindow(RenderFormat const& in, RenderFormat const& out, size_t floats, int block)
+    {
+        auto const bytes = static_cast<std::int64_t>(floats * sizeof(float));
+        auto frames = std::min<std::int64_t>({ static_cast<std::int64_t>(floats), bytes / in.bytesPerFrame(), bytes / out.bytesPerFrame() });
+        if (frames >= block) { frames -= frames % block; }
+        return static_cast<int>(std::max<std::int64_t>(1, frames));
+    }
+
+    static void run(Task const& task, RenderPool& pool, Settings const& settings)
+    {
+        auto& job = *task.job;
+        std::call_once(job.created, [&]
+        {
+            job.ready = job.sink.create(job.item.output, job.out, job.wav, job.header.lengthInFrames());
+            if (! job.ready) { job.fail(job.sink.error); }
+            job.header.close();
+        });
+
+        auto const started = std::chrono::steady_clock::now();
+        MappedSource source;
+        if (job.ready && ! job.failed() && job.open(source, settings))
+        {
+            source.windowBytes = static_cast<std::int64_t>(job.frames) * source.getFormat().bytesPerFrame();
+            auto& chain = job.chain.channels[static_cast<size_t>(task.channel)];
+            juce::String why;
+            for (std::int64_t at = 0; at < source.lengthInFrames() && ! job.failed();)
+            {
+                auto lease = pool.acquire();
+                auto const n = source.readChannel(task.channel, lease.data(), job.frames);
+                if (n > 0)
+                {
+                    for (int i = 0; i < n; i += settings.block) { chain.process(lease.data() + i, std::min(settings.block, n - i)); }
+                    if (! job.sink.writeChannel(task.channel, at, lease.data(), n, why)) { job.fail(why); }
+                }
+                else
+                {
+                    job.fail(source.error.isNotEmpty() ? source.error : job.item.input.getFileName() + ": ended early");
+                }
+                // unmapped before the lease goes back, so the window counts against the pool
+                source.release();
+                at += n;
+            }
+        }
+
+        // the file took from its first channel's start to its last channel's end
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (job.remaining == job.out.channels || started < job.begun) { job.begun = started; }
+        if (--job.remaining == 0)
+        {
+            job.item.stats.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.begun).count();
+        }
+    }
+};
+
+#endif // REDSP_BATCHRENDERER_HEADERGUARD
@@ -0,0 +1,145 @@
+#include <juce_core/juce_core.h>
+#include "../source/redsp.h"
+#include "render_chain.h"
+#include "render_io.h"
+#include "renderer.h"
+#include "batch_renderer.h"
+
+namespace {
+
+//! the arguments that aren't options, in order
+juce::StringArray positional(juce::ArgumentList const& args)
+{
+  juce::StringArray list;
+  for (auto const& a : args.arguments) { if (! a.isOption()) { list.add(a.text); } }
+  return list;
+}
+
+bool isWav(juce::File const& f) { return BatchRenderer::isWav(f); }
+
+//! --raw, --channels and --rate, or false if --raw isn't a known encoding
+bool rawFormat(juce::ArgumentList const& args, RenderFormat& raw)
+{
+  if (args.containsOption("--channels")) { raw.channels = args.getValueForOption("--channels").getIntValue(); }
+  if (args.containsOption("--rate")) { raw.sampleRate = args.getValueForOption("--rate").getDoubleValue(); }
+  return RenderFormat::parse(args.getValueForOption("--raw"), raw.encoding);
+}
+
+RenderFormat::Encoding outEncoding(juce::ArgumentList const& args)
+{
+  auto encoding = RenderFormat::Encoding::float32;
+  if (args.containsOption("--out") && ! RenderFormat::parse(args.getValueForOption("--out"), encoding))
+  {
+    juce::ConsoleApplication::fail("--out must be s16, s24, s32, f32 or f64");
+  }
+  return encoding;
+}
+
+void render(juce::ArgumentList const& args)
+{
+  auto const files = positional(args);
+  if (files.size() != 2) { juce::ConsoleApplication::fail("expected an input and an output file (see --help)"); }
+  auto const in = juce::File::getCurrentWorkingDirectory().getChildFile(files[0]);
+  auto const output = juce::File::getCurrentWorkingDirectory().getChildFile(files[1]);
+
+  MappedSource source;
+  if (args.containsOption("--window")) { source.windowBytes = juce::jmax<std::int64_t>(1, args.getValueForOption("--window").getLargeIntValue()) << 20; }
+  if (args.containsOption("--raw") || ! isWav(in))
+  {
+    RenderFormat raw;
+    if (! rawFormat(args, raw)) { juce::ConsoleApplication::fail("--raw=<s16|s24|s32|f32|f64> is needed for anything but WAV input"); }
+    if (! source.openRaw(in, raw)) { juce::ConsoleApplication::fail(source.error); }
+  }
+  else if (! source.openWav(in))
+  {
+    juce::ConsoleApplication::fail(source.error);
+  }
+
+  auto const block = args.containsOption("--block") ? juce::jmax(1, args.getValueForOption("--block").getIntValue()) : 1024;
+  auto format = source.getFormat();
+  format.encoding = outEncoding(args);
+
+  RenderChain chain;
+  if (! chain.parse(args.getValueForOption("--chain"), format.sampleRate, format.channels)) { juce::ConsoleApplication::fail(chain.error); }
+
+  StreamSink sink;
+  if (! sink.open(output, format, isWav(output), block)) { juce::ConsoleApplication::fail(sink.error); }
+
+  Renderer::Stats stats;
+  juce::String error;
+  if (! Renderer::render(source, chain, sink, block, stats, error)) { juce::ConsoleApplication::fail(error); }
+  if (! sink.close()) { juce::ConsoleApplication::fail(sink.error); }
+
+  std::printf("%s -> %s: %d channels, %s in, %s out, %.2fs of audio in %.3fs, %.1fx realtime\n",
+              in.getFileName().toRawUTF8(), output.getFileName().toRawUTF8(), format.channels,
+              RenderFormat::name(source.getFormat().encoding), RenderFormat::name(format.encoding), stats.seconds(),
+              stats.elapsed, stats.realtime());
+}
+
+void batch(juce::ArgumentList const& args)
+{
+  auto const directories = positional(args);
+  if (directories.size() != 2) { juce::ConsoleApplication::fail("expected an input and an output directory (see --help)"); }
+  auto const from = juce::File::getCurrentWorkingDirectory().getChildFile(directories[0]);
+  auto const to = juce::File::getCurrentWorkingDirectory().getChildFile(directories[1]);
+  if (! from.isDirectory()) { juce::ConsoleApplication::fail(from.getFullPathName() + " isn't a directory"); }
+  if (! to.createDirectory()) { juce::ConsoleApplication::fail("can't create " + to.getFullPathName()); }
+
+  BatchRenderer::Settings settings;
+  settings.chain = args.getValueForOption("--chain");
+  settings.encoding = outEncoding(args);
+  auto const raw = args.containsOption("--raw");
+  if (raw && ! rawFormat(args, settings.raw)) { juce::ConsoleApplication::fail("--raw must be s16, s24, s32, f32 or f64"); }
+  if (args.containsOption("--threads")) { settings.threads = juce::jmax(1, args.getValueForOption("--threads").getIntValue()); }
+  if (args.containsOption("--block")) { settings.block = juce::jmax(1, args.getValueForOption("--block").getIntValue()); }
+  if (args.containsOption("--memory")) { settings.memoryBytes = juce::jmax<std::int64_t>(1, args.getValueForOption("--memory").getLargeIntValue()) << 20; }
+  if (args.containsOption("--window")) { settings.windowBytes = juce::jmax<std::int64_t>(1, args.getValueForOption("--window").getLargeIntValue()) << 20; }
+
+  RenderChain check;
+  if (! check.parse(settings.chain, 48000.0, 1)) { juce::ConsoleApplication::fail(check.error); }
+
+  auto inputs = from.findChildFiles(juce::File::findFiles, false, raw ? "*.wav;*.wave;*.raw" : "*.wav;*.wave");
+  inputs.sort();
+  auto const summary = BatchRenderer::render(inputs, to, settings);
+  for (auto const& item : summary.items)
+  {
+    if (item.ok())
+    {
+      std::printf("%s: %d channels, %.2fs of audio in %.3fs\n", item.input.getFileName().toRawUTF8(), item.channels,
+                  item.stats.seconds(), item.stats.elapsed);
+    }
+    else
+    {
+      std::printf("failed: %s\n", item.error.toRawUTF8());
+    }
+  }
+  std::printf("%d files, %d failed: %.2fs of audio in %.3fs, %.1fx realtime on %d threads, %d of %d %.1fMiB slots in use at most\n",
+              static_cast<int>(summary.items.size()), summary.failures, summary.seconds, summary.elapsed, summary.realtime(),
+              summary.threads, static_cast<int>(summary.peakSlots), static_cast<int>(summary.slots),
+              3.0 * static_cast<double>(settings.windowBytes) / (1 << 20));
+  if (summary.failures > 0) { juce::ConsoleApplication::fail("some files failed"); }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  juce::ConsoleApplication app;
+
+  app.addHelpCommand("--help|-h", "use", true);
+  app.addDefaultCommand({"", "<input> <output> --chain=<stages> [--raw=<encoding> --channels=<n> --rate=<hz>] [--out=<encoding>] [--block=<n>] [--window=<MiB>]",
+                         "Streams a WAV or raw file through a chain of redsp processors and reports the speed in x realtime",
+                         "The chain is stages separated by ',', each of biquad:<lp|hp|bp|br|ap>:<Hz>[:<Q>], svf:<lp|hp|bp>:<Hz>[:<Q>] "
+                         "or gain:<dB>, e.g. --chain=biquad:hp:30,svf:lp:4000:2,gain:-3.\n"
+                         "Input that isn't .wav is headerless interleaved samples in --raw (s16, s24, s32, f32 or f64), with "
+                         "--channels (2) and --rate (48000). The output is WAV if it ends in .wav, otherwise raw, in --out (f32). "
+                         "The input is memory-mapped --window MiB (16) at a time and processed in blocks of --block frames (1024).",
+                         [](juce::ArgumentList const& args){ render(args); } });
+  app.addCommand({"--batch|-b", "--batch <input directory> <output directory> --chain=<stages> [--threads=<n>] [--memory=<MiB>] [--window=<MiB>] [--raw=<encoding> ...] [--out=<encoding>] [--block=<n>]",
+                  "Renders every WAV file in a directory (and .raw files, with --raw) on all cores, within a fixed memory budget",
+                  "Every channel of every file is a task of its own, run on --threads threads (one per core). The audio in flight "
+                  "never takes more than --memory MiB (256), in slots of three --window MiB (4) buffers: a scratch buffer, and an "
+                  "input and an output window mapped from the files. The chain and the other options are as for a single file.",
+                  [](juce::ArgumentList const& args){ batch(args); } });
+  return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,149 @@
+#ifndef REDSP_RENDERCHAIN_HEADERGUARD
+#define REDSP_RENDERCHAIN_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "../source/redsp.h"
+
+#pragma once
+
+/**
+ * The processors redsp_render runs, from a text description: stages separated by ',', each a processor name and its
+ * parameters separated by ':'.
+ *  - biquad:<lp|hp|bp|br|ap>:<cutoff Hz>[:<Q>]
+ *  - svf:<lp|hp|bp>:<cutoff Hz>[:<Q>]
+ *  - gain:<dB>
+ * Q is 0.7071 unless given. Every channel gets its own copy of the chain, so channels can be processed independently.
+ * Biquads keep double state when their cutoff is low enough for float's rounding to show (see float_state_suffices).
+ */
+struct RenderChain
+{
+    using Stage = std::function<void(float*, int)>;
+
+    //! one channel's stages, run in order
+    struct Channel
+    {
+        std::vector<Stage> stages;
+
+        void process(float* samples, int count)
+        {
+            for (auto& stage : stages) { stage(samples, count); }
+        }
+    };
+
+    std::vector<Channel> channels;
+    //! the description, as parsed
+    juce::String description;
+    //! why parse() failed
+    juce::String error;
+
+    /**
+     * Builds the chain described by `@param text` for `@param channelCount` channels at `@param fs`, replacing
+     * what was there. Returns false, with the reason in error, if the description doesn't make sense.
+     */
+    bool parse(juce::String const& text, double fs, int channelCount)
+    {
+        channels.assign(static_cast<size_t>(juce::jmax(channelCount, 0)), Channel {});
+        description = text;
+        error.clear();
+
+        for (auto const& stage : juce::StringArray::fromTokens(text, ",", ""))
+        {
+            auto const fields = juce::StringArray::fromTokens(stage.trim(), ":", "");
+            if (fields.isEmpty() || fields[0].isEmpty()) { continue; }
+            Stage prototype;
+            if (! build(fields, fs, prototype)) { return false; }
+            // each channel copies the prototype, state and all, while it's still fresh
+            for (auto& c : channels) { c.stages.push_back(prototype); }
+        }
+        return true;
+    }
+
+    void process(float* const* samples, int count)
+    {
+        for (size_t c = 0; c < channels.size(); ++c) { channels[c].process(samples[c], count); }
+    }
+
+private:
+    bool fail(juce::String const& why)
+    {
+        error = why;
+        return false;
+    }
+
+    //! reads parameter `@param i` of `@param fields` into `@param value`, or `@param fallback` if it isn't there
+    bool number(juce::StringArray const& fields, int i, double fallback, double& value)
+    {
+        if (i >= fields.size())
+        {
+            value = fallback;
+            return ! std::isnan(fallback) || fail(fields.joinIntoString(":") + ": missing parameter " + juce::String(i));
+        }
+        auto const text = fields[i].trim();
+        if (! text.containsOnly("0123456789.-+eE") || text.isEmpty()) { return fail(fields.joinIntoString(":") + ": '" + text + "' isn't a number"); }
+        value = text.getDoubleValue();
+        return true;
+    }
+
+    template <typename Precision>
+    bool biquad(juce::String const& type, double fc, double fs, double q, juce::String const& whole, Stage& stage)
+    {
+        redsp::biquad_with<Precision> f;
+        if (type == "lp") { f.calc_lp(fc, fs, q); }
+        else if (type == "hp") { f.calc_hp(fc, fs, q); }
+        else if (type == "bp") { f.calc_bp(fc, fs, q); }
+        else if (type == "br") { f.calc_br(fc, fs, q); }
+        else if (type == "ap") { f.calc_ap(fc, fs, q); }
+        else { return fail(whole + ": biquads are lp, hp, bp, br or ap"); }
+        f.reset();
+        stage = [f](float* x, int count) mutable { f.process_optimized(x, count); };
+        return true;
+    }
+
+    bool build(juce::StringArray const& fields, double fs, Stage& stage)
+    {
+        auto const name = fields[0].trim().toLowerCase();
+        auto const type = fields[1].trim().toLowerCase();
+        auto const nan = std::numeric_limits<double>::quiet_NaN();
+        auto const whole = fields.joinIntoString(":");
+
+        if (name == "gain")
+        {
+            double db;
+            if (! number(fields, 1, nan, db)) { return false; }
+            auto const g = static_cast<float>(std::pow(10.0, db / 20.0));
+            stage = [g](float* x, int count) { for (int i = 0; i < count; ++i) { x[i] *= g; } };
+            return true;
+        }
+
+        double fc, q;
+        if (! number(fields, 2, nan, fc) || ! number(fields, 3, 0.7071, q)) { return false; }
+        if (! (fc > 0 && fc < 0.5 * fs)) { return fail(whole + ": the cutoff must be between 0 and " + juce::String(0.5 * fs) + "Hz"); }
+        if (! (q > 0)) { return fail(whole + ": Q must be positive"); }
+
+        if (name == "biquad")
+        {
+            // float state where its rounding stays under -100dB, double where the poles sit too close to DC for that
+            if (redsp::float_state_suffices(fc / fs, q)) { return biquad<redsp::single_precision>(type, fc, fs, q, whole, stage); }
+            return biquad<redsp::mixed_precision>(type, fc, fs, q, whole, stage);
+        }
+        if (name == "svf")
+        {
+            using svf_type = redsp::svf<float, 1, double>;
+            svf_type f(fs);
+            f.calc_unsafe(fc, q);
+            if (f.f1 >= 2 - f.q1) { return fail(whole + ": unstable at this cutoff and Q"); }
+            if (type == "lp") { stage = [f](float* x, int count) mutable { f.process<svf_type::SVFType::Lowpass>(x, count); }; }
+            else if (type == "hp") { stage = [f](float* x, int count) mutable { f.process<svf_type::SVFType::Highpass>(x, count); }; }
+            else if (type == "bp") { stage = [f](float* x, int count) mutable { f.process<svf_type::SVFType::Bandpass>(x, count); }; }
+            else { return fail(whole + ": svfs are lp, hp or bp"); }
+            return true;
+        }
+        return fail(whole + ": unknown processor '" + name + "' (biquad, svf or gain)");
+    }
+};
+
+#endif // REDSP_RENDERCHAIN_HEADERGUARD
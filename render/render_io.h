@@ -0,0 +1,496 @@
+#ifndef REDSP_RENDERIO_HEADERGUARD
+#define REDSP_RENDERIO_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#pragma once
+
+/**
+ * File input and output for redsp_render, in blocks: MappedSource memory-maps a WAV or headerless file a window at a
+ * time and converts to planar float, and StreamSink converts planar float back and streams it out. Neither ever holds
+ * more than a window (in) or a block (out) of a file. MappedSink writes through mapped windows instead, a channel at a
+ * time, for the batch renderer.
+ */
+struct RenderFormat
+{
+    enum class Encoding { int16, int24, int32, float32, float64 };
+
+    Encoding encoding = Encoding::float32;
+    int channels = 2;
+    double sampleRate = 48000.0;
+
+    int bytesPerSample() const
+    {
+        switch (encoding)
+        {
+            case Encoding::int16: return 2;
+            case Encoding::int24: return 3;
+            case Encoding::int32: return 4;
+            case Encoding::float32: return 4;
+            case Encoding::float64: return 8;
+        }
+        return 0;
+    }
+
+    int bytesPerFrame() const { return bytesPerSample() * channels; }
+    bool isFloat() const { return encoding == Encoding::float32 || encoding == Encoding::float64; }
+
+    static constexpr int wavHeaderBytes = 44;
+
+    //! a plain WAV header, PCM or float, for `@param frames` frames in this format
+    void writeWavHeader(juce::OutputStream& out, std::int64_t frames) const
+    {
+        auto const data = frames * bytesPerFrame();
+        auto const clamp = [](std::int64_t v) { return static_cast<int>(static_cast<std::uint32_t>(std::min<std::int64_t>(v, 0xffffffff))); };
+        out.write("RIFF", 4);
+        out.writeInt(clamp(wavHeaderBytes - 8 + data + (data & 1)));
+        out.write("WAVEfmt ", 8);
+        out.writeInt(16);
+        out.writeShort(isFloat() ? 3 : 1);
+        out.writeShort(static_cast<short>(channels));
+        out.writeInt(static_cast<int>(sampleRate));
+        out.writeInt(static_cast<int>(sampleRate) * bytesPerFrame());
+        out.writeShort(static_cast<short>(bytesPerFrame()));
+        out.writeShort(static_cast<short>(8 * bytesPerSample()));
+        out.write("data", 4);
+        out.writeInt(clamp(data));
+    }
+
+    //! "s16", "s24", "s32", "f32" or "f64"
+    static char const* name(Encoding e)
+    {
+        switch (e)
+        {
+            case Encoding::int16: return "s16";
+            case Encoding::int24: return "s24";
+            case Encoding::int32: return "s32";
+            case Encoding::float32: return "f32";
+            case Encoding::float64: return "f64";
+        }
+        return "";
+    }
+
+    //! the encoding called `@param text` (as name() gives it) in `@param e`, or false if there's none
+    static bool parse(juce::String const& text, Encoding& e)
+    {
+        for (auto candidate : { Encoding::int16, Encoding::int24, Encoding::int32, Encoding::float32, Encoding::float64 })
+        {
+            if (text.equalsIgnoreCase(name(candidate)))
+            {
+                e = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! one sample at `@param p`, little-endian, as float
+    static float decode(Encoding e, std::uint8_t const* p)
+    {
+        switch (e)
+        {
+            case Encoding::int16: return static_cast<float>(static_cast<std::int16_t>(juce::ByteOrder::littleEndianShort(p))) * (1.0f / 32768.0f);
+            case Encoding::int24: return static_cast<float>(juce::ByteOrder::littleEndian24Bit(p)) * (1.0f / 8388608.0f);
+            case Encoding::int32: return static_cast<float>(static_cast<double>(static_cast<std::int32_t>(juce::ByteOrder::littleEndianInt(p))) * (1.0 / 2147483648.0));
+            case Encoding::float32:
+            {
+                auto const bits = juce::ByteOrder::littleEndianInt(p);
+                float f;
+                std::memcpy(&f, &bits, sizeof(f));
+                return f;
+            }
+            case Encoding::float64:
+            {
+                auto const bits = juce::ByteOrder::littleEndianInt64(p);
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                return static_cast<float>(d);
+            }
+        }
+        return 0;
+    }
+
+    //! writes `@param x` to `@param p`, little-endian, rounding and clipping to the integer encodings' range
+    static void encode(Encoding e, float x, std::uint8_t* p)
+    {
+        auto const integer = [x](double scale)
+        {
+            auto const v = std::round(static_cast<double>(x) * scale);
+            return static_cast<std::int32_t>(std::max(-scale, std::min(scale - 1.0, v)));
+        };
+        auto const store = [p](std::uint64_t bits, int bytes)
+        {
+            for (int i = 0; i < bytes; ++i) { p[i] = static_cast<std::uint8_t>(bits >> (8 * i)); }
+        };
+        switch (e)
+        {
+            case Encoding::int16: store(static_cast<std::uint16_t>(integer(32768.0)), 2); break;
+            case Encoding::int24: juce::ByteOrder::littleEndian24BitToChars(integer(8388608.0), p); break;
+            case Encoding::int32: store(static_cast<std::uint32_t>(integer(2147483648.0)), 4); break;
+            case Encoding::float32:
+            {
+                std::uint32_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                store(bits, 4);
+                break;
+            }
+            case Encoding::float64:
+            {
+                auto const d = static_cast<double>(x);
+                std::uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                store(bits, 8);
+                break;
+            }
+        }
+    }
+};
+
+/**
+ * Reads interleaved samples out of a file through a memory-mapped window that slides along it, so only the window
+ * (windowBytes, 16MiB by default) is ever mapped, however long the file.
+ */
+struct MappedSource
+{
+    std::int64_t windowBytes = std::int64_t(16) << 20;
+    //! why open() or read() failed
+    juce::String error;
+
+    //! opens WAV file `@param f` (PCM or float, plain or extensible), taking the format from its header
+    bool openWav(juce::File const& f)
+    {
+        close();
+        file = f;
+        juce::FileInputStream in(file);
+        if (in.failedToOpen()) { return fail("can't open " + file.getFullPathName()); }
+
+        char id[4];
+        if (in.read(id, 4) != 4 || std::memcmp(id, "RIFF", 4) != 0) { return fail("not a RIFF file"); }
+        in.readInt();
+        if (in.read(id, 4) != 4 || std::memcmp(id, "WAVE", 4) != 0) { return fail("not a WAVE file"); }
+
+        bool haveFormat = false;
+        while (! in.isExhausted())
+        {
+            if (in.read(id, 4) != 4) { break; }
+            auto const size = static_cast<std::int64_t>(static_cast<std::uint32_t>(in.readInt()));
+            auto const start = in.getPosition();
+
+            if (std::memcmp(id, "fmt ", 4) == 0)
+            {
+                auto tag = static_cast<std::uint16_t>(in.readShort());
+                format.channels = in.readShort();
+                format.sampleRate = static_cast<double>(in.readInt());
+                in.readInt();
+                in.readShort();
+                auto const bits = in.readShort();
+                if (tag == 0xfffe && size >= 40)
+                {
+                    in.readShort();
+                    in.readShort();
+                    in.readInt();
+                    tag = static_cast<std::uint16_t>(in.readShort());
+                }
+                if (tag == 1 && bits == 16) { format.encoding = RenderFormat::Encoding::int16; }
+                else if (tag == 1 && bits == 24) { format.encoding = RenderFormat::Encoding::int24; }
+                else if (tag == 1 && bits == 32) { format.encoding = RenderFormat::Encoding::int32; }
+                else if (tag == 3 && bits == 32) { format.encoding = RenderFormat::Encoding::float32; }
+                else if (tag == 3 && bits == 64) { format.encoding = RenderFormat::Encoding::float64; }
+                else { return fail("unsupported WAV encoding (format " + juce::String(tag) + ", " + juce::String(bits) + " bits)"); }
+                if (format.channels < 1) { return fail("WAV file has no channels"); }
+                haveFormat = true;
+            }
+            else if (std::memcmp(id, "data", 4) == 0)
+            {
+                if (! haveFormat) { return fail("WAV data before its format"); }
+                // streamed files may leave the size at 0 or ~0: take the rest of the file then
+                auto const available = file.getSize() - start;
+                return setData(start, size == 0 || size > available ? available : size);
+            }
+            in.setPosition(start + size + (size & 1));
+        }
+        return fail("no WAV data");
+    }
+
+    //! opens `@param f` as headerless interleaved samples in `@param raw`
+    bool openRaw(juce::File const& f, RenderFormat const& raw)
+    {
+        close();
+        file = f;
+        format = raw;
+        if (! file.existsAsFile()) { return fail("can't open " + file.getFullPathName()); }
+        if (format.channels < 1) { return fail("raw input needs at least one channel"); }
+        return setData(0, file.getSize());
+    }
+
+    void close()
+    {
+        window.reset();
+        dataStart = dataFrames = position = windowStart = windowFrames = 0;
+        error.clear();
+    }
+
+    RenderFormat const& getFormat() const { return format; }
+    std::int64_t lengthInFrames() const { return dataFrames; }
+    std::int64_t getPosition() const { return position; }
+
+    /**
+     * Converts the next `@param frames` frames (fewer at the end) into `@param channels`, one pointer per channel of
+     * the format, and returns how many it converted: 0 at the end, and -1 if mapping the file failed.
+     */
+    int read(float* const* channels, int frames)
+    {
+        auto const bytesPerSample = format.bytesPerSample();
+        return convert(frames, [&](std::uint8_t const* frame, int i)
+        {
+            for (int c = 0; c < format.channels; ++c)
+            {
+                channels[c][i] = RenderFormat::decode(format.encoding, frame + c * bytesPerSample);
+            }
+        });
+    }
+
+    //! as read(), but only converts `@param channel` into `@param samples`, skipping over the others
+    int readChannel(int channel, float* samples, int frames)
+    {
+        auto const offset = channel * format.bytesPerSample();
+        return convert(frames, [&](std::uint8_t const* frame, int i)
+        {
+            samples[i] = RenderFormat::decode(format.encoding, frame + offset);
+        });
+    }
+
+    //! unmaps the window, until the next read needs it
+    void release()
+    {
+        window.reset();
+        windowStart = windowFrames = 0;
+    }
+
+private:
+    juce::File file;
+    RenderFormat format;
+    std::int64_t dataStart = 0, dataFrames = 0, position = 0;
+    std::unique_ptr<juce::MemoryMappedFile> window;
+    std::uint8_t const* windowData = nullptr;
+    std::int64_t windowStart = 0, windowFrames = 0;
+
+    bool fail(juce::String const& why)
+    {
+        error = file.getFileName() + ": " + why;
+        return false;
+    }
+
+    bool setData(std::int64_t start, std::int64_t bytes)
+    {
+        dataStart = start;
+        dataFrames = bytes / format.bytesPerFrame();
+        return true;
+    }
+
+    //! runs `@param store` (frame bytes, index) over the next `@param frames` frames, mapping windows as it goes
+    template <typename Store>
+    int convert(int frames, Store&& store)
+    {
+        auto const count = static_cast<int>(std::min<std::int64_t>(frames, dataFrames - position));
+        auto const bytesPerFrame = format.bytesPerFrame();
+        int done = 0;
+        while (done < count)
+        {
+            if (position < windowStart || position >= windowStart + windowFrames)
+            {
+                if (! map(position)) { return -1; }
+            }
+            auto const n = static_cast<int>(std::min<std::int64_t>(count - done, windowStart + windowFrames - position));
+            auto const* frame = windowData + (position - windowStart) * bytesPerFrame;
+            for (int i = 0; i < n; ++i, frame += bytesPerFrame) { store(frame, done + i); }
+            done += n;
+            position += n;
+        }
+        return done;
+    }
+
+    //! maps the window that starts at frame `@param frame`
+    bool map(std::int64_t frame)
+    {
+        auto const bytesPerFrame = format.bytesPerFrame();
+        windowStart = frame;
+        windowFrames = std::min(std::max<std::int64_t>(1, windowBytes / bytesPerFrame), dataFrames - frame);
+        auto const begin = dataStart + frame * bytesPerFrame;
+        juce::Range<juce::int64> const range(begin, begin + windowFrames * bytesPerFrame);
+
+        window.reset();
+        window = std::make_unique<juce::MemoryMappedFile>(file, range, juce::MemoryMappedFile::readOnly);
+        if (window->getData() == nullptr)
+        {
+            windowFrames = 0;
+            return fail("can't map bytes " + juce::String(range.getStart()) + " to " + juce::String(range.getEnd()));
+        }
+        // the mapping starts on a page boundary, at or before the one asked for
+        windowData = static_cast<std::uint8_t const*>(window->getData()) + (begin - window->getRange().getStart());
+        return true;
+    }
+};
+
+/**
+ * Writes planar float out as interleaved samples in a RenderFormat, as a WAV file or headerless, a block at a time.
+ * A WAV file's sizes are filled in by close().
+ */
+struct StreamSink
+{
+    juce::String error;
+
+    /**
+     * Creates `@param f` (replacing it), to take up to `@param maxFrames` frames per write() in `@param format`, with a
+     * WAV header if `@param wav`.
+     */
+    bool open(juce::File const& f, RenderFormat const& fmt, bool wav, int maxFrames)
+    {
+        file = f;
+        format = fmt;
+        isWav = wav;
+        frames = 0;
+        error.clear();
+        scratch.assign(static_cast<size_t>(std::max(maxFrames, 1) * format.bytesPerFrame()), 0);
+
+        file.deleteFile();
+        out = std::make_unique<juce::FileOutputStream>(file);
+        if (out->failedToOpen()) { return fail("can't create " + file.getFullPathName()); }
+        if (isWav) { format.writeWavHeader(*out, frames); }
+        return ok();
+    }
+
+    //! converts and writes `@param count` frames of `@param channels`
+    bool write(float const* const* channels, int count)
+    {
+        auto const bytesPerFrame = format.bytesPerFrame(), bytesPerSample = format.bytesPerSample();
+        auto const maxFrames = static_cast<int>(scratch.size()) / bytesPerFrame;
+        for (int done = 0; done < count;)
+        {
+            auto const n = std::min(count - done, maxFrames);
+            auto* frame = scratch.data();
+            for (int i = 0; i < n; ++i, frame += bytesPerFrame)
+            {
+                for (int c = 0; c < format.channels; ++c)
+                {
+                    RenderFormat::encode(format.encoding, channels[c][done + i], frame + c * bytesPerSample);
+                }
+            }
+            if (! out->write(scratch.data(), static_cast<size_t>(n * bytesPerFrame))) { return fail("write failed"); }
+            done += n;
+        }
+        frames += count;
+        return true;
+    }
+
+    //! finishes the file, filling in a WAV header's sizes
+    bool close()
+    {
+        if (out == nullptr) { return true; }
+        if (isWav)
+        {
+            if ((frames * format.bytesPerFrame()) & 1) { out->writeByte(0); }
+            out->setPosition(0);
+            format.writeWavHeader(*out, frames);
+        }
+        out->flush();
+        auto const status = out->getStatus();
+        out.reset();
+        return status.wasOk() || fail(status.getErrorMessage());
+    }
+
+    std::int64_t framesWritten() const { return frames; }
+
+private:
+    juce::File file;
+    RenderFormat format;
+    bool isWav = false;
+    std::int64_t frames = 0;
+    std::unique_ptr<juce::FileOutputStream> out;
+    std::vector<std::uint8_t> scratch;
+
+    bool fail(juce::String const& why)
+    {
+        error = file.getFileName() + ": " + why;
+        return false;
+    }
+
+    bool ok() { return out->getStatus().wasOk() || fail(out->getStatus().getErrorMessage()); }
+};
+
+/**
+ * Writes planar float into a file of known length through memory-mapped windows, one channel and one stretch at a
+ * time, so that several threads can fill in different channels of the same file at once. create() sizes the file and
+ * writes any WAV header up front.
+ */
+struct MappedSink
+{
+    juce::String error;
+
+    //! creates `@param f` (replacing it) to hold `@param frames` frames in `@param fmt`, with a WAV header if `@param wav`
+    bool create(juce::File const& f, RenderFormat const& fmt, bool wav, std::int64_t frames)
+    {
+        file = f;
+        format = fmt;
+        dataStart = wav ? RenderFormat::wavHeaderBytes : 0;
+        error.clear();
+
+        file.deleteFile();
+        juce::FileOutputStream out(file);
+        if (out.failedToOpen()) { return fail("can't create " + file.getFullPathName()); }
+        if (wav) { format.writeWavHeader(out, frames); }
+        auto const data = frames * format.bytesPerFrame();
+        auto const end = dataStart + data + (wav ? (data & 1) : 0);
+        if (end > dataStart)
+        {
+            out.setPosition(end - 1);
+            out.writeByte(0);
+        }
+        out.flush();
+        return out.getStatus().wasOk() || fail(out.getStatus().getErrorMessage());
+    }
+
+    /**
+     * Converts `@param count` samples into channel `@param channel` of the file, from frame `@param start` on. Calls
+     * that write different channels, or different frames, may run at the same time. Returns false with the reason in
+     * `@param why` if the file couldn't be mapped.
+     */
+    bool writeChannel(int channel, std::int64_t start, float const* samples, int count, juce::String& why) const
+    {
+        if (count <= 0) { return true; }
+        auto const bytesPerFrame = format.bytesPerFrame();
+        auto const begin = dataStart + start * bytesPerFrame;
+        juce::Range<juce::int64> const range(begin, begin + static_cast<std::int64_t>(count) * bytesPerFrame);
+        juce::MemoryMappedFile window(file, range, juce::MemoryMappedFile::readWrite);
+        if (window.getData() == nullptr)
+        {
+            why = file.getFileName() + ": can't map bytes " + juce::String(range.getStart()) + " to " + juce::String(range.getEnd());
+            return false;
+        }
+        auto* frame = static_cast<std::uint8_t*>(window.getData()) + (begin - window.getRange().getStart())
+                      + channel * format.bytesPerSample();
+        for (int i = 0; i < count; ++i, frame += bytesPerFrame) { RenderFormat::encode(format.encoding, samples[i], frame); }
+        return true;
+    }
+
+    RenderFormat const& getFormat() const { return format; }
+
+private:
+    juce::File file;
+    RenderFormat format;
+    std::int64_t dataStart = 0;
+
+    bool fail(juce::String const& why)
+    {
+        error = file.getFileName() + ": " + why;
+        return false;
+    }
+};
+
+#endif // REDSP_RENDERIO_HEADERGUARD
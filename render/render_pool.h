@@ -0,0 +1,82 @@
+#ifndef REDSP_RENDERPOOL_HEADERGUARD
+#define REDSP_RENDERPOOL_HEADERGUARD
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#pragma once
+
+/**
+ * A fixed number of scratch buffers, all allocated up front, that the batch renderer's tasks take turns with. A task
+ * holds a lease on one for as long as it has a window of a file mapped, so the number of buffers also bounds the
+ * number of windows mapped at once: when they're all out, acquire() waits for one to come back.
+ */
+struct RenderPool
+{
+    //! a buffer on loan, handed back when it's destroyed
+    struct Lease
+    {
+        Lease(RenderPool& p, size_t i) : pool(&p), index(i) { }
+        Lease(Lease&& other) noexcept : pool(other.pool), index(other.index) { other.pool = nullptr; }
+        ~Lease() { if (pool != nullptr) { pool->release(index); } }
+
+        Lease(Lease const&) = delete;
+        Lease& operator=(Lease const&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        float* data() const { return pool->buffers[index].data(); }
+        size_t size() const { return pool->buffers[index].size(); }
+
+    private:
+        RenderPool* pool;
+        size_t index;
+    };
+
+    //! `@param slots` buffers (at least one) of `@param floats` samples each
+    RenderPool(size_t slots, size_t floats)
+        : buffers(slots > 0 ? slots : 1, std::vector<float>(floats))
+    {
+        for (size_t i = buffers.size(); i > 0; --i) { available.push_back(i - 1); }
+    }
+
+    //! a free buffer, waiting for one if they're all on loan
+    Lease acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        returned.wait(lock, [this] { return ! available.empty(); });
+        auto const i = available.back();
+        available.pop_back();
+        peak = std::max(peak, buffers.size() - available.size());
+        return Lease(*this, i);
+    }
+
+    size_t slots() const { return buffers.size(); }
+    size_t floatsPerSlot() const { return buffers.front().size(); }
+
+    //! the most buffers that were ever on loan at once
+    size_t peakInUse() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return peak;
+    }
+
+private:
+    std::vector<std::vector<float>> buffers;
+    std::vector<size_t> available;
+    size_t peak = 0;
+    mutable std::mutex mutex;
+    std::condition_variable returned;
+
+    void release(size_t i)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            available.push_back(i);
+        }
+        returned.notify_one();
+    }
+};
+
+#endif // REDSP_RENDERPOOL_HEADERGUARD
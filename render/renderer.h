@@ -0,0 +1,67 @@
+#ifndef REDSP_RENDERER_HEADERGUARD
+#define REDSP_RENDERER_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <chrono>
+#include <vector>
+#include "render_chain.h"
+#include "render_io.h"
+
+#pragma once
+
+/**
+ * Streams one file through a RenderChain a block at a time: convert a block in from the source's mapped window, process
+ * it, convert it out to the sink. Denormals are flushed to zero throughout, as a host's audio thread would.
+ */
+struct Renderer
+{
+    struct Stats
+    {
+        std::int64_t frames = 0;
+        double sampleRate = 0, elapsed = 0;
+
+        double seconds() const { return sampleRate > 0 ? static_cast<double>(frames) / sampleRate : 0.0; }
+        //! seconds of audio rendered per second of wall-clock time
+        double realtime() const { return elapsed > 0 ? seconds() / elapsed : 0.0; }
+    };
+
+    /**
+     * Renders what's left of `@param source` through `@param chain` into `@param sink` in blocks of `@param block`
+     * frames, leaving the time it took in `@param stats`. The sink is left open. Returns false, with the reason in
+     * `@param error`, if reading or writing failed.
+     */
+    static bool render(MappedSource& source, RenderChain& chain, StreamSink& sink, int block, Stats& stats, juce::String& error)
+    {
+        using clock = std::chrono::steady_clock;
+        auto const channels = source.getFormat().channels;
+        std::vector<std::vector<float>> scratch(static_cast<size_t>(channels), std::vector<float>(static_cast<size_t>(block)));
+        std::vector<float*> pointers;
+        for (auto& s : scratch) { pointers.push_back(s.data()); }
+
+        stats = Stats {};
+        stats.sampleRate = source.getFormat().sampleRate;
+        redsp::scoped_denormal_disable ftz;
+        auto const start = clock::now();
+        for (;;)
+        {
+            auto const n = source.read(pointers.data(), block);
+            if (n < 0)
+            {
+                error = source.error;
+                return false;
+            }
+            if (n == 0) { break; }
+            chain.process(pointers.data(), n);
+            if (! sink.write(pointers.data(), n))
+            {
+                error = sink.error;
+                return false;
+            }
+            stats.frames += n;
+        }
+        stats.elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        return true;
+    }
+};
+
+#endif // REDSP_RENDERER_HEADERGUARD
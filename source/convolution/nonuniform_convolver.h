@@ -0,0 +1,341 @@
+/**
+ * Zero-latency non-uniformly partitioned convolution, with the long tail partitions computed on worker threads.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_NONUNIFORMCONVOLVER_HEADERGUARD
+#define REDSP_NONUNIFORMCONVOLVER_HEADERGUARD
+
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include "uniform_convolver.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Zero-latency convolver in the style of Gardner (1995): the impulse response is split into segments that get
+ * longer as they get later, so each can use a partition size whose latency it can hide.
+ *  - the first B taps (B = block size) run as a direct-form FIR, which has no latency,
+ *  - taps [B, 2S) run through a uniform_convolver with partition size B on the audio thread, where S = 16B,
+ *  - each later segment [2S_i, 2S_{i+1}) runs through a uniform_convolver with partition size S_i = 16^i S on its
+ *    own worker thread. A segment starting at 2S_i only needs its output S_i samples after its input block is
+ *    complete, so the worker has a whole block period to compute it.
+ * With worker threads running, the audio thread never computes a threaded segment or waits for one. A segment's
+ * partitions are as long as its blocks, so for a long impulse response one job is an FFT of hundreds of thousands of
+ * points. If a block's output is due and the worker hasn't finished the job, whether or not it has started, the segment
+ * plays silence for that block and the next. It holds the block's input back to go in with the next job, so the
+ * segment's history stays aligned. If the worker is late again before then, the held block is lost and the segment
+ * starts its history over. deadline_misses() counts the late jobs and dropouts() counts the silent blocks.
+ * With worker threads disabled every segment is computed on the calling thread at its deadline, which is handy for
+ * deterministic offline rendering; nothing is ever late then.
+ */
+template <redsp_arithmetic T>
+struct nonuniform_convolver
+{
+    redsp_arithmetic_assert(T)
+
+    using sample_type = T;
+    static constexpr size_t channels = 1;
+
+    //! ratio between successive segments' partition sizes
+    static constexpr int growth = 16;
+
+    nonuniform_convolver() = default;
+    ~nonuniform_convolver() { stop(); }
+
+    nonuniform_convolver(nonuniform_convolver const&) = delete;
+    nonuniform_convolver& operator=(nonuniform_convolver const&) = delete;
+
+    /**
+     * Splits the impulse response into segments, transforms them, and starts the worker threads. Call this off the
+     * audio thread.
+     * @param ir impulse response
+     * @param ir_length length of the impulse response
+     * @param block_size length of the direct-form head and partition size of the first FFT segment. A power of two
+     * somewhere around the host block size is a good choice.
+     * @param use_threads whether to run the later segments on worker threads
+     */
+    void prepare(T const* ir, int ir_length, int block_size, bool use_threads = true)
+    {
+        stop();
+        tails.clear();
+
+        int order = 1;
+        while ((1 << order) < math::clip(uniform_convolver<T>::min_block, uniform_convolver<T>::max_block, block_size)) { ++order; }
+        B = 1 << order;
+        ir_length = math::max(ir_length, 0);
+
+        // head: taps [0, B), reversed for the dot product
+        head_taps.assign(static_cast<size_t>(B), T(0));
+        for (int i = 0; i < math::min(B, ir_length); ++i) { head_taps[static_cast<size_t>(B - 1 - i)] = ir[i]; }
+        head_buf.assign(static_cast<size_t>(2 * B - 1), T(0));
+        x.assign(static_cast<size_t>(B), T(0));
+        scratch.assign(static_cast<size_t>(B), T(0));
+
+        // the synchronous segment runs from B up to where the first threaded one starts
+        auto S = B * growth;
+        auto sync_end = S <= uniform_convolver<T>::max_block ? math::min(ir_length, 2 * S) : ir_length;
+        has_sync = sync_end > B;
+        if (has_sync) { sync.prepare(ir + B, sync_end - B, B); }
+
+        for (auto start = sync_end; start < ir_length; S *= growth)
+        {
+            auto next = S * growth;
+            auto end = next <= uniform_convolver<T>::max_block && 2 * next < ir_length ? 2 * next : ir_length;
+            tails.emplace_back(new tail(ir + start, end - start, S));
+            start = end;
+        }
+
+        misses.store(0);
+        silent.store(0);
+        if (use_threads)
+        {
+            running.store(true);
+            for (auto& t : tails)
+            {
+                auto* level = t.get();
+                level->worker = std::thread([this, level] { work(*level); });
+            }
+        }
+    }
+
+    //! clears all history, keeping the impulse response. Not realtime safe, as it waits for the workers' jobs.
+    void reset()
+    {
+        std::fill(head_buf.begin(), head_buf.end(), T(0));
+        if (has_sync) { sync.reset(); }
+        for (auto& t : tails)
+        {
+            while (! collect(*t)) { std::this_thread::yield(); }
+            t->conv.reset();
+            std::fill(t->in.begin(), t->in.end(), T(0));
+            std::fill(t->out.begin(), t->out.end(), T(0));
+            t->pos = 0;
+            t->holding = false;
+            t->restart = false;
+            t->state.store(idle);
+        }
+    }
+
+    //! always zero
+    int latency() const { return 0; }
+
+    int block_size() const { return B; }
+
+    //! number of threaded segments
+    int tail_segments() const { return static_cast<int>(tails.size()); }
+
+    //! how many times a threaded segment's result wasn't ready at its deadline since prepare()
+    int deadline_misses() const { return misses.load(std::memory_order_relaxed); }
+
+    //! how many blocks a threaded segment played as silence since prepare() because its worker was late
+    int dropouts() const { return silent.load(std::memory_order_relaxed); }
+
+    /**
+     * Convolves `@param count` samples from `@param in` into `@param out` with no latency. in and out may alias.
+     */
+    void process(T const* in, T* out, int count)
+    {
+        while (count > 0)
+        {
+            // don't cross a block boundary of any threaded segment
+            auto len = math::min(count, B);
+            for (auto& t : tails) { len = math::min(len, t->size - t->pos); }
+
+            std::copy(in, in + len, x.data());
+            run_head(out, len);
+
+            if (has_sync)
+            {
+                sync.process(x.data(), scratch.data(), len);
+                for (int i = 0; i < len; ++i) { out[i] += scratch[static_cast<size_t>(i)]; }
+            }
+
+            for (auto& t : tails)
+            {
+                auto& level = *t;
+                auto* played = level.out.data() + level.pos;
+                for (int i = 0; i < len; ++i) { out[i] += played[i]; }
+                std::copy(x.data(), x.data() + len, level.in.data() + level.pos);
+
+                level.pos += len;
+                if (level.pos == level.size)
+                {
+                    handoff(level);
+                    level.pos = 0;
+                }
+            }
+
+            in += len;
+            out += len;
+            count -= len;
+        }
+    }
+
+    void process(T* samples, int count, int = 0) { process(samples, samples, count); }
+
+private:
+    enum : int { idle = 0, pending, busy, done };
+
+    struct tail
+    {
+        tail(T const* ir, int length, int block) : size(block)
+        {
+            conv.prepare(ir, length, block);
+            in.assign(static_cast<size_t>(block), T(0));
+            out.assign(static_cast<size_t>(block), T(0));
+            held.assign(static_cast<size_t>(block), T(0));
+            job_in.assign(static_cast<size_t>(2 * block), T(0));
+            job_out.assign(static_cast<size_t>(block), T(0));
+        }
+
+        int size;
+        int pos = 0;
+        uniform_convolver<T> conv;
+        // in collects the current block, out plays the previous job's result and held keeps a block the worker was too
+        // late to take; job_* belong to whoever holds the job
+        std::vector<T> in, out, held, job_in, job_out;
+        bool holding = false, restart = false;
+        // set by the audio thread before submitting: whether the job starts with the held block, and starts over
+        int job_blocks = 1;
+        bool job_restart = false;
+        std::atomic<int> state { idle };
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wake;
+    };
+
+    int B = 0;
+    bool has_sync = false;
+    std::vector<T> head_taps, head_buf, x, scratch;
+    uniform_convolver<T> sync;
+    std::vector<std::unique_ptr<tail>> tails;
+    std::atomic<bool> running { false };
+    std::atomic<int> misses { 0 };
+    std::atomic<int> silent { 0 };
+
+    //! direct-form FIR over [history | x] so the dot products never wrap
+    void run_head(T* out, int len)
+    {
+        auto* buf = head_buf.data();
+        std::copy(x.data(), x.data() + len, buf + B - 1);
+        for (int i = 0; i < len; ++i) { out[i] = simd::dot(head_taps.data(), buf + i, B); }
+        std::copy(buf + len, buf + len + B - 1, buf);
+    }
+
+    //! at a block boundary: collect the previous job if it's finished and submit this block, or hold this block back
+    void handoff(tail& level)
+    {
+        auto const ready = collect(level);
+        if (! ready) { misses.fetch_add(1, std::memory_order_relaxed); }
+        if (! ready || level.holding)
+        {
+            // either no result, or one for the block that already went silent
+            std::fill(level.out.begin(), level.out.end(), T(0));
+            silent.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            std::copy(level.job_out.begin(), level.job_out.end(), level.out.begin());
+        }
+
+        if (! ready)
+        {
+            // a second block can't be held too, so the segment loses the first and starts over from this one
+            level.restart = level.holding;
+            level.holding = true;
+            std::copy(level.in.begin(), level.in.end(), level.held.begin());
+            return;
+        }
+
+        auto* dest = level.job_in.data();
+        if (level.holding)
+        {
+            dest = std::copy(level.held.begin(), level.held.end(), dest);
+        }
+        std::copy(level.in.begin(), level.in.end(), dest);
+        level.job_blocks = level.holding ? 2 : 1;
+        level.job_restart = level.restart;
+        level.holding = false;
+        level.restart = false;
+        level.state.store(pending, std::memory_order_release);
+
+        if (level.worker.joinable() && level.mutex.try_lock())
+        {
+            // holding the lock for a moment means a worker between checking for work and sleeping has gone to sleep,
+            // so the notify can't be lost. If the lock is busy the worker is awake, and its timed wait is the fallback
+            level.mutex.unlock();
+            level.wake.notify_one();
+        }
+    }
+
+    //! whether the submitted job has finished. Without a worker it's computed here; with one, it's never waited for
+    bool collect(tail& level)
+    {
+        auto const state = level.state.load(std::memory_order_acquire);
+        if (state == pending && ! level.worker.joinable())
+        {
+            compute(level);
+            return true;
+        }
+        return state != pending && state != busy;
+    }
+
+    static void compute(tail& level)
+    {
+        if (level.job_restart) { level.conv.reset(); }
+        // a held block's output was due while the worker was late, so only the last block's is kept
+        for (int b = 0; b < level.job_blocks; ++b)
+        {
+            level.conv.process_block(level.job_in.data() + b * level.size, level.job_out.data());
+        }
+        level.state.store(done, std::memory_order_release);
+    }
+
+    void work(tail& level)
+    {
+        while (running.load(std::memory_order_acquire))
+        {
+            {
+                std::unique_lock<std::mutex> lock(level.mutex);
+                level.wake.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                    return level.state.load(std::memory_order_acquire) == pending || ! running.load();
+                });
+            }
+
+            auto expected = static_cast<int>(pending);
+            if (level.state.compare_exchange_strong(expected, busy, std::memory_order_acquire)) { compute(level); }
+        }
+    }
+
+    void stop()
+    {
+        running.store(false);
+        for (auto& t : tails)
+        {
+            if (t->worker.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(t->mutex);
+                }
+                t->wake.notify_one();
+                t->worker.join();
+            }
+        }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_NONUNIFORMCONVOLVER_HEADERGUARD
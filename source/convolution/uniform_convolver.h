@@ -0,0 +1,196 @@
+/**
+ * Uniformly partitioned FFT convolution for long impulse responses.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_UNIFORMCONVOLVER_HEADERGUARD
+#define REDSP_UNIFORMCONVOLVER_HEADERGUARD
+
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "../fft/fft.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+namespace convolution {
+
+/**
+ * Complex multiply-accumulate over split arrays: acc += a * b, for `@param count` bins.
+ */
+template <redsp_arithmetic T>
+inline void cmac(T* acc_re, T* acc_im, T const* a_re, T const* a_im, T const* b_re, T const* b_im, int count)
+{
+    using V = simd::vec<T>;
+    constexpr int w = static_cast<int>(V::width);
+
+    int k = 0;
+    for (; k + w <= count; k += w)
+    {
+        auto ar = V::load(a_re + k), ai = V::load(a_im + k);
+        auto br = V::load(b_re + k), bi = V::load(b_im + k);
+        mul_add(ar, br, V::load(acc_re + k) - ai * bi).store(acc_re + k);
+        mul_add(ar, bi, mul_add(ai, br, V::load(acc_im + k))).store(acc_im + k);
+    }
+    for (; k < count; ++k)
+    {
+        acc_re[k] += a_re[k] * b_re[k] - a_im[k] * b_im[k];
+        acc_im[k] += a_re[k] * b_im[k] + a_im[k] * b_re[k];
+    }
+}
+
+} // namespace convolution
+
+/**
+ * @brief Uniformly partitioned overlap-save (UPOLS) convolver. The impulse response is cut into partitions of the
+ * block size B, each transformed once at prepare time. Every block of B input samples is transformed once (a real FFT
+ * of size 2B) and pushed into a frequency-domain delay line; the output spectrum is the sum over partitions of the
+ * partition's spectrum times the spectrum of the input from that many blocks ago, which is one SIMD complex
+ * multiply-accumulate per partition, and one inverse FFT. The FFT work per block doesn't depend on the length of the
+ * impulse response at all; only the multiply-accumulate does, and that's B + 1 bins per partition.
+ * process_block() works on whole blocks without adding latency; process() takes any number of samples and delays the
+ * output by B samples.
+ */
+template <redsp_arithmetic T>
+struct uniform_convolver
+{
+    redsp_arithmetic_assert(T)
+
+    using sample_type = T;
+    static constexpr size_t channels = 1;
+
+    static constexpr int min_block = 16;
+    static constexpr int max_block = 1 << (fft<T>::max_order - 1);
+
+    uniform_convolver() = default;
+
+    /**
+     * Partitions and transforms the impulse response, and allocates the delay line. Call this off the audio thread.
+     * @param ir impulse response
+     * @param ir_length length of the impulse response
+     * @param block_size partition size, a power of two between min_block and max_block (rounded up if not)
+     */
+    void prepare(T const* ir, int ir_length, int block_size)
+    {
+        int order = 1;
+        while ((1 << order) < math::clip(min_block, max_block, block_size)) { ++order; }
+        B = 1 << order;
+        bins = B + 1;
+        transform.reset(new fft<T>(order + 1));
+
+        P = math::max(1, (math::max(ir_length, 0) + B - 1) / B);
+        auto const stride = static_cast<size_t>(bins) * 2;
+        filter.assign(static_cast<size_t>(P) * stride, T(0));
+        fdl.assign(static_cast<size_t>(P) * stride, T(0));
+        acc.assign(stride, T(0));
+        time.assign(static_cast<size_t>(B) * 2, T(0));
+
+        // fold the inverse transform's 1 / 2B scaling into the filter
+        auto const scale = T(1) / static_cast<T>(2 * B);
+        for (int p = 0; p < P; ++p)
+        {
+            std::fill(time.begin(), time.end(), T(0));
+            auto const start = p * B;
+            auto const len = math::max(0, math::min(B, ir_length - start));
+            for (int i = 0; i < len; ++i) { time[static_cast<size_t>(i)] = ir[start + i] * scale; }
+            transform->forward_real(time.data(), filter_re(p), filter_im(p));
+        }
+
+        input.assign(static_cast<size_t>(B) * 2, T(0));
+        in_fifo.assign(static_cast<size_t>(B), T(0));
+        out_fifo.assign(static_cast<size_t>(B), T(0));
+        reset();
+    }
+
+    //! clears the delay line and buffers, keeping the impulse response
+    void reset()
+    {
+        std::fill(fdl.begin(), fdl.end(), T(0));
+        std::fill(input.begin(), input.end(), T(0));
+        std::fill(in_fifo.begin(), in_fifo.end(), T(0));
+        std::fill(out_fifo.begin(), out_fifo.end(), T(0));
+        current = 0;
+        fifo_pos = 0;
+    }
+
+    int block_size() const { return B; }
+    int partitions() const { return P; }
+
+    //! latency of process(), in samples
+    int latency() const { return B; }
+
+    /**
+     * Convolves exactly block_size() samples from `@param in` into `@param out`, without adding latency. in and out
+     * may alias. Don't mix this with process() on the same object.
+     */
+    void process_block(T const* in, T* out)
+    {
+        // overlap-save: transform the previous block followed by this one
+        std::copy(in, in + B, input.data() + B);
+        transform->forward_real(input.data(), fdl_re(current), fdl_im(current));
+        std::copy(input.data() + B, input.data() + 2 * B, input.data());
+
+        auto* ar = acc.data();
+        auto* ai = acc.data() + bins;
+        std::fill(acc.begin(), acc.end(), T(0));
+        for (int p = 0; p < P; ++p)
+        {
+            auto slot = current - p < 0 ? current - p + P : current - p;
+            convolution::cmac(ar, ai, filter_re(p), filter_im(p), fdl_re(slot), fdl_im(slot), bins);
+        }
+        current = current + 1 == P ? 0 : current + 1;
+
+        // the first half of the result is circularly aliased; the second half is this block's output
+        transform->inverse_real(ar, ai, time.data());
+        std::copy(time.data() + B, time.data() + 2 * B, out);
+    }
+
+    /**
+     * Convolves `@param count` samples from `@param in` into `@param out`, delayed by latency() samples. in and out
+     * may alias.
+     */
+    void process(T const* in, T* out, int count)
+    {
+        while (count > 0)
+        {
+            auto const len = math::min(count, B - fifo_pos);
+            auto const pos = static_cast<size_t>(fifo_pos);
+            std::copy(in, in + len, in_fifo.data() + pos);
+            std::copy(out_fifo.data() + pos, out_fifo.data() + pos + static_cast<size_t>(len), out);
+
+            fifo_pos += len;
+            if (fifo_pos == B)
+            {
+                process_block(in_fifo.data(), out_fifo.data());
+                fifo_pos = 0;
+            }
+            in += len;
+            out += len;
+            count -= len;
+        }
+    }
+
+    void process(T* samples, int count, int = 0) { process(samples, samples, count); }
+
+private:
+    int B = 0, bins = 0, P = 0;
+    int current = 0, fifo_pos = 0;
+    std::unique_ptr<fft<T>> transform;
+
+    // partition spectra and the frequency-domain delay line: P slots of (re[bins], im[bins])
+    std::vector<T> filter, fdl, acc;
+    std::vector<T> input, time, in_fifo, out_fifo;
+
+    T* filter_re(int p) { return filter.data() + static_cast<size_t>(p) * static_cast<size_t>(bins) * 2; }
+    T* filter_im(int p) { return filter_re(p) + bins; }
+    T* fdl_re(int p) { return fdl.data() + static_cast<size_t>(p) * static_cast<size_t>(bins) * 2; }
+    T* fdl_im(int p) { return fdl_re(p) + bins; }
+};
+
+} // namespace redsp
+
+#endif // REDSP_UNIFORMCONVOLVER_HEADERGUARD
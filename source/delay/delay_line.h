@@ -0,0 +1,369 @@
+/**
+ * Fractional delay line on a power-of-two ring buffer, with several interpolation schemes and block paths.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_DELAYLINE_HEADERGUARD
+#define REDSP_DELAYLINE_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+enum class delay_interpolation
+{
+    none = 0,   //!< rounds to the nearest sample
+    linear,     //!< two points; cheap, but lowpasses a little at fractional delays
+    lagrange3,  //!< four points, third order; needs a delay of at least one sample
+    allpass     //!< first order allpass; flat magnitude, but has state, so each tap should only move smoothly
+};
+
+/**
+ * @brief Delay line for chorus, flanger, comb and waveguide style processors.
+ * Each channel's ring buffer is a power of two long, so indices wrap with a mask rather than a modulo, and it's
+ * followed by a few guard samples mirroring its start, so every interpolator's points are contiguous even across the
+ * wrap. Block writes and integer-delay block reads are at most two contiguous copies, and constant fractional delays
+ * are read as SIMD weighted sums over at most two contiguous segments.
+ * Any number of reads can follow each write. With allpass interpolation each read tap has its own filter state, so
+ * reads name their tap (up to Taps); the other schemes ignore it.
+ * A delay d reads the sample written d writes ago: 0 is the most recent one. The ring can live in memory the delay
+ * line doesn't own (see storage_size()), so several can share one contiguous arena.
+ * @tparam SampleType sample type
+ * @tparam Interpolation fractional delay interpolation
+ * @tparam Channels number of channels
+ * @tparam Taps number of read taps with their own state (allpass interpolation only)
+ */
+template <redsp_arithmetic SampleType,
+          delay_interpolation Interpolation = delay_interpolation::linear,
+          size_t Channels = 1,
+          size_t Taps = 1>
+struct delay_line
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+    static_assert(Taps > 0, "There has to be at least one tap");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    //! samples mirrored past the end of each ring
+    static constexpr int guard = 4;
+
+    //! smallest delay the interpolation can produce without reading samples that haven't been written yet
+    static constexpr int min_delay = Interpolation == delay_interpolation::lagrange3 ? 1 : 0;
+
+    delay_line() = default;
+
+    /**
+     * Returns the number of samples of storage needed for prepare(max_delay, max_block, storage).
+     */
+    static size_t storage_size(int max_delay, int max_block = 1)
+    {
+        return Channels * static_cast<size_t>(ring_size(max_delay, max_block) + guard);
+    }
+
+    /**
+     * Allocates the ring buffers. Call this off the audio thread.
+     * @param max_delay longest delay that will be read, in samples
+     * @param max_block longest block written before the reads that go with it
+     */
+    void prepare(int max_delay, int max_block = 1)
+    {
+        owned.assign(storage_size(max_delay, max_block), SampleType(0));
+        prepare(max_delay, max_block, owned.data());
+    }
+
+    /**
+     * Like prepare(), but uses `@param storage` (storage_size() samples, which must outlive the delay line) instead of
+     * allocating.
+     */
+    void prepare(int max_delay, int max_block, SampleType* storage)
+    {
+        M = ring_size(max_delay, max_block);
+        mask = M - 1;
+        block = math::max(max_block, 1);
+        longest = M - block - 3;
+        for (size_t i = 0; i < Channels; ++i)
+        {
+            state[i].data = storage + i * static_cast<size_t>(M + guard);
+        }
+        delay = math::min(delay, static_cast<SampleType>(longest));
+        reset();
+    }
+
+    //! clears the buffers and interpolator state
+    void reset()
+    {
+        for (auto& s : state)
+        {
+            std::fill(s.data, s.data + M + guard, SampleType(0));
+            s.w = 0;
+            s.allpass.fill(SampleType(0));
+        }
+    }
+
+    //! longest delay that can be read
+    int max_delay() const { return longest; }
+
+    //! sets the delay used by process()
+    void set_delay(SampleType d) { delay = math::clip(static_cast<SampleType>(min_delay), static_cast<SampleType>(longest), d); }
+
+    //================================================================================================================//
+    //==                                                SINGLE SAMPLE                                               ==//
+    //================================================================================================================//
+
+    void write(SampleType x, int n = 0)
+    {
+        auto& s = state[static_cast<size_t>(n)];
+        s.data[s.w] = x;
+        if (s.w < guard) { s.data[s.w + M] = x; }
+        s.w = (s.w + 1) & mask;
+    }
+
+    //! reads the sample written `@param d` writes ago, which must be between 0 and max_delay()
+    SampleType read_integer(int d, int n = 0) const
+    {
+        auto const& s = state[static_cast<size_t>(n)];
+        return s.data[(s.w - 1 - d) & mask];
+    }
+
+    /**
+     * Reads at a fractional delay `@param d`, clamped to [min_delay, max_delay()], on channel `@param n` and tap
+     * `@param tap`.
+     */
+    SampleType read(SampleType d, int n = 0, int tap = 0)
+    {
+        auto& s = state[static_cast<size_t>(n)];
+        d = math::clip(static_cast<SampleType>(min_delay), static_cast<SampleType>(longest), d);
+        return read_clamped(s, d, s.w, tap);
+    }
+
+    //================================================================================================================//
+    //==                                                   BLOCKS                                                   ==//
+    //================================================================================================================//
+
+    /**
+     * Writes `@param count` samples (at most max_block) from `@param input`, in at most two copies.
+     */
+    void write(SampleType const* input, int count, int n = 0)
+    {
+        auto& s = state[static_cast<size_t>(n)];
+        auto const first = math::min(count, M - s.w);
+        std::copy(input, input + first, s.data + s.w);
+        std::copy(input + first, input + count, s.data);
+        if (s.w < guard || first < count) { std::copy(s.data, s.data + guard, s.data + M); }
+        s.w = (s.w + count) & mask;
+    }
+
+    /**
+     * Reads the last `@param count` writes, each delayed by `@param d` samples, in at most two copies.
+     */
+    void read_integer(SampleType* output, int count, int d, int n = 0) const
+    {
+        copy_out(state[static_cast<size_t>(n)], output, count, d);
+    }
+
+    /**
+     * Reads the last `@param count` writes, each delayed by the same fractional delay `@param d`. Apart from allpass
+     * interpolation, which is recursive, this runs as SIMD weighted sums over at most two contiguous segments.
+     */
+    void read(SampleType* output, int count, SampleType d, int n = 0, int tap = 0)
+    {
+        auto& s = state[static_cast<size_t>(n)];
+        d = math::clip(static_cast<SampleType>(min_delay), static_cast<SampleType>(longest), d);
+        read_constant(s, output, count, d, tap, std::integral_constant<delay_interpolation, Interpolation>());
+    }
+
+    /**
+     * Reads the last `@param count` writes, write i delayed by `@param delays`[i], for modulated taps.
+     */
+    void read(SampleType* output, SampleType const* delays, int count, int n = 0, int tap = 0)
+    {
+        auto& s = state[static_cast<size_t>(n)];
+        auto const end = s.w;
+        for (int i = 0; i < count; ++i)
+        {
+            auto d = math::clip(static_cast<SampleType>(min_delay), static_cast<SampleType>(longest), delays[i]);
+            output[i] = read_clamped(s, d, (end - count + 1 + i) & mask, tap);
+        }
+    }
+
+    /**
+     * Delays `@param count` samples in place by the delay given to set_delay(), on channel `@param n`.
+     */
+    void process(SampleType* samples, int count, int n = 0)
+    {
+        for (int done = 0; done < count; done += block)
+        {
+            auto const len = math::min(block, count - done);
+            write(samples + done, len, n);
+            read(samples + done, len, delay, n);
+        }
+    }
+
+    void process(SampleType** samples, int count)
+    {
+        for (int i = 0; i < static_cast<int>(Channels); ++i) { process(samples[i], count, i); }
+    }
+
+private:
+    struct channel_state
+    {
+        SampleType* data = nullptr;
+        //! where the next write goes
+        int w = 0;
+        //! previous output of each tap's allpass
+        std::array<SampleType, Taps> allpass {};
+    };
+
+    int M = 0, mask = 0, block = 1, longest = 0;
+    SampleType delay = 0;
+    std::vector<SampleType> owned;
+    std::array<channel_state, Channels> state;
+
+    static int ring_size(int max_delay, int max_block)
+    {
+        // the farthest point read is max_delay + 2 behind the oldest write of a block (lagrange3's oldest point)
+        auto const needed = math::max(max_delay, 0) + math::max(max_block, 1) + 3;
+        int size = 1;
+        while (size < needed) { size <<= 1; }
+        return size;
+    }
+
+    void copy_out(channel_state const& s, SampleType* output, int count, int d) const
+    {
+        auto const start = (s.w - count - d) & mask;
+        auto const first = math::min(count, M - start);
+        std::copy(s.data + start, s.data + start + first, output);
+        std::copy(s.data, s.data + (count - first), output + first);
+    }
+
+    static void lagrange_weights(SampleType f, SampleType* h)
+    {
+        // points at delays D + 2, D + 1, D, D - 1 (oldest first), evaluated at D + f
+        auto const fm1 = f - SampleType(1), fm2 = f - SampleType(2), fp1 = f + SampleType(1);
+        h[0] = fp1 * f * fm1 * SampleType(1.0 / 6.0);
+        h[1] = -fp1 * f * fm2 * SampleType(0.5);
+        h[2] = fp1 * fm1 * fm2 * SampleType(0.5);
+        h[3] = -f * fm1 * fm2 * SampleType(1.0 / 6.0);
+    }
+
+    //! reads delay d (already clamped) relative to the write position `end`, i.e. as if `end` were the next write
+    SampleType read_clamped(channel_state& s, SampleType d, int end, int tap)
+    {
+        return read_clamped(s, d, end, tap, std::integral_constant<delay_interpolation, Interpolation>());
+    }
+
+    SampleType read_clamped(channel_state& s, SampleType d, int end, int, std::integral_constant<delay_interpolation, delay_interpolation::none>)
+    {
+        return s.data[(end - 1 - static_cast<int>(d + SampleType(0.5))) & mask];
+    }
+
+    SampleType read_clamped(channel_state& s, SampleType d, int end, int, std::integral_constant<delay_interpolation, delay_interpolation::linear>)
+    {
+        auto const D = static_cast<int>(d);
+        auto const f = d - static_cast<SampleType>(D);
+        auto const* p = s.data + ((end - 2 - D) & mask);
+        return p[0] * f + p[1] * (SampleType(1) - f);
+    }
+
+    SampleType read_clamped(channel_state& s, SampleType d, int end, int, std::integral_constant<delay_interpolation, delay_interpolation::lagrange3>)
+    {
+        auto const D = static_cast<int>(d);
+        SampleType h[4];
+        lagrange_weights(d - static_cast<SampleType>(D), h);
+        auto const* p = s.data + ((end - 3 - D) & mask);
+        return h[0] * p[0] + h[1] * p[1] + h[2] * p[2] + h[3] * p[3];
+    }
+
+    SampleType read_clamped(channel_state& s, SampleType d, int end, int tap, std::integral_constant<delay_interpolation, delay_interpolation::allpass>)
+    {
+        // keep the allpass' fractional part in [0.5, 1.5) where it can, away from the pole at -1
+        auto D = static_cast<int>(d);
+        auto f = d - static_cast<SampleType>(D);
+        if (f < SampleType(0.5) && D > 0)
+        {
+            --D;
+            f += SampleType(1);
+        }
+        auto const a = (SampleType(1) - f) / (SampleType(1) + f);
+        auto const* p = s.data + ((end - 2 - D) & mask);
+
+        // y[n] = a x[n - D] + x[n - D - 1] - a y[n - 1]
+        auto& y = s.allpass[static_cast<size_t>(tap)];
+        y = a * (p[1] - y) + p[0];
+        return y;
+    }
+
+    //! output[i] = sum over k of h[k] * src[i + k], P points
+    template <size_t P>
+    static void weighted_sum(SampleType const* src, SampleType const* h, SampleType* output, int count)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+
+        std::array<V, P> hv;
+        for (size_t k = 0; k < P; ++k) { hv[k] = V::broadcast(h[k]); }
+
+        int i = 0;
+        for (; i + w <= count; i += w)
+        {
+            auto acc = V::load(src + i) * hv[0];
+            for (size_t k = 1; k < P; ++k) { acc = mul_add(V::load(src + i + k), hv[k], acc); }
+            acc.store(output + i);
+        }
+        for (; i < count; ++i)
+        {
+            auto acc = SampleType(0);
+            for (size_t k = 0; k < P; ++k) { acc += h[k] * src[static_cast<size_t>(i) + k]; }
+            output[i] = acc;
+        }
+    }
+
+    //! runs weighted_sum over the block starting at ring index `start`, split where the ring wraps
+    template <size_t P>
+    void weighted_block(channel_state const& s, int start, SampleType const* h, SampleType* output, int count) const
+    {
+        auto const first = math::min(count, M - start);
+        weighted_sum<P>(s.data + start, h, output, first);
+        weighted_sum<P>(s.data, h, output + first, count - first);
+    }
+
+    void read_constant(channel_state& s, SampleType* output, int count, SampleType d, int, std::integral_constant<delay_interpolation, delay_interpolation::none>)
+    {
+        copy_out(s, output, count, static_cast<int>(d + SampleType(0.5)));
+    }
+
+    void read_constant(channel_state& s, SampleType* output, int count, SampleType d, int, std::integral_constant<delay_interpolation, delay_interpolation::linear>)
+    {
+        auto const D = static_cast<int>(d);
+        auto const f = d - static_cast<SampleType>(D);
+        SampleType const h[2] = { f, SampleType(1) - f };
+        weighted_block<2>(s, (s.w - count - D - 1) & mask, h, output, count);
+    }
+
+    void read_constant(channel_state& s, SampleType* output, int count, SampleType d, int, std::integral_constant<delay_interpolation, delay_interpolation::lagrange3>)
+    {
+        auto const D = static_cast<int>(d);
+        SampleType h[4];
+        lagrange_weights(d - static_cast<SampleType>(D), h);
+        weighted_block<4>(s, (s.w - count - D - 2) & mask, h, output, count);
+    }
+
+    void read_constant(channel_state& s, SampleType* output, int count, SampleType d, int tap, std::integral_constant<delay_interpolation, delay_interpolation::allpass>)
+    {
+        auto const end = s.w;
+        for (int i = 0; i < count; ++i) { output[i] = read_clamped(s, d, (end - count + 1 + i) & mask, tap); }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_DELAYLINE_HEADERGUARD
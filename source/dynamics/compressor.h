@@ -0,0 +1,243 @@
+/**
+ * Feed-forward compressor/limiter with a dB-domain gain computer.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_COMPRESSOR_HEADERGUARD
+#define REDSP_COMPRESSOR_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include "envelope_follower.h"
+#include "../delay/delay_line.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Feed-forward compressor and limiter. Per channel, an envelope follower on the sidechain (the input itself by
+ * default) gives a level, which goes to dB, through a soft-kneed static curve (Giannoulis, Massberg & Reiss), and back
+ * to a linear gain applied to the input, optionally delayed for lookahead so the gain is already down when a
+ * transient arrives.
+ * The dB conversions are math::log_fast and math::exp2_fast rather than log10 and pow, and the whole per-sample
+ * chain (follower, log, curve, link, exp) runs SIMD across channels on frames interleaved by channel, so large
+ * channel counts cost little more per channel than a register's worth.
+ * Linking pulls every channel's level towards the loudest one's before the curve, so linked channels share one gain
+ * and the image doesn't shift; a pair of channels with link 1 is the usual stereo link.
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels, sharing the settings
+ * @tparam Detector peak or RMS level detection
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 2, envelope_detector Detector = envelope_detector::peak>
+struct compressor
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    compressor() = default;
+
+    compressor(compressor const&) = delete;
+    compressor& operator=(compressor const&) = delete;
+
+    /**
+     * Allocates the lookahead ring and the scratch frames. Call this off the audio thread.
+     * @param sample_rate sampling rate
+     * @param max_block longest block process() will be called with; longer ones are split
+     * @param max_lookahead longest lookahead that will be set, in seconds
+     */
+    void prepare(double sample_rate, int max_block, double max_lookahead = 0.0)
+    {
+        fs = sample_rate;
+        // longer blocks are run in chunks small enough for the frames to stay in cache
+        block = math::clip(1, 64, max_block);
+        auto const longest = math::max(static_cast<int>(std::ceil(max_lookahead * fs)), 1);
+        lookahead_line.prepare(longest, block);
+        frames.assign(static_cast<size_t>(block) * padded, SampleType(0));
+        set_times(attack_time, release_time);
+        set_lookahead(lookahead_time);
+        reset();
+    }
+
+    //! clears the envelopes and the lookahead ring
+    void reset()
+    {
+        envelope.fill(SampleType(0));
+        gain_db.fill(SampleType(0));
+        lookahead_line.reset();
+    }
+
+    //! sets the threshold, in dBFS
+    void set_threshold(SampleType db) { threshold = db; }
+
+    /**
+     * Sets the ratio; anything below 1 is taken as 1, and infinity makes a limiter.
+     */
+    void set_ratio(SampleType r) { slope = SampleType(1) - SampleType(1) / math::max(r, SampleType(1)); }
+
+    //! sets the width of the soft knee around the threshold, in dB; 0 is a hard knee
+    void set_knee(SampleType db)
+    {
+        knee = math::max(db, SampleType(0));
+        inv_twice_knee = knee > 0 ? SampleType(0.5) / knee : SampleType(0);
+    }
+
+    //! sets the makeup gain, in dB
+    void set_makeup(SampleType db) { makeup = db; }
+
+    //! sets the attack and release times of the level detector, in seconds
+    void set_times(double attack_seconds, double release_seconds)
+    {
+        attack_time = attack_seconds;
+        release_time = release_seconds;
+        attack = static_cast<SampleType>(envelope_detail::step_for(attack_seconds, fs));
+        release = static_cast<SampleType>(envelope_detail::step_for(release_seconds, fs));
+    }
+
+    /**
+     * Sets how much each channel's level is pulled towards the loudest channel's: 0 is independent, 1 fully linked.
+     */
+    void set_link(SampleType amount) { link = math::clip(SampleType(0), SampleType(1), amount); }
+
+    /**
+     * Sets the lookahead in seconds, up to the prepared maximum. The output is delayed by latency() samples.
+     */
+    void set_lookahead(double seconds)
+    {
+        lookahead_time = math::max(seconds, 0.0);
+        lookahead = math::clip(0, lookahead_line.max_delay(), static_cast<int>(std::round(lookahead_time * fs)));
+    }
+
+    //! the lookahead delay, in samples
+    int latency() const { return lookahead; }
+
+    //! gain applied to channel `@param c` at the end of the last block, in dB (including makeup)
+    SampleType gain(size_t c) const { return gain_db[c]; }
+
+    /**
+     * Compresses `@param count` samples of every channel of `@param samples`, of shape (Channels, count), in place,
+     * keyed by `@param sidechain` (same shape), or by the input itself if that's null.
+     */
+    void process(SampleType** samples, SampleType const* const* sidechain, int count)
+    {
+        for (int done = 0; done < count; done += block)
+        {
+            auto const len = math::min(block, count - done);
+            std::array<SampleType*, Channels> io;
+            std::array<SampleType const*, Channels> key;
+            for (size_t c = 0; c < Channels; ++c)
+            {
+                io[c] = samples[c] + done;
+                key[c] = (sidechain != nullptr ? sidechain[c] : samples[c]) + done;
+            }
+            run_block(io.data(), key.data(), len);
+        }
+    }
+
+    void process(SampleType** samples, int count) { process(samples, nullptr, count); }
+
+private:
+    using V = simd::vec<SampleType>;
+    static constexpr size_t width = V::width;
+    static constexpr size_t padded = simd::padded_count<SampleType>(Channels);
+    using detector = std::integral_constant<envelope_detector, Detector>;
+
+    //! 20 / log2(10) turns log2 of an amplitude into dB; RMS follows power, so half that
+    static constexpr double db_per_octave = Detector == envelope_detector::peak ? 6.0205999132796239 : 3.0102999566398120;
+
+    double fs = 48000, attack_time = 0.005, release_time = 0.1, lookahead_time = 0;
+    int block = 1, lookahead = 0;
+    SampleType threshold = -12, slope = SampleType(0.75), knee = 6, inv_twice_knee = SampleType(1.0 / 12.0), makeup = 0;
+    SampleType link = 1, attack = 1, release = 1;
+
+    std::array<SampleType, padded> envelope {};
+    std::array<SampleType, padded> gain_db {};
+    delay_line<SampleType, delay_interpolation::none, Channels> lookahead_line;
+    //! one frame of padded channels per sample: the sidechain, then the level in dB, then the linear gain
+    std::vector<SampleType> frames;
+
+    //! the largest of the real channels in frame `@param f`
+    static SampleType loudest_of(SampleType const* f)
+    {
+        constexpr size_t full = Channels / width * width;
+        auto m = V::broadcast(std::numeric_limits<SampleType>::lowest());
+        for (size_t j = 0; j < full; j += width) { m = max(m, V::load(f + j)); }
+        std::array<SampleType, width> lanes;
+        m.store(lanes.data());
+        auto result = *std::max_element(lanes.begin(), lanes.end());
+        for (size_t c = full; c < Channels; ++c) { result = math::max(result, f[c]); }
+        return result;
+    }
+
+    void run_block(SampleType** io, SampleType const* const* key, int len)
+    {
+        auto const count = static_cast<size_t>(len);
+
+        // interleave the sidechain, so the rest can run across channels. Padding lanes are computed but never read
+        for (size_t c = 0; c < Channels; ++c)
+        {
+            for (size_t t = 0; t < count; ++t) { frames[t * padded + c] = key[c][t]; }
+        }
+
+        // per frame: envelope and level in dB, then link, gain curve, and back to linear
+        auto const a = V::broadcast(attack), r = V::broadcast(release);
+        auto const floor = V::broadcast(std::numeric_limits<SampleType>::min());
+        auto const scale = V::broadcast(static_cast<SampleType>(db_per_octave));
+        auto const thresh = V::broadcast(threshold), half_knee = V::broadcast(knee * SampleType(0.5));
+        auto const knee_v = V::broadcast(knee), inv = V::broadcast(inv_twice_knee);
+        auto const minus_slope = V::broadcast(-slope), gain_makeup = V::broadcast(makeup);
+        auto const link_v = V::broadcast(link), zero = V::zero();
+        auto const per_db = V::broadcast(static_cast<SampleType>(1.0 / 6.0205999132796239));
+        auto const attack_faster = attack_time <= release_time;
+        for (size_t t = 0; t < count; ++t)
+        {
+            auto* f = frames.data() + t * padded;
+            for (size_t j = 0; j < padded; j += width)
+            {
+                auto const level = envelope_detail::rectify(V::load(f + j), detector());
+                auto e = V::load(envelope.data() + j);
+                e = attack_faster ? envelope_detail::follow<true>(level, e, a, r)
+                                  : envelope_detail::follow<false>(level, e, a, r);
+                e.store(envelope.data() + j);
+                (scale * simd::log2_fast(max(e, floor))).store(f + j);
+            }
+
+            auto const loudest = V::broadcast(link > 0 ? loudest_of(f) : SampleType(0));
+            for (size_t j = 0; j < padded; j += width)
+            {
+                auto x = V::load(f + j);
+                x = mul_add(link_v, loudest - x, x);
+                auto const over = x - thresh;
+                // below the knee nothing, above it slope * over, and a parabola joining the two across it
+                auto const q = min(max(over + half_knee, zero), knee_v);
+                auto const db = mul_add(minus_slope, mul_add(q * q, inv, max(over - half_knee, zero)), gain_makeup);
+                db.store(gain_db.data() + j);
+                simd::exp2_fast(db * per_db).store(f + j);
+            }
+        }
+
+        // delay the audio for lookahead and apply the gain
+        for (size_t c = 0; c < Channels; ++c)
+        {
+            auto* x = io[c];
+            if (lookahead > 0)
+            {
+                lookahead_line.write(x, len, static_cast<int>(c));
+                lookahead_line.read_integer(x, len, lookahead, static_cast<int>(c));
+            }
+            for (size_t t = 0; t < count; ++t) { x[t] *= frames[t * padded + c]; }
+        }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_COMPRESSOR_HEADERGUARD
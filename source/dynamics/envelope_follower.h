@@ -0,0 +1,157 @@
+/**
+ * Peak and RMS envelope followers with attack and release.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_ENVELOPEFOLLOWER_HEADERGUARD
+#define REDSP_ENVELOPEFOLLOWER_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+enum class envelope_detector
+{
+    peak = 0,   //!< follows |x|
+    rms         //!< follows x^2, giving the square root of that
+};
+
+namespace envelope_detail {
+
+//! the detector's input for sample `@param x`: |x| or x^2
+template <typename V>
+inline V rectify(V x, std::integral_constant<envelope_detector, envelope_detector::peak>) { using std::abs; return abs(x); }
+template <typename V>
+inline V rectify(V x, std::integral_constant<envelope_detector, envelope_detector::rms>) { return x * x; }
+
+/**
+ * One step of a branching one-pole follower (the "smooth branching" detector of Giannoulis, Massberg & Reiss): it
+ * moves `@param y` towards `@param x` with the attack coefficient when rising and the release one when falling.
+ * Stepping with both and keeping the larger picks the right one whenever attack is no slower than release, which
+ * needs no compare-and-select and so runs as well on simd::vec as on scalars. When attack is the slower of the two,
+ * the smaller is right instead.
+ */
+template <bool AttackFaster, typename V>
+inline V follow(V x, V y, V attack, V release)
+{
+    using std::max;
+    using std::min;
+    auto const up = y + attack * (x - y);
+    auto const down = y + release * (x - y);
+    return AttackFaster ? max(up, down) : min(up, down);
+}
+
+//! 1 - the one-pole coefficient for time constant `@param seconds`: the fraction of the way it moves each sample
+inline double step_for(double seconds, double fs) { return 1.0 - std::exp(-1.0 / math::max(seconds * fs, 1.0e-9)); }
+
+} // namespace envelope_detail
+
+/**
+ * @brief Envelope follower: a rectifier (|x| or x^2) into a one-pole smoother whose time constant depends on whether
+ * the level is rising (attack) or falling (release). Replaces its input with the envelope: the peak level, or for the
+ * RMS detector the square root of the smoothed power.
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels, sharing the times
+ * @tparam Detector what to follow
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1, envelope_detector Detector = envelope_detector::peak>
+struct envelope_follower
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    envelope_follower()
+    {
+        set_times(0.001, 0.1, 48000.0);
+        reset();
+    }
+
+    //! zeroes the envelopes
+    void reset() { y.fill(SampleType(0)); }
+
+    /**
+     * Sets the time constants, in seconds, at sampling rate `@param fs`
+     */
+    void set_times(double attack_seconds, double release_seconds, double fs)
+    {
+        attack_time = attack_seconds;
+        release_time = release_seconds;
+        attack = static_cast<SampleType>(envelope_detail::step_for(attack_seconds, fs));
+        release = static_cast<SampleType>(envelope_detail::step_for(release_seconds, fs));
+    }
+
+    //! returns the envelope after sample `@param sample` on channel `@param n`
+    SampleType process(SampleType sample, int n = 0)
+    {
+        auto& state = y[static_cast<size_t>(n)];
+        state = step(sample, state, attack, release);
+        return output(state, detector());
+    }
+
+    //! replaces `@param count` samples of channel `@param n` with their envelope
+    void process(SampleType* samples, int count, int n = 0)
+    {
+        auto& state = y[static_cast<size_t>(n)];
+        for (int i = 0; i < count; ++i)
+        {
+            state = step(samples[i], state, attack, release);
+            samples[i] = output(state, detector());
+        }
+    }
+
+    //! replaces every channel of `@param samples`, of shape (Channels, count), with its envelope, SIMD across channels
+    void process(SampleType** samples, int count)
+    {
+        simd::for_each_channel_group<SampleType, Channels>(samples, count, [this](V* x, int len, size_t j)
+        {
+            auto state = V::load(y.data() + j);
+            auto const a = V::broadcast(attack), r = V::broadcast(release);
+            for (int i = 0; i < len; ++i)
+            {
+                state = step(x[i], state, a, r);
+                x[i] = output(state, detector());
+            }
+            state.store(y.data() + j);
+        });
+    }
+
+private:
+    using V = simd::vec<SampleType>;
+    using detector = std::integral_constant<envelope_detector, Detector>;
+
+    double attack_time = 0, release_time = 0;
+    SampleType attack = 1, release = 1;
+    std::array<SampleType, simd::padded_count<SampleType>(Channels)> y;
+
+    template <typename T>
+    T step(T x, T state, T a, T r) const
+    {
+        auto const level = envelope_detail::rectify(x, detector());
+        return attack_time <= release_time ? envelope_detail::follow<true>(level, state, a, r)
+                                           : envelope_detail::follow<false>(level, state, a, r);
+    }
+
+    static SampleType output(SampleType state, std::integral_constant<envelope_detector, envelope_detector::peak>) { return state; }
+    static SampleType output(SampleType state, std::integral_constant<envelope_detector, envelope_detector::rms>) { return std::sqrt(state); }
+    static V output(V state, std::integral_constant<envelope_detector, envelope_detector::peak>) { return state; }
+    static V output(V state, std::integral_constant<envelope_detector, envelope_detector::rms>)
+    {
+        // no vector sqrt in simd::vec, so a lane at a time; RMS is the less common detector
+        std::array<SampleType, V::width> lanes;
+        state.store(lanes.data());
+        for (auto& l : lanes) { l = std::sqrt(l); }
+        return V::load(lanes.data());
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_ENVELOPEFOLLOWER_HEADERGUARD
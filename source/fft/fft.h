@@ -0,0 +1,472 @@
+/**
+ * Native FFT: complex and real-input transforms on power-of-two sizes.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_FFT_HEADERGUARD
+#define REDSP_FFT_HEADERGUARD
+
+#include <type_traits>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief A precomputed plan for a complex FFT of size 2^order, on split (separate real and imaginary) arrays.
+ * This is a Stockham autosort FFT: radix-4 stages (plus one radix-2 stage for odd orders) that ping-pong between two
+ * work buffers, so there's no bit-reversal pass. Each stage's inner loop runs over contiguous memory and is written
+ * with simd::vec, which falls back to scalar code where SIMD isn't available. The first stage, where the contiguous
+ * run is shorter than a register, is vectorized across butterflies instead.
+ * Transforms are unscaled, so inverse(forward(x)) = size * x.
+ */
+template <redsp_arithmetic T>
+struct fft_plan
+{
+    redsp_arithmetic_assert(T)
+    static_assert(std::is_floating_point<T>::value, "fft needs a floating point type");
+
+    explicit fft_plan(int order = 0) : n(1 << math::max(order, 0))
+    {
+        // stages for sub-length len and stride s: radix-4 while len >= 4, then radix-2 if one factor of 2 is left
+        for (int len = n, s = 1; len > 1; s *= (len >= 4 ? 4 : 2), len /= (len >= 4 ? 4 : 2))
+        {
+            stage st { len, s, twiddles.size() };
+            if (len >= 4)
+            {
+                auto m = static_cast<size_t>(len / 4);
+                twiddles.resize(twiddles.size() + 6 * m);
+                auto* w = twiddles.data() + st.offset;
+                for (size_t p = 0; p < m; ++p)
+                {
+                    for (size_t k = 1; k <= 3; ++k)
+                    {
+                        auto angle = -math::twopi<double>() * static_cast<double>(p * k) / len;
+                        w[(2 * k - 2) * m + p] = static_cast<T>(std::cos(angle));
+                        w[(2 * k - 1) * m + p] = static_cast<T>(std::sin(angle));
+                    }
+                }
+            }
+            stages.push_back(st);
+        }
+        work.resize(static_cast<size_t>(n) * 4);
+    }
+
+    int size() const { return n; }
+
+    /**
+     * Forward transform from (`@param in_re`, `@param in_im`) into (`@param out_re`, `@param out_im`). Input and
+     * output may be the same arrays. For the inverse transform, swap the real and imaginary pointers of both.
+     */
+    void forward(T const* in_re, T const* in_im, T* out_re, T* out_im)
+    {
+        if (stages.empty())
+        {
+            out_re[0] = in_re[0];
+            out_im[0] = in_im[0];
+            return;
+        }
+
+        if (stages.size() == 1 && (in_re == out_re || in_im == out_im))
+        {
+            run(in_re, in_im, re(0), im(0));
+            std::copy(re(0), re(0) + n, out_re);
+            std::copy(im(0), im(0) + n, out_im);
+            return;
+        }
+        run(in_re, in_im, out_re, out_im);
+    }
+
+    //! first work buffer pair, which forward() uses for input when it's passed the second pair
+    T* re(size_t i) { return work.data() + static_cast<size_t>(n) * 2 * i; }
+    T* im(size_t i) { return work.data() + static_cast<size_t>(n) * (2 * i + 1); }
+
+    //! index of the work buffer pair the final stage writes to when forward() reads from re(1)/im(1)
+    size_t result_buffer() const { return (stages.size() - 1) % 2; }
+
+private:
+    struct stage { int len, s; size_t offset; };
+
+    int n;
+    std::vector<stage> stages;
+    std::vector<T> twiddles;
+    std::vector<T> work;
+
+    using V = simd::vec<T>;
+    static constexpr int W = static_cast<int>(V::width);
+
+    void run(T const* in_re, T const* in_im, T* out_re, T* out_im)
+    {
+        auto const count = stages.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            T const* sr = i == 0 ? in_re : re((i - 1) % 2);
+            T const* si = i == 0 ? in_im : im((i - 1) % 2);
+            T* dr = i == count - 1 ? out_re : re(i % 2);
+            T* di = i == count - 1 ? out_im : im(i % 2);
+
+            auto const& st = stages[i];
+            if (st.len == 2) { radix2(st, sr, si, dr, di); }
+            else if (st.s >= W) { radix4(st, sr, si, dr, di); }
+            else if (st.s == 1 && (st.len / 4) % W == 0) { radix4_first(st, sr, si, dr, di); }
+            else { radix4_scalar(st, sr, si, dr, di); }
+        }
+    }
+
+    // complex multiply helpers on vectors of real and imaginary parts
+    static void cmul(V& r, V& i, V wr, V wi)
+    {
+        auto t = r * wr - i * wi;
+        i = r * wi + i * wr;
+        r = t;
+    }
+
+    //! y[q + s(4p + k)] from x[q + s(p + km)], vectorized over q
+    void radix4(stage const& st, T const* xr, T const* xi, T* yr, T* yi)
+    {
+        auto const s = st.s;
+        auto const m = st.len / 4;
+        auto const* w = twiddles.data() + st.offset;
+
+        for (int p = 0; p < m; ++p)
+        {
+            auto w1r = V::broadcast(w[p]),         w1i = V::broadcast(w[m + p]);
+            auto w2r = V::broadcast(w[2 * m + p]), w2i = V::broadcast(w[3 * m + p]);
+            auto w3r = V::broadcast(w[4 * m + p]), w3i = V::broadcast(w[5 * m + p]);
+
+            auto const* ar = xr + s * p;           auto const* ai = xi + s * p;
+            auto const* br = xr + s * (p + m);     auto const* bi = xi + s * (p + m);
+            auto const* cr = xr + s * (p + 2 * m); auto const* ci = xi + s * (p + 2 * m);
+            auto const* dr = xr + s * (p + 3 * m); auto const* di = xi + s * (p + 3 * m);
+            auto* y0r = yr + s * (4 * p);     auto* y0i = yi + s * (4 * p);
+            auto* y1r = yr + s * (4 * p + 1); auto* y1i = yi + s * (4 * p + 1);
+            auto* y2r = yr + s * (4 * p + 2); auto* y2i = yi + s * (4 * p + 2);
+            auto* y3r = yr + s * (4 * p + 3); auto* y3i = yi + s * (4 * p + 3);
+
+            for (int q = 0; q < s; q += W)
+            {
+                auto a_r = V::load(ar + q), a_i = V::load(ai + q);
+                auto b_r = V::load(br + q), b_i = V::load(bi + q);
+                auto c_r = V::load(cr + q), c_i = V::load(ci + q);
+                auto d_r = V::load(dr + q), d_i = V::load(di + q);
+
+                auto apc_r = a_r + c_r, apc_i = a_i + c_i;
+                auto amc_r = a_r - c_r, amc_i = a_i - c_i;
+                auto bpd_r = b_r + d_r, bpd_i = b_i + d_i;
+                auto bmd_r = b_r - d_r, bmd_i = b_i - d_i;
+
+                (apc_r + bpd_r).store(y0r + q);
+                (apc_i + bpd_i).store(y0i + q);
+
+                // amc -/+ j * bmd
+                auto o1r = amc_r + bmd_i, o1i = amc_i - bmd_r;
+                auto o2r = apc_r - bpd_r, o2i = apc_i - bpd_i;
+                auto o3r = amc_r - bmd_i, o3i = amc_i + bmd_r;
+                cmul(o1r, o1i, w1r, w1i);
+                cmul(o2r, o2i, w2r, w2i);
+                cmul(o3r, o3i, w3r, w3i);
+                o1r.store(y1r + q); o1i.store(y1i + q);
+                o2r.store(y2r + q); o2i.store(y2i + q);
+                o3r.store(y3r + q); o3i.store(y3i + q);
+            }
+        }
+    }
+
+    //! the stride-1 stage, vectorized across p, then scattered since outputs of neighbouring p are 4 apart
+    void radix4_first(stage const& st, T const* xr, T const* xi, T* yr, T* yi)
+    {
+        auto const m = st.len / 4;
+        auto const* w = twiddles.data() + st.offset;
+        T out[8][V::width];
+
+        for (int p = 0; p < m; p += W)
+        {
+            auto a_r = V::load(xr + p),         a_i = V::load(xi + p);
+            auto b_r = V::load(xr + p + m),     b_i = V::load(xi + p + m);
+            auto c_r = V::load(xr + p + 2 * m), c_i = V::load(xi + p + 2 * m);
+            auto d_r = V::load(xr + p + 3 * m), d_i = V::load(xi + p + 3 * m);
+
+            auto apc_r = a_r + c_r, apc_i = a_i + c_i;
+            auto amc_r = a_r - c_r, amc_i = a_i - c_i;
+            auto bpd_r = b_r + d_r, bpd_i = b_i + d_i;
+            auto bmd_r = b_r - d_r, bmd_i = b_i - d_i;
+
+            auto o1r = amc_r + bmd_i, o1i = amc_i - bmd_r;
+            auto o2r = apc_r - bpd_r, o2i = apc_i - bpd_i;
+            auto o3r = amc_r - bmd_i, o3i = amc_i + bmd_r;
+            cmul(o1r, o1i, V::load(w + p),         V::load(w + m + p));
+            cmul(o2r, o2i, V::load(w + 2 * m + p), V::load(w + 3 * m + p));
+            cmul(o3r, o3i, V::load(w + 4 * m + p), V::load(w + 5 * m + p));
+
+            (apc_r + bpd_r).store(out[0]); (apc_i + bpd_i).store(out[1]);
+            o1r.store(out[2]); o1i.store(out[3]);
+            o2r.store(out[4]); o2i.store(out[5]);
+            o3r.store(out[6]); o3i.store(out[7]);
+
+            for (int l = 0; l < W; ++l)
+            {
+                auto base = 4 * (p + l);
+                for (int k = 0; k < 4; ++k)
+                {
+                    yr[base + k] = out[2 * k][l];
+                    yi[base + k] = out[2 * k + 1][l];
+                }
+            }
+        }
+    }
+
+    void radix4_scalar(stage const& st, T const* xr, T const* xi, T* yr, T* yi)
+    {
+        auto const s = st.s;
+        auto const m = st.len / 4;
+        auto const* w = twiddles.data() + st.offset;
+
+        for (int p = 0; p < m; ++p)
+        {
+            for (int q = 0; q < s; ++q)
+            {
+                auto a = std::complex<T>(xr[q + s * p], xi[q + s * p]);
+                auto b = std::complex<T>(xr[q + s * (p + m)], xi[q + s * (p + m)]);
+                auto c = std::complex<T>(xr[q + s * (p + 2 * m)], xi[q + s * (p + 2 * m)]);
+                auto d = std::complex<T>(xr[q + s * (p + 3 * m)], xi[q + s * (p + 3 * m)]);
+                auto apc = a + c, amc = a - c, bpd = b + d;
+                auto jbmd = std::complex<T>(-(b - d).imag(), (b - d).real());
+
+                std::complex<T> y[4] = {
+                    apc + bpd,
+                    (amc - jbmd) * std::complex<T>(w[p], w[m + p]),
+                    (apc - bpd) * std::complex<T>(w[2 * m + p], w[3 * m + p]),
+                    (amc + jbmd) * std::complex<T>(w[4 * m + p], w[5 * m + p])
+                };
+                for (int k = 0; k < 4; ++k)
+                {
+                    yr[q + s * (4 * p + k)] = y[k].real();
+                    yi[q + s * (4 * p + k)] = y[k].imag();
+                }
+            }
+        }
+    }
+
+    //! the last stage of odd orders: no twiddles, y[q] = x[q] + x[q + s], y[q + s] = x[q] - x[q + s]
+    void radix2(stage const& st, T const* xr, T const* xi, T* yr, T* yi)
+    {
+        auto const s = st.s;
+        int q = 0;
+        for (; q + W <= s; q += W)
+        {
+            auto a_r = V::load(xr + q), a_i = V::load(xi + q);
+            auto b_r = V::load(xr + q + s), b_i = V::load(xi + q + s);
+            (a_r + b_r).store(yr + q);     (a_i + b_i).store(yi + q);
+            (a_r - b_r).store(yr + q + s); (a_i - b_i).store(yi + q + s);
+        }
+        for (; q < s; ++q)
+        {
+            auto a_r = xr[q], a_i = xi[q], b_r = xr[q + s], b_i = xi[q + s];
+            yr[q] = a_r + b_r;     yi[q] = a_i + b_i;
+            yr[q + s] = a_r - b_r; yi[q + s] = a_i - b_i;
+        }
+    }
+};
+
+/**
+ * @brief FFT of size 2^order, supporting orders from min_order to max_order (32 to 65536 points).
+ * Complex transforms take size() points, interleaved (std::complex) or split. Real transforms take size() real
+ * samples to size() / 2 + 1 bins (DC to nyquist) by running a half-size complex transform on the even/odd samples
+ * and untangling the result, which costs about half of a complex transform.
+ * Nothing is scaled: inverse(forward(x)) = size() * x, for both the complex and real transforms.
+ * Construction allocates; the transforms themselves don't, but they use internal scratch, so one fft object can't be
+ * shared between threads running transforms at the same time.
+ */
+template <redsp_arithmetic T>
+struct fft
+{
+    static constexpr int min_order = 5;
+    static constexpr int max_order = 16;
+
+    //! @param order log2 of the size, clamped to [min_order, max_order]
+    explicit fft(int order)
+        : n(1 << math::clip(min_order, max_order, order)),
+          full(math::clip(min_order, max_order, order)),
+          half(math::clip(min_order, max_order, order) - 1)
+    {
+        // e^(-2 pi i k / n) for k in [0, n/4], used to untangle the real transforms
+        auto quarter = static_cast<size_t>(n / 4);
+        tw_re.resize(quarter + 1);
+        tw_im.resize(quarter + 1);
+        for (size_t k = 0; k <= quarter; ++k)
+        {
+            auto angle = -math::twopi<double>() * static_cast<double>(k) / n;
+            tw_re[k] = static_cast<T>(std::cos(angle));
+            tw_im[k] = static_cast<T>(std::sin(angle));
+        }
+    }
+
+    int size() const { return n; }
+
+    //! number of bins produced by the real transform
+    int bins() const { return n / 2 + 1; }
+
+    //================================================================================================================//
+    //==                                                  COMPLEX                                                   ==//
+    //================================================================================================================//
+
+    void forward(T const* in_re, T const* in_im, T* out_re, T* out_im) { full.forward(in_re, in_im, out_re, out_im); }
+
+    void inverse(T const* in_re, T const* in_im, T* out_re, T* out_im) { full.forward(in_im, in_re, out_im, out_re); }
+
+    //! `@param in` and `@param out` may be the same array
+    void forward(std::complex<T> const* in, std::complex<T>* out) { interleaved(in, out, false); }
+
+    //! `@param in` and `@param out` may be the same array
+    void inverse(std::complex<T> const* in, std::complex<T>* out) { interleaved(in, out, true); }
+
+    //================================================================================================================//
+    //==                                                   REAL                                                     ==//
+    //================================================================================================================//
+
+    /**
+     * Transforms size() real samples from `@param in` into bins() bins in `@param out_re` and `@param out_im`.
+     */
+    void forward_real(T const* in, T* out_re, T* out_im)
+    {
+        auto* zr = half.re(1);
+        auto* zi = half.im(1);
+        auto const h = n / 2;
+        for (int i = 0; i < h; ++i)
+        {
+            zr[i] = in[2 * i];
+            zi[i] = in[2 * i + 1];
+        }
+        half.forward(zr, zi, half.re(half.result_buffer()), half.im(half.result_buffer()));
+        untangle(half.re(half.result_buffer()), half.im(half.result_buffer()), out_re, out_im);
+    }
+
+    void forward_real(T const* in, std::complex<T>* out)
+    {
+        auto* r = full.re(0);
+        auto* i = full.im(0);
+        forward_real(in, r, i);
+        for (int k = 0; k < bins(); ++k) { out[k] = std::complex<T>(r[k], i[k]); }
+    }
+
+    /**
+     * Transforms bins() bins from `@param in_re` and `@param in_im` back into size() real samples in `@param out`.
+     * The imaginary parts of the DC and nyquist bins are ignored.
+     */
+    void inverse_real(T const* in_re, T const* in_im, T* out)
+    {
+        auto* zr = half.re(1);
+        auto* zi = half.im(1);
+        tangle(in_re, in_im, zr, zi);
+
+        // inverse via swapped real/imaginary parts, so the result's real parts land in `im` and vice versa
+        auto* rr = half.re(half.result_buffer());
+        auto* ri = half.im(half.result_buffer());
+        half.forward(zi, zr, ri, rr);
+
+        auto const h = n / 2;
+        for (int i = 0; i < h; ++i)
+        {
+            out[2 * i] = rr[i];
+            out[2 * i + 1] = ri[i];
+        }
+    }
+
+    void inverse_real(std::complex<T> const* in, T* out)
+    {
+        auto* r = full.re(0);
+        auto* i = full.im(0);
+        for (int k = 0; k < bins(); ++k)
+        {
+            r[k] = in[k].real();
+            i[k] = in[k].imag();
+        }
+        inverse_real(r, i, out);
+    }
+
+private:
+    int n;
+    fft_plan<T> full, half;
+    std::vector<T> tw_re, tw_im;
+
+    void interleaved(std::complex<T> const* in, std::complex<T>* out, bool inverse)
+    {
+        // split into the second work buffer, which the plan can use as its input
+        auto* r = full.re(1);
+        auto* i = full.im(1);
+        for (int k = 0; k < n; ++k)
+        {
+            r[k] = in[k].real();
+            i[k] = in[k].imag();
+        }
+
+        auto* rr = full.re(full.result_buffer());
+        auto* ri = full.im(full.result_buffer());
+        if (inverse) { full.forward(i, r, ri, rr); }
+        else         { full.forward(r, i, rr, ri); }
+
+        for (int k = 0; k < n; ++k) { out[k] = std::complex<T>(rr[k], ri[k]); }
+    }
+
+    /**
+     * Given Z = FFT(x[2i] + j x[2i+1]) of size n/2, computes X[k] = E[k] + W^k O[k] for k in [0, n/2], with
+     * E[k] = (Z[k] + Z*[n/2-k]) / 2 and O[k] = (Z[k] - Z*[n/2-k]) / 2j. Bins k and n/2-k are done together.
+     */
+    void untangle(T const* zr, T const* zi, T* xr, T* xi) const
+    {
+        auto const h = n / 2;
+        xr[0] = zr[0] + zi[0];
+        xi[0] = 0;
+        xr[h] = zr[0] - zi[0];
+        xi[h] = 0;
+
+        for (int k = 1; k <= h / 2; ++k)
+        {
+            auto const c = h - k;
+            auto er = T(0.5) * (zr[k] + zr[c]), ei = T(0.5) * (zi[k] - zi[c]);
+            auto or_ = T(0.5) * (zi[k] + zi[c]), oi = T(-0.5) * (zr[k] - zr[c]);
+
+            auto wr = tw_re[static_cast<size_t>(k)], wi = tw_im[static_cast<size_t>(k)];
+            auto tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_;
+            xr[k] = er + tr;
+            xi[k] = ei + ti;
+            // X[n/2 - k] = E*[k] - (W^k O[k])* since W^(n/2-k) = -(W^k)*
+            xr[c] = er - tr;
+            xi[c] = ti - ei;
+        }
+    }
+
+    //! the inverse of untangle, scaled by 2 so that inverse_real(forward_real(x)) = n x
+    void tangle(T const* xr, T const* xi, T* zr, T* zi) const
+    {
+        auto const h = n / 2;
+        zr[0] = xr[0] + xr[h];
+        zi[0] = xr[0] - xr[h];
+
+        for (int k = 1; k <= h / 2; ++k)
+        {
+            auto const c = h - k;
+            auto er = xr[k] + xr[c], ei = xi[k] - xi[c];
+            auto dr = xr[k] - xr[c], di = xi[k] + xi[c];
+
+            // O = (X[k] - X*[n/2-k]) W^-k
+            auto wr = tw_re[static_cast<size_t>(k)], wi = -tw_im[static_cast<size_t>(k)];
+            auto or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+
+            // Z[k] = E + jO, Z[n/2-k] = E* + jO*
+            zr[k] = er - oi;
+            zi[k] = ei + or_;
+            zr[c] = er + oi;
+            zi[c] = or_ - ei;
+        }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_FFT_HEADERGUARD
@@ -0,0 +1,253 @@
+/**
+ * Short-time Fourier transform analysis/resynthesis with a callback on each frame's spectrum.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_STFT_HEADERGUARD
+#define REDSP_STFT_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include "fft.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+enum class stft_window
+{
+    rectangular = 0,
+    hann,       //!< periodic hann; as analysis and synthesis window it overlap-adds flat at a hop of size / 4
+    sqrt_hann,  //!< square root of periodic hann; analysis times synthesis is hann, flat at size / 2 or size / 4
+    hamming,
+    blackman
+};
+
+/**
+ * @brief Streaming STFT: the input is cut into windowed frames every hop samples, each frame's spectrum is handed to
+ * a callback to modify in place, and the inverse transforms are windowed again and overlap-added.
+ * The input and output run through ring buffers, so the host's block size has nothing to do with the hop size. Output
+ * is accumulated in a ring indexed by time, and a frame is computed as soon as its last sample arrives, so the latency
+ * is window_size() - 1 samples, the minimum for a causal STFT.
+ * The same window is used for analysis and synthesis, and the output is normalized so an untouched spectrum comes
+ * back as the input (delayed) whenever the squared window overlap-adds to a constant at the chosen hop.
+ * The callback is called as `callback(T* re, T* im, int bins, int channel)`, on the split real-FFT spectrum.
+ * @tparam SampleType sample type
+ * @tparam F spectrum callback
+ * @tparam Channels number of channels
+ */
+template <redsp_arithmetic SampleType, typename F, size_t Channels = 1>
+struct stft
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    F callback;
+
+    explicit stft(F f = F()) : callback(f) { }
+
+    /**
+     * Builds the window and allocates everything. Call this off the audio thread.
+     * @param fft_order log2 of the FFT size; clamped to the sizes redsp::fft supports
+     * @param window_size frame length, at most the FFT size; shorter frames are zero padded
+     * @param hop samples between frames, at most window_size
+     * @param window window shape
+     */
+    void prepare(int fft_order, int window_size, int hop, stft_window window = stft_window::sqrt_hann)
+    {
+        auto const order = math::clip(fft<SampleType>::min_order, fft<SampleType>::max_order, fft_order);
+        W = math::clip(1, 1 << order, window_size);
+        std::vector<SampleType> w(static_cast<size_t>(W));
+        for (int i = 0; i < W; ++i) { w[static_cast<size_t>(i)] = static_cast<SampleType>(window_value(window, i, W)); }
+        prepare(order, w, hop);
+    }
+
+    /**
+     * Like prepare(), with a custom window of any length up to the FFT size.
+     */
+    void prepare(int fft_order, std::vector<SampleType> const& window, int hop)
+    {
+        auto const order = math::clip(fft<SampleType>::min_order, fft<SampleType>::max_order, fft_order);
+        transform.reset(new fft<SampleType>(order));
+        N = transform->size();
+        W = math::clip(1, N, static_cast<int>(window.size()));
+        H = math::clip(1, W, hop);
+        R = W + H;
+
+        analysis.assign(window.begin(), window.begin() + W);
+
+        // the overlap-added product of analysis and synthesis windows, averaged over a hop, sets the output gain. The
+        // inverse transform's 1 / N goes in too
+        double sum = 0;
+        for (auto v : analysis) { sum += static_cast<double>(v) * static_cast<double>(v); }
+        auto const scale = sum > 0 ? H / (sum * N) : 0.0;
+        synthesis.resize(analysis.size());
+        for (size_t i = 0; i < analysis.size(); ++i) { synthesis[i] = static_cast<SampleType>(analysis[i] * scale); }
+
+        frame.assign(static_cast<size_t>(N), SampleType(0));
+        re.assign(static_cast<size_t>(transform->bins()), SampleType(0));
+        im.assign(static_cast<size_t>(transform->bins()), SampleType(0));
+        for (auto& s : state)
+        {
+            s.input.assign(static_cast<size_t>(W), SampleType(0));
+            s.output.assign(static_cast<size_t>(R), SampleType(0));
+        }
+        reset();
+    }
+
+    //! clears all history
+    void reset()
+    {
+        for (auto& s : state)
+        {
+            std::fill(s.input.begin(), s.input.end(), SampleType(0));
+            std::fill(s.output.begin(), s.output.end(), SampleType(0));
+            s.filled = 0;
+            s.now = 0;
+        }
+    }
+
+    int fft_size() const { return N; }
+    int window_size() const { return W; }
+    int hop_size() const { return H; }
+    int bins() const { return N / 2 + 1; }
+
+    //! in samples
+    int latency() const { return W - 1; }
+
+    /**
+     * Processes `@param count` samples from `@param input` into `@param output` on channel `@param n`. input and
+     * output may alias.
+     */
+    void process(SampleType const* input, SampleType* output, int count, int n = 0)
+    {
+        auto& s = state[static_cast<size_t>(n)];
+        while (count > 0)
+        {
+            // the newest hop of the input buffer fills up; once it's full a frame is due
+            auto const len = math::min(count, H - s.filled);
+            std::copy(input, input + len, s.input.data() + (W - H + s.filled));
+            s.filled += len;
+            if (s.filled == H)
+            {
+                run_frame(s, (s.now + len - 1) % R, n);
+                s.filled = 0;
+            }
+
+            // sample t reads time t - (W - 1), which is complete once any frame ending at t has been added
+            drain(s.output.data(), (s.now + H + 1) % R, output, len);
+            s.now = (s.now + len) % R;
+
+            input += len;
+            output += len;
+            count -= len;
+        }
+    }
+
+    void process(SampleType* samples, int count, int n = 0) { process(samples, samples, count, n); }
+
+    void process(SampleType** samples, int count)
+    {
+        for (int i = 0; i < static_cast<int>(Channels); ++i) { process(samples[i], count, i); }
+    }
+
+private:
+    struct channel_state
+    {
+        //! the last W input samples, oldest first, with the newest hop filling in at the end
+        std::vector<SampleType> input;
+        //! overlap-add accumulator, indexed by time modulo W + H. Up to W + H - 1 times are in flight: the ones being
+        //! accumulated by the frame that's just been computed, and the ones waiting to be read
+        std::vector<SampleType> output;
+        int filled = 0;
+        //! ring index of the next input sample's time
+        int now = 0;
+    };
+
+    int N = 0, W = 0, H = 0, R = 0;
+    std::unique_ptr<fft<SampleType>> transform;
+    std::vector<SampleType> analysis, synthesis, frame, re, im;
+    std::array<channel_state, Channels> state;
+
+    //! runs the frame ending at ring index `end`, on the sample that just arrived
+    void run_frame(channel_state& s, int end, int n)
+    {
+        multiply(s.input.data(), analysis.data(), frame.data(), W);
+        std::fill(frame.begin() + W, frame.end(), SampleType(0));
+        transform->forward_real(frame.data(), re.data(), im.data());
+        callback(re.data(), im.data(), bins(), n);
+        transform->inverse_real(re.data(), im.data(), frame.data());
+
+        // the frame covers times [end - W + 1, end]
+        auto const start = (end + H + 1) % R;
+        auto const first = math::min(W, R - start);
+        multiply_add(frame.data(), synthesis.data(), s.output.data() + start, first);
+        multiply_add(frame.data() + first, synthesis.data() + first, s.output.data(), W - first);
+
+        std::copy(s.input.data() + H, s.input.data() + W, s.input.data());
+    }
+
+    //! copies `count` samples out of the ring from `start`, zeroing them for the frames to come
+    void drain(SampleType* ring, int start, SampleType* out, int count)
+    {
+        auto const first = math::min(count, R - start);
+        std::copy(ring + start, ring + start + first, out);
+        std::fill(ring + start, ring + start + first, SampleType(0));
+        std::copy(ring, ring + (count - first), out + first);
+        std::fill(ring, ring + (count - first), SampleType(0));
+    }
+
+    static void multiply(SampleType const* a, SampleType const* b, SampleType* out, int count)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+        int i = 0;
+        for (; i + w <= count; i += w) { (V::load(a + i) * V::load(b + i)).store(out + i); }
+        for (; i < count; ++i) { out[i] = a[i] * b[i]; }
+    }
+
+    static void multiply_add(SampleType const* a, SampleType const* b, SampleType* acc, int count)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+        int i = 0;
+        for (; i + w <= count; i += w) { mul_add(V::load(a + i), V::load(b + i), V::load(acc + i)).store(acc + i); }
+        for (; i < count; ++i) { acc[i] += a[i] * b[i]; }
+    }
+
+    static double window_value(stft_window window, int i, int size)
+    {
+        auto const x = math::twopi<double>() * i / size;
+        switch (window)
+        {
+            case stft_window::hann:        return 0.5 - 0.5 * std::cos(x);
+            case stft_window::sqrt_hann:   return std::sqrt(0.5 - 0.5 * std::cos(x));
+            case stft_window::hamming:     return 0.54 - 0.46 * std::cos(x);
+            case stft_window::blackman:    return 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+            case stft_window::rectangular: return 1.0;
+        }
+        return 1.0;
+    }
+};
+
+/**
+ * Makes an stft from a functor or lambda, e.g.
+ * `auto gate = make_stft<float>([](float* re, float* im, int bins, int) { ... });`
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1, typename F>
+stft<SampleType, F, Channels> make_stft(F f)
+{
+    return stft<SampleType, F, Channels>(f);
+}
+
+} // namespace redsp
+
+#endif // REDSP_STFT_HEADERGUARD
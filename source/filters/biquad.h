@@ -8,6 +8,9 @@
 
 #include <type_traits>
 #include <array>
+#include <limits>
+#include "../internal/denormals.h"
+#include "../internal/precision.h"
 #include "../internal/remath.h"
 #include "../internal/universal.h"
 
@@ -18,13 +21,146 @@
 
 namespace redsp {
 
-template <redsp_arithmetic SampleType, redsp_arithmetic CoeffType, size_t Channels = 1, bool SingleSampleProcessing = false>
+/**
+ * @brief The five coefficients of a biquad, with constexpr designs for each response.
+ * For a filter whose frequency and sampling rate are known at compile time (a DC blocker, K-weighting, a fixed
+ * crossover), declaring the design constexpr leaves nothing to compute at startup:
+ *     static constexpr auto hp = biquad_coefficients<double>::hp(20.0, 48000.0, 0.7071);
+ *     filter.set_coefficients(hp);
+ * The designs from a frequency prewarp with math::tan_constexpr, so they're exact where biquad::calc_lp() and the
+ * like use math::tan_fast; the _direct designs take k = tan(pi f) and match those of biquad bit for bit.
+ */
+template <redsp_arithmetic CoeffType>
+struct biquad_coefficients
+{
+    redsp_arithmetic_assert(CoeffType)
+
+    CoeffType a1, a2, b0, b1, b2;
+
+    //! k = tan(pi * f) for normalized frequency `@param f`, in a constant expression
+    static constexpr CoeffType prewarp(CoeffType f) { return math::tan_constexpr(math::pi<CoeffType>() * f); }
+
+    static constexpr biquad_coefficients lp_direct(CoeffType k, CoeffType q)
+    {
+        auto const kk = k * k;
+        auto const den = kk * q + k + q;
+        auto const b0 = kk * q;
+        return { (2 * q * (kk - 1)) / den, (den-k-k) / den, b0 / den, (2 * b0) / den, b0 / den };
+    }
+
+    static constexpr biquad_coefficients hp_direct(CoeffType k, CoeffType q)
+    {
+        auto const kk = k * k;
+        auto const den = kk * q + k + q;
+        return { (2*q*(kk-1)) / den, (den-k-k) / den, q / den, (-2 * q) / den, q / den };
+    }
+
+    static constexpr biquad_coefficients bp_direct(CoeffType k, CoeffType q)
+    {
+        auto const kk = k * k;
+        auto const den = kk * q + k + q;
+        return { (2 * q * (kk - 1)) / den, (den-k-k) / den, k / den, 0, -k / den };
+    }
+
+    static constexpr biquad_coefficients br_direct(CoeffType k, CoeffType q)
+    {
+        auto const kk = k * k;
+        auto const den = kk * q + k + q;
+        auto const b0 = (q * (1 + kk)) / den;
+        return { (2 * q * (kk - 1)) / den, (den-k-k) / den, b0, (2 * q * (kk - 1)) / den, b0 };
+    }
+
+    static constexpr biquad_coefficients ap_direct(CoeffType k, CoeffType q)
+    {
+        auto const kk = k * k;
+        auto const den = kk * q + k + q;
+        auto const b0 = (den-k-k) / den;
+        auto const b1 = (2 * q * (kk - 1)) / den;
+        return { b1, b0, b0, b1, 1 };
+    }
+
+    //! lowpass at normalized frequency `@param f` with Q `@param q`
+    static constexpr biquad_coefficients lp(CoeffType f, CoeffType q) { return lp_direct(prewarp(f), q); }
+    //! highpass at normalized frequency `@param f` with Q `@param q`
+    static constexpr biquad_coefficients hp(CoeffType f, CoeffType q) { return hp_direct(prewarp(f), q); }
+    //! bandpass around normalized frequency `@param f` with Q `@param q`
+    static constexpr biquad_coefficients bp(CoeffType f, CoeffType q) { return bp_direct(prewarp(f), q); }
+    //! bandreject around normalized frequency `@param f` with Q `@param q`
+    static constexpr biquad_coefficients br(CoeffType f, CoeffType q) { return br_direct(prewarp(f), q); }
+    //! allpass turning at normalized frequency `@param f` with Q `@param q`
+    static constexpr biquad_coefficients ap(CoeffType f, CoeffType q) { return ap_direct(prewarp(f), q); }
+
+    static constexpr biquad_coefficients lp(CoeffType fc, CoeffType fs, CoeffType q) { return lp(fc / fs, q); }
+    static constexpr biquad_coefficients hp(CoeffType fc, CoeffType fs, CoeffType q) { return hp(fc / fs, q); }
+    static constexpr biquad_coefficients bp(CoeffType fc, CoeffType fs, CoeffType q) { return bp(fc / fs, q); }
+    static constexpr biquad_coefficients br(CoeffType fc, CoeffType fs, CoeffType q) { return br(fc / fs, q); }
+    static constexpr biquad_coefficients ap(CoeffType fc, CoeffType fs, CoeffType q) { return ap(fc / fs, q); }
+
+    /**
+     * The most the recursion amplifies rounding in the state, as a power gain: the peak of 1 / |A|^2 on the unit
+     * circle, A = 1 + a1 z^-1 + a2 z^-2. It's at DC, at nyquist or, with resonant poles, where |A| bottoms out, so it's
+     * found without any trig.
+     */
+    constexpr double noise_power_gain() const
+    {
+        auto least = math::min(denominator_power(1), denominator_power(-1));
+        auto const c = a2 > 0 ? -static_cast<double>(a1) * (1 + static_cast<double>(a2)) / (4 * static_cast<double>(a2)) : 2.0;
+        if (c > -1 && c < 1) { least = math::min(least, denominator_power(c)); }
+        return least > 0 ? 1 / least : std::numeric_limits<double>::infinity();
+    }
+
+    //! |A|^2 at the frequency whose cosine is `@param c`
+    constexpr double denominator_power(double c) const
+    {
+        auto const p = static_cast<double>(a1), q = static_cast<double>(a2);
+        return 1 + p * p + q * q + 2 * p * (1 + q) * c + 2 * q * (2 * c * c - 1);
+    }
+};
+
+/**
+ * @brief Whether a biquad designed as `@param c` can keep its state in float and hold its rounding noise under
+ * `@param tolerance` of full scale. Each output stored rounds by up to half a float ulp, 2^-24 of full scale, and the
+ * recursion amplifies that by noise_power_gain(). At the default -100dB, Q 0.7071 designs need double state below
+ * about 0.012 fs (590Hz at 48kHz), and resonance raises that.
+ */
+template <redsp_arithmetic CoeffType>
+constexpr bool float_state_suffices(biquad_coefficients<CoeffType> const& c, double tolerance = 1.0e-5)
+{
+    constexpr double rounding = 1.0 / 16777216.0;
+    return rounding * rounding * c.noise_power_gain() <= tolerance * tolerance;
+}
+
+/**
+ * As above, for a design at normalized frequency `@param f` and Q `@param q`: the poles, and so the noise, are the same
+ * whichever response it is. Usable at compile time, where cheapest_precision turns it into a type:
+ *     biquad_with<cheapest_precision<float_state_suffices(20.0 / 48000.0, 0.7071)>> highpass;
+ * and at run time, to choose between two instantiations.
+ */
+constexpr bool float_state_suffices(double f, double q, double tolerance = 1.0e-5)
+{
+    return float_state_suffices(biquad_coefficients<double>::lp(f, q), tolerance);
+}
+
+/**
+ * @brief A direct form I biquad.
+ * @tparam SampleType the samples read and written
+ * @tparam CoeffType the coefficients
+ * @tparam StateType the history between samples; SampleType unless given. Wider than SampleType (float samples, double
+ * state) keeps the precision a low cutoff needs without widening the buffers; see biquad_with and float_state_suffices.
+ */
+template <redsp_arithmetic SampleType, redsp_arithmetic CoeffType, size_t Channels = 1, bool SingleSampleProcessing = false,
+          redsp_arithmetic StateType = SampleType>
 struct biquad
 {
     redsp_arithmetic_assert(SampleType)
     redsp_arithmetic_assert(CoeffType)
+    redsp_arithmetic_assert(StateType)
     static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
 
+    using sample_type = SampleType;
+    using state_type = StateType;
+    static constexpr size_t channels = Channels;
+
     enum class Type
     {
         Lowpass = 0,
@@ -36,14 +172,78 @@ struct biquad
     };
 
     CoeffType a1, a2, b0, b1, b2;
-    std::array<std::array<SampleType, 2>, Channels> x;
-    std::array<std::array<SampleType, 2>, Channels> y;
+    std::array<std::array<StateType, 2>, Channels> x;
+    std::array<std::array<StateType, 2>, Channels> y;
 
     biquad() = default;
+
+    //! takes the coefficients of `@param c`, which may well have been designed at compile time
+    void set_coefficients(biquad_coefficients<CoeffType> const& c)
+    {
+        a1 = c.a1;
+        a2 = c.a2;
+        b0 = c.b0;
+        b1 = c.b1;
+        b2 = c.b2;
+    }
+
+    biquad_coefficients<CoeffType> coefficients() const { return { a1, a2, b0, b1, b2 }; }
+
+    //! zeroes the filter state on every channel
+    void reset()
+    {
+        for (auto& X : x) { X.fill(StateType(0)); }
+        for (auto& Y : y) { Y.fill(StateType(0)); }
+    }
+
+    /**
+     * With `@param on`, each block processed on a channel ends by zeroing its x and y history once it has decayed below
+     * denormal_floor(), so a silent tail can't reach the denormal range. Off by default; for when scoped_denormal_disable
+     * isn't available.
+     */
+    void set_denormal_flush(bool on) { denormal_flush = on; }
+
 private:
-    inline SampleType td2(SampleType const& x0, SampleType const& x1, SampleType const& x2, SampleType const& y1, SampleType const& y2 )
+    bool denormal_flush = false;
+
+    static constexpr bool widened = ! std::is_same<StateType, SampleType>::value;
+
+    inline StateType td2(StateType const& x0, StateType const& x1, StateType const& x2, StateType const& y1, StateType const& y2 )
     {
-        return b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        return static_cast<StateType>(b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2);
+    }
+
+    //! the block loop when the state is wider than the samples: the history is carried in StateType rather than read
+    //! back from the output, so only what's written out gets rounded. `@param input` may be `@param output`.
+    void process_widened(SampleType const* input, SampleType* output, int count, int n)
+    {
+        auto& X = x[static_cast<typename decltype(x)::size_type>(n)];
+        auto& Y = y[static_cast<typename decltype(y)::size_type>(n)];
+        auto x1 = X[0], x2 = X[1], y1 = Y[0], y2 = Y[1];
+        for (int i = 0; i < count; ++i)
+        {
+            auto const in = static_cast<StateType>(input[i]);
+            auto const out = td2(in, x1, x2, y1, y2);
+            x2 = x1;
+            x1 = in;
+            y2 = y1;
+            y1 = out;
+            output[i] = static_cast<SampleType>(out);
+        }
+        X[0] = x1;
+        X[1] = x2;
+        Y[0] = y1;
+        Y[1] = y2;
+        end_block(n);
+    }
+
+    void end_block(int n)
+    {
+        if (denormal_flush)
+        {
+            flush_denormal(x[static_cast<size_t>(n)]);
+            flush_denormal(y[static_cast<size_t>(n)]);
+        }
     }
 public:
 
@@ -52,15 +252,16 @@ public:
     {
         auto& X = x[static_cast<typename decltype(x)::size_type>(n)];
         auto& Y = y[static_cast<typename decltype(y)::size_type>(n)];
-        auto s = td2(sample, X[0], X[1], Y[0], Y[1]);
+        auto const in = static_cast<StateType>(sample);
+        auto s = td2(in, X[0], X[1], Y[0], Y[1]);
 
         // shuffle - avoided in process(SampleType*, int, int) when
         X[1] = X[0];
-        X[0] = sample;
+        X[0] = in;
         Y[1] = Y[0];
         Y[0] = s;
 
-        return s;
+        return static_cast<SampleType>(s);
     }
 
     template<class enabled = std::enable_if<SingleSampleProcessing, void>>
@@ -70,6 +271,7 @@ public:
         {
             *s = process(*s, n);
         }
+        end_block(n);
     }
 
     /**
@@ -81,31 +283,44 @@ public:
     template<class enabled = std::enable_if<! SingleSampleProcessing, void>>
     void process_optimized(SampleType *const samples, int count, int n = 0)
     {
-        auto& X = x[n];
-        auto& Y = y[n];
+        if (widened)
+        {
+            process_widened(samples, samples, count, n);
+            return;
+        }
 
-        auto* s = samples;
+        auto& X = x[static_cast<typename decltype(x)::size_type>(n)];
+        auto& Y = y[static_cast<typename decltype(y)::size_type>(n)];
 
-        // process the first two samples normally, so that there's room to process without referencing Y
-        for (; s != samples + 2; ++s)
+        // the inputs are overwritten as we go, so the last two are carried along; once the first two outputs are
+        // written, the last two outputs are read straight back from the buffer
+        auto x1 = X[0], x2 = X[1], y1 = Y[0], y2 = Y[1];
+        int i = 0;
+        for (; i < count && i < 2; ++i)
         {
-            auto sample = td2(*s, X[0], X[1], Y[0], Y[1]);
-            X[1] = X[0];
-            X[0] = sample;
-            *s = sample;
+            auto const in = samples[i];
+            auto const out = td2(in, x1, x2, y1, y2);
+            x2 = x1;
+            x1 = in;
+            y2 = y1;
+            y1 = out;
+            samples[i] = out;
         }
 
-        for (; s != samples + count; ++s)
+        for (; i < count; ++i)
         {
-            auto sample = td2(*s, X[0], X[1], *(s-1), *(s-2));
-            X[1] = X[0];
-            X[0] = sample;
-            *s = sample;
+            auto const in = samples[i];
+            samples[i] = td2(in, x1, x2, samples[i - 1], samples[i - 2]);
+            x2 = x1;
+            x1 = in;
         }
 
-        // fill Y with the correct samples for the next buffer
-        Y[0] = *(samples + count - 1);
-        Y[1] = *(samples + count - 2);
+        // fill X and Y with the correct samples for the next buffer
+        X[0] = x1;
+        X[1] = x2;
+        Y[0] = count >= 2 ? samples[count - 1] : y1;
+        Y[1] = count >= 2 ? samples[count - 2] : y2;
+        end_block(n);
     }
 
     /**
@@ -119,8 +334,20 @@ public:
     template<class enabled = std::enable_if<! SingleSampleProcessing, void>>
     void process_optimized(SampleType const *const input, SampleType *const output, int count, int n = 0)
     {
-        auto& X = x[n];
-        auto& Y = y[n];
+        if (widened)
+        {
+            process_widened(input, output, count, n);
+            return;
+        }
+        if (count < 2)
+        {
+            for (int i = 0; i < count; ++i) { output[i] = process(input[i], n); }
+            end_block(n);
+            return;
+        }
+
+        auto& X = x[static_cast<typename decltype(x)::size_type>(n)];
+        auto& Y = y[static_cast<typename decltype(y)::size_type>(n)];
 
         output[0] = td2(input[0], X[0], X[1], Y[0], Y[1]);
         output[1] = td2(input[1], input[0], X[0], output[0], Y[0]);
@@ -134,27 +361,28 @@ public:
         Y[1] = output[count - 2];
         X[0] = input[count - 1];
         X[1] = input[count - 2];
+        end_block(n);
     }
 
 
     template<class enabled = std::enable_if<Channels != 1 && ! SingleSampleProcessing>>
     void process_optimized(SampleType** samples, int count)
     {
-        for (int i = 0; i < Channels; ++i) { process_optimized(samples[count * i], count); }
+        for (size_t i = 0; i < Channels; ++i) { process_optimized(samples[i], count, static_cast<int>(i)); }
     }
 
     template<class enabled = std::enable_if<Channels != 1 && ! SingleSampleProcessing>>
     void process_optimized(SampleType** input, SampleType** output, int count)
     {
-        for (int i = 0; i < Channels; ++i) { process_optimized(input[count * i], output[count * i], count); }
+        for (size_t i = 0; i < Channels; ++i) { process_optimized(input[i], output[i], count, static_cast<int>(i)); }
     }
 
     template<class enabled = std::enable_if<Channels != 1>>
     void process(SampleType** samples, int count )
     {
-        for (int i = 0; i < Channels; ++i)
+        for (size_t i = 0; i < Channels; ++i)
         {
-            process(samples[count * i], count);
+            process(samples[i], count, static_cast<int>(i));
         }
     }
 
@@ -187,14 +415,7 @@ public:
      */
     void calc_lp_direct(CoeffType k, CoeffType q)
     {
-        auto kk = k * k;
-        auto den = kk * q + k + q;
-        b0 = kk * q;
-        b1 = (2 * b0) / den;
-        b0 /= den;
-        b2 = b0;
-        a1 = (2 * q * (kk - 1)) / den;
-        a2 = (den-k-k) / den;
+        set_coefficients(biquad_coefficients<CoeffType>::lp_direct(k, q));
     }
 
     /**
@@ -225,13 +446,7 @@ public:
      */
     void calc_hp_direct(CoeffType k, CoeffType q)
     {
-        auto kk = k * k;
-        auto den = kk * q + k + q;
-        b0 = q / den;
-        b1 = (-2 * q) / den;
-        b2 = b0;
-        a1 = (2*q*(kk-1)) / den;
-        a2 = (den-k-k) / den;
+        set_coefficients(biquad_coefficients<CoeffType>::hp_direct(k, q));
     }
 
     /**
@@ -262,13 +477,7 @@ public:
      */
     void calc_bp_direct(CoeffType k, CoeffType q)
     {
-        auto kk = k * k;
-        auto den = kk * q + k + q;
-        b0 = k / den;
-        b1 = 0;
-        b2 = -k / den;
-        a1 = (2 * q * (kk - 1)) / den;
-        a2 = (den-k-k) / den;
+        set_coefficients(biquad_coefficients<CoeffType>::bp_direct(k, q));
     }
 
     /**
@@ -299,13 +508,7 @@ public:
      */
     void calc_ap_direct(CoeffType k, CoeffType q)
     {
-        auto kk = k * k;
-        auto den = kk * q + k + q;
-        b0 = (den-k-k) / den;
-        b1 = (2 * q * (kk - 1)) / den;
-        b2 = 1;
-        a1 = b1;
-        a2 = b0;
+        set_coefficients(biquad_coefficients<CoeffType>::ap_direct(k, q));
     }
 
     /**
@@ -336,13 +539,7 @@ public:
      */
     void calc_br_direct(CoeffType k, CoeffType q)
     {
-        auto kk = k * k;
-        auto den = kk * q + k + q;
-        b0 = (q * (1 + kk)) / den;
-        b1 = (2 * q * (kk - 1)) / den;
-        b2 = b0;
-        a1 = (2 * q * (kk - 1)) / den;
-        a2 = (den-k-k) / den;
+        set_coefficients(biquad_coefficients<CoeffType>::br_direct(k, q));
     }
 
     template <Type FilterType>
@@ -364,6 +561,13 @@ public:
 #endif
 };
 
+/**
+ * A biquad working in the types of `@tparam Precision` (a redsp::precision), for instance float buffers with double
+ * state: biquad_with<mixed_precision>.
+ */
+template <typename Precision, size_t Channels = 1>
+using biquad_with = biquad<typename Precision::io_type, typename Precision::coeff_type, Channels, false, typename Precision::state_type>;
+
 } // namespace redsp
 
 #endif // REDSP_BIQUAD_HEADERGUARD
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * Fuses a series of per-sample filters into a single pass.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_FILTERCHAIN_HEADERGUARD
+#define REDSP_FILTERCHAIN_HEADERGUARD
+
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Runs a series of filters as one: each sample goes through every stage before the next sample is read, so a
+ * block is loaded and stored once rather than once per stage, and the stages' recursions overlap in the pipeline.
+ * A DC blocker in front of a biquad, for instance, costs little more than the biquad alone.
+ * Any stage with `SampleType process(SampleType, int channel)` will do: biquad, ladder, tpt_one_pole,
+ * leaky_integrator, dc_blocker, or another filter_chain. The stages are public through get<I>() for setting up.
+ * @tparam Stages the filters, in processing order. The first one sets the sample type and channel count.
+ */
+template <typename... Stages>
+struct filter_chain
+{
+    static_assert(sizeof...(Stages) > 0, "A chain needs at least one stage");
+
+    using first_type = typename std::tuple_element<0, std::tuple<Stages...>>::type;
+    using sample_type = typename first_type::sample_type;
+    static constexpr size_t channels = first_type::channels;
+
+    filter_chain() { reset(); }
+
+    template <size_t I>
+    typename std::tuple_element<I, std::tuple<Stages...>>::type& get() { return std::get<I>(stages); }
+
+    template <size_t I>
+    typename std::tuple_element<I, std::tuple<Stages...>>::type const& get() const { return std::get<I>(stages); }
+
+    //! resets every stage that has a reset()
+    void reset() { reset_stages(std::index_sequence_for<Stages...>()); }
+
+    //! runs one sample of channel `@param n` through every stage
+    sample_type process(sample_type sample, int n = 0)
+    {
+        return run(sample, n, std::index_sequence_for<Stages...>());
+    }
+
+    //! runs `@param count` samples of channel `@param n` through every stage, in place and in one pass
+    void process(sample_type* samples, int count, int n = 0)
+    {
+        for (int i = 0; i < count; ++i) { samples[i] = run(samples[i], n, std::index_sequence_for<Stages...>()); }
+    }
+
+    //! runs every channel of `@param samples`, of shape (channels, count), in place
+    void process(sample_type** samples, int count)
+    {
+        for (size_t c = 0; c < channels; ++c) { process(samples[c], count, static_cast<int>(c)); }
+    }
+
+private:
+    std::tuple<Stages...> stages;
+
+    template <typename Stage>
+    static auto reset_stage(Stage& stage, int) -> decltype(stage.reset(), void()) { stage.reset(); }
+    template <typename Stage>
+    static void reset_stage(Stage&, long) { }
+
+    template <size_t... I>
+    void reset_stages(std::index_sequence<I...>)
+    {
+        using expand = int[];
+        (void) expand { 0, (reset_stage(std::get<I>(stages), 0), 0)... };
+    }
+
+    template <size_t... I>
+    sample_type run(sample_type x, int n, std::index_sequence<I...>)
+    {
+        // a braced list is evaluated left to right, which makes it a fold over the stages in C++14
+        using expand = int[];
+        (void) expand { 0, (x = std::get<I>(stages).process(x, n), 0)... };
+        return x;
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_FILTERCHAIN_HEADERGUARD
@@ -0,0 +1,344 @@
+/**
+ * Direct-form FIR filters: plain, decimating and interpolating, with SIMD dot product kernels.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_FIR_HEADERGUARD
+#define REDSP_FIR_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+namespace fir_detail {
+
+//! fixed-size storage when N is known at compile time, a vector sized at runtime when it's 0
+template <typename T, size_t N>
+struct storage
+{
+    using type = std::array<T, N>;
+    static void allocate(type& s, size_t) { s.fill(T(0)); }
+};
+
+template <typename T>
+struct storage<T, 0>
+{
+    using type = std::vector<T>;
+    static void allocate(type& s, size_t size) { s.assign(size, T(0)); }
+};
+
+/**
+ * @brief Double-length circular buffer holding the last N inputs. Every sample is written twice, N apart, so the
+ * newest N samples are always contiguous (oldest first) and the dot product never has to wrap.
+ */
+template <typename T, size_t N>
+struct history
+{
+    typename storage<T, 2 * N>::type data;
+    int size = static_cast<int>(N), pos = 0;
+
+    history() { allocate(static_cast<int>(N)); }
+
+    void allocate(int n)
+    {
+        size = N ? static_cast<int>(N) : math::max(n, 1);
+        storage<T, 2 * N>::allocate(data, static_cast<size_t>(2 * size));
+        pos = 0;
+    }
+
+    void reset()
+    {
+        std::fill(data.begin(), data.end(), T(0));
+        pos = 0;
+    }
+
+    int length() const { return N ? static_cast<int>(N) : size; }
+
+    //! pushes `x` and returns the newest length() samples, oldest first
+    T const* push(T x)
+    {
+        auto const n = length();
+        pos = pos + 1 == n ? 0 : pos + 1;
+        data[static_cast<size_t>(pos)] = x;
+        data[static_cast<size_t>(pos + n)] = x;
+        return data.data() + pos + 1;
+    }
+};
+
+} // namespace fir_detail
+
+/**
+ * @brief Designs a linear-phase lowpass as a Kaiser-windowed sinc, normalized to unity gain at DC. Allocates, so call
+ * it off the audio thread.
+ * @param taps number of taps; odd lengths put the center of symmetry on a sample
+ * @param cutoff cutoff frequency, normalized to the sampling rate (0, 0.5)
+ * @param beta Kaiser window beta (8 gives roughly 80dB of stopband attenuation)
+ */
+template <redsp_arithmetic T>
+std::vector<T> kaiser_lowpass(int taps, double cutoff, double beta = 8.0)
+{
+    redsp_arithmetic_assert(T)
+    taps = math::max(taps, 1);
+    std::vector<double> h(static_cast<size_t>(taps));
+    auto const c = 0.5 * (taps - 1);
+    double sum = 0;
+    for (int i = 0; i < taps; ++i)
+    {
+        auto d = i - c;
+        auto r = c > 0 ? d / c : 0.0;
+        auto sinc = d == 0 ? 2.0 * cutoff : std::sin(math::twopi<double>() * cutoff * d) / (math::pi<double>() * d);
+        h[static_cast<size_t>(i)] = sinc * math::bessel_i0(beta * std::sqrt(math::max(0.0, 1.0 - r * r)))
+                                    / math::bessel_i0(beta);
+        sum += h[static_cast<size_t>(i)];
+    }
+
+    std::vector<T> result(h.size());
+    for (size_t i = 0; i < h.size(); ++i) { result[i] = static_cast<T>(h[i] / sum); }
+    return result;
+}
+
+/**
+ * @brief Direct-form FIR filter. The history is a double-length circular buffer, so each output is one contiguous
+ * SIMD dot product against the reversed coefficients.
+ * When Taps is nonzero the coefficients and history live inline and the dot product's length is a compile-time
+ * constant, which lets short filters (crossovers, small halfbands) unroll completely. With Taps = 0 the length is set
+ * by set_coefficients() at runtime.
+ * @tparam SampleType sample type
+ * @tparam Taps number of taps, or 0 to choose at runtime
+ * @tparam Channels number of channels
+ */
+template <redsp_arithmetic SampleType, size_t Taps = 0, size_t Channels = 1>
+struct fir
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    fir() { coefficients_storage::allocate(coeffs, Taps); }
+
+    /**
+     * Sets the impulse response and clears the history. With Taps = 0 this allocates; otherwise `@param count` must
+     * be at most Taps, and the rest of the taps are zeroed.
+     * @param h impulse response, h[0] applied to the newest sample
+     * @param count number of taps in h
+     */
+    void set_coefficients(SampleType const* h, int count)
+    {
+        count = math::max(count, 0);
+        auto const n = Taps ? static_cast<int>(Taps) : math::max(count, 1);
+        count = math::min(count, n);
+        coefficients_storage::allocate(coeffs, static_cast<size_t>(n));
+        for (int i = 0; i < count; ++i) { coeffs[static_cast<size_t>(n - 1 - i)] = h[i]; }
+        for (auto& s : state) { s.allocate(n); }
+    }
+
+    void set_coefficients(std::vector<SampleType> const& h) { set_coefficients(h.data(), static_cast<int>(h.size())); }
+
+    void reset() { for (auto& h : state) { h.reset(); } }
+
+    int taps() const { return Taps ? static_cast<int>(Taps) : static_cast<int>(coeffs.size()); }
+
+    //! group delay in samples, assuming the coefficients are symmetric (linear phase)
+    double latency() const { return 0.5 * (taps() - 1); }
+
+    SampleType process(SampleType sample, int n = 0)
+    {
+        auto* window = state[static_cast<size_t>(n)].push(sample);
+        return simd::dot(coeffs.data(), window, taps());
+    }
+
+    /**
+     * Filters `@param count` samples from `@param input` into `@param output` on channel `@param n`. input and output
+     * may alias.
+     */
+    void process(SampleType const* input, SampleType* output, int count, int n = 0)
+    {
+        auto& h = state[static_cast<size_t>(n)];
+        for (int i = 0; i < count; ++i) { output[i] = simd::dot(coeffs.data(), h.push(input[i]), taps()); }
+    }
+
+    void process(SampleType* samples, int count, int n = 0) { process(samples, samples, count, n); }
+
+    void process(SampleType** samples, int count)
+    {
+        for (int i = 0; i < static_cast<int>(Channels); ++i) { process(samples[i], count, i); }
+    }
+
+private:
+    using coefficients_storage = fir_detail::storage<SampleType, Taps>;
+
+    typename coefficients_storage::type coeffs;
+    std::array<fir_detail::history<SampleType, Taps>, Channels> state;
+};
+
+/**
+ * @brief FIR filter followed by decimation by Factor: y[m] = (h * x)[m * Factor]. Every input goes into the history,
+ * but the dot product only runs for the outputs that are kept, so it costs Taps / Factor multiply-adds per input.
+ * The decimation phase is tracked per channel, so calls can have any length.
+ * @tparam SampleType sample type
+ * @tparam Factor decimation factor
+ * @tparam Taps number of taps, or 0 to choose at runtime
+ * @tparam Channels number of channels
+ */
+template <redsp_arithmetic SampleType, size_t Factor, size_t Taps = 0, size_t Channels = 1>
+struct fir_decimator
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Factor > 0, "Factor must be positive");
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+    static constexpr size_t factor = Factor;
+
+    fir_decimator() { coefficients_storage::allocate(coeffs, Taps); }
+
+    //! see fir::set_coefficients(). Also resets the decimation phase
+    void set_coefficients(SampleType const* h, int count)
+    {
+        count = math::max(count, 0);
+        auto const n = Taps ? static_cast<int>(Taps) : math::max(count, 1);
+        count = math::min(count, n);
+        coefficients_storage::allocate(coeffs, static_cast<size_t>(n));
+        for (int i = 0; i < count; ++i) { coeffs[static_cast<size_t>(n - 1 - i)] = h[i]; }
+        for (auto& s : state) { s.allocate(n); }
+        phase.fill(0);
+    }
+
+    void set_coefficients(std::vector<SampleType> const& h) { set_coefficients(h.data(), static_cast<int>(h.size())); }
+
+    void reset()
+    {
+        for (auto& h : state) { h.reset(); }
+        phase.fill(0);
+    }
+
+    int taps() const { return Taps ? static_cast<int>(Taps) : static_cast<int>(coeffs.size()); }
+
+    //! group delay in input samples, assuming the coefficients are symmetric (linear phase)
+    double latency() const { return 0.5 * (taps() - 1); }
+
+    /**
+     * Filters and decimates `@param count` samples from `@param input` on channel `@param n` into `@param output`,
+     * which needs room for count / Factor + 1 samples. input and output may alias.
+     * @return the number of samples written to output
+     */
+    int process(SampleType const* input, SampleType* output, int count, int n = 0)
+    {
+        auto& h = state[static_cast<size_t>(n)];
+        auto& p = phase[static_cast<size_t>(n)];
+        int written = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            auto* window = h.push(input[i]);
+            if (p == 0) { output[written++] = simd::dot(coeffs.data(), window, taps()); }
+            p = p + 1 == static_cast<int>(Factor) ? 0 : p + 1;
+        }
+        return written;
+    }
+
+    int process(SampleType* samples, int count, int n = 0) { return process(samples, samples, count, n); }
+
+private:
+    using coefficients_storage = fir_detail::storage<SampleType, Taps>;
+
+    typename coefficients_storage::type coeffs;
+    std::array<fir_detail::history<SampleType, Taps>, Channels> state;
+    std::array<int, Channels> phase {};
+};
+
+/**
+ * @brief Upsampling by Factor (zero stuffing) followed by an FIR filter, in polyphase form: the taps are split into
+ * Factor branches of ceil(Taps / Factor) taps each, and each input produces Factor outputs, one per branch, so the
+ * multiplications by stuffed zeros never happen.
+ * The coefficients are used as given, so an anti-imaging lowpass should have a passband gain of Factor to keep the
+ * signal's level (e.g. kaiser_lowpass() scaled by Factor).
+ * @tparam SampleType sample type
+ * @tparam Factor interpolation factor
+ * @tparam Taps number of taps of the full (high rate) filter, or 0 to choose at runtime
+ * @tparam Channels number of channels
+ */
+template <redsp_arithmetic SampleType, size_t Factor, size_t Taps = 0, size_t Channels = 1>
+struct fir_interpolator
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Factor > 0, "Factor must be positive");
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+    static constexpr size_t factor = Factor;
+
+    //! taps per polyphase branch
+    static constexpr size_t branch_taps = (Taps + Factor - 1) / Factor;
+
+    fir_interpolator() { coefficients_storage::allocate(coeffs, branch_taps * Factor); }
+
+    /**
+     * Sets the impulse response of the full filter, running at the high rate, and clears the history.
+     * @param h impulse response
+     * @param count number of taps in h; at most Taps when Taps is nonzero
+     */
+    void set_coefficients(SampleType const* h, int count)
+    {
+        count = math::max(count, 0);
+        auto const total = Taps ? static_cast<int>(Taps) : math::max(count, 1);
+        auto const P = (total + static_cast<int>(Factor) - 1) / static_cast<int>(Factor);
+        count = math::min(count, total);
+        coefficients_storage::allocate(coeffs, static_cast<size_t>(P) * Factor);
+
+        // branch l holds h[l], h[l + Factor], ... reversed, so its newest sample lines up with its last coefficient
+        for (int i = 0; i < count; ++i)
+        {
+            auto const l = i % static_cast<int>(Factor), k = i / static_cast<int>(Factor);
+            coeffs[static_cast<size_t>(l * P + P - 1 - k)] = h[i];
+        }
+        for (auto& s : state) { s.allocate(P); }
+    }
+
+    void set_coefficients(std::vector<SampleType> const& h) { set_coefficients(h.data(), static_cast<int>(h.size())); }
+
+    void reset() { for (auto& h : state) { h.reset(); } }
+
+    int branch_length() const { return branch_taps ? static_cast<int>(branch_taps) : static_cast<int>(coeffs.size() / Factor); }
+
+    int taps() const { return branch_length() * static_cast<int>(Factor); }
+
+    //! group delay in output (high rate) samples, assuming the coefficients are symmetric (linear phase)
+    double latency() const { return 0.5 * (taps() - 1); }
+
+    /**
+     * Upsamples and filters `@param count` samples from `@param input` on channel `@param n` into Factor * count
+     * samples in `@param output`. input and output must not alias.
+     */
+    void process(SampleType const* input, SampleType* output, int count, int n = 0)
+    {
+        auto& h = state[static_cast<size_t>(n)];
+        auto const P = branch_length();
+        for (int i = 0; i < count; ++i)
+        {
+            auto* window = h.push(input[i]);
+            auto* y = output + static_cast<size_t>(i) * Factor;
+            for (size_t l = 0; l < Factor; ++l) { y[l] = simd::dot(coeffs.data() + l * static_cast<size_t>(P), window, P); }
+        }
+    }
+
+private:
+    using coefficients_storage = fir_detail::storage<SampleType, branch_taps * Factor>;
+
+    typename coefficients_storage::type coeffs;
+    std::array<fir_detail::history<SampleType, branch_taps>, Channels> state;
+};
+
+} // namespace redsp
+
+#endif // REDSP_FIR_HEADERGUARD
@@ -0,0 +1,290 @@
+/**
+ * Integrator primitives: trapezoidal one-pole, leaky integrator and DC blocker.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_INTEGRATORS_HEADERGUARD
+#define REDSP_INTEGRATORS_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include "../internal/denormals.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+enum class one_pole_type
+{
+    lowpass = 0,
+    highpass,
+    allpass
+};
+
+/**
+ * @brief Trapezoidal (TPT) one-pole filter: a trapezoidal integrator in a zero-delay feedback loop (Zavalishin). Its
+ * cutoff is prewarped, so it matches the analog one-pole at the cutoff, and it behaves under fast modulation.
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels, sharing the cutoff
+ * @tparam Type which output to take
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1, one_pole_type Type = one_pole_type::lowpass>
+struct tpt_one_pole
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    tpt_one_pole()
+    {
+        set_cutoff(SampleType(0.1));
+        reset();
+    }
+
+    //! zeroes the integrators
+    void reset() { s.fill(SampleType(0)); }
+
+    //! sets the cutoff as a fraction of the sampling rate, clamped to (0, 0.49]
+    void set_cutoff(SampleType f)
+    {
+        auto const g = math::tan(math::pi<SampleType>() * math::clip(SampleType(1.0e-7), SampleType(0.49), f));
+        G = g / (SampleType(1) + g);
+    }
+
+    //! sets the cutoff to `@param fc` Hz at sampling rate `@param fs`
+    void set_cutoff(double fc, double fs) { set_cutoff(static_cast<SampleType>(fc / fs)); }
+
+    //! with `@param on`, zeroes the state after each block once it's below denormal_floor() (off by default)
+    void set_denormal_flush(bool on) { denormal_flush = on; }
+
+    SampleType process(SampleType sample, int n = 0) { return tick(sample, G, s[static_cast<size_t>(n)]); }
+
+    void process(SampleType* samples, int count, int n = 0)
+    {
+        auto& state = s[static_cast<size_t>(n)];
+        for (int i = 0; i < count; ++i) { samples[i] = tick(samples[i], G, state); }
+        if (denormal_flush) { flush_denormal(state); }
+    }
+
+    //! filters every channel of `@param samples`, of shape (Channels, count), in place, SIMD across channels
+    void process(SampleType** samples, int count)
+    {
+        simd::for_each_channel_group<SampleType, Channels>(samples, count, [this](V* x, int len, size_t j)
+        {
+            auto state = V::load(s.data() + j);
+            auto const gv = V::broadcast(G);
+            for (int i = 0; i < len; ++i) { x[i] = tick(x[i], gv, state); }
+            state.store(s.data() + j);
+        });
+        if (denormal_flush) { flush_denormal(s); }
+    }
+
+    //! one-pole sample on its own, for use in a filter_chain or a caller's own loop
+    template <typename T>
+    static T tick(T x, T g, T& state)
+    {
+        auto const v = (x - state) * g;
+        auto const lp = v + state;
+        state = lp + v;
+        return output(x, lp, std::integral_constant<one_pole_type, Type>());
+    }
+
+private:
+    using V = simd::vec<SampleType>;
+
+    SampleType G = 0;
+    std::array<SampleType, simd::padded_count<SampleType>(Channels)> s;
+    bool denormal_flush = false;
+
+    template <typename T>
+    static T output(T, T lp, std::integral_constant<one_pole_type, one_pole_type::lowpass>) { return lp; }
+    template <typename T>
+    static T output(T x, T lp, std::integral_constant<one_pole_type, one_pole_type::highpass>) { return x - lp; }
+    template <typename T>
+    static T output(T x, T lp, std::integral_constant<one_pole_type, one_pole_type::allpass>) { return lp + lp - x; }
+};
+
+/**
+ * @brief Leaky integrator y[n] = a y[n-1] + (1 - a) x[n]: an integrator whose memory fades with time constant
+ * -1 / ln(a) samples, normalized to unity gain at DC. The usual smoother for control signals and envelopes.
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels, sharing the coefficient
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1>
+struct leaky_integrator
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    leaky_integrator() { reset(); }
+
+    //! zeroes the integrators
+    void reset() { reset(SampleType(0)); }
+
+    //! sets every channel's output to `@param value`, e.g. to start a smoother at its target
+    void reset(SampleType value) { y.fill(value); }
+
+    //! sets the feedback coefficient a directly, clamped to [0, 1]
+    void set_coefficient(SampleType coefficient)
+    {
+        a = math::clip(SampleType(0), SampleType(1), coefficient);
+        b = SampleType(1) - a;
+    }
+
+    //! sets the time the output takes to move 1 - 1/e of the way to a new input, in seconds at sampling rate `@param fs`
+    void set_time_constant(double seconds, double fs)
+    {
+        set_coefficient(static_cast<SampleType>(std::exp(-1.0 / math::max(seconds * fs, 1.0e-9))));
+    }
+
+    //! as tpt_one_pole::set_denormal_flush()
+    void set_denormal_flush(bool on) { denormal_flush = on; }
+
+    SampleType process(SampleType sample, int n = 0) { return tick(sample, a, b, y[static_cast<size_t>(n)]); }
+
+    void process(SampleType* samples, int count, int n = 0)
+    {
+        auto& state = y[static_cast<size_t>(n)];
+        for (int i = 0; i < count; ++i) { samples[i] = tick(samples[i], a, b, state); }
+        if (denormal_flush) { flush_denormal(state); }
+    }
+
+    //! filters every channel of `@param samples`, of shape (Channels, count), in place, SIMD across channels
+    void process(SampleType** samples, int count)
+    {
+        simd::for_each_channel_group<SampleType, Channels>(samples, count, [this](V* x, int len, size_t j)
+        {
+            auto state = V::load(y.data() + j);
+            auto const av = V::broadcast(a), bv = V::broadcast(b);
+            for (int i = 0; i < len; ++i) { x[i] = tick(x[i], av, bv, state); }
+            state.store(y.data() + j);
+        });
+        if (denormal_flush) { flush_denormal(y); }
+    }
+
+    template <typename T>
+    static T tick(T x, T a, T b, T& state)
+    {
+        state = a * state + b * x;
+        return state;
+    }
+
+private:
+    using V = simd::vec<SampleType>;
+
+    SampleType a = 0, b = 1;
+    std::array<SampleType, simd::padded_count<SampleType>(Channels)> y;
+    bool denormal_flush = false;
+};
+
+/**
+ * @brief DC blocker y[n] = x[n] - x[n-1] + R y[n-1]: a zero at DC and a pole just inside it, so everything but the
+ * lowest few Hz passes untouched.
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels, sharing the cutoff
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1>
+struct dc_blocker
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    dc_blocker() { reset(); }
+
+    //! zeroes the filter state
+    void reset()
+    {
+        x1.fill(SampleType(0));
+        y1.fill(SampleType(0));
+    }
+
+    //! sets the -3dB point as a fraction of the sampling rate
+    void set_cutoff(SampleType f)
+    {
+        R = static_cast<SampleType>(std::exp(-2.0 * math::pi<double>() * math::clip(0.0, 0.1, static_cast<double>(f))));
+    }
+
+    //! sets the -3dB point to `@param fc` Hz at sampling rate `@param fs`
+    void set_cutoff(double fc, double fs) { set_cutoff(static_cast<SampleType>(fc / fs)); }
+
+    //! the pole that set_cutoff(`@param f`) would choose, in a constant expression, for a blocker fixed at compile time
+    static constexpr SampleType pole(double f)
+    {
+        return static_cast<SampleType>(math::exp_constexpr(-2.0 * math::pi<double>() * math::clip(0.0, 0.1, f)));
+    }
+
+    //! sets the pole R directly, say to one from pole()
+    void set_pole(SampleType r) { R = r; }
+
+    //! as tpt_one_pole::set_denormal_flush(), for both the input and output history
+    void set_denormal_flush(bool on) { denormal_flush = on; }
+
+    SampleType process(SampleType sample, int n = 0)
+    {
+        auto const i = static_cast<size_t>(n);
+        return tick(sample, R, x1[i], y1[i]);
+    }
+
+    void process(SampleType* samples, int count, int n = 0)
+    {
+        auto const c = static_cast<size_t>(n);
+        auto& x = x1[c];
+        auto& y = y1[c];
+        for (int i = 0; i < count; ++i) { samples[i] = tick(samples[i], R, x, y); }
+        if (denormal_flush)
+        {
+            flush_denormal(x);
+            flush_denormal(y);
+        }
+    }
+
+    //! filters every channel of `@param samples`, of shape (Channels, count), in place, SIMD across channels
+    void process(SampleType** samples, int count)
+    {
+        simd::for_each_channel_group<SampleType, Channels>(samples, count, [this](V* in, int len, size_t j)
+        {
+            auto x = V::load(x1.data() + j), y = V::load(y1.data() + j);
+            auto const r = V::broadcast(R);
+            for (int i = 0; i < len; ++i) { in[i] = tick(in[i], r, x, y); }
+            x.store(x1.data() + j);
+            y.store(y1.data() + j);
+        });
+        if (denormal_flush)
+        {
+            flush_denormal(x1);
+            flush_denormal(y1);
+        }
+    }
+
+    template <typename T>
+    static T tick(T sample, T r, T& x, T& y)
+    {
+        y = sample - x + r * y;
+        x = sample;
+        return y;
+    }
+
+private:
+    using V = simd::vec<SampleType>;
+
+    // about 10Hz at 48kHz
+    SampleType R = static_cast<SampleType>(0.9987);
+    std::array<SampleType, simd::padded_count<SampleType>(Channels)> x1;
+    std::array<SampleType, simd::padded_count<SampleType>(Channels)> y1;
+    bool denormal_flush = false;
+};
+
+} // namespace redsp
+
+#endif // REDSP_INTEGRATORS_HEADERGUARD
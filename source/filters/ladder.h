@@ -0,0 +1,274 @@
+/**
+ * Virtual-analog Moog ladder filter with a zero-delay feedback solve.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_LADDER_HEADERGUARD
+#define REDSP_LADDER_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <algorithm>
+#include "../internal/denormals.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+namespace ladder_detail {
+
+//! math::tanh_fast(v) / v: the gain a saturating stage has at v, written so that it's finite at 0
+template <redsp_arithmetic T>
+inline T tanh_gain(T v)
+{
+    auto const c = math::clip(T(-3), T(3), v);
+    auto const cc = c * c;
+    // past +-3 tanh_fast is +-1, so the gain is 1 / |v|
+    return (T(27) + cc) / ((T(27) + T(9) * cc) * math::max(T(1), math::abs(v) * T(1.0 / 3.0)));
+}
+
+template <redsp_arithmetic T>
+inline simd::vec<T> tanh_gain(simd::vec<T> v)
+{
+    using V = simd::vec<T>;
+    auto const c = min(max(v, V::broadcast(T(-3))), V::broadcast(T(3)));
+    auto const cc = c * c;
+    auto const abs_v = max(v, V::zero() - v);
+    return (V::broadcast(T(27)) + cc)
+           / (mul_add(V::broadcast(T(9)), cc, V::broadcast(T(27)))
+              * max(V::broadcast(T(1)), abs_v * V::broadcast(T(1.0 / 3.0))));
+}
+
+template <typename V> struct constant { static V get(double x) { return static_cast<V>(x); } };
+template <typename T> struct constant<simd::vec<T>> { static simd::vec<T> get(double x) { return simd::vec<T>::broadcast(static_cast<T>(x)); } };
+
+/**
+ * Runs one sample through the ladder. Every tanh is replaced by its gain at an estimate of its operating point (the
+ * stage states, and for the input the input it would see if the output didn't move), which leaves a linear ZDF loop
+ * that solves in closed form. Works for scalars and simd::vec alike.
+ * @param s the four TPT integrator states, updated
+ */
+template <typename V>
+inline V tick(V x, V g, V k, V* s)
+{
+    auto const one = constant<V>::get(1);
+
+    std::array<V, 5> t;
+    t[0] = tanh_gain(x - k * s[3]);
+    for (size_t i = 0; i < 4; ++i) { t[i + 1] = tanh_gain(s[i]); }
+
+    // stage i gives y_i = (s_i + g t_i y_(i-1)) / (1 + g t_(i+1)). Walking the chain writes y_4 as a + b u for the
+    // loop input u = x - k y_4
+    std::array<V, 4> c;
+    auto a = constant<V>::get(0), b = one;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        c[i] = one / (one + g * t[i + 1]);
+        auto const gt = g * t[i];
+        a = (s[i] + gt * a) * c[i];
+        b = gt * b * c[i];
+    }
+
+    auto y = (x - k * a) / (one + k * b);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        y = (s[i] + g * t[i] * y) * c[i];
+        s[i] = y + y - s[i];
+    }
+    return y;
+}
+
+template <redsp_arithmetic T>
+inline T cutoff_gain(T f) { return math::tan_fast(math::pi<T>() * math::clip(T(1.0e-5), T(0.45), f)); }
+
+} // namespace ladder_detail
+
+/**
+ * @brief Four-pole Moog transistor ladder lowpass (Huovilainen's model: a tanh on the input and on each of the four
+ * one-pole stages), discretized with trapezoidal integrators and a zero-delay feedback loop.
+ * The nonlinear loop is solved with the cheap linearized method: each math::tanh_fast is swapped for its gain at the
+ * previous sample's state, after which the loop solves exactly with one division. That keeps the ZDF response (the
+ * resonance stays tuned to the cutoff all the way up) for a fraction of a Newton solve, and because the gains are
+ * at most one the loop stays bounded at any resonance.
+ * As in the analog circuit the passband drops by 1 / (1 + 4 resonance).
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels, sharing cutoff and resonance
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1>
+struct ladder
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    ladder() { reset(); }
+
+    //! zeroes the filter state
+    void reset() { for (auto& s : state) { s.fill(SampleType(0)); } }
+
+    /**
+     * Sets the cutoff as a fraction of the sampling rate, clamped to (0, 0.45]
+     */
+    void set_cutoff(SampleType f) { g = ladder_detail::cutoff_gain(f); }
+
+    //! sets the cutoff to `@param fc` Hz at sampling rate `@param fs`
+    void set_cutoff(double fc, double fs) { set_cutoff(static_cast<SampleType>(fc / fs)); }
+
+    /**
+     * Sets the resonance: 0 is none, 1 is the edge of self-oscillation, and above that the filter sings at the cutoff.
+     */
+    void set_resonance(SampleType resonance) { k = SampleType(4) * math::max(resonance, SampleType(0)); }
+
+    //! with `@param on`, zeroes a channel's four stages after each block once they're below denormal_floor() (off by default)
+    void set_denormal_flush(bool on) { denormal_flush = on; }
+
+    /**
+     * Filters a single sample on channel `@param N`
+     */
+    SampleType process(SampleType sample, int N = 0)
+    {
+        return ladder_detail::tick(sample, g, k, state[static_cast<size_t>(N)].data());
+    }
+
+    /**
+     * Filters `@param count` samples of channel `@param N` in place
+     */
+    void process(SampleType* samples, int count, int N = 0)
+    {
+        auto* s = state[static_cast<size_t>(N)].data();
+        for (int i = 0; i < count; ++i) { samples[i] = ladder_detail::tick(samples[i], g, k, s); }
+        if (denormal_flush) { flush_denormal(state[static_cast<size_t>(N)]); }
+    }
+
+    /**
+     * Filters `@param count` samples of channel `@param N` in place, with the cutoff (as a fraction of the sampling
+     * rate) and resonance given for every sample. The last values stay set afterwards.
+     */
+    void process(SampleType* samples, SampleType const* cutoff, SampleType const* resonance, int count, int N = 0)
+    {
+        auto* s = state[static_cast<size_t>(N)].data();
+        for (int i = 0; i < count; ++i)
+        {
+            set_cutoff(cutoff[i]);
+            set_resonance(resonance[i]);
+            samples[i] = ladder_detail::tick(samples[i], g, k, s);
+        }
+        if (denormal_flush) { flush_denormal(state[static_cast<size_t>(N)]); }
+    }
+
+    /**
+     * Filters every channel of `@param samples`, of shape (Channels, count), in place
+     */
+    void process(SampleType** samples, int count)
+    {
+        for (size_t i = 0; i < Channels; ++i) { process(samples[i], count, static_cast<int>(i)); }
+    }
+
+private:
+    SampleType g = ladder_detail::cutoff_gain(SampleType(0.1));
+    SampleType k = 0;
+    std::array<std::array<SampleType, 4>, Channels> state;
+    bool denormal_flush = false;
+};
+
+/**
+ * @brief A bank of independent ladder filters, one per synth voice, run a SIMD register of voices at a time. Each
+ * voice has its own cutoff and resonance; each voice matches a ladder run on its own.
+ * Samples are interleaved by voice: frame t of voice v is at `frames[t * Voices + v]`.
+ * @tparam SampleType sample type
+ * @tparam Voices number of voices. Multiples of the SIMD width (4 floats, 2 doubles) avoid a copy per frame.
+ */
+template <redsp_arithmetic SampleType, size_t Voices>
+struct ladder_voices
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Voices > 0, "It doesn't make sense to have zero voices");
+
+    using sample_type = SampleType;
+    static constexpr size_t voices = Voices;
+
+    ladder_voices()
+    {
+        g.fill(ladder_detail::cutoff_gain(SampleType(0.1)));
+        k.fill(SampleType(0));
+        reset();
+    }
+
+    //! zeroes every voice's state
+    void reset() { for (auto& s : state) { s.fill(SampleType(0)); } }
+
+    //! zeroes voice `@param v`, e.g. when it's stolen for a new note
+    void reset(size_t v) { for (auto& s : state) { s[v] = SampleType(0); } }
+
+    //! sets voice `@param v`'s cutoff as a fraction of the sampling rate, clamped to (0, 0.45]
+    void set_cutoff(size_t v, SampleType f) { g[v] = ladder_detail::cutoff_gain(f); }
+
+    //! sets voice `@param v`'s resonance, see ladder::set_resonance
+    void set_resonance(size_t v, SampleType resonance) { k[v] = SampleType(4) * math::max(resonance, SampleType(0)); }
+
+    /**
+     * Filters `@param count` interleaved frames in place
+     */
+    void process(SampleType* frames, int count)
+    {
+        for (int t = 0; t < count; ++t) { run_frame(frames + static_cast<size_t>(t) * Voices); }
+    }
+
+    /**
+     * Filters `@param count` interleaved frames in place, with every voice's cutoff and resonance given per frame in
+     * the same layout. The last values stay set afterwards.
+     */
+    void process(SampleType* frames, SampleType const* cutoff, SampleType const* resonance, int count)
+    {
+        for (int t = 0; t < count; ++t)
+        {
+            auto const offset = static_cast<size_t>(t) * Voices;
+            for (size_t v = 0; v < Voices; ++v)
+            {
+                set_cutoff(v, cutoff[offset + v]);
+                set_resonance(v, resonance[offset + v]);
+            }
+            run_frame(frames + offset);
+        }
+    }
+
+private:
+    using V = simd::vec<SampleType>;
+    static constexpr size_t width = V::width;
+    static constexpr size_t padded = (Voices + width - 1) / width * width;
+
+    // kept as plain arrays, padded to whole registers, so voices can be set one at a time
+    std::array<SampleType, padded> g {};
+    std::array<SampleType, padded> k {};
+    std::array<std::array<SampleType, padded>, 4> state;
+
+    void run_frame(SampleType* frame)
+    {
+        if (Voices % width == 0) { run_groups(frame); }
+        else
+        {
+            std::array<SampleType, padded> x {};
+            std::copy(frame, frame + Voices, x.begin());
+            run_groups(x.data());
+            std::copy(x.begin(), x.begin() + Voices, frame);
+        }
+    }
+
+    void run_groups(SampleType* x)
+    {
+        for (size_t j = 0; j < padded; j += width)
+        {
+            std::array<V, 4> s;
+            for (size_t i = 0; i < 4; ++i) { s[i] = V::load(state[i].data() + j); }
+            ladder_detail::tick(V::load(x + j), V::load(g.data() + j), V::load(k.data() + j), s.data()).store(x + j);
+            for (size_t i = 0; i < 4; ++i) { s[i].store(state[i].data() + j); }
+        }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_LADDER_HEADERGUARD
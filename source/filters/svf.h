@@ -13,7 +13,10 @@
 #define REDSP_SVF_HEADERGUARD
 
 #include <type_traits>
+#include <array>
+#include <algorithm>
 
+#include "../internal/denormals.h"
 #include "../internal/remath.h"
 #include "../internal/universal.h"
 
@@ -36,6 +39,9 @@ template<typename SampleType = double, size_t Channels = 1, typename CoeffType =
 #endif
 struct svf
 {
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
     enum class SVFType
     {
         Highpass = 0,
@@ -47,6 +53,9 @@ struct svf
     CoeffType f1, q1;
     // c is: h, b, l
     std::array<std::array<SampleType, 3>, Channels> c;
+    bool denormal_flush = false;
+
+    static constexpr size_t index(SVFType t) { return static_cast<size_t>(t); }
 
 
 #ifndef redsp_cxx20
@@ -70,16 +79,16 @@ struct svf
      */
     void process(SampleType* outframe, SampleType const& sample, int const N = 0)
     {
-        auto &C = c[N];
+        auto &C = c[static_cast<size_t>(N)];
         SampleType h, b, l;
-        h = sample - C[SVFType::Highpass] - q1 * C[SVFType::Bandpass];
-        b = f1 * h + C[SVFType::Bandpass];
-        l = f1 * b + C[SVFType::Lowpass];
-        C[SVFType::Highpass] = h;
-        C[SVFType::Bandpass] = b;
-        C[SVFType::Lowpass] = l;
-
-        memcpy(C, outframe, 3);
+        h = sample - C[index(SVFType::Lowpass)] - q1 * C[index(SVFType::Bandpass)];
+        b = f1 * h + C[index(SVFType::Bandpass)];
+        l = f1 * b + C[index(SVFType::Lowpass)];
+        C[index(SVFType::Highpass)] = h;
+        C[index(SVFType::Bandpass)] = b;
+        C[index(SVFType::Lowpass)] = l;
+
+        std::copy(C.begin(), C.end(), outframe);
     }
 
     /**
@@ -92,7 +101,7 @@ struct svf
     template <SVFType t>
     SampleType process(SampleType const& sample, int const N = 0)
     {
-        std::array<SampleType, 3> frame;
+        std::array<SampleType, 3> frame {};
         process(frame.data(), sample, N);
 
         return frame[static_cast<size_t>(t)];
@@ -110,21 +119,28 @@ struct svf
     {
         for (auto* sample = samples; sample != samples + count; ++sample)
         {
-            process<t>(*sample, N);
+            *sample = process<t>(*sample, N);
         }
+        if (denormal_flush) { flush_denormal(c[static_cast<size_t>(N)]); }
     }
 
     /**
-     * Processes multi-channel samples. Disabled when Channels is 1.
-     * @param samples input samples, of shape (Channels, samples)
-     * @param count the number of samples per channel in the input frame (@param samples should be length `count * N`)
+     * Processes every channel of `@param samples`, of shape (Channels, count), replacing them as process<t>() does.
+     * @param samples (in/out) samples, one pointer per channel
+     * @param count the number of samples per channel
      */
-    template <SVFType t, typename std::enable_if<Channels != 1, void>::type>
+    template <SVFType t>
     void process(SampleType **samples, int count)
     {
-        for (int i = 0; i < Channels - 1; ++i) { process(samples[i * count], count, i); }
+        for (size_t i = 0; i < Channels; ++i) { process<t>(samples[i], count, static_cast<int>(i)); }
     }
 
+    /**
+     * With `@param on`, a channel's integrator states are zeroed at the end of each block once they're below
+     * denormal_floor(). Off by default: scoped_denormal_disable is cheaper where it's supported.
+     */
+    void set_denormal_flush(bool on) { denormal_flush = on; }
+
     /**
      * Resets the filter, zeroing coefficients and replacing fs with @param fs
      * @param fs new sampling rate
@@ -134,7 +150,7 @@ struct svf
         q1 = CoeffType(0);
         f1 = CoeffType(0);
         _fs = fs;
-        c.fill(CoeffType(0));
+        for (auto& C : c) { C.fill(SampleType(0)); }
     }
 
     /**
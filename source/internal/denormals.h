@@ -0,0 +1,91 @@
+/**
+ * Keeping denormals out of recursive processors.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_DENORMALS_HEADERGUARD
+#define REDSP_DENORMALS_HEADERGUARD
+
+#include <array>
+#include <cstdint>
+#include "remath.h"
+#include "universal.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define REDSP_DENORMALS_MXCSR 1
+#elif defined(__aarch64__)
+#define REDSP_DENORMALS_FPCR 1
+#elif defined(__arm__) && defined(__ARM_FP)
+#define REDSP_DENORMALS_FPSCR 1
+#endif
+
+namespace redsp {
+
+/**
+ * @brief Flushes denormals to zero on the calling thread for as long as it lives, restoring the previous mode after.
+ * A recursive filter fed silence decays through the denormal range, where every operation can cost 10 to 100 times
+ * as much on x86; with this around an audio callback they read as zero instead. On x86 it sets FTZ and DAZ in the
+ * MXCSR, on ARM the FZ bit of the FPCR (AArch64) or FPSCR (32 bit). Elsewhere it does nothing, and supported is false:
+ * there, the filters' set_denormal_flush() does the same job a block at a time.
+ */
+struct scoped_denormal_disable
+{
+#if defined(REDSP_DENORMALS_MXCSR)
+    static constexpr bool supported = true;
+    scoped_denormal_disable() : saved(_mm_getcsr()) { _mm_setcsr(saved | 0x8040); }
+    ~scoped_denormal_disable() { _mm_setcsr(saved); }
+#elif defined(REDSP_DENORMALS_FPCR)
+    static constexpr bool supported = true;
+    scoped_denormal_disable()
+    {
+        asm volatile("mrs %0, fpcr" : "=r"(saved));
+        std::uint64_t const flushing = saved | (std::uint64_t(1) << 24);
+        asm volatile("msr fpcr, %0" : : "r"(flushing));
+    }
+    ~scoped_denormal_disable() { asm volatile("msr fpcr, %0" : : "r"(saved)); }
+#elif defined(REDSP_DENORMALS_FPSCR)
+    static constexpr bool supported = true;
+    scoped_denormal_disable()
+    {
+        asm volatile("vmrs %0, fpscr" : "=r"(saved));
+        std::uint32_t const flushing = saved | (std::uint32_t(1) << 24);
+        asm volatile("vmsr fpscr, %0" : : "r"(flushing));
+    }
+    ~scoped_denormal_disable() { asm volatile("vmsr fpscr, %0" : : "r"(saved)); }
+#else
+    static constexpr bool supported = false;
+    scoped_denormal_disable() = default;
+#endif
+
+    scoped_denormal_disable(scoped_denormal_disable const&) = delete;
+    scoped_denormal_disable& operator=(scoped_denormal_disable const&) = delete;
+
+private:
+#if defined(REDSP_DENORMALS_MXCSR)
+    unsigned int saved;
+#elif defined(REDSP_DENORMALS_FPCR)
+    std::uint64_t saved = 0;
+#elif defined(REDSP_DENORMALS_FPSCR)
+    std::uint32_t saved = 0;
+#endif
+};
+
+/**
+ * @brief State below this (-300dB) is zeroed by a filter's per-block flush: far below anything audible, and far enough
+ * above the denormal range (below 1.2e-38 for float) that a decaying state gets caught at a block boundary before it
+ * gets there.
+ */
+template <redsp_arithmetic T>
+constexpr T denormal_floor() { return T(1.0e-15); }
+
+//! zeroes `@param x` if it's below denormal_floor()
+template <redsp_arithmetic T>
+inline void flush_denormal(T& x) { x = math::abs(x) < denormal_floor<T>() ? T(0) : x; }
+
+template <typename T, size_t N>
+inline void flush_denormal(std::array<T, N>& state) { for (auto& x : state) { flush_denormal(x); } }
+
+} // namespace redsp
+
+#endif // REDSP_DENORMALS_HEADERGUARD
@@ -0,0 +1,47 @@
+/**
+ * Precision policies: which type a processor reads and writes, which it keeps its state in, and which its
+ * coefficients are.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_PRECISION_HEADERGUARD
+#define REDSP_PRECISION_HEADERGUARD
+
+#include <type_traits>
+#include "universal.h"
+
+namespace redsp {
+
+/**
+ * @brief The three types a recursive filter works in, chosen separately.
+ * A filter with poles close to DC needs a wide state to hold its rounding noise down, but nothing says its buffers
+ * have to be as wide: float I/O with double state costs half the memory bandwidth of doubles throughout.
+ * @tparam IOType the samples read and written
+ * @tparam StateType the history kept between samples, and what each output is accumulated in
+ * @tparam CoeffType the coefficients
+ */
+template <redsp_arithmetic IOType, redsp_arithmetic StateType = IOType, redsp_arithmetic CoeffType = StateType>
+struct precision
+{
+    redsp_arithmetic_assert(IOType)
+    redsp_arithmetic_assert(StateType)
+    redsp_arithmetic_assert(CoeffType)
+
+    using io_type = IOType;
+    using state_type = StateType;
+    using coeff_type = CoeffType;
+};
+
+//! float throughout, with double coefficients so the design itself isn't what's rounded
+using single_precision = precision<float, float, double>;
+//! float samples in and out, double state and coefficients
+using mixed_precision = precision<float, double, double>;
+using double_precision = precision<double>;
+
+//! single_precision if `@tparam FloatStateSuffices` (see float_state_suffices() in biquad.h), else mixed_precision
+template <bool FloatStateSuffices>
+using cheapest_precision = typename std::conditional<FloatStateSuffices, single_precision, mixed_precision>::type;
+
+} // namespace redsp
+
+#endif // REDSP_PRECISION_HEADERGUARD
@@ -0,0 +1,27 @@
+/**
+ * Common description of redsp processors.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_PROCESSOR_HEADERGUARD
+#define REDSP_PROCESSOR_HEADERGUARD
+
+#include <cstddef>
+#include "universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Describes a processor to the wrappers that take arbitrary processors (oversampled, etc.). Processors expose
+ * `sample_type` and `channels`; specialize this for third-party types that don't.
+ */
+template <typename Processor>
+struct processor_traits
+{
+    using sample_type = typename Processor::sample_type;
+    static constexpr size_t channels = Processor::channels;
+};
+
+} // namespace redsp
+
+#endif // REDSP_PROCESSOR_HEADERGUARD
@@ -10,6 +10,9 @@
 
 #include <type_traits>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include "universal.h"
 
 #ifdef redsp_cxx20
@@ -36,7 +39,8 @@ struct math
         return std::sin(x);
     }
 
-    //! returns an approximation of sin(x), diverging outside ().
+    //! returns an approximation of sin(x). For now it's the library's, within a couple of ulps for any x; a faster one
+    //! would be held to [-2pi, 2pi], where the tests measure it.
     template <redsp_arithmetic T>
     static T sin_fast(T x)
     {
@@ -44,7 +48,8 @@ struct math
         return  std::sin(x); // todo: add pade approx of sin
     }
 
-    //! returns an approximation of sin(x), diverging outside ().
+    //! returns an approximation of sin(x). For now it's the library's, within a couple of ulps for any x; a faster one
+    //! would be held to [-2pi, 2pi], where the tests measure it.
     template <redsp_arithmetic T>
     static T sin_faster(T x)
     {
@@ -60,7 +65,8 @@ struct math
         return static_cast<T>(std::cos(x));
     }
 
-    //! returns an approximation of cos(x), diverging outside ().
+    //! returns an approximation of cos(x). The library's until a pade approximant replaces it, so for now within a couple
+    //! of ulps everywhere; the tests measure it over [-2pi, 2pi].
     template <redsp_arithmetic T>
     static T cos_fast(T x)
     {
@@ -68,7 +74,8 @@ struct math
          return cos(x); // todo: add pade approx of cos
     }
 
-    //! returns an approximation of cos(x), diverging outside ().
+    //! returns an approximation of cos(x). The library's until a pade approximant replaces it, so for now within a couple
+    //! of ulps everywhere; the tests measure it over [-2pi, 2pi].
     template <redsp_arithmetic T>
     static T cos_faster(T x)
     {
@@ -81,23 +88,26 @@ struct math
     static T tan(T x)
     {
         redsp_arithmetic_assert(T)
-        return static_cast<T>(tan(x));
+        return static_cast<T>(std::tan(x));
     }
 
-    //! returns an approximation of tan(x), diverging outside ()
+    //! returns the [5/4] pade approximant of tan(x); relative error under 5e-5 on [-1.45, 1.45] (a cutoff of 0.46 fs
+    //! in tan(pi f)), diverging towards +-pi/2
     template <redsp_arithmetic T>
     static T tan_fast(T x)
     {
         redsp_arithmetic_assert(T)
-        return static_cast<T>(std::tanh(x)); // todo: add pade approx of tan
+        auto const xx = x * x;
+        return x * (T(945) - xx * (T(105) - xx)) / (T(945) - xx * (T(420) - T(15) * xx));
     }
 
-    //! returns an approximation of tan(x), diverging outside ()
+    //! returns the [3/2] pade approximant of tan(x); relative error under 1.2e-3 on [-1, 1], diverging towards +-pi/2
     template <redsp_arithmetic T>
     static T tan_faster(T x)
     {
         redsp_arithmetic_assert(T)
-        return static_cast<T>(std::tanh(x)); // todo: add fast approx of tan
+        auto const xx = x * x;
+        return x * (T(15) - xx) / (T(15) - T(6) * xx);
     }
 
     //! returns tanh(x) using stl implementation
@@ -108,30 +118,42 @@ struct math
         return static_cast<T>(std::tanh(x));
     }
 
-    //! returns an approximation of tanh(x), diverging outside ()
+    //! returns the [3/2] pade approximant of tanh(x), clipped to +-1 beyond +-3 where its slope reaches zero. Absolute
+    //! error under 0.024 everywhere; smooth and monotonic, which is what a saturator needs.
     template <redsp_arithmetic T>
     static T tanh_fast(T x)
     {
         redsp_arithmetic_assert(T)
-        return static_cast<T>(std::tanh(x)); // todo: add fast approx of tanh
+        x = clip(T(-3), T(3), x);
+        auto const xx = x * x;
+        return x * (T(27) + xx) / (T(27) + T(9) * xx);
     }
 
-
-    //! returns an approximation of tanh(x), diverging outside ()
+    //! returns a cubic soft clipper shaped like tanh(x): x - 4x^3 / 27, clipped to +-1 beyond +-1.5. No division, but
+    //! absolute error up to 0.12.
     template <redsp_arithmetic T>
     static T tanh_faster(T x)
     {
         redsp_arithmetic_assert(T)
-        return static_cast<T>(std::tanh(x)); // todo: add faster approx of tanh
+        x = clip(T(-1.5), T(1.5), x);
+        return x - T(4.0 / 27.0) * x * x * x;
     }
 
-
+    //! returns an approximation of log2(x) for x > 0, absolute error under 2e-4. Only float and double are specialized.
     template <redsp_arithmetic T>
     static T log_fast(T x)
     {
         return 0; // only use specializations!
     }
 
+    //! returns an approximation of 2^x, relative error under 1e-4, for x clamped to [-126, 127].
+    //! Only float and double are specialized.
+    template <redsp_arithmetic T>
+    static T exp2_fast(T x)
+    {
+        return 0; // only use specializations!
+    }
+
     //================================================================================================================//
     //==                                                                                                            ==//
     //==                                                   OTHER                                                    ==//
@@ -139,17 +161,147 @@ struct math
     //================================================================================================================//
 
     template <redsp_arithmetic T>
-    static T min(T x, T y) { return x < y ? x : y; }
+    static constexpr T min(T x, T y) { return x < y ? x : y; }
 
     template <redsp_arithmetic T>
-    static T max(T x, T y) { return x > y ? x : y; }
+    static constexpr T max(T x, T y) { return x > y ? x : y; }
 
     template <redsp_arithmetic T>
-    static T clip(T low, T high, T x) { return max(low, min(x, high)); }
+    static constexpr T clip(T low, T high, T x) { return max(low, min(x, high)); }
+
+    template <redsp_arithmetic T>
+    static constexpr T abs(T x) { return x < T(0) ? -x : x; }
 
     template <redsp_arithmetic T, redsp_arithmetic T2>
     static bool within(T x, T y, T2 lim) { return abs(x - y) < lim; }
 
+    //! returns the zeroth order modified bessel function of the first kind, I0(x), by its power series. Used to build
+    //! Kaiser windows, so it's meant for prepare time rather than the audio thread. Relative error under 1e-12 on
+    //! [0, 50], computed in double whatever T is.
+    template <redsp_arithmetic T>
+    static T bessel_i0(T x)
+    {
+        redsp_arithmetic_assert(T)
+        double sum = 1, term = 1;
+        for (int i = 1; i < 64 && term > 1.0e-12 * sum; ++i)
+        {
+            auto t = static_cast<double>(x) / (2.0 * i);
+            term *= t * t;
+            sum += term;
+        }
+        return static_cast<T>(sum);
+    }
+
+    //================================================================================================================//
+    //==                                                                                                            ==//
+    //==                                                COMPILE TIME                                                ==//
+    //==                                                                                                            ==//
+    //================================================================================================================//
+
+    // These work in constant expressions, so coefficients of filters fixed at compile time can be baked in as
+    // immediates. They sum series in long double until the terms stop counting: accurate but slow, so they're for
+    // initializing constexpr values rather than for anything at run time.
+
+    /**
+     * @brief returns sin(x), usable in a constant expression
+     * Within an ulp of double for |x| up to a billion or so, past which the reduction by pi/2 starts to lose bits; |x|
+     * must stay under 1e18.
+     */
+    template <redsp_arithmetic T>
+    static constexpr T sin_constexpr(T x)
+    {
+        redsp_arithmetic_assert(T)
+        return static_cast<T>(sin_quadrant(static_cast<long double>(x), 0));
+    }
+
+    //! returns cos(x), usable in a constant expression; as accurate as sin_constexpr
+    template <redsp_arithmetic T>
+    static constexpr T cos_constexpr(T x)
+    {
+        redsp_arithmetic_assert(T)
+        return static_cast<T>(sin_quadrant(static_cast<long double>(x), 1));
+    }
+
+    //! returns tan(x), usable in a constant expression, as the quotient of the two
+    template <redsp_arithmetic T>
+    static constexpr T tan_constexpr(T x)
+    {
+        redsp_arithmetic_assert(T)
+        auto const y = static_cast<long double>(x);
+        return static_cast<T>(sin_quadrant(y, 0) / sin_quadrant(y, 1));
+    }
+
+    /**
+     * @brief returns e^x, usable in a constant expression
+     * x = k ln2 + r with |r| <= ln2 / 2, so e^x is 2^k times a short series in r. Overflows to infinity and underflows
+     * to 0 as the library does.
+     */
+    template <redsp_arithmetic T>
+    static constexpr T exp_constexpr(T x)
+    {
+        redsp_arithmetic_assert(T)
+        constexpr long double ln2 = 0.693147180559945309417232121458176568L;
+        // beyond +-12000, e^x is out of range of long double anyway
+        auto const clipped = clip(-12000.0L, 12000.0L, static_cast<long double>(x));
+        auto const k = static_cast<long>(clipped / ln2 + (clipped < 0 ? -0.5L : 0.5L));
+        auto const r = clipped - static_cast<long double>(k) * ln2;
+        long double sum = 1, term = 1;
+        for (int i = 1; i < 40 && term != 0; ++i)
+        {
+            term *= r / i;
+            sum += term;
+        }
+        for (long i = 0; i < k; ++i) { sum *= 2; }
+        for (long i = 0; i > k; --i) { sum *= 0.5L; }
+        return static_cast<T>(sum);
+    }
+
+    /**
+     * sin(x + `@param quarters` pi/2). x is brought into [-pi/4, pi/4] by whole quarter turns, with pi/2 split in three
+     * (Cody and Waite's trick): the first two parts have 32 bits each, so their multiples by up to 2^32 quarter turns
+     * are exact in long double, and the reduction keeps all of x's precision.
+     */
+    static constexpr long double sin_quadrant(long double x, int quarters)
+    {
+        constexpr long double high = 1.570796326734125614166259765625L;
+        constexpr long double mid = 6.077100506303965976595549136618501506745815277099609375e-11L;
+        constexpr long double low = 2.0222662487959507323996846200947577164762024039082031431e-21L;
+        auto const n = static_cast<long long>(x / (high + mid + low) + (x < 0 ? -0.5L : 0.5L));
+        auto const turns = static_cast<long double>(n);
+        auto const r = ((x - turns * high) - turns * mid) - turns * low;
+        switch ((n + quarters) & 3)
+        {
+            case 0: return sin_series(r);
+            case 1: return cos_series(r);
+            case 2: return -sin_series(r);
+            default: return -cos_series(r);
+        }
+    }
+
+    //! sin's Taylor series, summed until the terms fall below long double's precision
+    static constexpr long double sin_series(long double x)
+    {
+        long double sum = x, term = x;
+        for (int i = 1; i < 40 && term != 0; ++i)
+        {
+            term *= -x * x / ((2 * i) * (2 * i + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    //! cos's Taylor series, likewise
+    static constexpr long double cos_series(long double x)
+    {
+        long double sum = 1, term = 1;
+        for (int i = 1; i < 40 && term != 0; ++i)
+        {
+            term *= -x * x / ((2 * i - 1) * (2 * i));
+            sum += term;
+        }
+        return sum;
+    }
+
     //================================================================================================================//
     //==                                                                                                            ==//
     //==                                                 CONSTANTS                                                  ==//
@@ -157,12 +309,12 @@ struct math
     //================================================================================================================//
 
 
-    // todo: improve pi() so that it returns pi as different types when needed
-    //! returns pi
+    //! returns pi, correctly rounded to T: written out to more digits than long double holds, so each type gets the
+    //! nearest value it has rather than a rounded double's
     template <redsp_arithmetic T>
     inline static constexpr T pi()
     {
-        return T(3.1415926535);
+        return static_cast<T>(3.141592653589793238462643383279502884L);
     }
 
     //! returns two pi
@@ -179,12 +331,11 @@ struct math
         return pi<T>() * 0.5;
     }
 
-    // todo: make e() not rely on non-constexpr library function
     //! returns e
     template <redsp_arithmetic T>
     inline static constexpr T e()
     {
-        return exp(1);
+        return static_cast<T>(2.718281828459045235360287471352662498L);
     }
 
 
@@ -192,7 +343,7 @@ struct math
 
 //! pretty gross, but returns a good log approximation fast. Inspired by Q library (unsure of origin).
 template<>
-float math::log_fast(float x)
+inline float math::log_fast(float x)
 {
     static_assert(std::numeric_limits<float>::is_iec559, "floats must be ieee for this to work");
     uint32_t vi, mi;
@@ -208,12 +359,33 @@ float math::log_fast(float x)
 }
 
 template<>
-double math::log_fast(double x)
+inline double math::log_fast(double x)
 {
     // this is ok for now until I figure out how to write a dedicated double version of this
     return static_cast<double>(log_fast(static_cast<float>(x)));
 }
 
+//! the inverse of log_fast: the integer part of x goes straight into the exponent bits, and a rational fit of 2^z on
+//! the fractional part z into the mantissa (Mineiro's fastpow2).
+template<>
+inline float math::exp2_fast(float x)
+{
+    static_assert(std::numeric_limits<float>::is_iec559, "floats must be ieee for this to work");
+    x = clip(-126.0f, 127.0f, x);
+    auto const offset = x < 0 ? 1.0f : 0.0f;
+    auto const z = x - static_cast<float>(static_cast<int32_t>(x)) + offset;
+    auto const bits = static_cast<uint32_t>(8388608.0f * (x + 121.2740575f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z));
+    float y;
+    std::memcpy(&y, &bits, 4);
+    return y;
+}
+
+template<>
+inline double math::exp2_fast(double x)
+{
+    return static_cast<double>(exp2_fast(static_cast<float>(x)));
+}
+
 
 
 } // namespace redsp
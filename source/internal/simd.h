@@ -0,0 +1,416 @@
+/**
+ * A thin SIMD abstraction over SSE2 and NEON, with a scalar fallback for everything else. Define REDSP_NO_SIMD to
+ * force the fallback.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_SIMD_HEADERGUARD
+#define REDSP_SIMD_HEADERGUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <type_traits>
+#include "remath.h"
+#include "universal.h"
+
+#if ! defined(REDSP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define REDSP_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif ! defined(REDSP_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define REDSP_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace redsp {
+namespace simd {
+
+/**
+ * @brief A register's worth of T. This is the scalar fallback (a "register" of one T); SSE2 and NEON specialize it
+ * for float and double. All loads and stores are unaligned.
+ */
+template <redsp_arithmetic T>
+struct vec
+{
+    redsp_arithmetic_assert(T)
+    using value_type = T;
+    static constexpr size_t width = 1;
+
+    T v;
+
+    static vec load(T const* p) { return { *p }; }
+    static vec broadcast(T x) { return { x }; }
+    static vec zero() { return { T(0) }; }
+    void store(T* p) const { *p = v; }
+
+    friend vec operator+(vec a, vec b) { return { a.v + b.v }; }
+    friend vec operator-(vec a, vec b) { return { a.v - b.v }; }
+    friend vec operator*(vec a, vec b) { return { a.v * b.v }; }
+    friend vec operator/(vec a, vec b) { return { a.v / b.v }; }
+    friend vec min(vec a, vec b) { return { a.v < b.v ? a.v : b.v }; }
+    friend vec max(vec a, vec b) { return { a.v > b.v ? a.v : b.v }; }
+
+    //! returns a * b + c
+    friend vec mul_add(vec a, vec b, vec c) { return { a.v * b.v + c.v }; }
+
+    //! returns the sum of every lane
+    T sum() const { return v; }
+};
+
+#if REDSP_SIMD_SSE2
+
+template <>
+struct vec<float>
+{
+    using value_type = float;
+    static constexpr size_t width = 4;
+
+    __m128 v;
+
+    static vec load(float const* p) { return { _mm_loadu_ps(p) }; }
+    static vec broadcast(float x) { return { _mm_set1_ps(x) }; }
+    static vec zero() { return { _mm_setzero_ps() }; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend vec operator+(vec a, vec b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend vec operator-(vec a, vec b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend vec operator*(vec a, vec b) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend vec operator/(vec a, vec b) { return { _mm_div_ps(a.v, b.v) }; }
+    friend vec min(vec a, vec b) { return { _mm_min_ps(a.v, b.v) }; }
+    friend vec max(vec a, vec b) { return { _mm_max_ps(a.v, b.v) }; }
+    friend vec mul_add(vec a, vec b, vec c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+
+    float sum() const
+    {
+        auto hi = _mm_movehl_ps(v, v);
+        auto pair = _mm_add_ps(v, hi);
+        return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+    }
+};
+
+template <>
+struct vec<double>
+{
+    using value_type = double;
+    static constexpr size_t width = 2;
+
+    __m128d v;
+
+    static vec load(double const* p) { return { _mm_loadu_pd(p) }; }
+    static vec broadcast(double x) { return { _mm_set1_pd(x) }; }
+    static vec zero() { return { _mm_setzero_pd() }; }
+    void store(double* p) const { _mm_storeu_pd(p, v); }
+
+    friend vec operator+(vec a, vec b) { return { _mm_add_pd(a.v, b.v) }; }
+    friend vec operator-(vec a, vec b) { return { _mm_sub_pd(a.v, b.v) }; }
+    friend vec operator*(vec a, vec b) { return { _mm_mul_pd(a.v, b.v) }; }
+    friend vec operator/(vec a, vec b) { return { _mm_div_pd(a.v, b.v) }; }
+    friend vec min(vec a, vec b) { return { _mm_min_pd(a.v, b.v) }; }
+    friend vec max(vec a, vec b) { return { _mm_max_pd(a.v, b.v) }; }
+    friend vec mul_add(vec a, vec b, vec c) { return { _mm_add_pd(_mm_mul_pd(a.v, b.v), c.v) }; }
+
+    double sum() const { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+};
+
+#elif REDSP_SIMD_NEON
+
+template <>
+struct vec<float>
+{
+    using value_type = float;
+    static constexpr size_t width = 4;
+
+    float32x4_t v;
+
+    static vec load(float const* p) { return { vld1q_f32(p) }; }
+    static vec broadcast(float x) { return { vdupq_n_f32(x) }; }
+    static vec zero() { return { vdupq_n_f32(0.0f) }; }
+    void store(float* p) const { vst1q_f32(p, v); }
+
+    friend vec operator+(vec a, vec b) { return { vaddq_f32(a.v, b.v) }; }
+    friend vec operator-(vec a, vec b) { return { vsubq_f32(a.v, b.v) }; }
+    friend vec operator*(vec a, vec b) { return { vmulq_f32(a.v, b.v) }; }
+#if defined(__aarch64__)
+    friend vec operator/(vec a, vec b) { return { vdivq_f32(a.v, b.v) }; }
+#else
+    friend vec operator/(vec a, vec b)
+    {
+        auto r = vrecpeq_f32(b.v);
+        r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+        r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+        return { vmulq_f32(a.v, r) };
+    }
+#endif
+    friend vec min(vec a, vec b) { return { vminq_f32(a.v, b.v) }; }
+    friend vec max(vec a, vec b) { return { vmaxq_f32(a.v, b.v) }; }
+    friend vec mul_add(vec a, vec b, vec c) { return { vmlaq_f32(c.v, a.v, b.v) }; }
+
+    float sum() const
+    {
+        auto pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(pair, pair), 0);
+    }
+};
+
+#if defined(__aarch64__)
+template <>
+struct vec<double>
+{
+    using value_type = double;
+    static constexpr size_t width = 2;
+
+    float64x2_t v;
+
+    static vec load(double const* p) { return { vld1q_f64(p) }; }
+    static vec broadcast(double x) { return { vdupq_n_f64(x) }; }
+    static vec zero() { return { vdupq_n_f64(0.0) }; }
+    void store(double* p) const { vst1q_f64(p, v); }
+
+    friend vec operator+(vec a, vec b) { return { vaddq_f64(a.v, b.v) }; }
+    friend vec operator-(vec a, vec b) { return { vsubq_f64(a.v, b.v) }; }
+    friend vec operator*(vec a, vec b) { return { vmulq_f64(a.v, b.v) }; }
+    friend vec operator/(vec a, vec b) { return { vdivq_f64(a.v, b.v) }; }
+    friend vec min(vec a, vec b) { return { vminq_f64(a.v, b.v) }; }
+    friend vec max(vec a, vec b) { return { vmaxq_f64(a.v, b.v) }; }
+    friend vec mul_add(vec a, vec b, vec c) { return { vmlaq_f64(c.v, a.v, b.v) }; }
+
+    double sum() const { return vaddvq_f64(v); }
+};
+#endif
+
+#endif
+
+/**
+ * Returns the dot product of `@param count` elements of `@param a` and `@param b`. Neither needs to be aligned.
+ */
+template <redsp_arithmetic T>
+inline T dot(T const* a, T const* b, int count)
+{
+    using V = vec<T>;
+    constexpr int w = static_cast<int>(V::width);
+
+    // two accumulators hide the add latency
+    auto acc0 = V::zero(), acc1 = V::zero();
+    int i = 0;
+    for (; i + 2 * w <= count; i += 2 * w)
+    {
+        acc0 = mul_add(V::load(a + i), V::load(b + i), acc0);
+        acc1 = mul_add(V::load(a + i + w), V::load(b + i + w), acc1);
+    }
+    for (; i + w <= count; i += w)
+    {
+        acc0 = mul_add(V::load(a + i), V::load(b + i), acc0);
+    }
+
+    auto result = (acc0 + acc1).sum();
+    for (; i < count; ++i) { result += a[i] * b[i]; }
+    return result;
+}
+
+//! returns |x| in every lane
+template <redsp_arithmetic T>
+inline vec<T> abs(vec<T> x) { return max(x, vec<T>::zero() - x); }
+
+/**
+ * Returns math::log_fast (log2) of every lane. SSE2 and NEON floats (and SSE2 doubles, through floats) do it in
+ * registers with the same bit tricks; anything else goes a lane at a time.
+ */
+template <redsp_arithmetic T>
+inline vec<T> log2_fast(vec<T> x)
+{
+    std::array<T, vec<T>::width> lanes;
+    x.store(lanes.data());
+    for (auto& l : lanes) { l = math::log_fast(l); }
+    return vec<T>::load(lanes.data());
+}
+
+//! returns math::exp2_fast of every lane, see log2_fast
+template <redsp_arithmetic T>
+inline vec<T> exp2_fast(vec<T> x)
+{
+    std::array<T, vec<T>::width> lanes;
+    x.store(lanes.data());
+    for (auto& l : lanes) { l = math::exp2_fast(l); }
+    return vec<T>::load(lanes.data());
+}
+
+namespace detail {
+
+//! the polynomial parts of math::log_fast and math::exp2_fast, shared by the backends
+inline vec<float> log2_fast_tail(vec<float> y, vec<float> mantissa)
+{
+    using V = vec<float>;
+    return y - V::broadcast(124.22551499f) - V::broadcast(1.498030302f) * mantissa
+           - V::broadcast(1.72587999f) / (V::broadcast(0.3520887068f) + mantissa);
+}
+
+inline vec<float> exp2_fast_scaled(vec<float> p, vec<float> z)
+{
+    using V = vec<float>;
+    return V::broadcast(8388608.0f) * (p + V::broadcast(121.2740575f)
+                                       + V::broadcast(27.7280233f) / (V::broadcast(4.84252568f) - z)
+                                       - V::broadcast(1.49012907f) * z);
+}
+
+} // namespace detail
+
+#if REDSP_SIMD_SSE2
+
+inline vec<float> log2_fast(vec<float> x)
+{
+    auto const bits = _mm_castps_si128(x.v);
+    auto const mantissa = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000));
+    vec<float> const y { _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.1920928955078125e-7f)) };
+    return detail::log2_fast_tail(y, { _mm_castsi128_ps(mantissa) });
+}
+
+inline vec<float> exp2_fast(vec<float> x)
+{
+    auto const p = _mm_min_ps(_mm_max_ps(x.v, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+    auto const offset = _mm_and_ps(_mm_cmplt_ps(p, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    auto const z = _mm_add_ps(_mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p))), offset);
+    return { _mm_castsi128_ps(_mm_cvttps_epi32(detail::exp2_fast_scaled({ p }, { z }).v)) };
+}
+
+// the approximations are only float-accurate anyway, so doubles go through floats
+inline vec<double> log2_fast(vec<double> x) { return { _mm_cvtps_pd(log2_fast(vec<float> { _mm_cvtpd_ps(x.v) }).v) }; }
+inline vec<double> exp2_fast(vec<double> x) { return { _mm_cvtps_pd(exp2_fast(vec<float> { _mm_cvtpd_ps(x.v) }).v) }; }
+
+#elif REDSP_SIMD_NEON
+
+inline vec<float> log2_fast(vec<float> x)
+{
+    auto const bits = vreinterpretq_s32_f32(x.v);
+    auto const mantissa = vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007fffff)), vdupq_n_s32(0x3f000000));
+    vec<float> const y { vmulq_n_f32(vcvtq_f32_s32(bits), 1.1920928955078125e-7f) };
+    return detail::log2_fast_tail(y, { vreinterpretq_f32_s32(mantissa) });
+}
+
+inline vec<float> exp2_fast(vec<float> x)
+{
+    auto const p = vminq_f32(vmaxq_f32(x.v, vdupq_n_f32(-126.0f)), vdupq_n_f32(127.0f));
+    auto const negative = vcltq_f32(p, vdupq_n_f32(0.0f));
+    auto const offset = vreinterpretq_f32_u32(vandq_u32(negative, vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+    auto const z = vaddq_f32(vsubq_f32(p, vcvtq_f32_s32(vcvtq_s32_f32(p))), offset);
+    return { vreinterpretq_f32_s32(vcvtq_s32_f32(detail::exp2_fast_scaled({ p }, { z }).v)) };
+}
+
+#endif
+
+//! Channels rounded up to whole registers of T, so per-channel state can be loaded a register at a time
+template <redsp_arithmetic T>
+constexpr size_t padded_count(size_t channels) { return (channels + vec<T>::width - 1) / vec<T>::width * vec<T>::width; }
+
+/**
+ * Runs a recursive filter over Channels planar buffers a register of channels at a time. Each tile of up to 32
+ * samples of a group of channels is transposed into registers, handed to `@param f` as f(vec<T>* tile, int len,
+ * size_t first_channel) to filter in place, and transposed back. A recursion can't be vectorized along time, but
+ * across channels it can.
+ */
+template <redsp_arithmetic T, size_t Channels, typename F>
+inline void for_each_channel_group(T** samples, int count, F&& f)
+{
+    using V = vec<T>;
+    constexpr size_t width = V::width;
+    constexpr int tile_size = 32;
+
+    std::array<V, tile_size> tile;
+    std::array<T, width> lanes {};
+    for (size_t j = 0; j < Channels; j += width)
+    {
+        auto const used = std::min(width, Channels - j);
+        for (int done = 0; done < count; done += tile_size)
+        {
+            auto const len = std::min(tile_size, count - done);
+            for (int t = 0; t < len; ++t)
+            {
+                for (size_t c = 0; c < used; ++c) { lanes[c] = samples[j + c][done + t]; }
+                tile[static_cast<size_t>(t)] = V::load(lanes.data());
+            }
+            f(tile.data(), len, j);
+            for (int t = 0; t < len; ++t)
+            {
+                tile[static_cast<size_t>(t)].store(lanes.data());
+                for (size_t c = 0; c < used; ++c) { samples[j + c][done + t] = lanes[c]; }
+            }
+        }
+    }
+}
+
+/**
+ * The read-only form, for measuring rather than filtering: the tiles hold `@param samples` converted to T (so float
+ * input can be measured in double) and aren't written back. Lanes past the last channel hold stale values.
+ */
+template <redsp_arithmetic T, size_t Channels, typename U, typename F>
+inline void for_each_channel_group(U const* const* samples, int count, F&& f)
+{
+    using V = vec<T>;
+    constexpr size_t width = V::width;
+    constexpr int tile_size = 32;
+
+    std::array<V, tile_size> tile;
+    std::array<T, width> lanes {};
+    for (size_t j = 0; j < Channels; j += width)
+    {
+        auto const used = std::min(width, Channels - j);
+        for (int done = 0; done < count; done += tile_size)
+        {
+            auto const len = std::min(tile_size, count - done);
+            for (int t = 0; t < len; ++t)
+            {
+                for (size_t c = 0; c < used; ++c) { lanes[c] = static_cast<T>(samples[j + c][done + t]); }
+                tile[static_cast<size_t>(t)] = V::load(lanes.data());
+            }
+            f(static_cast<V const*>(tile.data()), len, j);
+        }
+    }
+}
+
+namespace detail {
+
+//! a register of T from `@param p`, converting from U a lane at a time if need be
+template <typename T, typename U>
+inline vec<T> load_as(U const* p, std::false_type)
+{
+    std::array<T, vec<T>::width> lanes;
+    for (size_t c = 0; c < lanes.size(); ++c) { lanes[c] = static_cast<T>(p[c]); }
+    return vec<T>::load(lanes.data());
+}
+
+template <typename T>
+inline vec<T> load_as(T const* p, std::true_type) { return vec<T>::load(p); }
+
+template <typename T, typename U>
+inline vec<T> load_as(U const* p) { return load_as<T>(p, std::is_same<T, U>()); }
+
+} // namespace detail
+
+/**
+ * The read-only form for interleaved `@param frames`, `@param stride` samples apart: frames already hold a group of
+ * channels side by side, so the tiles fill with one load per sample rather than a gather. The stride must leave room
+ * for a whole register past the last channel, as padded_count() does.
+ */
+template <redsp_arithmetic T, size_t Channels, typename U, typename F>
+inline void for_each_frame_group(U const* frames, size_t stride, int count, F&& f)
+{
+    using V = vec<T>;
+    constexpr int tile_size = 32;
+
+    std::array<V, tile_size> tile;
+    for (size_t j = 0; j < Channels; j += V::width)
+    {
+        for (int done = 0; done < count; done += tile_size)
+        {
+            auto const len = std::min(tile_size, count - done);
+            auto const* from = frames + static_cast<size_t>(done) * stride + j;
+            for (int t = 0; t < len; ++t) { tile[static_cast<size_t>(t)] = detail::load_as<T>(from + static_cast<size_t>(t) * stride); }
+            f(static_cast<V const*>(tile.data()), len, j);
+        }
+    }
+}
+
+} // namespace simd
+} // namespace redsp
+
+#endif // REDSP_SIMD_HEADERGUARD
@@ -0,0 +1,133 @@
+/**
+ * Lock-free single-producer single-consumer ring buffer.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_SPSCRING_HEADERGUARD
+#define REDSP_SPSCRING_HEADERGUARD
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace redsp {
+
+/**
+ * @brief Wait-free ring buffer for handing samples from exactly one producer thread (typically the audio thread) to
+ * exactly one consumer thread. Neither side ever blocks, locks or allocates once the ring is sized; a push that
+ * doesn't fit is truncated and the shortfall counted, so the audio thread never waits on a slow consumer.
+ * The read and write positions only ever increase and are masked into a power-of-two buffer. Each side publishes its
+ * position with a release store and reads the other's with an acquire load, so the samples themselves need no
+ * atomics. The positions sit on separate cache lines so the two threads don't contend for one.
+ * @tparam T element type, trivially copyable
+ */
+template <typename T>
+struct spsc_ring
+{
+    spsc_ring() = default;
+
+    spsc_ring(spsc_ring const&) = delete;
+    spsc_ring& operator=(spsc_ring const&) = delete;
+
+    /**
+     * Sizes the ring to hold at least `@param capacity` elements and empties it. Allocates, and must not run
+     * concurrently with either side.
+     */
+    void prepare(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity) { size <<= 1; }
+        buffer.assign(size, T());
+        mask = size - 1;
+        reset();
+    }
+
+    //! empties the ring; must not run concurrently with either side
+    void reset()
+    {
+        write_position.value.store(0, std::memory_order_relaxed);
+        read_position.value.store(0, std::memory_order_relaxed);
+        dropped_count.store(0, std::memory_order_relaxed);
+    }
+
+    //! number of elements the ring holds
+    size_t capacity() const { return buffer.size(); }
+
+    /**
+     * Producer side: appends up to `@param count` elements from `@param data`, returning how many fit.
+     */
+    size_t push(T const* data, size_t count)
+    {
+        auto const w = write_position.value.load(std::memory_order_relaxed);
+        auto const r = read_position.value.load(std::memory_order_acquire);
+        auto const n = std::min(count, buffer.size() - (w - r));
+        copy_in(data, w, n);
+        write_position.value.store(w + n, std::memory_order_release);
+        if (n < count) { dropped_count.fetch_add(count - n, std::memory_order_relaxed); }
+        return n;
+    }
+
+    /**
+     * Consumer side: takes up to `@param count` elements into `@param data`, returning how many there were.
+     */
+    size_t pop(T* data, size_t count)
+    {
+        auto const r = read_position.value.load(std::memory_order_relaxed);
+        auto const w = write_position.value.load(std::memory_order_acquire);
+        auto const n = std::min(count, w - r);
+        copy_out(data, r, n);
+        read_position.value.store(r + n, std::memory_order_release);
+        return n;
+    }
+
+    //! consumer side: elements ready to pop
+    size_t available() const
+    {
+        return write_position.value.load(std::memory_order_acquire) - read_position.value.load(std::memory_order_relaxed);
+    }
+
+    //! producer side: elements that would fit right now
+    size_t space() const
+    {
+        return buffer.size() - (write_position.value.load(std::memory_order_relaxed) - read_position.value.load(std::memory_order_acquire));
+    }
+
+    //! elements pushes have had to drop since the last reset
+    size_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> buffer;
+    size_t mask = 0;
+
+    //! a position alone on its cache line (64 bytes covers the platforms redsp targets)
+    struct padded_position
+    {
+        std::atomic<size_t> value { 0 };
+        char padding[64 - sizeof(std::atomic<size_t>)];
+    };
+
+    padded_position write_position, read_position;
+    std::atomic<size_t> dropped_count { 0 };
+
+    //! at most two contiguous copies, either side of the wrap
+    void copy_in(T const* data, size_t position, size_t count)
+    {
+        auto const start = position & mask;
+        auto const first = std::min(count, buffer.size() - start);
+        std::copy(data, data + first, buffer.begin() + static_cast<std::ptrdiff_t>(start));
+        std::copy(data + first, data + count, buffer.begin());
+    }
+
+    void copy_out(T* data, size_t position, size_t count) const
+    {
+        auto const start = position & mask;
+        auto const first = std::min(count, buffer.size() - start);
+        std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(start), buffer.begin() + static_cast<std::ptrdiff_t>(start + first), data);
+        std::copy(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(count - first), data + first);
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_SPSCRING_HEADERGUARD
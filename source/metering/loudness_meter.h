@@ -0,0 +1,292 @@
+/**
+ * ITU-R BS.1770 / EBU R128 loudness meter.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_LOUDNESSMETER_HEADERGUARD
+#define REDSP_LOUDNESSMETER_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <limits>
+#include <cmath>
+#include "../filters/biquad.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * Sets `@param shelf` and `@param highpass` to the two stages of the BS.1770 K-weighting filter at sampling rate
+ * `@param fs`: a +4dB high shelf modelling the head, and the RLB highpass. The analog prototypes are the ones the
+ * standard's 48kHz coefficients come from, so any rate gets the same curve.
+ */
+template <typename Biquad>
+void k_weighting(Biquad& shelf, Biquad& highpass, double fs)
+{
+    {
+        auto const f0 = 1681.974450955533, gain_db = 3.999843853973347, Q = 0.7071752369554196;
+        auto const K = std::tan(math::pi<double>() * f0 / fs);
+        auto const Vh = std::pow(10.0, gain_db / 20.0);
+        auto const Vb = std::pow(Vh, 0.4996667741545416);
+        auto const a0 = 1.0 + K / Q + K * K;
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        shelf.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+    {
+        auto const f0 = 38.13547087602444, Q = 0.5003270373238773;
+        auto const K = std::tan(math::pi<double>() * f0 / fs);
+        auto const a0 = 1.0 + K / Q + K * K;
+        highpass.b0 = 1.0;
+        highpass.b1 = -2.0;
+        highpass.b2 = 1.0;
+        highpass.a1 = 2.0 * (K * K - 1.0) / a0;
+        highpass.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+}
+
+/**
+ * @brief Loudness meter after ITU-R BS.1770-4 and EBU R128: momentary (400ms), short-term (3s) and gated integrated
+ * loudness, in LUFS.
+ * Each channel is K-weighted and its power summed over 100ms sub-blocks, SIMD across channels and in double whatever
+ * the sample type, so the cost per channel stays flat as the channel count grows. The momentary and short-term
+ * windows are running sums over the last 4 and 30 sub-blocks, updated by adding the newest and subtracting the one
+ * falling out, and every 400ms gating block (one per sub-block, overlapping by 75%) goes into a histogram
+ * of 0.1 LU bins from -70 to +5 LUFS holding each bin's block count and summed power. The integrated loudness gates
+ * on the histogram, so its cost doesn't grow with the length of the programme; the relative gate is resolved to the
+ * nearest bin edge.
+ * Not thread safe: see metering_engine for running it off the audio thread.
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 2>
+struct loudness_meter
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    //! histogram range and resolution, in LUFS and LU
+    static constexpr double histogram_floor = -70.0, histogram_ceiling = 5.0, histogram_step = 0.1;
+    static constexpr size_t histogram_bins = 750;
+
+    //! samples per frame for process_frames()
+    static constexpr size_t frame_stride = simd::padded_count<SampleType>(Channels);
+
+    loudness_meter()
+    {
+        weights.fill(1.0);
+        prepare(48000.0);
+    }
+
+    /**
+     * Sets up the K-weighting and the sub-block length for sampling rate `@param fs` and resets. Doesn't allocate.
+     */
+    void prepare(double fs)
+    {
+        k_weighting(shelf, highpass, fs);
+        sub_block = math::max(static_cast<int>(std::round(0.1 * fs)), 1);
+        reset();
+    }
+
+    //! forgets everything measured so far
+    void reset()
+    {
+        state.fill(0.0);
+        accumulators.fill(0.0);
+        position = 0;
+        sub_blocks.fill(0.0);
+        sub_block_count = 0;
+        momentary_sum = short_term_sum = 0.0;
+        counts.fill(0);
+        energies.fill(0.0);
+    }
+
+    /**
+     * Sets the weight of channel `@param c` in the sum: 1 for left, right and centre, 1.41 for the surrounds, and 0 to
+     * leave a channel (e.g. the LFE) out.
+     */
+    void set_channel_weight(size_t c, double weight) { weights[c] = weight; }
+
+    /**
+     * Measures `@param count` samples of every channel of `@param samples`, of shape (Channels, count).
+     */
+    void process(SampleType const* const* samples, int count)
+    {
+        run(count, [this, samples](int done, int len)
+        {
+            std::array<SampleType const*, Channels> from;
+            for (size_t c = 0; c < Channels; ++c) { from[c] = samples[c] + done; }
+            simd::for_each_channel_group<double, Channels>(from.data(), len, [this](V const* x, int n, size_t j) { weigh(x, n, j); });
+        });
+    }
+
+    /**
+     * Measures `@param count` interleaved frames of `@param frames`, each frame_stride samples long (the channels,
+     * then padding up to a whole register).
+     */
+    void process_frames(SampleType const* frames, int count)
+    {
+        run(count, [this, frames](int done, int len)
+        {
+            simd::for_each_frame_group<double, Channels>(frames + static_cast<size_t>(done) * frame_stride, frame_stride, len,
+                                                         [this](V const* x, int n, size_t j) { weigh(x, n, j); });
+        });
+    }
+
+    //! loudness over the last 400ms, in LUFS
+    double momentary() const { return lufs(momentary_sum / 4.0); }
+
+    //! loudness over the last 3s, in LUFS
+    double short_term() const { return lufs(short_term_sum / 30.0); }
+
+    //! gated loudness of everything since the last reset, in LUFS (-inf until a block passes the absolute gate)
+    double integrated() const
+    {
+        double energy = 0;
+        size_t blocks = 0;
+        for (size_t b = 0; b < histogram_bins; ++b)
+        {
+            energy += energies[b];
+            blocks += counts[b];
+        }
+        if (blocks == 0) { return -std::numeric_limits<double>::infinity(); }
+
+        // the relative gate sits 10 LU under the loudness of the blocks that passed the absolute one
+        auto const gate = lufs(energy / static_cast<double>(blocks)) - 10.0;
+        energy = 0;
+        blocks = 0;
+        for (auto b = first_bin_above(gate); b < histogram_bins; ++b)
+        {
+            energy += energies[b];
+            blocks += counts[b];
+        }
+        return blocks ? lufs(energy / static_cast<double>(blocks)) : -std::numeric_limits<double>::infinity();
+    }
+
+private:
+    using V = simd::vec<double>;
+    static constexpr size_t padded = simd::padded_count<double>(Channels);
+
+    //! the K-weighting design; only the coefficients are used, the meter keeping its own state
+    biquad<double, double> shelf, highpass;
+    //! transposed direct form II state, two per stage, padded channels apart
+    std::array<double, 4 * padded> state {};
+    std::array<double, Channels> weights;
+    std::array<double, padded> accumulators {};
+    int sub_block = 4800, position = 0;
+
+    //! the last 30 sub-blocks' weighted mean power, newest at sub_block_count % 30
+    std::array<double, 30> sub_blocks {};
+    size_t sub_block_count = 0;
+    double momentary_sum = 0, short_term_sum = 0;
+
+    std::array<size_t, histogram_bins> counts {};
+    std::array<double, histogram_bins> energies {};
+
+    //! hands `@param measure` each stretch of the `@param count` samples that lies within one sub-block
+    template <typename F>
+    void run(int count, F&& measure)
+    {
+        for (int done = 0; done < count;)
+        {
+            auto const len = math::min(count - done, sub_block - position);
+            measure(done, len);
+            done += len;
+            position += len;
+            if (position == sub_block) { finish_sub_block(); }
+        }
+    }
+
+    //! K-weights a tile of `@param n` samples of the channels from `@param j` and adds up their power
+    void weigh(V const* x, int n, size_t j)
+    {
+        auto const sb0 = V::broadcast(shelf.b0), sb1 = V::broadcast(shelf.b1), sb2 = V::broadcast(shelf.b2);
+        auto const sa1 = V::broadcast(-shelf.a1), sa2 = V::broadcast(-shelf.a2);
+        auto const ha1 = V::broadcast(-highpass.a1), ha2 = V::broadcast(-highpass.a2), two = V::broadcast(2.0);
+        auto s1 = V::load(state.data() + j), s2 = V::load(state.data() + padded + j);
+        auto h1 = V::load(state.data() + 2 * padded + j), h2 = V::load(state.data() + 3 * padded + j);
+        auto acc = V::load(accumulators.data() + j);
+        for (int i = 0; i < n; ++i)
+        {
+            auto const u = x[i];
+            auto const v = mul_add(sb0, u, s1);
+            s1 = mul_add(sa1, v, mul_add(sb1, u, s2));
+            s2 = mul_add(sa2, v, sb2 * u);
+            // the highpass's numerator is 1, -2, 1
+            auto const y = v + h1;
+            h1 = mul_add(ha1, y, h2 - two * v);
+            h2 = mul_add(ha2, y, v);
+            acc = mul_add(y, y, acc);
+        }
+        s1.store(state.data() + j);
+        s2.store(state.data() + padded + j);
+        h1.store(state.data() + 2 * padded + j);
+        h2.store(state.data() + 3 * padded + j);
+        acc.store(accumulators.data() + j);
+    }
+
+    static double lufs(double power)
+    {
+        return power > 0 ? -0.691 + 10.0 * std::log10(power) : -std::numeric_limits<double>::infinity();
+    }
+
+    //! the first bin counted above `@param loudness`: the one whose lower edge is nearest
+    static size_t first_bin_above(double loudness)
+    {
+        auto const b = std::round((loudness - histogram_floor) / histogram_step);
+        return static_cast<size_t>(math::clip(0.0, static_cast<double>(histogram_bins - 1), b));
+    }
+
+    void finish_sub_block()
+    {
+        double power = 0;
+        for (size_t c = 0; c < Channels; ++c)
+        {
+            power += weights[c] * accumulators[c];
+            accumulators[c] = 0;
+        }
+        power /= sub_block;
+        position = 0;
+
+        // running sums: in with the newest sub-block, out with the ones leaving each window
+        auto const slot = sub_block_count % 30;
+        auto const old_short = sub_blocks[slot];
+        auto const old_momentary = sub_blocks[(sub_block_count + 26) % 30];
+        sub_blocks[slot] = power;
+        ++sub_block_count;
+        short_term_sum = math::max(short_term_sum + power - old_short, 0.0);
+        momentary_sum = math::max(momentary_sum + power - old_momentary, 0.0);
+        if (slot == 29)
+        {
+            // once round the ring, sum afresh so rounding can't build up over a long programme
+            short_term_sum = momentary_sum = 0;
+            for (size_t i = 0; i < 30; ++i) { short_term_sum += sub_blocks[i]; }
+            for (size_t i = 26; i < 30; ++i) { momentary_sum += sub_blocks[i]; }
+        }
+
+        // a gating block once four sub-blocks have come in, kept if it passes the absolute gate
+        if (sub_block_count >= 4)
+        {
+            auto const block = momentary_sum / 4.0;
+            auto const loudness = lufs(block);
+            if (loudness > histogram_floor)
+            {
+                auto const b = static_cast<size_t>(math::clip(0.0, static_cast<double>(histogram_bins - 1),
+                                                              std::floor((loudness - histogram_floor) / histogram_step)));
+                ++counts[b];
+                energies[b] += block;
+            }
+        }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_LOUDNESSMETER_HEADERGUARD
@@ -0,0 +1,161 @@
+/**
+ * Loudness and true-peak metering off the audio thread.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_METERINGENGINE_HEADERGUARD
+#define REDSP_METERINGENGINE_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include "loudness_meter.h"
+#include "true_peak_meter.h"
+#include "../internal/spsc_ring.h"
+#include "../internal/remath.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Runs a loudness_meter and a true_peak_meter on a thread of its own, so the audio thread only pays for a copy.
+ * The audio thread calls push() with each block: the frames are interleaved into an spsc_ring, which is wait-free,
+ * and if the meter thread has fallen behind so far that they don't fit, the frames that don't are dropped (and
+ * counted) rather than waited for. The meter thread calls update() whenever it likes, which measures everything
+ * pushed since and publishes the readings through atomics, so any thread (a UI timer, say) can read them without
+ * locking. Resets are requested from any thread and carried out by the next update().
+ * @tparam SampleType sample type
+ * @tparam Channels number of channels
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 2>
+struct metering_engine
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    metering_engine() { publish(); }
+
+    metering_engine(metering_engine const&) = delete;
+    metering_engine& operator=(metering_engine const&) = delete;
+
+    /**
+     * Sizes the ring and scratch and resets. Allocates, and must not run concurrently with push() or update().
+     * @param fs sampling rate
+     * @param max_block longest block push() will be called with; longer ones are split
+     * @param buffer_seconds how far the meter thread may fall behind before frames are dropped
+     */
+    void prepare(double fs, int max_block, double buffer_seconds = 0.5)
+    {
+        block = math::max(max_block, 1);
+        auto const frames = math::max(static_cast<size_t>(std::ceil(buffer_seconds * fs)), static_cast<size_t>(block));
+        ring.prepare(frames * stride);
+        interleaved.assign(static_cast<size_t>(block) * stride, SampleType(0));
+        popped.assign(static_cast<size_t>(update_chunk) * stride, SampleType(0));
+        loudness.prepare(fs);
+        true_peak.reset();
+        dropped_frames.store(0, std::memory_order_relaxed);
+        reset_requested.store(false, std::memory_order_relaxed);
+        publish();
+    }
+
+    //! sets the weight of channel `@param c` in the loudness sum; see loudness_meter::set_channel_weight()
+    void set_channel_weight(size_t c, double weight) { loudness.set_channel_weight(c, weight); }
+
+    /**
+     * Audio thread: queues `@param count` samples of every channel of `@param samples`, of shape (Channels, count),
+     * for the meter thread. Never blocks or allocates.
+     */
+    void push(SampleType const* const* samples, int count)
+    {
+        for (int done = 0; done < count; done += block)
+        {
+            auto const len = math::min(block, count - done);
+            for (size_t c = 0; c < Channels; ++c)
+            {
+                auto const* x = samples[c] + done;
+                for (int t = 0; t < len; ++t) { interleaved[static_cast<size_t>(t) * stride + c] = x[t]; }
+            }
+
+            // whole frames only, so the meter thread never sees one split across a drop
+            auto const fit = math::min(static_cast<size_t>(len), ring.space() / stride);
+            ring.push(interleaved.data(), fit * stride);
+            if (fit < static_cast<size_t>(len))
+            {
+                dropped_frames.fetch_add(static_cast<size_t>(len) - fit, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Meter thread: measures every frame pushed so far and publishes the new readings.
+     */
+    void update()
+    {
+        if (reset_requested.exchange(false, std::memory_order_acquire))
+        {
+            loudness.reset();
+            true_peak.reset();
+        }
+
+        // the frames go to the meters as they come out of the ring, already side by side for SIMD across channels
+        while (ring.available() >= stride)
+        {
+            auto const frames = math::min(ring.available() / stride, static_cast<size_t>(update_chunk));
+            ring.pop(popped.data(), frames * stride);
+            loudness.process_frames(popped.data(), static_cast<int>(frames));
+            true_peak.process_frames(popped.data(), static_cast<int>(frames));
+        }
+        publish();
+    }
+
+    //! any thread: asks the next update() to start measuring afresh
+    void request_reset() { reset_requested.store(true, std::memory_order_release); }
+
+    //! any thread: the readings as of the last update(), in LUFS and dBTP
+    double momentary() const { return momentary_lufs.load(std::memory_order_relaxed); }
+    double short_term() const { return short_term_lufs.load(std::memory_order_relaxed); }
+    double integrated() const { return integrated_lufs.load(std::memory_order_relaxed); }
+    double true_peak_db(size_t c) const { return true_peak_dbtp[c].load(std::memory_order_relaxed); }
+
+    //! any thread: frames push() had to drop because the meter thread fell behind
+    size_t dropped() const { return dropped_frames.load(std::memory_order_relaxed); }
+
+private:
+    //! frames are padded to whole registers, the layout the meters' process_frames() take
+    static constexpr size_t stride = loudness_meter<SampleType, Channels>::frame_stride;
+    //! small enough for a chunk of 64 channels to stay in L1 while both meters go over it
+    static constexpr int update_chunk = 64;
+
+    int block = 1;
+    spsc_ring<SampleType> ring;
+    //! producer-side scratch
+    std::vector<SampleType> interleaved;
+    //! consumer-side scratch
+    std::vector<SampleType> popped;
+
+    loudness_meter<SampleType, Channels> loudness;
+    true_peak_meter<SampleType, Channels> true_peak;
+
+    std::atomic<double> momentary_lufs { 0 }, short_term_lufs { 0 }, integrated_lufs { 0 };
+    std::array<std::atomic<double>, Channels> true_peak_dbtp;
+    std::atomic<size_t> dropped_frames { 0 };
+    std::atomic<bool> reset_requested { false };
+
+    void publish()
+    {
+        momentary_lufs.store(loudness.momentary(), std::memory_order_relaxed);
+        short_term_lufs.store(loudness.short_term(), std::memory_order_relaxed);
+        integrated_lufs.store(loudness.integrated(), std::memory_order_relaxed);
+        for (size_t c = 0; c < Channels; ++c) { true_peak_dbtp[c].store(true_peak.peak_db(c), std::memory_order_relaxed); }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_METERINGENGINE_HEADERGUARD
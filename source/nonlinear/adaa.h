@@ -0,0 +1,297 @@
+/**
+ * Antiderivative anti-aliasing (ADAA) for static nonlinearities.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_ADAA_HEADERGUARD
+#define REDSP_ADAA_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/universal.h"
+
+#ifdef redsp_cxx20
+#include <concepts>
+#endif
+
+namespace redsp {
+
+//! tag used in place of a second antiderivative, selecting first-order adaa
+struct no_antiderivative {};
+
+/**
+ * @brief Wraps a static nonlinearity f with second-order antiderivative anti-aliasing (Bilbao, Esqueda, Parker,
+ * Välimäki 2017). Needs f, its first antiderivative F1 and its second antiderivative F2. Adds one sample of delay.
+ * When the difference between inputs falls under `tolerance` the divided differences are ill-conditioned, and the
+ * processor falls back to evaluating the lower-order function at the midpoint.
+ * The block path evaluates F2 and the divided differences in straight loops the compiler can vectorize (as long as
+ * the functors can be inlined), and then patches up the (rare) ill-conditioned samples in a second, scalar pass.
+ * @tparam SampleType sample type (normally float or double)
+ * @tparam F the nonlinearity, callable as SampleType(SampleType)
+ * @tparam F1 first antiderivative of F
+ * @tparam F2 second antiderivative of F, or no_antiderivative for first-order adaa
+ * @tparam Channels number of channels of state
+ */
+template <redsp_arithmetic SampleType, typename F, typename F1, typename F2 = no_antiderivative, size_t Channels = 1>
+struct adaa
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    //! number of samples processed per pass of the block path. Scratch for this lives on the stack.
+    static constexpr int block_size = 64;
+
+    F f;
+    F1 f1;
+    F2 f2;
+    SampleType tolerance;
+
+    // per channel: x[n-1], x[n-2], F2(x[n-1]), F2(x[n-2]), D(x[n-1], x[n-2])
+    struct state { SampleType x1, x2, f2x1, f2x2, d1; };
+    std::array<state, Channels> s;
+
+    explicit adaa(F nl = F(), F1 ad1 = F1(), F2 ad2 = F2(), SampleType tol = default_tolerance())
+        : f(nl), f1(ad1), f2(ad2), tolerance(tol)
+    {
+        reset();
+    }
+
+    //! a tolerance that keeps the cancellation error of the divided differences small for SampleType
+    static constexpr SampleType default_tolerance()
+    {
+        return std::is_same<SampleType, float>::value ? SampleType(1.0e-2) : SampleType(1.0e-5);
+    }
+
+    /**
+     * Resets every channel's state as though the input had been zero forever.
+     */
+    void reset()
+    {
+        auto zero = f2(SampleType(0));
+        auto dzero = f1(SampleType(0));
+        s.fill({ SampleType(0), SampleType(0), zero, zero, dzero });
+    }
+
+    /**
+     * Processes a single sample on channel `@param n`.
+     * @param sample input sample
+     * @param n channel to process on
+     * @return the anti-aliased output, delayed by one sample
+     */
+    SampleType process(SampleType const& sample, int n = 0)
+    {
+        auto& S = s[static_cast<size_t>(n)];
+        auto f2x0 = f2(sample);
+        auto d0 = divided(sample, S.x1, f2x0, S.f2x1);
+
+        auto y = math::abs(sample - S.x2) < tolerance
+                 ? fallback(sample, S.x1, S.x2)
+                 : SampleType(2) * (d0 - S.d1) / (sample - S.x2);
+
+        S.d1 = d0;
+        S.x2 = S.x1;
+        S.f2x2 = S.f2x1;
+        S.x1 = sample;
+        S.f2x1 = f2x0;
+        return y;
+    }
+
+    /**
+     * Processes `@param count` samples from `@param input` into `@param output` on channel `@param n`. input and
+     * output may alias.
+     */
+    void process(SampleType const* input, SampleType* output, int count, int n = 0)
+    {
+        auto& S = s[static_cast<size_t>(n)];
+
+        // xb[j] holds x[j - 2], so xb[0], xb[1] are the two samples of history
+        SampleType xb[block_size + 2], fb[block_size + 2], db[block_size + 2];
+
+        for (int done = 0; done < count; done += block_size)
+        {
+            int const len = math::min(block_size, count - done);
+            xb[0] = S.x2;  xb[1] = S.x1;
+            fb[0] = S.f2x2; fb[1] = S.f2x1;
+            db[1] = S.d1;
+
+            for (int j = 0; j < len; ++j) { xb[j + 2] = input[done + j]; }
+            for (int j = 2; j < len + 2; ++j) { fb[j] = f2(xb[j]); }
+
+            for (int j = 2; j < len + 2; ++j)
+            {
+                auto dx = xb[j] - xb[j - 1];
+                db[j] = (fb[j] - fb[j - 1]) / (math::abs(dx) < tolerance ? SampleType(1) : dx);
+            }
+            for (int j = 2; j < len + 2; ++j)
+            {
+                if (math::abs(xb[j] - xb[j - 1]) < tolerance) { db[j] = f1(SampleType(0.5) * (xb[j] + xb[j - 1])); }
+            }
+
+            auto* out = output + done;
+            for (int j = 2; j < len + 2; ++j)
+            {
+                auto dx = xb[j] - xb[j - 2];
+                out[j - 2] = SampleType(2) * (db[j] - db[j - 1]) / (math::abs(dx) < tolerance ? SampleType(1) : dx);
+            }
+            for (int j = 2; j < len + 2; ++j)
+            {
+                if (math::abs(xb[j] - xb[j - 2]) < tolerance) { out[j - 2] = fallback(xb[j], xb[j - 1], xb[j - 2]); }
+            }
+
+            S.x2 = xb[len];     S.x1 = xb[len + 1];
+            S.f2x2 = fb[len];   S.f2x1 = fb[len + 1];
+            S.d1 = db[len + 1];
+        }
+    }
+
+    /**
+     * Processes `@param count` samples in place on channel `@param n`.
+     */
+    void process(SampleType* samples, int count, int n = 0) { process(samples, samples, count, n); }
+
+    /**
+     * Processes multi-channel samples in place.
+     * @param samples array of Channels pointers to `@param count` samples each
+     */
+    void process(SampleType** samples, int count)
+    {
+        for (int i = 0; i < static_cast<int>(Channels); ++i) { process(samples[i], count, i); }
+    }
+
+private:
+    //! (F2(x0) - F2(x1)) / (x0 - x1), or F1 at the midpoint when ill-conditioned
+    SampleType divided(SampleType x0, SampleType x1, SampleType f2x0, SampleType f2x1)
+    {
+        return math::abs(x0 - x1) < tolerance ? f1(SampleType(0.5) * (x0 + x1)) : (f2x0 - f2x1) / (x0 - x1);
+    }
+
+    /**
+     * used when x[n] ~= x[n-2]: replaces both with their midpoint xbar, so the output is the average of f over the
+     * segment from xbar to x[n-1] and back, weighted towards xbar. Only when x[n-1] is close to xbar as well does it
+     * come down to f at the midpoint of the two.
+     */
+    SampleType fallback(SampleType x0, SampleType x1, SampleType x2)
+    {
+        auto xbar = SampleType(0.5) * (x0 + x2);
+        auto delta = xbar - x1;
+        if (math::abs(delta) < tolerance) { return f(SampleType(0.5) * (xbar + x1)); }
+        return (SampleType(2) / delta) * (f1(xbar) + (f2(x1) - f2(xbar)) / delta);
+    }
+};
+
+/**
+ * @brief First-order antiderivative anti-aliasing: y[n] = (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1]), falling back to
+ * f((x[n] + x[n-1]) / 2) when the inputs are within `tolerance` of each other. Adds half a sample of delay.
+ */
+template <redsp_arithmetic SampleType, typename F, typename F1, size_t Channels>
+struct adaa<SampleType, F, F1, no_antiderivative, Channels>
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    static constexpr int block_size = 64;
+
+    F f;
+    F1 f1;
+    SampleType tolerance;
+
+    // per channel: x[n-1], F1(x[n-1])
+    struct state { SampleType x1, f1x1; };
+    std::array<state, Channels> s;
+
+    explicit adaa(F nl = F(), F1 ad1 = F1(), SampleType tol = default_tolerance())
+        : f(nl), f1(ad1), tolerance(tol)
+    {
+        reset();
+    }
+
+    static constexpr SampleType default_tolerance()
+    {
+        return std::is_same<SampleType, float>::value ? SampleType(1.0e-3) : SampleType(1.0e-6);
+    }
+
+    void reset()
+    {
+        s.fill({ SampleType(0), f1(SampleType(0)) });
+    }
+
+    SampleType process(SampleType const& sample, int n = 0)
+    {
+        auto& S = s[static_cast<size_t>(n)];
+        auto f1x0 = f1(sample);
+        auto dx = sample - S.x1;
+        auto y = math::abs(dx) < tolerance ? f(SampleType(0.5) * (sample + S.x1)) : (f1x0 - S.f1x1) / dx;
+
+        S.x1 = sample;
+        S.f1x1 = f1x0;
+        return y;
+    }
+
+    void process(SampleType const* input, SampleType* output, int count, int n = 0)
+    {
+        auto& S = s[static_cast<size_t>(n)];
+        SampleType xb[block_size + 1], fb[block_size + 1];
+
+        for (int done = 0; done < count; done += block_size)
+        {
+            int const len = math::min(block_size, count - done);
+            xb[0] = S.x1;
+            fb[0] = S.f1x1;
+
+            for (int j = 0; j < len; ++j) { xb[j + 1] = input[done + j]; }
+            for (int j = 1; j < len + 1; ++j) { fb[j] = f1(xb[j]); }
+
+            auto* out = output + done;
+            for (int j = 1; j < len + 1; ++j)
+            {
+                auto dx = xb[j] - xb[j - 1];
+                out[j - 1] = (fb[j] - fb[j - 1]) / (math::abs(dx) < tolerance ? SampleType(1) : dx);
+            }
+            for (int j = 1; j < len + 1; ++j)
+            {
+                if (math::abs(xb[j] - xb[j - 1]) < tolerance) { out[j - 1] = f(SampleType(0.5) * (xb[j] + xb[j - 1])); }
+            }
+
+            S.x1 = xb[len];
+            S.f1x1 = fb[len];
+        }
+    }
+
+    void process(SampleType* samples, int count, int n = 0) { process(samples, samples, count, n); }
+
+    void process(SampleType** samples, int count)
+    {
+        for (int i = 0; i < static_cast<int>(Channels); ++i) { process(samples[i], count, i); }
+    }
+};
+
+/**
+ * Makes a first-order adaa processor from a nonlinearity and its antiderivative, e.g.
+ * `auto clipper = make_adaa<float>(hardclip, hardclip_ad1);`
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1, typename F, typename F1>
+adaa<SampleType, F, F1, no_antiderivative, Channels> make_adaa(F f, F1 f1)
+{
+    return adaa<SampleType, F, F1, no_antiderivative, Channels>(f, f1);
+}
+
+/**
+ * Makes a second-order adaa processor from a nonlinearity and its first and second antiderivatives.
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1, typename F, typename F1, typename F2>
+adaa<SampleType, F, F1, F2, Channels> make_adaa(F f, F1 f1, F2 f2)
+{
+    return adaa<SampleType, F, F1, F2, Channels>(f, f1, f2);
+}
+
+} // namespace redsp
+
+#endif // REDSP_ADAA_HEADERGUARD
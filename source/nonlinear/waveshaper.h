@@ -0,0 +1,142 @@
+/**
+ * Static nonlinearity (waveshaper) processors.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_WAVESHAPER_HEADERGUARD
+#define REDSP_WAVESHAPER_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include "../internal/remath.h"
+#include "../internal/universal.h"
+
+#ifdef redsp_cxx20
+#include <concepts>
+#endif
+
+namespace redsp {
+
+/**
+ * @brief Applies a static nonlinearity f to every sample. f is held by value and called directly, so a functor or
+ * lambda is inlined into the block loop (which the compiler is then free to vectorize) - there's no indirection
+ * per sample as there would be through std::function or a function pointer.
+ * @tparam SampleType sample type (normally float or double)
+ * @tparam F the nonlinearity, callable as SampleType(SampleType)
+ * @tparam Channels number of channels processed by process(SampleType**, int). The shaper itself has no state.
+ */
+template <redsp_arithmetic SampleType, typename F, size_t Channels = 1>
+struct waveshaper
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Channels > 0, "It doesn't make sense to have zero/negative channels");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = Channels;
+
+    F f;
+
+    explicit waveshaper(F nl = F()) : f(nl) { }
+
+    SampleType process(SampleType const& sample, int = 0) { return f(sample); }
+
+    /**
+     * Shapes `@param count` samples from `@param input` into `@param output`. input and output may alias.
+     */
+    void process(SampleType const* input, SampleType* output, int count, int = 0)
+    {
+        for (int i = 0; i < count; ++i) { output[i] = f(input[i]); }
+    }
+
+    void process(SampleType* samples, int count, int n = 0) { process(samples, samples, count, n); }
+
+    void process(SampleType** samples, int count)
+    {
+        for (int i = 0; i < static_cast<int>(Channels); ++i) { process(samples[i], count, i); }
+    }
+};
+
+/**
+ * Makes a waveshaper from a functor or lambda, e.g. `auto shaper = make_waveshaper<float>([](float x) { ... });`
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1, typename F>
+waveshaper<SampleType, F, Channels> make_waveshaper(F f)
+{
+    return waveshaper<SampleType, F, Channels>(f);
+}
+
+/**
+ * @brief A transfer curve sampled on a uniform grid over [low, high], evaluated by linear interpolation. Inputs
+ * outside the range are clamped to it. Each point is stored next to the slope to the following point, so a lookup
+ * is a single multiply-add on one cache line. The default of 1024 points keeps float tables at 8kB, which stays in L1.
+ */
+template <redsp_arithmetic SampleType>
+struct lookup_table
+{
+    redsp_arithmetic_assert(SampleType)
+
+    lookup_table() = default;
+
+    template <typename Curve>
+    lookup_table(Curve&& curve, SampleType low, SampleType high, int points = 1024)
+    {
+        prepare(curve, low, high, points);
+    }
+
+    /**
+     * Samples `@param curve` at `@param points` points spanning [`@param low`, `@param high`]. Allocates, so call
+     * this outside of the audio callback. The curve can be anything callable, including a std::function - it is
+     * only called here.
+     */
+    template <typename Curve>
+    void prepare(Curve&& curve, SampleType low, SampleType high, int points = 1024)
+    {
+        points = math::max(points, 2);
+        lo = low;
+        hi = high;
+        last = SampleType(points - 1);
+        scale = last / (high - low);
+
+        table.resize(static_cast<size_t>(points) * 2);
+        auto step = (high - low) / last;
+        auto prev = static_cast<SampleType>(curve(low));
+        for (int i = 0; i < points; ++i)
+        {
+            auto next = i + 1 < points ? static_cast<SampleType>(curve(low + step * SampleType(i + 1))) : prev;
+            table[static_cast<size_t>(i) * 2] = prev;
+            table[static_cast<size_t>(i) * 2 + 1] = next - prev;
+            prev = next;
+        }
+    }
+
+    SampleType operator()(SampleType x) const
+    {
+        auto pos = math::clip(SampleType(0), last, (x - lo) * scale);
+        auto i = static_cast<size_t>(pos);
+        auto frac = pos - static_cast<SampleType>(i);
+        return table[i * 2] + frac * table[i * 2 + 1];
+    }
+
+    bool empty() const { return table.empty(); }
+
+    SampleType lo = 0, hi = 0, last = 0, scale = 0;
+    std::vector<SampleType> table;
+};
+
+/**
+ * @brief A waveshaper whose curve is baked into a lookup_table. Call `prepare()` with the curve before processing.
+ */
+template <redsp_arithmetic SampleType, size_t Channels = 1>
+struct table_waveshaper : public waveshaper<SampleType, lookup_table<SampleType>, Channels>
+{
+    template <typename Curve>
+    void prepare(Curve&& curve, SampleType low, SampleType high, int points = 1024)
+    {
+        this->f.prepare(curve, low, high, points);
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_WAVESHAPER_HEADERGUARD
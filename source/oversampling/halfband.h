@@ -0,0 +1,318 @@
+/**
+ * Polyphase halfband 2x up/downsampling stages, FIR (linear phase) and IIR (minimum phase, low latency).
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_HALFBAND_HEADERGUARD
+#define REDSP_HALFBAND_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Linear-phase halfband FIR stage for one channel, Kaiser-windowed sinc with 4K-1 taps.
+ * Every other tap of a halfband filter is zero and the center tap is 0.5, so in polyphase form one phase is a 2K-tap
+ * FIR (run as a SIMD dot product) and the other is a pure delay of K-1 samples at the low rate.
+ */
+template <redsp_arithmetic SampleType>
+struct halfband_fir
+{
+    redsp_arithmetic_assert(SampleType)
+
+    /**
+     * Designs the filter.
+     * @param k half the length of the nonzero polyphase branch; the full filter has 4k-1 taps
+     * @param beta Kaiser window beta (8 gives roughly 80dB of stopband attenuation)
+     */
+    explicit halfband_fir(int k = 16, double beta = 8.0) : K(math::max(k, 1))
+    {
+        auto const L = 2 * K;
+        auto const c = 2 * K - 1;
+
+        // taps h[c + d] for odd d, stored reversed so the newest sample lines up with the last coefficient
+        taps.resize(static_cast<size_t>(L));
+        double sum = 0;
+        for (int j = 0; j < L; ++j)
+        {
+            auto d = 2 * j - c;
+            auto r = static_cast<double>(d) / c;
+            auto h = std::sin(math::halfpi<double>() * d) / (math::pi<double>() * d)
+                     * math::bessel_i0(beta * std::sqrt(math::max(0.0, 1.0 - r * r))) / math::bessel_i0(beta);
+            taps[static_cast<size_t>(L - 1 - j)] = static_cast<SampleType>(h);
+            sum += h;
+        }
+        // normalize to unity gain at DC: the branch sums to 0.5 and the center tap supplies the rest
+        for (auto& t : taps) { t = static_cast<SampleType>(t * (0.5 / sum)); }
+        up_taps = taps;
+        for (auto& t : up_taps) { t *= SampleType(2); }
+    }
+
+    /**
+     * Allocates history and working buffers for blocks of up to `@param max_block` low-rate samples.
+     */
+    void prepare(int max_block)
+    {
+        auto const L = static_cast<size_t>(2 * K);
+        up_buf.assign(L - 1 + static_cast<size_t>(max_block), SampleType(0));
+        even_buf.assign(L - 1 + static_cast<size_t>(max_block), SampleType(0));
+        odd_buf.assign(static_cast<size_t>(K + max_block), SampleType(0));
+    }
+
+    void reset()
+    {
+        std::fill(up_buf.begin(), up_buf.end(), SampleType(0));
+        std::fill(even_buf.begin(), even_buf.end(), SampleType(0));
+        std::fill(odd_buf.begin(), odd_buf.end(), SampleType(0));
+    }
+
+    /**
+     * Upsamples `@param count` samples from `@param input` into 2 * count samples in `@param output`.
+     */
+    void upsample(SampleType const* input, SampleType* output, int count)
+    {
+        auto const L = 2 * K;
+        auto* buf = up_buf.data();
+        std::copy(input, input + count, buf + L - 1);
+
+        for (int n = 0; n < count; ++n)
+        {
+            output[2 * n] = simd::dot(up_taps.data(), buf + n, L);
+            output[2 * n + 1] = buf[n + K];
+        }
+
+        std::copy(buf + count, buf + count + L - 1, buf);
+    }
+
+    /**
+     * Downsamples 2 * `@param count` samples from `@param input` into `@param count` samples in `@param output`.
+     */
+    void downsample(SampleType const* input, SampleType* output, int count)
+    {
+        auto const L = 2 * K;
+        auto* even = even_buf.data();
+        auto* odd = odd_buf.data();
+        for (int n = 0; n < count; ++n)
+        {
+            even[L - 1 + n] = input[2 * n];
+            odd[K + n] = input[2 * n + 1];
+        }
+
+        for (int n = 0; n < count; ++n)
+        {
+            output[n] = simd::dot(taps.data(), even + n, L) + SampleType(0.5) * odd[n];
+        }
+
+        std::copy(even + count, even + count + L - 1, even);
+        std::copy(odd + count, odd + count + K, odd);
+    }
+
+    //! group delay of one pass (up or down), in samples at the high rate
+    double latency() const { return 2.0 * K - 1.0; }
+
+    int K;
+    std::vector<SampleType> taps, up_taps;
+    std::vector<SampleType> up_buf, even_buf, odd_buf;
+};
+
+/**
+ * @brief Minimum-phase-ish halfband IIR stage: two parallel chains of first-order allpasses in z^2 (Valenzuela &
+ * Constantinides), with coefficients designed from an elliptic prototype as in Laurent de Soras' HIIR.
+ * Much cheaper and lower latency than halfband_fir, at the cost of phase distortion near the band edge.
+ * Each section depends on the one before, so a channel's chains don't vectorize; instead the stage holds `Lanes`
+ * channels and the overloads taking a pointer per channel run them side by side in simd lanes. The single-channel
+ * overloads run one lane on its own.
+ */
+template <redsp_arithmetic SampleType, size_t Lanes = 1>
+struct halfband_iir
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Lanes > 0, "It doesn't make sense to have zero lanes");
+
+    /**
+     * Designs the filter.
+     * @param coefficients number of allpass coefficients (split between both chains); more is steeper
+     * @param transition transition bandwidth, normalized to the high rate (0, 0.5)
+     */
+    explicit halfband_iir(int coefficients = 8, double transition = 0.05)
+    {
+        coefficients = math::max(coefficients, 1);
+        coefs.resize(static_cast<size_t>(coefficients));
+
+        // elliptic parameters from the transition band
+        auto k = std::tan((1.0 - transition * 2.0) * math::pi<double>() / 4.0);
+        k *= k;
+        auto kksqrt = std::pow(1.0 - k * k, 0.25);
+        auto e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+        auto e4 = e * e * e * e;
+        auto q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+        auto order = coefficients * 2 + 1;
+        for (int i = 0; i < coefficients; ++i)
+        {
+            auto c = i + 1;
+            double num = 0, den = 0, term;
+            int j = 0;
+            do
+            {
+                term = std::pow(q, j * (j + 1)) * std::sin((j * 2 + 1) * c * math::pi<double>() / order)
+                       * (j % 2 ? -1.0 : 1.0);
+                num += term;
+                ++j;
+            } while (std::abs(term) > 1.0e-100 && j < 64);
+            j = 1;
+            do
+            {
+                term = std::pow(q, j * j) * std::cos(j * 2 * c * math::pi<double>() / order) * (j % 2 ? -1.0 : 1.0);
+                den += term;
+                ++j;
+            } while (std::abs(term) > 1.0e-100 && j < 64);
+
+            auto ww = num * std::pow(q, 0.25) / (den + 0.5);
+            auto wwsq = ww * ww;
+            auto x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+            coefs[static_cast<size_t>(i)] = static_cast<SampleType>((1.0 - x) / (1.0 + x));
+        }
+
+        state.assign(coefs.size() * 2 * padded, SampleType(0));
+    }
+
+    void prepare(int) { reset(); }
+
+    void reset() { std::fill(state.begin(), state.end(), SampleType(0)); }
+
+    //! upsamples `@param count` samples of lane `@param lane` from `@param input` into 2 * count in `@param output`
+    void upsample(SampleType const* input, SampleType* output, int count, size_t lane = 0)
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            auto even = input[n], odd = input[n];
+            run_chains(even, odd, lane);
+            output[2 * n] = even;
+            output[2 * n + 1] = odd;
+        }
+    }
+
+    //! downsamples 2 * `@param count` samples of lane `@param lane` from `@param input` into count in `@param output`
+    void downsample(SampleType const* input, SampleType* output, int count, size_t lane = 0)
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            auto a = input[2 * n + 1], b = input[2 * n];
+            run_chains(a, b, lane);
+            output[n] = SampleType(0.5) * (a + b);
+        }
+    }
+
+    /**
+     * Upsamples `@param count` samples of every lane, from `@param input`[lane] into 2 * count samples in
+     * `@param output`[lane].
+     */
+    void upsample(SampleType const* const* input, SampleType* const* output, int count)
+    {
+        for (size_t g = 0; g < Lanes; g += width)
+        {
+            std::array<SampleType, width> x {}, even, odd;
+            for (int n = 0; n < count; ++n)
+            {
+                for (size_t l = 0; l < width && g + l < Lanes; ++l) { x[l] = input[g + l][n]; }
+                auto a = V::load(x.data()), b = a;
+                run_chains(a, b, g);
+                a.store(even.data());
+                b.store(odd.data());
+                for (size_t l = 0; l < width && g + l < Lanes; ++l)
+                {
+                    output[g + l][2 * n] = even[l];
+                    output[g + l][2 * n + 1] = odd[l];
+                }
+            }
+        }
+    }
+
+    /**
+     * Downsamples 2 * `@param count` samples of every lane, from `@param input`[lane] into count samples in
+     * `@param output`[lane].
+     */
+    void downsample(SampleType const* const* input, SampleType* const* output, int count)
+    {
+        for (size_t g = 0; g < Lanes; g += width)
+        {
+            std::array<SampleType, width> even {}, odd {}, y;
+            for (int n = 0; n < count; ++n)
+            {
+                for (size_t l = 0; l < width && g + l < Lanes; ++l)
+                {
+                    even[l] = input[g + l][2 * n];
+                    odd[l] = input[g + l][2 * n + 1];
+                }
+                auto a = V::load(odd.data()), b = V::load(even.data());
+                run_chains(a, b, g);
+                (V::broadcast(SampleType(0.5)) * (a + b)).store(y.data());
+                for (size_t l = 0; l < width && g + l < Lanes; ++l) { output[g + l][n] = y[l]; }
+            }
+        }
+    }
+
+    //! group delay at DC of one pass (up or down), in samples at the high rate
+    double latency() const
+    {
+        // each section (c + z^-2) / (1 + c z^-2) delays DC by 2(1-c)/(1+c); the odd chain has an extra z^-1
+        double chain[2] = { 0, 1 };
+        for (size_t i = 0; i < coefs.size(); ++i)
+        {
+            chain[i % 2] += 2.0 * (1.0 - coefs[i]) / (1.0 + coefs[i]);
+        }
+        return 0.5 * (chain[0] + chain[1]);
+    }
+
+    std::vector<SampleType> coefs;
+
+private:
+    using V = simd::vec<SampleType>;
+    static constexpr size_t width = V::width;
+    static constexpr size_t padded = (Lanes + width - 1) / width * width;
+
+    // x[n-1] then y[n-1] for each section, each a row of every lane, padded to whole registers
+    std::vector<SampleType> state;
+
+    //! runs `a` through the even-indexed sections and `b` through the odd-indexed ones, for lane `lane`
+    void run_chains(SampleType& a, SampleType& b, size_t lane)
+    {
+        auto* S = state.data() + lane;
+        auto const N = coefs.size();
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto& v = i % 2 ? b : a;
+            auto y = (v - S[(2 * i + 1) * padded]) * coefs[i] + S[2 * i * padded];
+            S[2 * i * padded] = v;
+            S[(2 * i + 1) * padded] = y;
+            v = y;
+        }
+    }
+
+    //! the same for the register of lanes starting at `first`
+    void run_chains(V& a, V& b, size_t first)
+    {
+        auto* S = state.data() + first;
+        auto const N = coefs.size();
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto& v = i % 2 ? b : a;
+            auto y = (v - V::load(S + (2 * i + 1) * padded)) * V::broadcast(coefs[i]) + V::load(S + 2 * i * padded);
+            v.store(S + 2 * i * padded);
+            y.store(S + (2 * i + 1) * padded);
+            v = y;
+        }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_HALFBAND_HEADERGUARD
@@ -0,0 +1,225 @@
+/**
+ * Runs any processor at a multiple of the host sampling rate.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_OVERSAMPLED_HEADERGUARD
+#define REDSP_OVERSAMPLED_HEADERGUARD
+
+#include <algorithm>
+#include <type_traits>
+#include <array>
+#include <vector>
+#include "halfband.h"
+#include "../internal/processor.h"
+#include "../internal/remath.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+enum class oversampling_phase
+{
+    linear = 0, //!< halfband FIR stages: no phase distortion, more latency and cpu
+    minimum     //!< halfband allpass IIR stages: low latency and cheap, phase distortion near nyquist
+};
+
+/**
+ * @brief Upsamples by Factor through a cascade of polyphase 2x halfband stages, runs the inner processor at the high
+ * rate, and downsamples back. The first stage (nearest the host rate) gets the steepest filter; later stages only need
+ * to reject images far from the passband, so they're much shorter.
+ * The inner processor needs `process(sample_type* samples, int count, int channel)`, and is exposed as `inner` so it
+ * can be configured for the high rate (i.e. Factor * fs).
+ * Linear phase stages are vectorized within a channel. Minimum phase stages hold every channel, and the overload taking
+ * a pointer per channel runs them through each stage together, in simd lanes.
+ * @tparam Processor processor to oversample, see processor_traits
+ * @tparam Factor oversampling factor, a power of two
+ * @tparam Phase linear (FIR) or minimum (IIR) phase stages
+ */
+template <typename Processor, size_t Factor, oversampling_phase Phase = oversampling_phase::linear>
+struct oversampled
+{
+    using sample_type = typename processor_traits<Processor>::sample_type;
+    static constexpr size_t channels = processor_traits<Processor>::channels;
+
+    static_assert(Factor > 0 && (Factor & (Factor - 1)) == 0, "Factor must be a power of two");
+
+    static constexpr size_t factor = Factor;
+    static constexpr size_t stages = Factor >= 16 ? 4 : Factor >= 8 ? 3 : Factor >= 4 ? 2 : Factor >= 2 ? 1 : 0;
+    static_assert(size_t(1) << stages == Factor, "Factors above 16 aren't supported");
+
+    using stage_type = typename std::conditional<Phase == oversampling_phase::linear,
+                                                 halfband_fir<sample_type>,
+                                                 halfband_iir<sample_type, channels>>::type;
+
+    Processor inner;
+
+    explicit oversampled(Processor p = Processor()) : inner(p)
+    {
+        for (auto& bank : filters)
+        {
+            for (size_t s = 0; s < stages; ++s) { bank.push_back(make_stage(s)); }
+        }
+    }
+
+    /**
+     * Allocates buffers for up to `@param max_block` samples per call at the host rate. Longer calls are split up.
+     */
+    void prepare(int max_block)
+    {
+        block = math::max(max_block, 1);
+        for (auto& bank : filters)
+        {
+            for (size_t s = 0; s < stages; ++s) { bank[s].prepare(block << s); }
+        }
+        for (auto& ch : buffers)
+        {
+            for (auto& b : ch) { b.assign(static_cast<size_t>(block) * Factor, sample_type(0)); }
+        }
+    }
+
+    void reset()
+    {
+        for (auto& bank : filters) { for (auto& f : bank) { f.reset(); } }
+    }
+
+    /**
+     * Processes `@param count` samples in place on channel `@param n`. `prepare()` must have been called.
+     */
+    void process(sample_type* samples, int count, int n = 0)
+    {
+        auto const c = static_cast<size_t>(n);
+        auto& bank = filters[linear ? c : 0];
+        auto& buf = buffers[c];
+
+        for (int done = 0; done < count; done += block)
+        {
+            int const len = math::min(block, count - done);
+            auto* x = samples + done;
+
+            // stage s takes len << s samples to len << (s + 1), ping-ponging between buffers
+            sample_type const* src = x;
+            size_t b = 0;
+            for (size_t s = 0; s < stages; ++s, b ^= 1)
+            {
+                upsample(bank[s], src, buf[b].data(), len << s, c);
+                src = buf[b].data();
+            }
+
+            auto* high = stages ? buf[b ^ 1].data() : x;
+            inner.process(high, len * static_cast<int>(Factor), n);
+
+            src = high;
+            for (size_t s = stages; s-- > 0; b ^= 1)
+            {
+                auto* dst = s == 0 ? x : buf[b].data();
+                downsample(bank[s], src, dst, len << s, c);
+                src = dst;
+            }
+        }
+    }
+
+    void process(sample_type** samples, int count)
+    {
+        process(samples, count, std::integral_constant<bool, linear>());
+    }
+
+    /**
+     * Returns the delay the up/downsampling filters add, in samples at the host rate. This doesn't include any latency
+     * of the inner processor. For minimum phase stages it's the group delay at DC, and may be fractional.
+     */
+    double latency() const
+    {
+        double total = 0;
+        for (size_t s = 0; s < stages; ++s)
+        {
+            // a stage runs at 2^(s+1) times the host rate, and is passed through twice
+            total += 2.0 * filters[0][s].latency() / static_cast<double>(size_t(2) << s);
+        }
+        return total;
+    }
+
+private:
+    static constexpr bool linear = Phase == oversampling_phase::linear;
+
+    //! a channel at a time
+    void process(sample_type** samples, int count, std::true_type)
+    {
+        for (int i = 0; i < static_cast<int>(channels); ++i) { process(samples[i], count, i); }
+    }
+
+    //! every channel through each stage at once, as simd lanes of the minimum phase stages
+    void process(sample_type** samples, int count, std::false_type)
+    {
+        auto& bank = filters[0];
+        std::array<sample_type const*, channels> src;
+        std::array<sample_type*, channels> dst;
+
+        for (int done = 0; done < count; done += block)
+        {
+            int const len = math::min(block, count - done);
+            for (size_t c = 0; c < channels; ++c) { src[c] = samples[c] + done; }
+
+            size_t b = 0;
+            for (size_t s = 0; s < stages; ++s, b ^= 1)
+            {
+                for (size_t c = 0; c < channels; ++c) { dst[c] = buffers[c][b].data(); }
+                bank[s].upsample(src.data(), dst.data(), len << s);
+                std::copy(dst.begin(), dst.end(), src.begin());
+            }
+
+            for (size_t c = 0; c < channels; ++c)
+            {
+                auto* high = stages ? buffers[c][b ^ 1].data() : samples[c] + done;
+                inner.process(high, len * static_cast<int>(Factor), static_cast<int>(c));
+                src[c] = high;
+            }
+
+            for (size_t s = stages; s-- > 0; b ^= 1)
+            {
+                for (size_t c = 0; c < channels; ++c) { dst[c] = s == 0 ? samples[c] + done : buffers[c][b].data(); }
+                bank[s].downsample(src.data(), dst.data(), len << s);
+                std::copy(dst.begin(), dst.end(), src.begin());
+            }
+        }
+    }
+
+    // a linear phase stage runs one channel; a minimum phase one runs lane c of its channels
+    static void upsample(halfband_fir<sample_type>& f, sample_type const* in, sample_type* out, int count, size_t)
+    {
+        f.upsample(in, out, count);
+    }
+
+    static void downsample(halfband_fir<sample_type>& f, sample_type const* in, sample_type* out, int count, size_t)
+    {
+        f.downsample(in, out, count);
+    }
+
+    template <typename Stage>
+    static void upsample(Stage& f, sample_type const* in, sample_type* out, int count, size_t c)
+    {
+        f.upsample(in, out, count, c);
+    }
+
+    template <typename Stage>
+    static void downsample(Stage& f, sample_type const* in, sample_type* out, int count, size_t c)
+    {
+        f.downsample(in, out, count, c);
+    }
+
+    static stage_type make_stage(size_t s)
+    {
+        return make_stage(s, std::integral_constant<bool, linear>());
+    }
+
+    static stage_type make_stage(size_t s, std::true_type)  { return stage_type(s == 0 ? 16 : s == 1 ? 6 : 4); }
+    static stage_type make_stage(size_t s, std::false_type) { return stage_type(s == 0 ? 10 : s == 1 ? 4 : 3, s == 0 ? 0.04 : 0.25); }
+
+    int block = 0;
+    // a bank of stages per channel for linear phase; for minimum phase, one bank holds every channel
+    std::array<std::vector<stage_type>, linear ? channels : 1> filters;
+    std::array<std::array<std::vector<sample_type>, 2>, channels> buffers;
+};
+
+} // namespace redsp
+
+#endif // REDSP_OVERSAMPLED_HEADERGUARD
@@ -1,2 +1,22 @@
+#include "internal/denormals.h"
 #include "filters/svf.h"
-#include "filters/biquad.h"
\ No newline at end of file
+#include "filters/biquad.h"
+#include "filters/fir.h"
+#include "filters/ladder.h"
+#include "filters/integrators.h"
+#include "filters/filter_chain.h"
+#include "delay/delay_line.h"
+#include "reverb/fdn_reverb.h"
+#include "dynamics/envelope_follower.h"
+#include "dynamics/compressor.h"
+#include "metering/loudness_meter.h"
+#include "metering/true_peak_meter.h"
+#include "metering/metering_engine.h"
+#include "nonlinear/adaa.h"
+#include "nonlinear/waveshaper.h"
+#include "oversampling/oversampled.h"
+#include "resampling/resampler.h"
+#include "fft/fft.h"
+#include "fft/stft.h"
+#include "convolution/uniform_convolver.h"
+#include "convolution/nonuniform_convolver.h"
\ No newline at end of file
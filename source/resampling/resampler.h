@@ -0,0 +1,305 @@
+/**
+ * Streaming arbitrary-ratio sample rate conversion with a shared polyphase windowed-sinc bank.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_RESAMPLER_HEADERGUARD
+#define REDSP_RESAMPLER_HEADERGUARD
+
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <cmath>
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+/**
+ * @brief Polyphase bank of a Kaiser-windowed sinc lowpass, sampled at `phases` fractional offsets between input
+ * samples. Each row stores its coefficients followed by the difference to the next phase's coefficients, so a
+ * resampler can interpolate linearly between phases in the same pass as the inner product.
+ * Tables are immutable once built and are shared between resamplers with the same design through get().
+ */
+template <redsp_arithmetic T>
+struct resampler_table
+{
+    redsp_arithmetic_assert(T)
+
+    /**
+     * Designs the bank.
+     * @param zero_crossings zero crossings of the sinc on each side of the center
+     * @param phase_count number of fractional phases
+     * @param fc cutoff frequency normalized to the input rate (0, 0.5]
+     * @param beta Kaiser window beta (8 gives roughly 80dB of stopband attenuation)
+     */
+    resampler_table(int zero_crossings, int phase_count, double fc, double beta)
+        : phases(math::max(phase_count, 1)), cutoff(fc)
+    {
+        // the sinc's zero crossings are 1 / 2fc apart, so a lower cutoff needs a proportionally longer filter
+        auto const half = static_cast<int>(std::ceil(math::max(zero_crossings, 1) / (2.0 * cutoff)));
+        taps = 2 * half;
+
+        std::vector<double> h(static_cast<size_t>(phases + 1) * static_cast<size_t>(taps));
+        for (int p = 0; p <= phases; ++p)
+        {
+            auto* row = h.data() + static_cast<size_t>(p) * static_cast<size_t>(taps);
+            double sum = 0;
+            for (int k = 0; k < taps; ++k)
+            {
+                // tap k sits x samples from the output's position, which is (half - 1) + p / phases into the window
+                auto x = k - (half - 1) - static_cast<double>(p) / phases;
+                auto r = x / half;
+                auto arg = 2.0 * cutoff * x;
+                auto sinc = arg == 0 ? 1.0 : std::sin(math::pi<double>() * arg) / (math::pi<double>() * arg);
+                row[k] = 2.0 * cutoff * sinc * math::bessel_i0(beta * std::sqrt(math::max(0.0, 1.0 - r * r)))
+                         / math::bessel_i0(beta);
+                sum += row[k];
+            }
+            // unity gain at DC for every phase, so there's no DC ripple as the phase moves
+            for (int k = 0; k < taps; ++k) { row[k] /= sum; }
+        }
+
+        rows.resize(static_cast<size_t>(phases) * static_cast<size_t>(taps) * 2);
+        for (int p = 0; p < phases; ++p)
+        {
+            auto const* c = h.data() + static_cast<size_t>(p) * static_cast<size_t>(taps);
+            auto const* next = c + taps;
+            auto* row = rows.data() + static_cast<size_t>(p) * static_cast<size_t>(taps) * 2;
+            for (int k = 0; k < taps; ++k)
+            {
+                row[k] = static_cast<T>(c[k]);
+                row[taps + k] = static_cast<T>(next[k] - c[k]);
+            }
+        }
+    }
+
+    //! coefficients of phase p, followed by taps differences to phase p + 1
+    T const* row(int p) const { return rows.data() + static_cast<size_t>(p) * static_cast<size_t>(taps) * 2; }
+
+    /**
+     * Returns the table for a design, building it if no live resampler is already using it. Locks and may allocate,
+     * so call it off the audio thread.
+     */
+    static std::shared_ptr<resampler_table const> get(int zero_crossings, int phase_count, double cutoff, double beta)
+    {
+        static std::mutex mutex;
+        static std::map<std::tuple<int, int, double, double>, std::weak_ptr<resampler_table const>> cache;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        // drop the designs nobody uses any more, so a host trying many ratios doesn't grow the cache without bound
+        for (auto i = cache.begin(); i != cache.end();)
+        {
+            if (i->second.expired()) { i = cache.erase(i); }
+            else { ++i; }
+        }
+        auto& entry = cache[std::make_tuple(zero_crossings, phase_count, cutoff, beta)];
+        auto table = entry.lock();
+        if (! table)
+        {
+            table = std::make_shared<resampler_table const>(zero_crossings, phase_count, cutoff, beta);
+            entry = table;
+        }
+        return table;
+    }
+
+    int taps;
+    int phases;
+    double cutoff;
+
+private:
+    std::vector<T> rows;
+};
+
+/**
+ * @brief Streaming resampler for one channel at an arbitrary (and adjustable) ratio. Each output is an inner product
+ * of the input around its position with the polyphase bank, linearly interpolated between the two nearest phases; the
+ * interpolation is folded into the SIMD loop, so it costs one extra multiply-add per tap.
+ * Input is pushed in whatever block sizes arrive and output is pulled as it becomes available; neither allocates.
+ * Outputs are time aligned with the input (output n sits at input time n * input_rate / output_rate), and output n can
+ * be pulled once the input has got latency() samples past that time.
+ * The filter tables are shared between instances, so one resampler per channel is cheap.
+ */
+template <redsp_arithmetic SampleType>
+struct resampler
+{
+    redsp_arithmetic_assert(SampleType)
+
+    using sample_type = SampleType;
+    using table_type = resampler_table<SampleType>;
+
+    resampler() = default;
+
+    /**
+     * Picks (or builds) the filter table and allocates the input buffer. Call this off the audio thread.
+     * @param input_rate sampling rate of the pushed input
+     * @param output_rate sampling rate of the pulled output
+     * @param max_push most samples pushed without pulling in between
+     * @param zero_crossings filter length, in zero crossings on each side
+     * @param phase_count number of fractional phases in the table
+     * @param bandwidth passband as a fraction of the lower of the two nyquist rates
+     * @param beta Kaiser window beta
+     */
+    void prepare(double input_rate, double output_rate, int max_push, int zero_crossings = 32, int phase_count = 256,
+                 double bandwidth = 0.92, double beta = 8.0)
+    {
+        auto const cutoff = 0.5 * bandwidth * math::min(1.0, output_rate / input_rate);
+        table = table_type::get(zero_crossings, phase_count, cutoff, beta);
+        set_ratio(input_rate, output_rate);
+
+        capacity = table->taps + math::max(max_push, 1);
+        buffer.assign(static_cast<size_t>(capacity), SampleType(0));
+        reset();
+    }
+
+    //! clears the input history
+    void reset()
+    {
+        std::fill(buffer.begin(), buffer.end(), SampleType(0));
+        // start with half a window of silence so the first output lands on the first input sample
+        read = 0;
+        fill = table->taps / 2 - 1;
+        frac = 0;
+    }
+
+    /**
+     * Changes the conversion ratio without touching the filter, for small adjustments like tracking clock drift.
+     * Realtime safe.
+     */
+    void set_ratio(double input_rate, double output_rate) { step = input_rate / output_rate; }
+
+    //! input samples between an output's time and it becoming available to pull()
+    int latency() const { return table->taps / 2; }
+
+    std::shared_ptr<table_type const> const& filter_table() const { return table; }
+
+    /**
+     * Appends up to `@param count` samples from `@param input`.
+     * @return the number of samples taken, which is less than count only if more than max_push samples were pushed
+     * without pulling
+     */
+    int push(SampleType const* input, int count)
+    {
+        if (fill + count > capacity && read > 0)
+        {
+            std::copy(buffer.data() + read, buffer.data() + fill, buffer.data());
+            fill -= read;
+            read = 0;
+        }
+        count = math::max(0, math::min(count, capacity - fill));
+        std::copy(input, input + count, buffer.data() + fill);
+        fill += count;
+        return count;
+    }
+
+    /**
+     * Writes up to `@param max_count` output samples to `@param output`.
+     * @return the number of samples written
+     */
+    int pull(SampleType* output, int max_count)
+    {
+        auto const L = table->taps;
+        auto const phases = table->phases;
+        int written = 0;
+        while (written < max_count && read + L <= fill)
+        {
+            auto const position = frac * phases;
+            auto const p = static_cast<int>(position);
+            auto const* row = table->row(p);
+            output[written++] = interpolated_dot(row, row + L, buffer.data() + read, L,
+                                                 static_cast<SampleType>(position - p));
+            advance(read, frac);
+        }
+        return written;
+    }
+
+    //! number of samples pull() could write right now
+    int available() const
+    {
+        // walking the positions pull() will visit, rather than dividing, keeps the rounding of frac identical
+        int count = 0;
+        auto position = read;
+        auto f = frac;
+        for (; position + table->taps <= fill; ++count) { advance(position, f); }
+        return count;
+    }
+
+    //! number of samples to push before `@param outputs` more can be pulled
+    int input_needed(int outputs) const
+    {
+        if (outputs <= 0) { return 0; }
+        auto last = read;
+        auto f = frac;
+        for (int i = 1; i < outputs; ++i) { advance(last, f); }
+        return math::max(0, last + table->taps - fill);
+    }
+
+    /**
+     * Pushes `@param count` samples from `@param input` and pulls up to `@param max_out` samples into
+     * `@param output`, which should have room for count * output_rate / input_rate + 1 samples; input that doesn't
+     * fit is dropped.
+     * @return the number of samples written
+     */
+    int process(SampleType const* input, int count, SampleType* output, int max_out)
+    {
+        int written = 0;
+        while (count > 0)
+        {
+            auto const taken = push(input, count);
+            input += taken;
+            count -= taken;
+            written += pull(output + written, max_out - written);
+            if (taken == 0 && written == max_out) { break; }
+        }
+        return written + pull(output + written, max_out - written);
+    }
+
+private:
+    std::shared_ptr<table_type const> table;
+    std::vector<SampleType> buffer;
+    int capacity = 0, read = 0, fill = 0;
+    double frac = 0, step = 1;
+
+    //! moves an input position and its fractional part on by one output, exactly as pull() does
+    void advance(int& position, double& f) const
+    {
+        f += step;
+        auto const whole = static_cast<int>(f);
+        position += whole;
+        f -= whole;
+    }
+
+    //! sum of (c[k] + mu * d[k]) * x[k], in one pass
+    static SampleType interpolated_dot(SampleType const* c, SampleType const* d, SampleType const* x, int count,
+                                       SampleType mu)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+
+        auto const m = V::broadcast(mu);
+        auto acc0 = V::zero(), acc1 = V::zero();
+        int k = 0;
+        for (; k + 2 * w <= count; k += 2 * w)
+        {
+            acc0 = mul_add(mul_add(V::load(d + k), m, V::load(c + k)), V::load(x + k), acc0);
+            acc1 = mul_add(mul_add(V::load(d + k + w), m, V::load(c + k + w)), V::load(x + k + w), acc1);
+        }
+        for (; k + w <= count; k += w)
+        {
+            acc0 = mul_add(mul_add(V::load(d + k), m, V::load(c + k)), V::load(x + k), acc0);
+        }
+
+        auto result = (acc0 + acc1).sum();
+        for (; k < count; ++k) { result += (c[k] + mu * d[k]) * x[k]; }
+        return result;
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_RESAMPLER_HEADERGUARD
@@ -0,0 +1,275 @@
+/**
+ * Feedback delay network reverb.
+ *
+ * See redsp/LICENSE for license information.
+*/
+#ifndef REDSP_FDNREVERB_HEADERGUARD
+#define REDSP_FDNREVERB_HEADERGUARD
+
+#include <type_traits>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "../delay/delay_line.h"
+#include "../filters/biquad.h"
+#include "../internal/remath.h"
+#include "../internal/simd.h"
+#include "../internal/universal.h"
+
+namespace redsp {
+
+enum class fdn_matrix
+{
+    hadamard = 0,   //!< dense: every line feeds every other with equal weight, so echoes build up fastest
+    householder     //!< I - 2/N 11^T: cheaper still, but each line mostly feeds itself
+};
+
+/**
+ * @brief Stereo feedback delay network reverb (Jot & Chaigne). Lines delay lines of mutually prime lengths feed back
+ * into each other through an orthogonal matrix, each through a gain that sets the decay time and a biquad lowpass
+ * that makes the highs die away faster.
+ * The loop is run a block at a time: a block no longer than the shortest line only reads samples written before it,
+ * so each line is read with one contiguous copy, damped with the biquad's block path, mixed, and written back in one
+ * go. The matrix is applied as a fast transform (log2(Lines) stages of butterflies for Hadamard, a sum for
+ * Householder), with every butterfly running as a SIMD loop across the block. The delay lines share one contiguous
+ * arena, as do the block buffers.
+ * The output is the reverberated signal only (100% wet), as for a send.
+ * @tparam SampleType sample type
+ * @tparam Lines number of delay lines, a power of two (8 and 16 are the useful sizes)
+ * @tparam Matrix feedback matrix
+ */
+template <redsp_arithmetic SampleType, size_t Lines = 8, fdn_matrix Matrix = fdn_matrix::hadamard>
+struct fdn_reverb
+{
+    redsp_arithmetic_assert(SampleType)
+    static_assert(Lines >= 2 && (Lines & (Lines - 1)) == 0, "Lines must be a power of two");
+
+    using sample_type = SampleType;
+    static constexpr size_t channels = 2;
+    static constexpr size_t lines = Lines;
+
+    fdn_reverb() = default;
+
+    fdn_reverb(fdn_reverb const&) = delete;
+    fdn_reverb& operator=(fdn_reverb const&) = delete;
+
+    /**
+     * Picks the delay lengths and allocates the arenas. Call this off the audio thread.
+     * @param sample_rate sampling rate
+     * @param max_block longest block process() will be called with
+     * @param size scales the delay lengths; 1 is a medium hall
+     */
+    void prepare(double sample_rate, int max_block, double size = 1.0)
+    {
+        fs = sample_rate;
+
+        // exponentially spaced between 29ms and 89ms, nudged up to primes so no two lines share a period
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            auto const ms = 29.0 * std::pow(89.0 / 29.0, static_cast<double>(i) / (Lines - 1)) * math::max(size, 0.01);
+            auto d = math::max(static_cast<int>(ms * 0.001 * sample_rate), 2);
+            while (! is_prime(d)) { ++d; }
+            delays[i] = d;
+        }
+
+        // a block can't be longer than the shortest line, or it would read what it's about to write
+        block = math::min(math::max(max_block, 1), *std::min_element(delays.begin(), delays.end()));
+
+        size_t total = 0;
+        for (size_t i = 0; i < Lines; ++i) { total += line_type::storage_size(delays[i], block); }
+        arena.assign(total, SampleType(0));
+        auto* p = arena.data();
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            lines_[i].prepare(delays[i], block, p);
+            p += line_type::storage_size(delays[i], block);
+        }
+
+        work.assign((2 * Lines + 1) * static_cast<size_t>(block), SampleType(0));
+
+        set_decay(decay);
+        set_damping(damping_frequency);
+        reset();
+    }
+
+    //! clears the delay lines and filters
+    void reset()
+    {
+        for (auto& l : lines_) { l.reset(); }
+        damping.reset();
+    }
+
+    /**
+     * Sets the time it takes the reverb to decay by 60dB at low frequencies, in seconds. Realtime safe.
+     */
+    void set_decay(double seconds)
+    {
+        decay = math::max(seconds, 0.01);
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            // -60dB over `decay` seconds is -60 * d / (decay * fs) dB per trip round line i. The matrix' normalization
+            // goes in here too
+            auto const g = std::pow(10.0, -3.0 * delays[i] / (decay * fs)) * matrix_scale();
+            gains[i] = static_cast<SampleType>(g);
+        }
+    }
+
+    /**
+     * Sets the cutoff of the lowpass in the loop, in Hz. Higher frequencies decay faster. Realtime safe.
+     */
+    void set_damping(double frequency)
+    {
+        damping_frequency = math::clip(20.0, 0.45 * fs, frequency);
+        damping.calc_lp(static_cast<SampleType>(damping_frequency / fs), static_cast<SampleType>(0.5));
+    }
+
+    //! length of line `@param i`, in samples
+    int delay(size_t i) const { return delays[i]; }
+
+    /**
+     * Reverberates `@param count` samples of stereo input into stereo output. Inputs and outputs may alias.
+     */
+    void process(SampleType const* in_l, SampleType const* in_r, SampleType* out_l, SampleType* out_r, int count)
+    {
+        for (int done = 0; done < count; done += block)
+        {
+            run_block(in_l + done, in_r + done, out_l + done, out_r + done, math::min(block, count - done));
+        }
+    }
+
+    void process(SampleType** samples, int count) { process(samples[0], samples[1], samples[0], samples[1], count); }
+
+private:
+    using line_type = delay_line<SampleType, delay_interpolation::none>;
+
+    double fs = 48000, decay = 2.0, damping_frequency = 8000;
+    int block = 1;
+    std::array<int, Lines> delays {};
+    std::array<SampleType, Lines> gains {};
+    std::array<line_type, Lines> lines_;
+    biquad<SampleType, SampleType, Lines> damping;
+
+    //! every line's ring, back to back
+    std::vector<SampleType> arena;
+    //! Lines raw blocks, Lines damped blocks, and one for the Householder sum
+    std::vector<SampleType> work;
+
+    static double matrix_scale() { return Matrix == fdn_matrix::hadamard ? 1.0 / std::sqrt(static_cast<double>(Lines)) : 1.0; }
+
+    static bool is_prime(int n)
+    {
+        if (n < 2) { return false; }
+        for (int k = 2; k * k <= n; ++k) { if (n % k == 0) { return false; } }
+        return true;
+    }
+
+    SampleType* raw(size_t i) { return work.data() + i * static_cast<size_t>(block); }
+    SampleType* damped(size_t i) { return work.data() + (Lines + i) * static_cast<size_t>(block); }
+    SampleType* sum() { return work.data() + 2 * Lines * static_cast<size_t>(block); }
+
+    void run_block(SampleType const* in_l, SampleType const* in_r, SampleType* out_l, SampleType* out_r, int len)
+    {
+        // each line's output over the block was written at least len samples ago
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            lines_[i].read_integer(raw(i), len, delays[i] - len);
+            if (len > 1) { damping.process_optimized(raw(i), damped(i), len, static_cast<int>(i)); }
+            else { damped(i)[0] = damping.process(raw(i)[0], static_cast<int>(i)); }
+        }
+
+        // even lines go left, odd lines right, with alternating signs so the two sides decorrelate. Read the input
+        // first, as it may be the same memory as the output
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            auto* in = raw(i);
+            auto const* source = i % 2 ? in_r : in_l;
+            auto const sign = (i / 2) % 2 ? SampleType(-1) : SampleType(1);
+            scale(source, sign, in, len);
+        }
+
+        auto const out_gain = static_cast<SampleType>(1.0 / std::sqrt(Lines / 2.0));
+        scale(damped(0), out_gain, out_l, len);
+        scale(damped(1), out_gain, out_r, len);
+        for (size_t i = 2; i < Lines; ++i)
+        {
+            auto const g = (i / 2) % 2 ? -out_gain : out_gain;
+            accumulate(damped(i), g, i % 2 ? out_r : out_l, len);
+        }
+
+        mix(len, std::integral_constant<fdn_matrix, Matrix>());
+
+        // feed back through the decay gains, on top of the input, and write the block into the lines
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            accumulate(damped(i), gains[i], raw(i), len);
+            lines_[i].write(raw(i), len);
+        }
+    }
+
+    //! Hadamard matrix as a fast Walsh-Hadamard transform: log2(Lines) stages of butterflies between whole blocks
+    void mix(int len, std::integral_constant<fdn_matrix, fdn_matrix::hadamard>)
+    {
+        for (size_t h = 1; h < Lines; h <<= 1)
+        {
+            for (size_t i = 0; i < Lines; i += 2 * h)
+            {
+                for (size_t j = i; j < i + h; ++j) { butterfly(damped(j), damped(j + h), len); }
+            }
+        }
+    }
+
+    //! Householder reflection: x - 2/N sum(x)
+    void mix(int len, std::integral_constant<fdn_matrix, fdn_matrix::householder>)
+    {
+        auto* s = sum();
+        scale(damped(0), SampleType(-2.0 / Lines), s, len);
+        for (size_t i = 1; i < Lines; ++i) { accumulate(damped(i), SampleType(-2.0 / Lines), s, len); }
+        for (size_t i = 0; i < Lines; ++i) { accumulate(s, SampleType(1), damped(i), len); }
+    }
+
+    static void butterfly(SampleType* a, SampleType* b, int count)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+        int k = 0;
+        for (; k + w <= count; k += w)
+        {
+            auto x = V::load(a + k), y = V::load(b + k);
+            (x + y).store(a + k);
+            (x - y).store(b + k);
+        }
+        for (; k < count; ++k)
+        {
+            auto x = a[k], y = b[k];
+            a[k] = x + y;
+            b[k] = x - y;
+        }
+    }
+
+    //! out = x * g
+    static void scale(SampleType const* x, SampleType g, SampleType* out, int count)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+        auto const gv = V::broadcast(g);
+        int k = 0;
+        for (; k + w <= count; k += w) { (V::load(x + k) * gv).store(out + k); }
+        for (; k < count; ++k) { out[k] = x[k] * g; }
+    }
+
+    //! acc += x * g
+    static void accumulate(SampleType const* x, SampleType g, SampleType* acc, int count)
+    {
+        using V = simd::vec<SampleType>;
+        constexpr int w = static_cast<int>(V::width);
+        auto const gv = V::broadcast(g);
+        int k = 0;
+        for (; k + w <= count; k += w) { mul_add(V::load(x + k), gv, V::load(acc + k)).store(acc + k); }
+        for (; k < count; ++k) { acc[k] += x[k] * g; }
+    }
+};
+
+} // namespace redsp
+
+#endif // REDSP_FDNREVERB_HEADERGUARD
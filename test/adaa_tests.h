@@ -0,0 +1,118 @@
+#ifndef REDSP_ADAATESTS_HEADERGUARD
+#define REDSP_ADAATESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/nonlinear/adaa.h"
+
+#pragma once
+
+using namespace juce;
+
+struct ADAATest : public RedspTest
+{
+    ADAATest() : RedspTest("ADAA", "Nonlinear") { }
+
+private:
+    // hard clipper and its first two antiderivatives
+    struct hardclip { double operator()(double x) const { return redsp::math::clip(-1.0, 1.0, x); } };
+    struct hardclip_ad1
+    {
+        double operator()(double x) const { return std::abs(x) <= 1.0 ? 0.5 * x * x : std::abs(x) - 0.5; }
+    };
+    struct hardclip_ad2
+    {
+        double operator()(double x) const
+        {
+            if (x > 1.0)  { return 0.5 * x * x - 0.5 * x + 1.0 / 6.0; }
+            if (x < -1.0) { return -0.5 * x * x - 0.5 * x - 1.0 / 6.0; }
+            return x * x * x / 6.0;
+        }
+    };
+
+    using first_order = redsp::adaa<double, hardclip, hardclip_ad1>;
+    using second_order = redsp::adaa<double, hardclip, hardclip_ad1, hardclip_ad2>;
+
+    template <typename Processor>
+    void expectBlockMatchesSample(Processor& a, Processor& b)
+    {
+        std::vector<double> in(1000), out(1000);
+        for (size_t i = 0; i < in.size(); ++i)
+        {
+            // hold some values so the ill-conditioned fallbacks are hit too
+            in[i] = (i % 7 == 0 && i > 0) ? in[i - 1] : random.nextDouble() * 6.0 - 3.0;
+        }
+
+        a.process(in.data(), out.data(), 333);
+        a.process(in.data() + 333, out.data() + 333, 667);
+
+        for (size_t i = 0; i < in.size(); ++i)
+        {
+            expectWithinAbsoluteError(out[i], b.process(in[i]), 1.0e-9);
+        }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("first_order_converges_on_dc");
+            first_order a;
+            for (int i = 0; i < 4; ++i) { a.process(0.5); }
+            expectWithinAbsoluteError(a.process(0.5), 0.5, 1.0e-12);
+            for (int i = 0; i < 4; ++i) { a.process(3.0); }
+            expectWithinAbsoluteError(a.process(3.0), 1.0, 1.0e-12);
+        }
+        {
+            beginTest("first_order_averages_over_segment");
+            first_order a;
+            a.process(0.5);
+            // mean of clip(x) over [0.5, 1.5] is 0.875
+            expectWithinAbsoluteError(a.process(1.5), 0.875, 1.0e-12);
+        }
+        {
+            beginTest("second_order_converges_on_dc");
+            second_order a;
+            for (int i = 0; i < 4; ++i) { a.process(-0.25); }
+            expectWithinAbsoluteError(a.process(-0.25), -0.25, 1.0e-9);
+            for (int i = 0; i < 4; ++i) { a.process(-5.0); }
+            expectWithinAbsoluteError(a.process(-5.0), -1.0, 1.0e-9);
+        }
+        {
+            beginTest("second_order_alternating_input");
+            // a, -a, a, ... has x[n] = x[n-2] throughout, so every output comes from the fallback. Its xbar is +-a and
+            // x[n-1] is -+a, and as F1 is even and F2 odd that's y = +-(F1(a) - F2(a) / a) / a: a / 3 where the clipper
+            // is linear (the three-tap mean of x that second-order adaa of a line is), 11 / 24 for a = 2
+            for (auto a : { 0.5, 2.0 })
+            {
+                auto const expected = (hardclip_ad1()(a) - hardclip_ad2()(a) / a) / a;
+                second_order sample, block;
+                std::vector<double> in(64), out(64);
+                for (size_t i = 0; i < in.size(); ++i) { in[i] = i % 2 ? -a : a; }
+                block.process(in.data(), out.data(), static_cast<int>(in.size()));
+                // the first two outputs still see the zeroed history
+                sample.process(in[0]);
+                sample.process(in[1]);
+                for (size_t i = 2; i < in.size(); ++i)
+                {
+                    auto const sign = i % 2 ? -1.0 : 1.0;
+                    expectWithinAbsoluteError(sample.process(in[i]), sign * expected, 1.0e-12);
+                    expectWithinAbsoluteError(out[i], sign * expected, 1.0e-12);
+                }
+            }
+            expectWithinAbsoluteError((hardclip_ad1()(0.5) - hardclip_ad2()(0.5) / 0.5) / 0.5, 0.5 / 3.0, 1.0e-15);
+            expectWithinAbsoluteError((hardclip_ad1()(2.0) - hardclip_ad2()(2.0) / 2.0) / 2.0, 11.0 / 24.0, 1.0e-15);
+        }
+        {
+            beginTest("first_order_block_matches_sample");
+            first_order a, b;
+            expectBlockMatchesSample(a, b);
+        }
+        {
+            beginTest("second_order_block_matches_sample");
+            second_order a, b;
+            expectBlockMatchesSample(a, b);
+        }
+    }
+};
+
+#endif // REDSP_ADAATESTS_HEADERGUARD
@@ -2,17 +2,36 @@
 #define REDSP_BIQUADTESTS_HEADERGUARD
 
 #include <juce_core/juce_core.h>
+#include "test_helpers.h"
 #include "../source/filters/biquad.h"
 
 #pragma once
 
 using namespace juce;
 
-struct BiquadTest : public UnitTest
+struct BiquadTest : public RedspTest
 {
-    BiquadTest() : UnitTest("Biquad", "Filters") { }
+    BiquadTest() : RedspTest("Biquad", "Filters") { }
 
 private:
+    //! the gain a cosine at `@param f` settles on through `@param filter`, from its projection onto the cosine and sine
+    template <typename Filter>
+    static double gainAt(Filter filter, double f)
+    {
+        auto const w = 2.0 * redsp::math::pi<double>() * f;
+        int const settle = 20000, length = 48000;
+        double re = 0, im = 0;
+        for (int i = 0; i < settle + length; ++i)
+        {
+            auto const y = filter.process(std::cos(w * i));
+            if (i >= settle)
+            {
+                re += y * std::cos(w * i);
+                im += y * std::sin(w * i);
+            }
+        }
+        return 2.0 * std::sqrt(re * re + im * im) / length;
+    }
 
     void runTest() override
     {
@@ -46,6 +65,176 @@ private:
                 b->process(getRandom().nextDouble());
             }
         }
+        {
+            beginTest("magnitude_at_cutoff");
+            // the bilinear designs land the analog prototype's response at the cutoff exactly on f, given a true tan:
+            // Q through the lowpass and highpass, unity through the bandpass and allpass, and a null in the bandreject
+            for (auto Q : { 0.7071, 3.0 })
+            {
+                for (auto f : { 0.01, 0.1, 0.3 })
+                {
+                    redsp::biquad<double, double, 1> lp {}, hp {}, bp {}, br {}, ap {};
+                    lp.calc_lp(f, Q);
+                    hp.calc_hp(f, Q);
+                    bp.calc_bp(f, Q);
+                    br.calc_br(f, Q);
+                    ap.calc_ap(f, Q);
+                    auto const at = "Q " + String(Q) + " at " + String(f) + " fs";
+                    expectWithinAbsoluteError(gainAt(lp, f), Q, 0.005 * Q, "lowpass, " + at);
+                    expectWithinAbsoluteError(gainAt(hp, f), Q, 0.005 * Q, "highpass, " + at);
+                    expectWithinAbsoluteError(gainAt(bp, f), 1.0, 0.005, "bandpass, " + at);
+                    expectWithinAbsoluteError(gainAt(br, f), 0.0, 0.005, "bandreject, " + at);
+                    expectWithinAbsoluteError(gainAt(ap, f), 1.0, 0.005, "allpass, " + at);
+                }
+            }
+        }
+        {
+            beginTest("process_optimized_matches_process");
+            redsp::biquad<double, double, 2> reference, inPlace, outOfPlace;
+            for (auto* f : { &reference, &inPlace, &outOfPlace })
+            {
+                f->calc_lp(0.1, 0.9);
+                f->reset();
+            }
+
+            // blocks of every length from 1 up, so the state carried between blocks is checked from each path
+            std::vector<double> expected, a, c, out;
+            for (int count = 1; count < 40; ++count)
+            {
+                expected.resize(static_cast<size_t>(count));
+                for (auto& v : expected) { v = random.nextDouble() * 2.0 - 1.0; }
+                a = expected;
+                c = expected;
+                out.resize(expected.size());
+                reference.process(expected.data(), count, count % 2);
+                inPlace.process_optimized(a.data(), count, count % 2);
+                outOfPlace.process_optimized(c.data(), out.data(), count, count % 2);
+                for (size_t i = 0; i < expected.size(); ++i)
+                {
+                    expectWithinAbsoluteError(a[i], expected[i], 1.0e-12);
+                    expectWithinAbsoluteError(out[i], expected[i], 1.0e-12);
+                }
+            }
+
+            // and the multichannel overloads take one pointer per channel
+            std::vector<double> l(64, 1.0), r(64, -1.0), lo(64), ro(64);
+            double* io[] = { l.data(), r.data() };
+            double* o[] = { lo.data(), ro.data() };
+            inPlace.reset();
+            outOfPlace.reset();
+            outOfPlace.process_optimized(io, o, 64);
+            inPlace.process_optimized(io, 64);
+            for (size_t i = 0; i < 64; ++i)
+            {
+                expectWithinAbsoluteError(l[i], lo[i], 1.0e-12);
+                expectWithinAbsoluteError(r[i], ro[i], 1.0e-12);
+                expectWithinAbsoluteError(ro[i], -lo[i], 1.0e-12);
+            }
+        }
+        {
+            beginTest("constexpr_coefficients");
+            using coefficients = redsp::biquad_coefficients<double>;
+            // designed by the compiler: these have to be constant expressions to compile at all
+            static constexpr coefficients designs[] = {
+                coefficients::lp(1000.0, 48000.0, 0.7071), coefficients::hp(20.0, 48000.0, 0.5),
+                coefficients::bp(0.1, 2.0), coefficients::br(0.2, 4.0), coefficients::ap(0.3, 0.9)
+            };
+            static_assert(designs[3].b1 == designs[3].a1, "a bandreject's b1 is its a1");
+            static_assert(designs[4].b2 == 1, "an allpass's b2 is 1");
+
+            // they match the run time designs given the exact prewarp
+            auto const pi = redsp::math::pi<double>();
+            redsp::biquad<double, double> f;
+            f.calc_lp_direct(std::tan(pi * 1000.0 / 48000.0), 0.7071);
+            auto const lp = f.coefficients();
+            f.calc_hp_direct(std::tan(pi * 20.0 / 48000.0), 0.5);
+            auto const hp = f.coefficients();
+            f.calc_bp_direct(std::tan(pi * 0.1), 2.0);
+            auto const bp = f.coefficients();
+            f.calc_br_direct(std::tan(pi * 0.2), 4.0);
+            auto const br = f.coefficients();
+            f.calc_ap_direct(std::tan(pi * 0.3), 0.9);
+            auto const ap = f.coefficients();
+            coefficients const expected[] = { lp, hp, bp, br, ap };
+            for (size_t i = 0; i < 5; ++i)
+            {
+                expectWithinAbsoluteError(designs[i].a1, expected[i].a1, 1.0e-15);
+                expectWithinAbsoluteError(designs[i].a2, expected[i].a2, 1.0e-15);
+                expectWithinAbsoluteError(designs[i].b0, expected[i].b0, 1.0e-15);
+                expectWithinAbsoluteError(designs[i].b1, expected[i].b1, 1.0e-15);
+                expectWithinAbsoluteError(designs[i].b2, expected[i].b2, 1.0e-15);
+            }
+
+            // and set_coefficients() takes them as they are
+            f.set_coefficients(designs[0]);
+            expect(f.b0 == designs[0].b0 && f.a2 == designs[0].a2);
+        }
+        {
+            beginTest("mixed_precision");
+            // float state is enough well above DC, and not close to it, where resonance makes it worse still
+            static_assert(redsp::float_state_suffices(0.05, 0.7071), "float state at 0.05 fs");
+            static_assert(! redsp::float_state_suffices(0.001, 0.7071), "double state at 0.001 fs");
+            static_assert(! redsp::float_state_suffices(0.02, 5.0), "double state for a resonant 0.02 fs");
+            static_assert(std::is_same<redsp::cheapest_precision<redsp::float_state_suffices(20.0 / 48000.0, 0.7071)>,
+                                       redsp::mixed_precision>::value, "a 20Hz highpass needs double state");
+            static_assert(std::is_same<redsp::biquad_with<redsp::mixed_precision>::state_type, double>::value, "");
+
+            std::vector<float> input(48000);
+            for (size_t i = 0; i < input.size(); ++i)
+            {
+                // noise riding on a square wave, to exercise the poles right down at DC
+                input[i] = static_cast<float>(0.9 * random.nextDouble() - 0.45 + (i / 12000 % 2 ? 0.45 : -0.45));
+            }
+
+            for (auto f : { 0.0002, 0.05 })
+            {
+                redsp::biquad_with<redsp::single_precision> single;
+                redsp::biquad_with<redsp::mixed_precision> mixed;
+                redsp::biquad<double, double> reference;
+                single.calc_lp(f, 0.7071);
+                mixed.calc_lp(f, 0.7071);
+                reference.calc_lp(f, 0.7071);
+                single.reset();
+                mixed.reset();
+                reference.reset();
+                auto singleOut = input, mixedOut = input;
+                std::vector<double> r(input.begin(), input.end());
+                single.process_optimized(singleOut.data(), static_cast<int>(singleOut.size()));
+                mixed.process_optimized(mixedOut.data(), static_cast<int>(mixedOut.size()));
+                reference.process_optimized(r.data(), static_cast<int>(r.size()));
+
+                double singleError = 0, mixedError = 0;
+                for (size_t i = 0; i < r.size(); ++i)
+                {
+                    singleError = std::max(singleError, std::abs(singleOut[i] - r[i]));
+                    mixedError = std::max(mixedError, std::abs(mixedOut[i] - r[i]));
+                }
+                // with double state, only the output is rounded to float
+                expectLessOrEqual(mixedError, 1.0e-7);
+                if (redsp::float_state_suffices(f, 0.7071)) { expectLessOrEqual(singleError, 1.0e-5); }
+                else { expectGreaterThan(singleError, 1.0e-5); }
+            }
+
+            // and the block paths carry the wide state between blocks as process() does
+            redsp::biquad_with<redsp::mixed_precision, 2> reference, inPlace, outOfPlace;
+            for (auto* filter : { &reference, &inPlace, &outOfPlace })
+            {
+                filter->calc_hp(0.0005, 0.7071);
+                filter->reset();
+            }
+            std::vector<float> expected, c, out;
+            for (int count = 1, done = 0; count < 40; done += count++)
+            {
+                expected.assign(input.begin() + done, input.begin() + done + count);
+                c = expected;
+                out.resize(expected.size());
+                for (auto& v : expected) { v = reference.process(v, count % 2); }
+                inPlace.process_optimized(c.data(), count, count % 2);
+                outOfPlace.process_optimized(input.data() + done, out.data(), count, count % 2);
+                expect(c == expected);
+                expect(out == expected);
+            }
+        }
     }
 };
 
@@ -0,0 +1,109 @@
+#ifndef REDSP_CONVOLUTIONTESTS_HEADERGUARD
+#define REDSP_CONVOLUTIONTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <thread>
+#include <chrono>
+#include "test_helpers.h"
+#include "../source/convolution/uniform_convolver.h"
+#include "../source/convolution/nonuniform_convolver.h"
+
+#pragma once
+
+using namespace juce;
+
+struct ConvolutionTest : public RedspTest
+{
+    ConvolutionTest() : RedspTest("Convolution", "Convolution") { }
+
+private:
+    static std::vector<double> direct(std::vector<double> const& x, std::vector<double> const& h)
+    {
+        std::vector<double> y(x.size(), 0.0);
+        for (size_t n = 0; n < x.size(); ++n)
+        {
+            for (size_t k = 0; k < h.size() && k <= n; ++k) { y[n] += h[k] * x[n - k]; }
+        }
+        return y;
+    }
+
+    void expectNonuniformMatchesDirect(bool threaded)
+    {
+        // B = 16 gives a head of [0, 16), audio thread partitions over [16, 512), and threaded segments with
+        // partitions of 256 over [512, 8192) and 4096 over [8192, 10000)
+        auto h = randomSignal(10000);
+        auto x = randomSignal(20000);
+        auto expected = direct(x, h);
+
+        redsp::nonuniform_convolver<double> conv;
+        conv.prepare(h.data(), static_cast<int>(h.size()), 16, threaded);
+        expectEquals(conv.latency(), 0);
+        expectEquals(conv.tail_segments(), 2);
+
+        auto y = x;
+        for (size_t done = 0; done < y.size();)
+        {
+            auto len = std::min(y.size() - done, static_cast<size_t>(random.nextInt(40) + 1));
+            conv.process(y.data() + done, static_cast<int>(len));
+            done += len;
+            // a late worker costs the threaded segments a dropout rather than a wait, so feed them no faster than
+            // 48 kHz audio would arrive and give the workers the block period they're designed around
+            if (threaded) { std::this_thread::sleep_for(std::chrono::microseconds(len * 1000000 / 48000)); }
+        }
+        expectEquals(conv.dropouts(), 0);
+        // outputs of 10000 taps reach the hundreds, where the direct sum's own rounding is already near 1e-12
+        double peak = 0;
+        for (auto v : expected) { peak = std::max(peak, std::abs(v)); }
+        for (size_t i = 0; i < y.size(); ++i) { expectWithinAbsoluteError(y[i], expected[i], 1.0e-13 * peak); }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("uniform_block_matches_direct");
+            auto h = randomSignal(1000);
+            auto x = randomSignal(64 * 40);
+            auto expected = direct(x, h);
+
+            redsp::uniform_convolver<double> conv;
+            conv.prepare(h.data(), static_cast<int>(h.size()), 64);
+            expectEquals(conv.partitions(), 16);
+
+            auto y = x;
+            for (size_t b = 0; b < y.size(); b += 64) { conv.process_block(y.data() + b, y.data() + b); }
+            for (size_t i = 0; i < y.size(); ++i) { expectWithinAbsoluteError(y[i], expected[i], 1.0e-12); }
+        }
+        {
+            beginTest("uniform_stream_matches_direct");
+            auto h = randomSignal(777);
+            auto x = randomSignal(5000);
+            auto expected = direct(x, h);
+
+            redsp::uniform_convolver<double> conv;
+            conv.prepare(h.data(), static_cast<int>(h.size()), 128);
+
+            // awkward host block sizes
+            std::vector<double> y(x.size());
+            for (size_t done = 0; done < x.size();)
+            {
+                auto len = std::min(x.size() - done, static_cast<size_t>(random.nextInt(300) + 1));
+                conv.process(x.data() + done, y.data() + done, static_cast<int>(len));
+                done += len;
+            }
+
+            auto const latency = static_cast<size_t>(conv.latency());
+            for (size_t i = 0; i < latency; ++i) { expectEquals(y[i], 0.0); }
+            for (size_t i = latency; i < y.size(); ++i) { expectWithinAbsoluteError(y[i], expected[i - latency], 1.0e-12); }
+        }
+        {
+            beginTest("nonuniform_threaded_matches_direct");
+            expectNonuniformMatchesDirect(true);
+        }
+        {
+            beginTest("nonuniform_unthreaded_matches_direct");
+            expectNonuniformMatchesDirect(false);
+        }
+    }
+};
+
+#endif // REDSP_CONVOLUTIONTESTS_HEADERGUARD
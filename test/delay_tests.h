@@ -0,0 +1,155 @@
+#ifndef REDSP_DELAYTESTS_HEADERGUARD
+#define REDSP_DELAYTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/delay/delay_line.h"
+
+#pragma once
+
+using namespace juce;
+
+struct DelayTest : public RedspTest
+{
+    DelayTest() : RedspTest("Delay line", "Delay") { }
+
+private:
+    //! x[t - d], or 0 before the start
+    static double at(std::vector<double> const& x, long t) { return t < 0 ? 0.0 : x[static_cast<size_t>(t)]; }
+
+    //! writes x in random blocks, after each one checking a constant fractional block read against `expected` from
+    //! time `from` on
+    template <typename Line, typename Expected>
+    void expectBlockReads(Line& line, std::vector<double> const& x, double d, Expected expected, double tolerance,
+                          long from = 0)
+    {
+        std::vector<double> y(64);
+        for (size_t done = 0; done < x.size();)
+        {
+            auto len = std::min(x.size() - done, static_cast<size_t>(random.nextInt(64) + 1));
+            line.write(x.data() + done, static_cast<int>(len));
+            line.read(y.data(), static_cast<int>(len), d);
+            for (size_t i = 0; i < len; ++i)
+            {
+                auto t = static_cast<long>(done + i);
+                if (t >= from) { expectWithinAbsoluteError(y[i], expected(t), tolerance); }
+            }
+            done += len;
+        }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("integer_reads_across_wrap");
+            // a small ring wraps every few blocks
+            redsp::delay_line<double, redsp::delay_interpolation::none> line;
+            line.prepare(37, 64);
+            auto x = randomSignal(3000);
+            std::vector<double> y(64);
+            for (size_t done = 0; done < x.size();)
+            {
+                auto len = std::min(x.size() - done, static_cast<size_t>(random.nextInt(64) + 1));
+                line.write(x.data() + done, static_cast<int>(len));
+                auto d = random.nextInt(line.max_delay() + 1);
+                line.read_integer(y.data(), static_cast<int>(len), d);
+                for (size_t i = 0; i < len; ++i)
+                {
+                    expectEquals(y[i], at(x, static_cast<long>(done + i) - d));
+                }
+                expectEquals(line.read_integer(d), at(x, static_cast<long>(done + len - 1) - d));
+                done += len;
+            }
+        }
+        {
+            beginTest("linear_interpolation");
+            redsp::delay_line<double, redsp::delay_interpolation::linear> line;
+            line.prepare(100, 64);
+            auto x = randomSignal(3000);
+            expectBlockReads(line, x, 17.25, [&x](long t) { return 0.75 * at(x, t - 17) + 0.25 * at(x, t - 18); }, 1.0e-12);
+        }
+        {
+            beginTest("lagrange_exact_for_cubics");
+            redsp::delay_line<double, redsp::delay_interpolation::lagrange3> line;
+            line.prepare(100, 64);
+            auto cubic = [](double t) { return 1.0e-9 * t * t * t - 2.0e-6 * t * t + 0.01 * t - 0.5; };
+            std::vector<double> x(3000);
+            for (size_t i = 0; i < x.size(); ++i) { x[i] = cubic(static_cast<double>(i)); }
+            // once all four points are past the start, the interpolator reproduces the cubic
+            expectBlockReads(line, x, 40.3, [&cubic](long t) { return cubic(static_cast<double>(t) - 40.3); }, 1.0e-9, 42);
+        }
+        {
+            beginTest("per_sample_matches_block");
+            redsp::delay_line<double, redsp::delay_interpolation::lagrange3, 2> block, single;
+            block.prepare(200, 32);
+            single.prepare(200, 32);
+            auto x = randomSignal(2000);
+            std::vector<double> y(32), delays(32);
+            for (size_t done = 0; done + 32 <= x.size(); done += 32)
+            {
+                for (auto& d : delays) { d = 1.0 + random.nextDouble() * 150.0; }
+                block.write(x.data() + done, 32, 1);
+                block.read(y.data(), delays.data(), 32, 1);
+                for (size_t i = 0; i < 32; ++i)
+                {
+                    single.write(x[done + i], 1);
+                    expectWithinAbsoluteError(y[i], single.read(delays[i], 1), 1.0e-12);
+                }
+            }
+        }
+        {
+            beginTest("allpass_delays_sines");
+            redsp::delay_line<double, redsp::delay_interpolation::allpass> line;
+            line.prepare(100, 64);
+            std::vector<double> x(4096);
+            auto const w = 2.0 * redsp::math::pi<double>() * 0.01;
+            for (size_t i = 0; i < x.size(); ++i) { x[i] = std::sin(w * static_cast<double>(i)); }
+            std::vector<double> y(x.size());
+            line.write(x.data(), 64);
+            for (size_t done = 0; done < x.size(); done += 64)
+            {
+                if (done > 0) { line.write(x.data() + done, 64); }
+                line.read(y.data() + done, 64, 10.3);
+            }
+            for (size_t i = 500; i < y.size(); ++i)
+            {
+                expectWithinAbsoluteError(y[i], std::sin(w * (static_cast<double>(i) - 10.3)), 1.0e-3);
+            }
+        }
+        {
+            beginTest("shared_arena");
+            using line_type = redsp::delay_line<double, redsp::delay_interpolation::linear>;
+            auto const size = line_type::storage_size(50, 16);
+            std::vector<double> arena(2 * size, 0.0);
+            line_type a, b, owned;
+            a.prepare(50, 16, arena.data());
+            b.prepare(50, 16, arena.data() + size);
+            owned.prepare(50, 16);
+
+            auto x = randomSignal(16);
+            std::vector<double> silence(16, 0.0), ya(16), yo(16);
+            for (int i = 0; i < 10; ++i)
+            {
+                a.write(x.data(), 16);
+                owned.write(x.data(), 16);
+                b.write(silence.data(), 16);
+            }
+            a.read(ya.data(), 16, 20.5);
+            owned.read(yo.data(), 16, 20.5);
+            for (size_t i = 0; i < 16; ++i) { expectEquals(ya[i], yo[i]); }
+            for (int d = 0; d <= b.max_delay(); ++d) { expectEquals(b.read_integer(d), 0.0); }
+        }
+        {
+            beginTest("process_delays");
+            redsp::delay_line<double, redsp::delay_interpolation::linear, 2> line;
+            line.prepare(500, 64);
+            line.set_delay(300.0);
+            auto x = randomSignal(5000);
+            auto y = x;
+            line.process(y.data(), static_cast<int>(y.size()), 1);
+            for (size_t i = 0; i < y.size(); ++i) { expectEquals(y[i], at(x, static_cast<long>(i) - 300)); }
+        }
+    }
+};
+
+#endif // REDSP_DELAYTESTS_HEADERGUARD
@@ -0,0 +1,158 @@
+#ifndef REDSP_DENORMALTESTS_HEADERGUARD
+#define REDSP_DENORMALTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "test_helpers.h"
+#include "../source/redsp.h"
+
+#pragma once
+
+using namespace juce;
+
+struct DenormalTest : public RedspTest
+{
+    DenormalTest() : RedspTest("Denormals", "Denormals") { }
+
+private:
+    static constexpr int block = 256, channels = 2;
+    //! 2s at 48kHz, long enough for every filter below to decay through the floor
+    static constexpr int silentBlocks = 375;
+
+    template <typename T>
+    static bool denormal(T x) { return x != T(0) && std::abs(x) < std::numeric_limits<T>::min(); }
+
+    /**
+     * Runs a block of noise then silence through two filters from `@param make`, one with set_denormal_flush() and
+     * one without, via `@param process` (filter&, T** samples, int count). The flushed one must follow the other to
+     * within `@param tolerance`, never output a denormal, and end in exact silence.
+     */
+    template <typename T, typename Make, typename Process>
+    void expectFlushes(String const& what, Make&& make, Process&& process, double tolerance)
+    {
+        auto plain = make(), flushed = make();
+        flushed.set_denormal_flush(true);
+
+        std::vector<std::vector<T>> a(channels, std::vector<T>(block)), b = a;
+        std::vector<T*> pa, pb;
+        for (size_t c = 0; c < channels; ++c)
+        {
+            pa.push_back(a[c].data());
+            pb.push_back(b[c].data());
+        }
+
+        T worst = 0;
+        bool anyDenormal = false, silent = true;
+        for (int i = 0; i <= silentBlocks; ++i)
+        {
+            for (size_t c = 0; c < channels; ++c)
+            {
+                for (size_t s = 0; s < block; ++s) { a[c][s] = b[c][s] = i == 0 ? static_cast<T>(random.nextDouble() - 0.5) : T(0); }
+            }
+            process(plain, pa.data(), block);
+            process(flushed, pb.data(), block);
+            for (size_t c = 0; c < channels; ++c)
+            {
+                for (size_t s = 0; s < block; ++s)
+                {
+                    worst = std::max(worst, std::abs(a[c][s] - b[c][s]));
+                    anyDenormal = anyDenormal || denormal(b[c][s]);
+                    if (i == silentBlocks) { silent = silent && b[c][s] == T(0); }
+                }
+            }
+        }
+        expect(worst <= static_cast<T>(tolerance), what + " strays " + String(static_cast<double>(worst)) + " from unflushed");
+        expect(! anyDenormal, what + " output a denormal");
+        expect(silent, what + " didn't decay to exact silence");
+    }
+
+    template <typename T>
+    void filters(double tolerance)
+    {
+        expectFlushes<T>("biquad::process", [] {
+            redsp::biquad<T, T, channels> f;
+            f.calc_lp(T(0.01), T(0.7));
+            f.reset();
+            return f;
+        }, [](auto& f, T** x, int count) { for (int c = 0; c < channels; ++c) { f.process(x[c], count, c); } }, tolerance);
+        expectFlushes<T>("biquad::process_optimized", [] {
+            redsp::biquad<T, T, channels> f;
+            f.calc_hp(T(0.01), T(0.7));
+            f.reset();
+            return f;
+        }, [](auto& f, T** x, int count) { f.process_optimized(x, count); }, tolerance);
+        expectFlushes<T>("svf", [] {
+            redsp::svf<T, channels, T> f(T(48000));
+            f.calc_unsafe(T(500), T(0.7));
+            return f;
+        }, [](auto& f, T** x, int count) { f.template process<redsp::svf<T, channels, T>::SVFType::Lowpass>(x, count); }, tolerance);
+        expectFlushes<T>("ladder", [] {
+            redsp::ladder<T, channels> f;
+            f.set_cutoff(T(0.01));
+            f.set_resonance(T(0.5));
+            return f;
+        }, [](auto& f, T** x, int count) { f.process(x, count); }, tolerance);
+        expectFlushes<T>("tpt_one_pole", [] {
+            redsp::tpt_one_pole<T, channels> f;
+            f.set_cutoff(T(0.01));
+            return f;
+        }, [](auto& f, T** x, int count) { f.process(x, count); }, tolerance);
+        expectFlushes<T>("leaky_integrator", [] {
+            redsp::leaky_integrator<T, channels> f;
+            f.set_time_constant(0.01, 48000.0);
+            return f;
+        }, [](auto& f, T** x, int count) { f.process(x, count); }, tolerance);
+        expectFlushes<T>("dc_blocker", [] {
+            redsp::dc_blocker<T, channels> f;
+            f.set_cutoff(20.0, 48000.0);
+            return f;
+        }, [](auto& f, T** x, int count) { for (int c = 0; c < channels; ++c) { f.process(x[c], count, c); } }, tolerance);
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("scoped_denormal_disable");
+            volatile float smallest = std::numeric_limits<float>::min();
+            volatile float half = 0.5f;
+            {
+                redsp::scoped_denormal_disable ftz;
+                float const x = smallest * half;
+                if (redsp::scoped_denormal_disable::supported) { expectEquals(x, 0.0f); }
+                {
+                    redsp::scoped_denormal_disable nested;
+                }
+                float const y = smallest * half;
+                if (redsp::scoped_denormal_disable::supported) { expectEquals(y, 0.0f, "a nested guard undid the outer"); }
+            }
+            float const z = smallest * half;
+            expect(denormal(z), "the mode wasn't restored");
+        }
+
+        {
+            beginTest("flush_denormal");
+            std::array<double, 3> state { 1.0e-16, -0.5, 1.0e-300 };
+            redsp::flush_denormal(state);
+            expectEquals(state[0], 0.0);
+            expectEquals(state[1], -0.5);
+            expectEquals(state[2], 0.0);
+            float small = 1.0e-20f;
+            redsp::flush_denormal(small);
+            expectEquals(small, 0.0f);
+        }
+
+        {
+            beginTest("float");
+            filters<float>(1.0e-14);
+        }
+
+        {
+            beginTest("double");
+            filters<double>(1.0e-14);
+        }
+    }
+};
+
+#endif // REDSP_DENORMALTESTS_HEADERGUARD
@@ -0,0 +1,214 @@
+#ifndef REDSP_DYNAMICSTESTS_HEADERGUARD
+#define REDSP_DYNAMICSTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/dynamics/envelope_follower.h"
+#include "../source/dynamics/compressor.h"
+
+#pragma once
+
+using namespace juce;
+
+struct DynamicsTest : public RedspTest
+{
+    DynamicsTest() : RedspTest("Dynamics", "Dynamics") { }
+
+private:
+    static double db(double x) { return 20.0 * std::log10(x); }
+
+    //! steady gain (dB) a compressor settles on for a constant input at `@param level_db`
+    template <typename Compressor>
+    static double settledGain(Compressor& comp, double level_db)
+    {
+        auto const level = std::pow(10.0, level_db / 20.0);
+        std::vector<double> x(4800);
+        double* p = x.data();
+        for (int i = 0; i < 10; ++i) { std::fill(x.begin(), x.end(), level); comp.process(&p, 4800); }
+        return comp.gain(0);
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("follower_times");
+            redsp::envelope_follower<double> follower;
+            follower.set_times(0.01, 0.1, 48000.0);
+            std::vector<double> x(480, 1.0);
+            follower.process(x.data(), static_cast<int>(x.size()));
+            expectWithinAbsoluteError(x.back(), 1.0 - std::exp(-1.0), 1.0e-3);
+
+            // let it get all the way up, then release for one release time
+            std::vector<double> more(48000, 1.0);
+            follower.process(more.data(), static_cast<int>(more.size()));
+            std::vector<double> silence(4800, 0.0);
+            follower.process(silence.data(), static_cast<int>(silence.size()));
+            expectWithinAbsoluteError(silence.back(), std::exp(-1.0), 1.0e-3);
+        }
+        {
+            beginTest("follower_rms");
+            redsp::envelope_follower<double, 1, redsp::envelope_detector::rms> follower;
+            follower.set_times(0.2, 0.2, 48000.0);
+            std::vector<double> x(96000);
+            for (size_t i = 0; i < x.size(); ++i) { x[i] = 0.5 * std::sin(2.0 * redsp::math::pi<double>() * 0.01 * i); }
+            follower.process(x.data(), static_cast<int>(x.size()));
+            expectWithinAbsoluteError(x.back(), 0.5 / std::sqrt(2.0), 2.0e-3);
+        }
+        {
+            beginTest("follower_planar_matches_single");
+            redsp::envelope_follower<double, 5> planar, single;
+            planar.set_times(0.001, 0.05, 44100.0);
+            single.set_times(0.001, 0.05, 44100.0);
+            std::vector<std::vector<double>> x;
+            std::vector<double*> pointers;
+            for (size_t c = 0; c < 5; ++c) { x.push_back(randomSignal(700)); }
+            auto expected = x;
+            for (auto& channel : x) { pointers.push_back(channel.data()); }
+            planar.process(pointers.data(), 700);
+            for (size_t c = 0; c < 5; ++c)
+            {
+                single.process(expected[c].data(), 700, static_cast<int>(c));
+                for (size_t i = 0; i < 700; ++i) { expectWithinAbsoluteError(x[c][i], expected[c][i], 1.0e-14); }
+            }
+        }
+        {
+            beginTest("static_curve");
+            redsp::compressor<double, 1> comp;
+            comp.prepare(48000.0, 512);
+            comp.set_threshold(-20.0);
+            comp.set_ratio(4.0);
+            comp.set_times(0.001, 0.01);
+
+            // hard knee: nothing below, 3/4 of the overshoot taken off above
+            comp.set_knee(0.0);
+            expectWithinAbsoluteError(settledGain(comp, -30.0), 0.0, 0.01);
+            expectWithinAbsoluteError(settledGain(comp, -10.0), -7.5, 0.01);
+            expectWithinAbsoluteError(settledGain(comp, 0.0), -15.0, 0.01);
+
+            // soft knee: the curve's midpoint is slope * knee / 8 down, and it's back on the hard curve past the knee
+            comp.set_knee(10.0);
+            expectWithinAbsoluteError(settledGain(comp, -20.0), -0.75 * 10.0 / 8.0, 0.01);
+            expectWithinAbsoluteError(settledGain(comp, -26.0), 0.0, 0.01);
+            expectWithinAbsoluteError(settledGain(comp, -10.0), -7.5, 0.01);
+
+            comp.set_makeup(6.0);
+            expectWithinAbsoluteError(settledGain(comp, -10.0), -1.5, 0.01);
+        }
+        {
+            beginTest("limiter_holds_ceiling");
+            redsp::compressor<double, 2> limiter;
+            limiter.prepare(48000.0, 256);
+            limiter.set_threshold(-6.0);
+            limiter.set_ratio(std::numeric_limits<double>::infinity());
+            limiter.set_knee(0.0);
+            limiter.set_times(0.0, 0.05);
+            auto l = randomSignal(10000), r = randomSignal(10000, 2.0);
+            double* p[] = { l.data(), r.data() };
+            limiter.process(p, 10000);
+            double peak = 0;
+            for (size_t i = 0; i < l.size(); ++i) { peak = std::max({ peak, std::abs(l[i]), std::abs(r[i]) }); }
+            expectLessThan(db(peak), -6.0 + 0.01);
+        }
+        {
+            beginTest("lookahead_delays");
+            redsp::compressor<double, 2> comp;
+            comp.prepare(48000.0, 100, 0.01);
+            comp.set_threshold(0.0);
+            comp.set_lookahead(0.001);
+            expectEquals(comp.latency(), 48);
+
+            // well under the threshold, so the output is just the input, late
+            auto l = randomSignal(1000, 0.01), r = randomSignal(1000, 0.01);
+            auto yl = l, yr = r;
+            double* p[] = { yl.data(), yr.data() };
+            comp.process(p, 1000);
+            for (size_t i = 0; i < l.size(); ++i)
+            {
+                expectWithinAbsoluteError(yl[i], i < 48 ? 0.0 : l[i - 48], 1.0e-6);
+                expectWithinAbsoluteError(yr[i], i < 48 ? 0.0 : r[i - 48], 1.0e-6);
+            }
+        }
+        {
+            beginTest("linking_and_sidechain");
+            redsp::compressor<double, 2> comp;
+            comp.prepare(48000.0, 512);
+            comp.set_threshold(-20.0);
+            comp.set_ratio(4.0);
+            comp.set_knee(0.0);
+
+            std::vector<double> l(4800), r(4800);
+            auto run = [&]
+            {
+                for (int i = 0; i < 10; ++i)
+                {
+                    std::fill(l.begin(), l.end(), 1.0);
+                    std::fill(r.begin(), r.end(), 0.01);
+                    double* p[] = { l.data(), r.data() };
+                    comp.process(p, 4800);
+                }
+            };
+
+            // linked, the quiet side gets the loud side's gain
+            comp.set_link(1.0);
+            run();
+            expectWithinAbsoluteError(comp.gain(0), -15.0, 0.01);
+            expectWithinAbsoluteError(comp.gain(1), -15.0, 0.01);
+
+            comp.set_link(0.0);
+            run();
+            expectWithinAbsoluteError(comp.gain(0), -15.0, 0.01);
+            expectWithinAbsoluteError(comp.gain(1), 0.0, 0.01);
+
+            // keyed from outside: a loud key ducks a quiet input
+            std::vector<double> key(4800, 1.0), x(4800, 0.01);
+            double const* k[] = { key.data(), key.data() };
+            for (int i = 0; i < 10; ++i)
+            {
+                std::fill(x.begin(), x.end(), 0.01);
+                double* p[] = { x.data(), r.data() };
+                comp.process(p, k, 4800);
+            }
+            expectWithinAbsoluteError(db(x.back() / 0.01), -15.0, 0.01);
+        }
+        {
+            beginTest("fast_log_domain_matches_reference");
+            // the same chain with log10 and pow, for a signal swinging through the knee
+            redsp::compressor<float, 4> comp;
+            comp.prepare(48000.0, 64);
+            comp.set_threshold(-18.0f);
+            comp.set_ratio(3.0f);
+            comp.set_knee(6.0f);
+            comp.set_link(0.0f);
+            comp.set_times(0.002, 0.05);
+
+            auto const a = 1.0 - std::exp(-1.0 / (0.002 * 48000.0)), r = 1.0 - std::exp(-1.0 / (0.05 * 48000.0));
+            std::array<double, 4> env {};
+            std::vector<std::vector<float>> x(4, std::vector<float>(2000));
+            for (size_t c = 0; c < 4; ++c)
+            {
+                for (size_t i = 0; i < 2000; ++i)
+                {
+                    x[c][i] = static_cast<float>(std::sin(0.05 * i + c) * std::pow(10.0, (-40.0 + 40.0 * i / 2000.0) / 20.0));
+                }
+            }
+            auto y = x;
+            std::vector<float*> p { y[0].data(), y[1].data(), y[2].data(), y[3].data() };
+            comp.process(p.data(), 2000);
+
+            for (size_t c = 0; c < 4; ++c)
+            {
+                for (size_t i = 0; i < 2000; ++i)
+                {
+                    auto const level = std::abs(static_cast<double>(x[c][i]));
+                    env[c] += (level > env[c] ? a : r) * (level - env[c]);
+                    auto const over = 20.0 * std::log10(std::max(env[c], 1.0e-30)) + 18.0;
+                    auto const q = std::min(std::max(over + 3.0, 0.0), 6.0);
+                    auto const gain = -(2.0 / 3.0) * (q * q / 12.0 + std::max(over - 3.0, 0.0));
+                    expectWithinAbsoluteError(static_cast<double>(y[c][i]), x[c][i] * std::pow(10.0, gain / 20.0), 1.0e-4);
+                }
+            }
+        }
+    }
+};
+
+#endif // REDSP_DYNAMICSTESTS_HEADERGUARD
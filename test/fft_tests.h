@@ -0,0 +1,105 @@
+#ifndef REDSP_FFTTESTS_HEADERGUARD
+#define REDSP_FFTTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/fft/fft.h"
+
+#pragma once
+
+using namespace juce;
+
+struct FFTTest : public RedspTest
+{
+    FFTTest() : RedspTest("FFT", "FFT") { }
+
+private:
+    using cplx = std::complex<double>;
+
+    static std::vector<cplx> dft(std::vector<cplx> const& x)
+    {
+        auto const n = x.size();
+        std::vector<cplx> X(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                X[k] += x[i] * std::polar(1.0, -redsp::math::twopi<double>() * static_cast<double>((i * k) % n) / n);
+            }
+        }
+        return X;
+    }
+
+    std::vector<cplx> randomComplex(size_t n)
+    {
+        std::vector<cplx> x(n);
+        for (auto& v : x) { v = cplx(random.nextDouble() * 2 - 1, random.nextDouble() * 2 - 1); }
+        return x;
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("complex_matches_dft");
+            for (int order = redsp::fft<double>::min_order; order <= 9; ++order)
+            {
+                redsp::fft<double> f(order);
+                auto x = randomComplex(static_cast<size_t>(f.size()));
+                auto expected = dft(x);
+                std::vector<cplx> out(x.size());
+                f.forward(x.data(), out.data());
+                for (size_t k = 0; k < x.size(); ++k) { expectWithinAbsoluteError(std::abs(out[k] - expected[k]), 0.0, 1.0e-12); }
+            }
+        }
+        {
+            beginTest("real_matches_dft");
+            for (int order = redsp::fft<double>::min_order; order <= 9; ++order)
+            {
+                redsp::fft<double> f(order);
+                auto x = randomComplex(static_cast<size_t>(f.size()));
+                std::vector<double> real(x.size());
+                for (size_t i = 0; i < x.size(); ++i) { real[i] = x[i].real(); x[i] = cplx(real[i], 0); }
+                auto expected = dft(x);
+
+                std::vector<cplx> out(static_cast<size_t>(f.bins()));
+                f.forward_real(real.data(), out.data());
+                for (size_t k = 0; k < out.size(); ++k) { expectWithinAbsoluteError(std::abs(out[k] - expected[k]), 0.0, 1.0e-12); }
+            }
+        }
+        {
+            beginTest("in_place_round_trip");
+            for (int order = redsp::fft<float>::min_order; order <= redsp::fft<float>::max_order; ++order)
+            {
+                redsp::fft<float> f(order);
+                auto const n = static_cast<size_t>(f.size());
+                std::vector<std::complex<float>> x(n), y;
+                for (auto& v : x) { v = { random.nextFloat() - 0.5f, random.nextFloat() - 0.5f }; }
+                y = x;
+                f.forward(y.data(), y.data());
+                f.inverse(y.data(), y.data());
+
+                float err = 0;
+                for (size_t i = 0; i < n; ++i) { err = std::max(err, std::abs(y[i] / static_cast<float>(n) - x[i])); }
+                expectLessThan(err, 1.0e-5f);
+            }
+        }
+        {
+            beginTest("real_round_trip");
+            for (int order = redsp::fft<float>::min_order; order <= redsp::fft<float>::max_order; ++order)
+            {
+                redsp::fft<float> f(order);
+                auto const n = static_cast<size_t>(f.size());
+                std::vector<float> x(n), y(n), re(n / 2 + 1), im(n / 2 + 1);
+                for (auto& v : x) { v = random.nextFloat() - 0.5f; }
+                f.forward_real(x.data(), re.data(), im.data());
+                f.inverse_real(re.data(), im.data(), y.data());
+
+                float err = 0;
+                for (size_t i = 0; i < n; ++i) { err = std::max(err, std::abs(y[i] / static_cast<float>(n) - x[i])); }
+                expectLessThan(err, 1.0e-5f);
+            }
+        }
+    }
+};
+
+#endif // REDSP_FFTTESTS_HEADERGUARD
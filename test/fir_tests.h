@@ -0,0 +1,139 @@
+#ifndef REDSP_FIRTESTS_HEADERGUARD
+#define REDSP_FIRTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/filters/fir.h"
+
+#pragma once
+
+using namespace juce;
+
+struct FIRTest : public RedspTest
+{
+    FIRTest() : RedspTest("FIR", "Filters") { }
+
+private:
+    static std::vector<double> direct(std::vector<double> const& x, std::vector<double> const& h)
+    {
+        std::vector<double> y(x.size(), 0.0);
+        for (size_t n = 0; n < x.size(); ++n)
+        {
+            for (size_t k = 0; k < h.size() && k <= n; ++k) { y[n] += h[k] * x[n - k]; }
+        }
+        return y;
+    }
+
+    //! runs both channels in randomly sized calls and compares with direct convolution
+    template <typename Filter>
+    void expectMatchesDirect(Filter filter, size_t taps)
+    {
+        auto h = randomSignal(taps);
+        std::vector<std::vector<double>> x { randomSignal(1000), randomSignal(1000) };
+        filter.set_coefficients(h);
+        expectEquals(filter.taps(), static_cast<int>(taps));
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            auto expected = direct(x[static_cast<size_t>(ch)], h);
+            auto y = x[static_cast<size_t>(ch)];
+            for (size_t done = 0; done < y.size();)
+            {
+                auto len = std::min(y.size() - done, static_cast<size_t>(random.nextInt(40) + 1));
+                filter.process(y.data() + done, static_cast<int>(len), ch);
+                done += len;
+            }
+            for (size_t i = 0; i < y.size(); ++i) { expectWithinAbsoluteError(y[i], expected[i], 1.0e-12); }
+        }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("fixed_taps_match_direct");
+            expectMatchesDirect(redsp::fir<double, 7, 2>(), 7);
+            expectMatchesDirect(redsp::fir<double, 16, 2>(), 16);
+        }
+        {
+            beginTest("runtime_taps_match_direct");
+            expectMatchesDirect(redsp::fir<double, 0, 2>(), 37);
+            expectMatchesDirect(redsp::fir<double, 0, 2>(), 1);
+        }
+        {
+            beginTest("fixed_taps_zero_padded");
+            // fewer coefficients than Taps behave like the shorter filter
+            auto h = randomSignal(5);
+            auto x = randomSignal(200);
+            auto expected = direct(x, h);
+            redsp::fir<double, 8> filter;
+            filter.set_coefficients(h);
+            filter.process(x.data(), static_cast<int>(x.size()));
+            for (size_t i = 0; i < x.size(); ++i) { expectWithinAbsoluteError(x[i], expected[i], 1.0e-12); }
+        }
+        {
+            beginTest("decimator_keeps_every_mth_output");
+            auto h = randomSignal(23);
+            auto x = randomSignal(999);
+            auto full = direct(x, h);
+
+            redsp::fir_decimator<double, 3> decimator;
+            decimator.set_coefficients(h);
+            std::vector<double> y(x.size() / 3 + 1);
+            size_t written = 0;
+            for (size_t done = 0; done < x.size();)
+            {
+                auto len = std::min(x.size() - done, static_cast<size_t>(random.nextInt(20) + 1));
+                written += static_cast<size_t>(decimator.process(x.data() + done, y.data() + written, static_cast<int>(len)));
+                done += len;
+            }
+            expectEquals(static_cast<int>(written), 333);
+            for (size_t m = 0; m < written; ++m) { expectWithinAbsoluteError(y[m], full[3 * m], 1.0e-12); }
+        }
+        {
+            beginTest("interpolator_matches_zero_stuffing");
+            auto h = randomSignal(30);
+            auto x = randomSignal(300);
+            std::vector<double> stuffed(x.size() * 4, 0.0);
+            for (size_t i = 0; i < x.size(); ++i) { stuffed[4 * i] = x[i]; }
+            auto expected = direct(stuffed, h);
+
+            auto check = [&](auto interpolator)
+            {
+                interpolator.set_coefficients(h);
+                std::vector<double> y(stuffed.size());
+                for (size_t done = 0; done < x.size();)
+                {
+                    auto len = std::min(x.size() - done, static_cast<size_t>(random.nextInt(20) + 1));
+                    interpolator.process(x.data() + done, y.data() + 4 * done, static_cast<int>(len));
+                    done += len;
+                }
+                for (size_t i = 0; i < y.size(); ++i) { expectWithinAbsoluteError(y[i], expected[i], 1.0e-12); }
+            };
+            check(redsp::fir_interpolator<double, 4>());
+            check(redsp::fir_interpolator<double, 4, 30>());
+        }
+        {
+            beginTest("kaiser_lowpass_response");
+            auto h = redsp::kaiser_lowpass<double>(63, 0.125);
+            auto response = [&h](double f)
+            {
+                double re = 0, im = 0;
+                for (size_t i = 0; i < h.size(); ++i)
+                {
+                    re += h[i] * std::cos(2.0 * redsp::math::pi<double>() * f * i);
+                    im += h[i] * std::sin(2.0 * redsp::math::pi<double>() * f * i);
+                }
+                return std::sqrt(re * re + im * im);
+            };
+            expectWithinAbsoluteError(response(0.0), 1.0, 1.0e-12);
+            expectWithinAbsoluteError(response(0.05), 1.0, 1.0e-3);
+            expectLessThan(response(0.25), 1.0e-3);
+            expectLessThan(response(0.4), 1.0e-3);
+
+            // symmetric, so linear phase
+            for (size_t i = 0; i < h.size(); ++i) { expectWithinAbsoluteError(h[i], h[h.size() - 1 - i], 1.0e-15); }
+        }
+    }
+};
+
+#endif // REDSP_FIRTESTS_HEADERGUARD
@@ -0,0 +1,152 @@
+#ifndef REDSP_INTEGRATORTESTS_HEADERGUARD
+#define REDSP_INTEGRATORTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/filters/integrators.h"
+#include "../source/filters/filter_chain.h"
+#include "../source/filters/biquad.h"
+
+#pragma once
+
+using namespace juce;
+
+struct IntegratorTest : public RedspTest
+{
+    IntegratorTest() : RedspTest("Integrators", "Filters") { }
+
+private:
+    //! steady-state gain of `@param filter` for a sine of `@param f` (a fraction of the sampling rate)
+    template <typename Filter>
+    static double gainAt(Filter filter, double f)
+    {
+        // whole periods, so the rms is exact
+        double sum = 0;
+        int const settle = 20000, length = static_cast<int>(std::round(std::ceil(40000.0 * f) / f));
+        for (int i = 0; i < settle + length; ++i)
+        {
+            auto y = filter.process(std::sin(2.0 * redsp::math::pi<double>() * f * i));
+            if (i >= settle) { sum += y * y; }
+        }
+        return std::sqrt(2.0 * sum / length);
+    }
+
+    //! the planar multichannel path, SIMD across channels, against each channel on its own
+    template <typename Filter, typename Setup>
+    void expectPlanarMatchesSingle(Setup setup)
+    {
+        Filter planar, single;
+        setup(planar);
+        setup(single);
+
+        std::vector<std::vector<double>> x, expected;
+        std::vector<double*> pointers;
+        for (size_t c = 0; c < Filter::channels; ++c) { x.push_back(randomSignal(1000)); }
+        expected = x;
+        for (auto& channel : x) { pointers.push_back(channel.data()); }
+
+        // in random block lengths, so the tiles and the state carried between calls both get exercised
+        for (int done = 0; done < 1000;)
+        {
+            auto len = std::min(1000 - done, random.nextInt(100) + 1);
+            std::vector<double*> offset;
+            for (auto* p : pointers) { offset.push_back(p + done); }
+            planar.process(offset.data(), len);
+            done += len;
+        }
+        for (size_t c = 0; c < Filter::channels; ++c)
+        {
+            single.process(expected[c].data(), 1000, static_cast<int>(c));
+            for (size_t i = 0; i < 1000; ++i) { expectWithinAbsoluteError(x[c][i], expected[c][i], 1.0e-14); }
+        }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("one_pole_responses");
+            redsp::tpt_one_pole<double> lp;
+            redsp::tpt_one_pole<double, 1, redsp::one_pole_type::highpass> hp;
+            redsp::tpt_one_pole<double, 1, redsp::one_pole_type::allpass> ap;
+            lp.set_cutoff(1000.0, 48000.0);
+            hp.set_cutoff(1000.0, 48000.0);
+            ap.set_cutoff(1000.0, 48000.0);
+
+            // prewarped, so -3dB right at the cutoff
+            expectWithinAbsoluteError(gainAt(lp, 1000.0 / 48000.0), std::sqrt(0.5), 1.0e-3);
+            expectWithinAbsoluteError(gainAt(hp, 1000.0 / 48000.0), std::sqrt(0.5), 1.0e-3);
+            expectWithinAbsoluteError(gainAt(lp, 10.0 / 48000.0), 1.0, 1.0e-3);
+            expectWithinAbsoluteError(gainAt(hp, 10000.0 / 48000.0), 1.0, 0.03);
+            for (auto f : { 0.001, 0.02, 0.3 }) { expectWithinAbsoluteError(gainAt(ap, f), 1.0, 1.0e-3); }
+
+            // the outputs share an integrator, so lowpass and highpass add back up to the input
+            auto x = randomSignal(500);
+            for (auto v : x) { expectWithinAbsoluteError(lp.process(v) + hp.process(v), v, 1.0e-14); }
+        }
+        {
+            beginTest("leaky_integrator_time_constant");
+            redsp::leaky_integrator<double> smoother;
+            smoother.set_time_constant(0.01, 48000.0);
+            std::vector<double> step(480, 1.0);
+            smoother.process(step.data(), static_cast<int>(step.size()));
+            expectWithinAbsoluteError(step.back(), 1.0 - std::exp(-1.0), 2.0e-3);
+
+            smoother.reset(0.5);
+            expectWithinAbsoluteError(smoother.process(0.5), 0.5, 1.0e-15);
+        }
+        {
+            beginTest("dc_blocker_removes_offset");
+            redsp::dc_blocker<double> blocker;
+            blocker.set_cutoff(10.0, 48000.0);
+            expectWithinAbsoluteError(gainAt(blocker, 1000.0 / 48000.0), 1.0, 1.0e-3);
+            expectWithinAbsoluteError(gainAt(blocker, 10.0 / 48000.0), std::sqrt(0.5), 0.01);
+
+            std::vector<double> x(48000, 0.3);
+            blocker.process(x.data(), static_cast<int>(x.size()));
+            expectLessThan(std::abs(x.back()), 1.0e-6);
+
+            // a pole worked out at compile time behaves as set_cutoff()'s
+            static constexpr auto pole = redsp::dc_blocker<double>::pole(10.0 / 48000.0);
+            redsp::dc_blocker<double> fixed, tuned;
+            fixed.set_pole(pole);
+            tuned.set_cutoff(10.0, 48000.0);
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto const in = std::sin(0.001 * i * i);
+                expectWithinAbsoluteError(fixed.process(in), tuned.process(in), 1.0e-12);
+            }
+        }
+        {
+            beginTest("planar_simd_matches_single");
+            expectPlanarMatchesSingle<redsp::tpt_one_pole<double, 5>>([](auto& f) { f.set_cutoff(0.01); });
+            expectPlanarMatchesSingle<redsp::leaky_integrator<double, 3>>([](auto& f) { f.set_coefficient(0.99); });
+            expectPlanarMatchesSingle<redsp::dc_blocker<double, 8>>([](auto& f) { f.set_cutoff(0.001); });
+        }
+        {
+            beginTest("chain_fuses_stages");
+            // a dc blocker folded into the same pass as a biquad gives what the two give one after the other
+            using blocker_type = redsp::dc_blocker<double, 2>;
+            using biquad_type = redsp::biquad<double, double, 2>;
+            redsp::filter_chain<blocker_type, biquad_type> chain;
+            blocker_type blocker;
+            biquad_type lowpass;
+            lowpass.reset();
+            chain.get<0>().set_cutoff(20.0, 44100.0);
+            blocker.set_cutoff(20.0, 44100.0);
+            chain.get<1>().calc_lp(0.1, 0.707);
+            lowpass.calc_lp(0.1, 0.707);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                auto x = randomSignal(2000);
+                for (auto& v : x) { v += 0.5; }
+                auto y = x;
+                chain.process(x.data(), static_cast<int>(x.size()), channel);
+                for (auto& v : y) { v = lowpass.process(blocker.process(v, channel), channel); }
+                for (size_t i = 0; i < x.size(); ++i) { expectWithinAbsoluteError(x[i], y[i], 1.0e-14); }
+            }
+        }
+    }
+};
+
+#endif // REDSP_INTEGRATORTESTS_HEADERGUARD
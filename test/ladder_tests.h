@@ -0,0 +1,154 @@
+#ifndef REDSP_LADDERTESTS_HEADERGUARD
+#define REDSP_LADDERTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/filters/ladder.h"
+
+#pragma once
+
+using namespace juce;
+
+struct LadderTest : public RedspTest
+{
+    LadderTest() : RedspTest("Ladder", "Filters") { }
+
+private:
+    //! steady-state gain for a sine of `@param f` (a fraction of the sampling rate), small enough to stay linear
+    static double gainAt(double f, double cutoff, double resonance)
+    {
+        redsp::ladder<double> filter;
+        filter.set_cutoff(cutoff);
+        filter.set_resonance(resonance);
+        double const amplitude = 1.0e-4;
+        double sum = 0;
+        int const settle = 20000, length = 40000;
+        for (int i = 0; i < settle + length; ++i)
+        {
+            auto y = filter.process(amplitude * std::sin(2.0 * redsp::math::pi<double>() * f * i));
+            if (i >= settle) { sum += y * y; }
+        }
+        return std::sqrt(2.0 * sum / length) / amplitude;
+    }
+
+    template <typename T, size_t Voices>
+    void expectVoicesMatchScalar(double tolerance)
+    {
+        redsp::ladder_voices<T, Voices> bank;
+        std::array<redsp::ladder<T>, Voices> single;
+        for (size_t v = 0; v < Voices; ++v)
+        {
+            auto const f = static_cast<T>(0.001 + 0.2 * random.nextDouble());
+            auto const r = static_cast<T>(1.2 * random.nextDouble());
+            bank.set_cutoff(v, f);
+            bank.set_resonance(v, r);
+            single[v].set_cutoff(f);
+            single[v].set_resonance(r);
+        }
+
+        int const count = 2000;
+        std::vector<T> frames(static_cast<size_t>(count) * Voices);
+        for (auto& x : frames) { x = static_cast<T>(4.0 * random.nextDouble() - 2.0); }
+        auto expected = frames;
+        bank.process(frames.data(), count);
+        for (size_t t = 0; t < static_cast<size_t>(count); ++t)
+        {
+            for (size_t v = 0; v < Voices; ++v)
+            {
+                auto const i = t * Voices + v;
+                expectWithinAbsoluteError(frames[i], single[v].process(expected[i]), static_cast<T>(tolerance));
+            }
+        }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("four_pole_lowpass");
+            // four one-poles meeting at the cutoff: unity in the passband, -12dB at the cutoff, -24dB per octave
+            expectWithinAbsoluteError(gainAt(0.001, 0.05, 0.0), 1.0, 0.01);
+            expectWithinAbsoluteError(gainAt(0.05, 0.05, 0.0), 0.25, 0.005);
+            expectLessThan(gainAt(0.2, 0.05, 0.0), 0.003);
+        }
+        {
+            beginTest("resonance_tuned_to_cutoff");
+            // the feedback sees -1/4 at the cutoff, so the peak there is 1 / (4 (1 - r)), and the passband drops to
+            // 1 / (1 + 4r). Bilinear prewarping puts it on the cutoff even close to nyquist
+            for (auto cutoff : { 0.01, 0.1, 0.3 })
+            {
+                expectWithinAbsoluteError(gainAt(cutoff, cutoff, 0.8), 1.25, 0.02);
+                expectWithinAbsoluteError(gainAt(cutoff * 0.01, cutoff, 0.8), 1.0 / 4.2, 0.01);
+            }
+        }
+        {
+            beginTest("self_oscillation");
+            redsp::ladder<double> filter;
+            filter.set_cutoff(0.02);
+            filter.set_resonance(1.1);
+            std::vector<double> y(48000, 0.0);
+            y[0] = 0.1;
+            filter.process(y.data(), static_cast<int>(y.size()));
+
+            double peak = 0, sum = 0;
+            int crossings = 0;
+            for (size_t i = 36000; i < y.size(); ++i)
+            {
+                peak = std::max(peak, std::abs(y[i]));
+                sum += y[i] * y[i];
+                if ((y[i - 1] < 0) != (y[i] < 0)) { ++crossings; }
+            }
+            // the tanh stages hold it at a steady level, ringing at the cutoff
+            expectGreaterThan(std::sqrt(sum / 12000.0), 0.1);
+            expectLessThan(peak, 4.0);
+            expectWithinAbsoluteError(crossings / 2.0 / 12000.0, 0.02, 0.002);
+        }
+        {
+            beginTest("stable_under_modulation");
+            redsp::ladder<float, 2> filter;
+            std::vector<float> x(20000), cutoff(x.size()), resonance(x.size());
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                x[i] = 20.0f * random.nextFloat() - 10.0f;
+                cutoff[i] = 0.5f * random.nextFloat();
+                resonance[i] = 1.5f * random.nextFloat();
+            }
+            filter.process(x.data(), cutoff.data(), resonance.data(), static_cast<int>(x.size()), 1);
+            auto peak = 0.0f;
+            for (auto v : x) { peak = std::isfinite(v) ? std::max(peak, std::abs(v)) : 1.0e30f; }
+            expectLessThan(peak, 20.0f);
+        }
+        {
+            beginTest("voices_match_scalar");
+            expectVoicesMatchScalar<double, 8>(1.0e-12);
+            expectVoicesMatchScalar<double, 5>(1.0e-12);
+            expectVoicesMatchScalar<float, 8>(1.0e-5);
+            expectVoicesMatchScalar<float, 3>(1.0e-5);
+        }
+        {
+            beginTest("voices_per_sample_parameters");
+            redsp::ladder_voices<double, 4> bank;
+            std::array<redsp::ladder<double>, 4> single;
+            int const count = 500;
+            std::vector<double> frames(4 * count), cutoff(frames.size()), resonance(frames.size());
+            for (size_t i = 0; i < frames.size(); ++i)
+            {
+                frames[i] = random.nextDouble() * 2.0 - 1.0;
+                cutoff[i] = 0.3 * random.nextDouble();
+                resonance[i] = random.nextDouble();
+            }
+            auto expected = frames;
+            bank.process(frames.data(), cutoff.data(), resonance.data(), count);
+            for (size_t v = 0; v < 4; ++v)
+            {
+                for (size_t t = 0; t < static_cast<size_t>(count); ++t)
+                {
+                    auto const i = t * 4 + v;
+                    single[v].process(expected.data() + i, cutoff.data() + i, resonance.data() + i, 1);
+                    expectWithinAbsoluteError(frames[i], expected[i], 1.0e-12);
+                }
+            }
+        }
+    }
+};
+
+#endif // REDSP_LADDERTESTS_HEADERGUARD
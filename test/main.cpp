@@ -2,6 +2,25 @@
 #include "../source/redsp.h"
 #include "biquad_tests.h"
 #include "svf_tests.h"
+#include "adaa_tests.h"
+#include "waveshaper_tests.h"
+#include "oversampling_tests.h"
+#include "fft_tests.h"
+#include "stft_tests.h"
+#include "convolution_tests.h"
+#include "fir_tests.h"
+#include "ladder_tests.h"
+#include "integrator_tests.h"
+#include "resampler_tests.h"
+#include "delay_tests.h"
+#include "reverb_tests.h"
+#include "dynamics_tests.h"
+#include "metering_tests.h"
+#include "performance_tests.h"
+#include "realtime_tests.h"
+#include "denormal_tests.h"
+#include "render_tests.h"
+#include "remath_tests.h"
 
 int main(int argc, char** argv)
 {
@@ -9,12 +28,44 @@ int main(int argc, char** argv)
   juce::UnitTestRunner runner;
 
   static BiquadTest biquadtest;
-//  static SVFTest svftest;
+  static SVFTest svftest;
+  static ADAATest adaatest;
+  static WaveshaperTest waveshapertest;
+  static OversamplingTest oversamplingtest;
+  static FFTTest ffttest;
+  static STFTTest stfttest;
+  static ConvolutionTest convolutiontest;
+  static FIRTest firtest;
+  static LadderTest laddertest;
+  static IntegratorTest integratortest;
+  static ResamplerTest resamplertest;
+  static DelayTest delaytest;
+  static ReverbTest reverbtest;
+  static DynamicsTest dynamicstest;
+  static MeteringTest meteringtest;
+  static RealtimeTest realtimetest;
+  static DenormalTest denormaltest;
+  static RenderTest rendertest;
+  static RemathTest remathtest;
 
   juce::int64 seed = 0;
   app.addHelpCommand("--help|-h", "use", true);
   app.addCommand({"--seed|-s", "Sets the random seed for running", "Sets the random seed for running", "", [&seed](const juce::ArgumentList& args){ seed = args.getValueForOption("--seed|-s").getLargeIntValue(); }});
   app.addCommand({"--all|-a", "Runs all tests", "Runs all tests", "",[&runner, seed](const auto&){ runner.runAllTests(seed); } } );
   app.addCommand({"--category|-c", "runs all tests in the given category", "", "", [&runner, seed](const juce::ArgumentList& args){ runner.runTestsInCategory(args.getValueForOption("--category|-c")); } });
+  app.addCommand({"--performance|-p", "--performance [--baseline=<file>] [--record=<file>]",
+                  "Runs the Performance category against a baseline, exiting non-zero on a regression",
+                  "The baseline is a result file from redsp_bench --suite --json, or one this wrote with --record.",
+                  [&runner](const juce::ArgumentList& args){
+                      // only registered here, so the timings stay out of --all and --category
+                      PerformanceTest performancetest;
+                      if (args.containsOption("--baseline")) { performancetest.baseline = args.getFileForOption("--baseline"); }
+                      if (args.containsOption("--record")) { performancetest.record = args.getFileForOption("--record"); }
+                      runner.runTestsInCategory("Performance");
+                      for (int i = 0; i < runner.getNumResults(); ++i)
+                      {
+                          if (runner.getResult(i)->failures > 0) { juce::ConsoleApplication::fail("performance regressions", 2); }
+                      }
+                  } });
   return app.findAndRunCommand(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+#ifndef REDSP_METERINGTESTS_HEADERGUARD
+#define REDSP_METERINGTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <thread>
+#include "test_helpers.h"
+#include "../source/internal/spsc_ring.h"
+#include "../source/metering/loudness_meter.h"
+#include "../source/metering/true_peak_meter.h"
+#include "../source/metering/metering_engine.h"
+
+#pragma once
+
+using namespace juce;
+
+struct MeteringTest : public RedspTest
+{
+    MeteringTest() : RedspTest("Metering", "Metering") { }
+
+private:
+    //! `@param seconds` of a sine at `@param freq` Hz and `@param level_db` dBFS, at 48kHz
+    static std::vector<double> sine(double seconds, double freq, double level_db, double phase = 0.0)
+    {
+        std::vector<double> x(static_cast<size_t>(seconds * 48000.0));
+        auto const amplitude = std::pow(10.0, level_db / 20.0);
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            x[i] = amplitude * std::sin(2.0 * redsp::math::pi<double>() * freq * i / 48000.0 + phase);
+        }
+        return x;
+    }
+
+    static std::vector<double> concatenate(std::vector<std::vector<double>> const& parts)
+    {
+        std::vector<double> x;
+        for (auto const& p : parts) { x.insert(x.end(), p.begin(), p.end()); }
+        return x;
+    }
+
+    //! runs `@param x` through both channels of a stereo meter, in blocks of `@param block`
+    static void measure(redsp::loudness_meter<double, 2>& meter, std::vector<double> const& x, int block = 512)
+    {
+        for (size_t done = 0; done < x.size(); done += static_cast<size_t>(block))
+        {
+            auto const len = std::min(static_cast<size_t>(block), x.size() - done);
+            double const* p[] = { x.data() + done, x.data() + done };
+            meter.process(p, static_cast<int>(len));
+        }
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("ring_wraps");
+            redsp::spsc_ring<int> ring;
+            ring.prepare(10);
+            expectEquals(static_cast<int>(ring.capacity()), 16);
+
+            // pushing from any offset under 20 continues the count mod 20
+            std::vector<int> in(40), out(40);
+            for (size_t i = 0; i < in.size(); ++i) { in[i] = static_cast<int>(i % 20); }
+            int next = 0, expected = 0;
+            for (int round = 0; round < 20; ++round)
+            {
+                auto const n = static_cast<size_t>(random.nextInt(12));
+                next += static_cast<int>(ring.push(in.data() + next % 20, n));
+                auto const got = ring.pop(out.data(), static_cast<size_t>(random.nextInt(12)));
+                for (size_t i = 0; i < got; ++i) { expectEquals(out[i], expected++ % 20); }
+            }
+
+            // full: the rest is dropped and counted
+            ring.reset();
+            expectEquals(static_cast<int>(ring.push(in.data(), 20)), 16);
+            expectEquals(static_cast<int>(ring.dropped()), 4);
+            expectEquals(static_cast<int>(ring.space()), 0);
+        }
+        {
+            beginTest("ring_two_threads");
+            redsp::spsc_ring<int> ring;
+            ring.prepare(64);
+            constexpr int total = 200000;
+            std::thread producer([&ring]
+            {
+                std::array<int, 7> chunk;
+                for (int sent = 0; sent < total;)
+                {
+                    auto const n = std::min(7, total - sent);
+                    for (int i = 0; i < n; ++i) { chunk[static_cast<size_t>(i)] = sent + i; }
+                    sent += static_cast<int>(ring.push(chunk.data(), static_cast<size_t>(n)));
+                    std::this_thread::yield();
+                }
+            });
+
+            std::array<int, 13> chunk;
+            int received = 0;
+            bool ordered = true;
+            while (received < total)
+            {
+                auto const n = ring.pop(chunk.data(), chunk.size());
+                for (size_t i = 0; i < n; ++i) { ordered = ordered && chunk[i] == received++; }
+            }
+            producer.join();
+            expect(ordered);
+            expectEquals(received, total);
+        }
+        {
+            beginTest("sine_reads_its_level");
+            // a 997Hz sine in both channels reads its level in dBFS as LUFS, the K-weighting's gain there cancelling
+            // the -0.691 in the definition
+            redsp::loudness_meter<double, 2> meter;
+            meter.prepare(48000.0);
+            measure(meter, sine(5.0, 997.0, -20.0), 441);
+            expectWithinAbsoluteError(meter.momentary(), -20.0, 0.05);
+            expectWithinAbsoluteError(meter.short_term(), -20.0, 0.05);
+            expectWithinAbsoluteError(meter.integrated(), -20.0, 0.05);
+
+            // the same at 44.1kHz, the K-weighting being redesigned for the rate
+            redsp::loudness_meter<float, 2> other;
+            other.prepare(44100.0);
+            std::vector<float> y(44100 * 2);
+            for (size_t i = 0; i < y.size(); ++i)
+            {
+                y[i] = static_cast<float>(0.1 * std::sin(2.0 * redsp::math::pi<double>() * 997.0 * i / 44100.0));
+            }
+            float const* p[] = { y.data(), y.data() };
+            other.process(p, static_cast<int>(y.size()));
+            expectWithinAbsoluteError(other.momentary(), -20.0, 0.05);
+        }
+        {
+            beginTest("running_sums_match_direct");
+            redsp::loudness_meter<double, 2> meter;
+            meter.prepare(48000.0);
+            redsp::biquad<double, double, 1> shelf, highpass;
+            redsp::k_weighting(shelf, highpass, 48000.0);
+            shelf.reset();
+            highpass.reset();
+
+            // 4.3s of noise whose level wanders, checked on each 100ms boundary against sums over the filtered signal
+            std::vector<double> x(48000 * 43 / 10), weighted(x.size());
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                x[i] = (0.1 + 0.5 * std::abs(std::sin(i / 20000.0))) * (random.nextDouble() * 2.0 - 1.0);
+                weighted[i] = highpass.process(shelf.process(x[i]));
+            }
+            auto const lufs = [&](size_t end, size_t length)
+            {
+                double sum = 0;
+                for (size_t i = end - length; i < end; ++i) { sum += weighted[i] * weighted[i]; }
+                return -0.691 + 10.0 * std::log10(2.0 * sum / length);
+            };
+            for (size_t end = 4800; end <= x.size(); end += 4800)
+            {
+                double const* p[] = { x.data() + end - 4800, x.data() + end - 4800 };
+                meter.process(p, 4800);
+                if (end >= 19200) { expectWithinAbsoluteError(meter.momentary(), lufs(end, 19200), 1.0e-9); }
+                if (end >= 144000) { expectWithinAbsoluteError(meter.short_term(), lufs(end, 144000), 1.0e-9); }
+            }
+        }
+        {
+            beginTest("gating");
+            // EBU Tech 3341 case 3: the quiet parts fall under the relative gate
+            redsp::loudness_meter<double, 2> meter;
+            meter.prepare(48000.0);
+            measure(meter, concatenate({ sine(10.0, 1000.0, -36.0), sine(60.0, 1000.0, -23.0), sine(10.0, 1000.0, -36.0) }));
+            expectWithinAbsoluteError(meter.integrated(), -23.0, 0.1);
+
+            // silence falls under the absolute gate
+            meter.reset();
+            measure(meter, concatenate({ sine(20.0, 1000.0, -23.0), std::vector<double>(48000 * 20, 0.0) }));
+            expectWithinAbsoluteError(meter.integrated(), -23.0, 0.1);
+            expectLessThan(meter.momentary(), -70.0);
+
+            // and nothing but silence has no integrated loudness at all
+            meter.reset();
+            measure(meter, std::vector<double>(48000 * 2, 0.0));
+            expect(std::isinf(meter.integrated()));
+
+            // the LFE can be left out
+            meter.reset();
+            meter.set_channel_weight(1, 0.0);
+            measure(meter, sine(2.0, 997.0, -20.0));
+            expectWithinAbsoluteError(meter.momentary(), -20.0 - 10.0 * std::log10(2.0), 0.05);
+        }
+        {
+            beginTest("true_peak");
+            // a quarter-rate sine at 45 degrees: every sample is at -3dB, the waveform between them at 0dB
+            redsp::true_peak_meter<double, 2> meter;
+            auto x = sine(0.1, 12000.0, 0.0, 0.25 * redsp::math::pi<double>());
+            auto y = sine(0.1, 997.0, -6.0);
+            double sample_peak = 0;
+            for (auto v : x) { sample_peak = std::max(sample_peak, std::abs(v)); }
+            expectWithinAbsoluteError(20.0 * std::log10(sample_peak), -3.01, 0.01);
+
+            double const* p[] = { x.data(), y.data() };
+            meter.process(p, static_cast<int>(x.size()));
+            expectWithinAbsoluteError(meter.peak_db(0), 0.0, 0.2);
+            expectWithinAbsoluteError(meter.peak_db(1), -6.0, 0.1);
+
+            meter.reset_peaks();
+            expect(std::isinf(meter.peak_db(0)));
+        }
+        {
+            beginTest("engine_matches_meters");
+            redsp::metering_engine<float, 2> engine;
+            engine.prepare(48000.0, 256, 3.0);
+            redsp::loudness_meter<float, 2> loudness;
+            loudness.prepare(48000.0);
+            redsp::true_peak_meter<float, 2> peak;
+
+            std::vector<float> l(48000 * 3), r(l.size());
+            for (size_t i = 0; i < l.size(); ++i)
+            {
+                l[i] = static_cast<float>(0.3 * (random.nextDouble() * 2.0 - 1.0));
+                r[i] = static_cast<float>(0.1 * std::sin(0.01 * i));
+            }
+
+            // blocks larger than the engine's, and a meter thread updating in its own time; the ring holds it all, so
+            // nothing is dropped however the two interleave
+            std::atomic<bool> done { false };
+            std::thread meter_thread([&] { while (!done.load()) { engine.update(); std::this_thread::yield(); } });
+            for (size_t start = 0; start < l.size(); start += 1000)
+            {
+                auto const len = static_cast<int>(std::min(static_cast<size_t>(1000), l.size() - start));
+                float const* p[] = { l.data() + start, r.data() + start };
+                engine.push(p, len);
+                loudness.process(p, len);
+                peak.process(p, len);
+            }
+            done.store(true);
+            meter_thread.join();
+            engine.update();
+
+            expectEquals(static_cast<int>(engine.dropped()), 0);
+            expectWithinAbsoluteError(engine.momentary(), loudness.momentary(), 1.0e-9);
+            expectWithinAbsoluteError(engine.short_term(), loudness.short_term(), 1.0e-9);
+            expectWithinAbsoluteError(engine.integrated(), loudness.integrated(), 1.0e-9);
+            expectWithinAbsoluteError(engine.true_peak_db(0), peak.peak_db(0), 1.0e-9);
+            expectWithinAbsoluteError(engine.true_peak_db(1), peak.peak_db(1), 1.0e-9);
+
+            engine.request_reset();
+            engine.update();
+            expect(std::isinf(engine.integrated()));
+        }
+        {
+            beginTest("engine_drops_whole_frames");
+            // nobody updating: pushes past the ring's capacity are dropped, and what's kept is still in step
+            redsp::metering_engine<double, 3> engine;
+            engine.prepare(48000.0, 64, 0.01);
+            std::vector<double> x(2000, 0.5);
+            double const* p[] = { x.data(), x.data(), x.data() };
+            engine.push(p, 2000);
+            expectGreaterThan(static_cast<int>(engine.dropped()), 0);
+            expectLessThan(static_cast<int>(engine.dropped()), 2000);
+            engine.update();
+            expectWithinAbsoluteError(engine.true_peak_db(0), engine.true_peak_db(2), 1.0e-12);
+        }
+    }
+};
+
+#endif // REDSP_METERINGTESTS_HEADERGUARD
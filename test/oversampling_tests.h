@@ -0,0 +1,134 @@
+#ifndef REDSP_OVERSAMPLINGTESTS_HEADERGUARD
+#define REDSP_OVERSAMPLINGTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/oversampling/oversampled.h"
+#include "../source/filters/biquad.h"
+
+#pragma once
+
+using namespace juce;
+
+struct OversamplingTest : public RedspTest
+{
+    OversamplingTest() : RedspTest("Oversampling", "Oversampling") { }
+
+private:
+    //! passes samples through untouched, counting how many it saw
+    struct passthrough
+    {
+        using sample_type = double;
+        static constexpr size_t channels = 1;
+        int seen = 0;
+        void process(double*, int count, int) { seen += count; }
+    };
+
+    //! scales channel n by n + 1, so a mixed up channel shows
+    struct channel_gain
+    {
+        using sample_type = double;
+        static constexpr size_t channels = 3;
+        void process(double* x, int count, int n)
+        {
+            for (int i = 0; i < count; ++i) { x[i] *= n + 1; }
+        }
+    };
+
+    //! magnitude of the component of x at normalized frequency f
+    static double magnitude(std::vector<double> const& x, double f, size_t start)
+    {
+        double re = 0, im = 0;
+        for (size_t i = start; i < x.size(); ++i)
+        {
+            re += x[i] * std::cos(2.0 * redsp::math::pi<double>() * f * i);
+            im += x[i] * std::sin(2.0 * redsp::math::pi<double>() * f * i);
+        }
+        return 2.0 * std::sqrt(re * re + im * im) / static_cast<double>(x.size() - start);
+    }
+
+    template <typename Stage>
+    void expectImagesRejected(Stage stage, double freq, double limit)
+    {
+        std::vector<double> in(4096), out(8192);
+        for (size_t i = 0; i < in.size(); ++i) { in[i] = std::sin(2.0 * redsp::math::pi<double>() * freq * i); }
+        stage.prepare(static_cast<int>(in.size()));
+        stage.upsample(in.data(), out.data(), static_cast<int>(in.size()));
+
+        expectWithinAbsoluteError(magnitude(out, freq / 2.0, 1024), 1.0, 0.01);
+        expectLessThan(magnitude(out, 0.5 - freq / 2.0, 1024), limit);
+    }
+
+    template <redsp::oversampling_phase Phase>
+    void expectUnityAtDC()
+    {
+        redsp::oversampled<passthrough, 8, Phase> os;
+        os.prepare(100);
+        std::vector<double> x(1000, 0.5);
+        os.process(x.data(), static_cast<int>(x.size()));
+        expectEquals(os.inner.seen, 8000);
+        expectWithinAbsoluteError(x.back(), 0.5, 1.0e-4);
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("fir_images_rejected");
+            // image of ~0.2 fs lands at ~0.4 of the high rate, well into the stopband. The frequency is picked to sit
+            // exactly on a bin of the measurement so the tone doesn't leak into the image's bin
+            expectImagesRejected(redsp::halfband_fir<double>(16), 1434.0 / 7168.0, 1.0e-4);
+        }
+        {
+            beginTest("iir_images_rejected");
+            expectImagesRejected(redsp::halfband_iir<double>(10, 0.04), 1434.0 / 7168.0, 1.0e-4);
+        }
+        {
+            beginTest("fir_latency_reported");
+            redsp::oversampled<passthrough, 2> os;
+            os.prepare(64);
+            std::vector<double> x(256, 0.0);
+            x[0] = 1.0;
+            os.process(x.data(), static_cast<int>(x.size()));
+
+            auto peak = std::max_element(x.begin(), x.end(), [](double a, double b) { return std::abs(a) < std::abs(b); });
+            expectEquals(static_cast<double>(peak - x.begin()), os.latency());
+        }
+        {
+            beginTest("unity_gain_at_dc");
+            expectUnityAtDC<redsp::oversampling_phase::linear>();
+            expectUnityAtDC<redsp::oversampling_phase::minimum>();
+        }
+        {
+            beginTest("minimum_phase_channels_together");
+            // all channels at once go through the stages' simd lanes, one at a time through a single lane each
+            redsp::oversampled<channel_gain, 8, redsp::oversampling_phase::minimum> together, apart;
+            together.prepare(100);
+            apart.prepare(100);
+
+            std::vector<std::vector<double>> x, y;
+            for (int c = 0; c < 3; ++c) { x.push_back(randomSignal(1000)); }
+            y = x;
+            double* channels[] = { x[0].data(), x[1].data(), x[2].data() };
+            together.process(channels, 1000);
+            for (int c = 0; c < 3; ++c) { apart.process(y[static_cast<size_t>(c)].data(), 1000, c); }
+
+            for (size_t c = 0; c < 3; ++c)
+            {
+                for (size_t i = 0; i < x[c].size(); ++i) { expectWithinAbsoluteError(x[c][i], y[c][i], 1.0e-12); }
+            }
+        }
+        {
+            beginTest("wraps_biquad");
+            redsp::oversampled<redsp::biquad<double, double, 2>, 4> os;
+            os.inner.calc_lp(1000.0, 4 * 48000.0, 0.707);
+            os.inner.x = {};
+            os.inner.y = {};
+            os.prepare(32);
+            std::vector<double> x(512, 1.0);
+            os.process(x.data(), static_cast<int>(x.size()), 1);
+            expectWithinAbsoluteError(x.back(), 1.0, 1.0e-3);
+        }
+    }
+};
+
+#endif // REDSP_OVERSAMPLINGTESTS_HEADERGUARD
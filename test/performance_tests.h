@@ -0,0 +1,209 @@
+#ifndef REDSP_PERFORMANCETESTS_HEADERGUARD
+#define REDSP_PERFORMANCETESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <vector>
+#include "../bench/bench_harness.h"
+#include "../bench/compare_bench.h"
+#include "../bench/latency_bench.h"
+#include "../bench/processor_bench.h"
+
+#pragma once
+
+using namespace juce;
+
+/**
+ * Times the filters the way redsp_bench --suite does and fails on any that got significantly slower than a baseline,
+ * a result file from redsp_bench --suite --json or from an earlier run of this test with `record` set. Timings only
+ * mean something against a baseline from the same machine and build, so without one this only checks the comparison
+ * itself. The files default to the REDSP_PERF_BASELINE and REDSP_PERF_RECORD environment variables.
+ * The same filters' per-call latency is profiled too, and written to `latency` (REDSP_LATENCY_JSON) if it's set.
+ */
+struct PerformanceTest : public UnitTest
+{
+    PerformanceTest() : UnitTest("Performance", "Performance")
+    {
+        auto const fromEnvironment = [](char const* variable)
+        {
+            auto const path = SystemStats::getEnvironmentVariable(variable, {});
+            return path.isEmpty() ? File() : File::getCurrentWorkingDirectory().getChildFile(path);
+        };
+        baseline = fromEnvironment("REDSP_PERF_BASELINE");
+        record = fromEnvironment("REDSP_PERF_RECORD");
+        latency = fromEnvironment("REDSP_LATENCY_JSON");
+    }
+
+    File baseline, record, latency;
+    //! repetitions here are shorter than the suite's, so noisier; a regression must also show up on a second run
+    CompareBench::Settings settings { 3.0, 0.10 };
+
+private:
+    static BenchHarness::Result result(String const& name, double ns, double stddev, int repetitions = 15)
+    {
+        BenchHarness::Result r;
+        r.name = name;
+        r.type = "float";
+        r.block = 256;
+        r.channels = 2;
+        r.measurement.nsMedian = ns;
+        r.measurement.nsMean = ns;
+        r.measurement.nsMin = ns - stddev;
+        r.measurement.nsStdDev = stddev;
+        r.measurement.repetitions = repetitions;
+        return r;
+    }
+
+    //! the same benchmarks, block size and names as redsp_bench --suite --quick, so either can be the baseline
+    static std::vector<BenchHarness::Result> measure()
+    {
+        BenchHarness::Settings s;
+        s.repetitions = 9;
+        s.msPerRepetition = 2.0;
+        s.warmupMs = 10.0;
+        s.filter = "biquad/|svf/";
+
+        BenchHarness::Report report(s);
+        Random random(42);
+        std::vector<int> const blocks { 256 };
+        ProcessorBench::processors<float, 1>(report, blocks, random);
+        ProcessorBench::processors<float, 2>(report, blocks, random);
+        ProcessorBench::processors<float, 8>(report, blocks, random);
+        ProcessorBench::processors<double, 1>(report, blocks, random);
+        ProcessorBench::processors<double, 2>(report, blocks, random);
+        ProcessorBench::processors<double, 8>(report, blocks, random);
+        return report.results;
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("comparison");
+            std::vector<BenchHarness::Result> const before {
+                result("same", 1.0, 0.01), result("slower", 1.0, 0.01), result("noisy", 1.0, 0.5),
+                result("within_tolerance", 1.0, 0.001), result("faster", 2.0, 0.01), result("gone", 1.0, 0.01)
+            };
+            std::vector<BenchHarness::Result> const after {
+                result("same", 1.0, 0.01), result("slower", 2.0, 0.01), result("noisy", 1.3, 0.5),
+                result("within_tolerance", 1.03, 0.001), result("faster", 1.0, 0.01), result("new", 1.0, 0.01)
+            };
+            auto const summary = CompareBench::compare(before, after, CompareBench::Settings {});
+            expectEquals(summary.regressions, 1);
+            expectEquals(summary.improvements, 1);
+            expectEquals(summary.missing, 1);
+            expectEquals(summary.added, 1);
+            for (auto const& c : summary.comparisons)
+            {
+                if (c.verdict == CompareBench::Verdict::slower) { expect(c.key.startsWith("slower/"), c.key); }
+                if (c.verdict == CompareBench::Verdict::faster) { expect(c.key.startsWith("faster/"), c.key); }
+            }
+
+            // the noisy one gets through on 3 standard errors, but not on 1
+            auto const strict = CompareBench::compare(before[2], after[2], CompareBench::Settings { 1.0, 0.05 });
+            expect(strict.verdict == CompareBench::Verdict::slower);
+
+            // and the results survive the trip through a file
+            TemporaryFile temp(".json");
+            BenchHarness::Report report(BenchHarness::Settings {});
+            report.results = after;
+            expect(report.writeJson(temp.getFile()));
+            std::vector<BenchHarness::Result> read;
+            expect(BenchHarness::readJson(temp.getFile(), read));
+            expect(CompareBench::compare(after, read, CompareBench::Settings { 0.0, 0.0 }).regressions == 0);
+            expectEquals(static_cast<int>(read.size()), static_cast<int>(after.size()));
+            expect(! BenchHarness::readJson(File(), read));
+        }
+
+        {
+            beginTest("latency_histogram");
+            LatencyProfile::Histogram h;
+            for (std::uint64_t v = 1; v <= 10000; ++v) { h.record(v); }
+            expectEquals(static_cast<int>(h.count()), 10000);
+            expectEquals(static_cast<int>(h.min()), 1);
+            expectEquals(static_cast<int>(h.max()), 10000);
+            expectWithinAbsoluteError(h.mean(), 5000.5, 1.0e-9);
+            for (auto q : { 0.5, 0.9, 0.99, 0.999 })
+            {
+                // within a bucket, about 1 / 32, above the exact answer
+                auto const exact = q * 10000.0;
+                expect(static_cast<double>(h.percentile(q)) >= exact);
+                expect(static_cast<double>(h.percentile(q)) <= exact * (1.0 + 1.0 / 32.0), String(q));
+            }
+            expectEquals(static_cast<int>(h.percentile(1.0)), 10000);
+
+            // buckets tile the range without gaps
+            for (int i = 1; i < (64 - LatencyProfile::Histogram::sub_bits + 1) * LatencyProfile::Histogram::sub_count; ++i)
+            {
+                expect(LatencyProfile::Histogram::lower(i) == LatencyProfile::Histogram::upper(i - 1) + 1);
+                expectEquals(LatencyProfile::Histogram::index(LatencyProfile::Histogram::lower(i)), i);
+                expectEquals(LatencyProfile::Histogram::index(LatencyProfile::Histogram::upper(i)), i);
+            }
+        }
+
+        {
+            beginTest("latency");
+            LatencyProfile::Settings s;
+            s.calls = 400;
+            s.cold_calls = 32;
+            s.filter = "biquad|svf";
+            LatencyProfile profile(s);
+            LatencyBench::processors<float, 2>(profile, 256);
+            LatencyBench::processors<double, 2>(profile, 256);
+            expectEquals(static_cast<int>(profile.entries.size()), 6);
+            for (auto const& e : profile.entries)
+            {
+                expectEquals(static_cast<int>(e.warm.count()), s.calls);
+                expectEquals(static_cast<int>(e.cold.count()), s.cold_calls);
+                expect(e.warm.percentile(0.5) <= e.warm.percentile(0.99) && e.warm.percentile(0.99) <= e.warm.max());
+                if (e.denormals) { logMessage(e.name + "/" + e.type + ": denormals in the tail"); }
+            }
+            if (latency != File())
+            {
+                expect(profile.writeJson(latency), "couldn't write " + latency.getFullPathName());
+            }
+        }
+
+        {
+            beginTest("biquad_svf");
+            auto const current = measure();
+            expect(! current.empty());
+
+            if (record != File())
+            {
+                BenchHarness::Report report(BenchHarness::Settings {});
+                report.results = current;
+                expect(report.writeJson(record), "couldn't write " + record.getFullPathName());
+            }
+            if (baseline == File())
+            {
+                logMessage("no baseline (set REDSP_PERF_BASELINE, or pass --baseline=<file>), so the timings aren't checked");
+                return;
+            }
+
+            std::vector<BenchHarness::Result> before;
+            if (! BenchHarness::readJson(baseline, before))
+            {
+                expect(false, "couldn't read " + baseline.getFullPathName());
+                return;
+            }
+            auto const first = CompareBench::compare(before, current, settings);
+            CompareBench::print(first, false);
+            expect(first.added < static_cast<int>(current.size()), "nothing in the baseline matches these benchmarks");
+            if (first.regressions == 0) { return; }
+
+            // a second run, so one bad moment on a busy machine doesn't fail the build
+            auto const second = CompareBench::compare(before, measure(), settings);
+            for (auto const& c : first.comparisons)
+            {
+                if (c.verdict != CompareBench::Verdict::slower) { continue; }
+                auto const again = std::find_if(second.comparisons.begin(), second.comparisons.end(),
+                                                [&c](CompareBench::Comparison const& d) { return d.key == c.key; });
+                if (again == second.comparisons.end()) { continue; }
+                expect(again->verdict != CompareBench::Verdict::slower,
+                       c.key + " got slower: " + String(c.baseline, 3) + " -> " + String(c.current, 3) + " ns/sample, and "
+                       + String(again->current, 3) + " on a second run");
+            }
+        }
+    }
+};
+
+#endif // REDSP_PERFORMANCETESTS_HEADERGUARD
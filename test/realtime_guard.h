@@ -0,0 +1,242 @@
+#ifndef REDSP_REALTIMEGUARD_HEADERGUARD
+#define REDSP_REALTIMEGUARD_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#define REDSP_REALTIME_GUARD_HOOKS_LIBC 1
+#else
+#define REDSP_REALTIME_GUARD_HOOKS_LIBC 0
+#endif
+
+#pragma once
+
+/**
+ * Catches what an audio callback must not do: while a RealtimeGuard::Callback is alive, every allocation,
+ * deallocation and blocking lock on its thread is counted. Other threads, and the same thread outside the callback, go
+ * unnoticed, so processors can be prepared and results checked around it as usual.
+ * operator new and delete are replaced everywhere. With glibc, malloc, calloc, realloc and free are replaced too
+ * (forwarding to glibc's own), as are pthread_mutex_lock, the rwlock locks and the condition variable waits
+ * (forwarding through dlsym), which is where std::mutex and friends end up. pthread_mutex_trylock doesn't block, and
+ * is allowed.
+ * The replacements are definitions, not declarations, so include this from one translation unit only.
+ */
+struct RealtimeGuard
+{
+    struct Counts
+    {
+        size_t allocations = 0, deallocations = 0, locks = 0;
+
+        bool clean() const { return allocations == 0 && deallocations == 0 && locks == 0; }
+
+        juce::String describe() const
+        {
+            return juce::String(allocations) + " allocations, " + juce::String(deallocations) + " deallocations, "
+                   + juce::String(locks) + " blocking locks";
+        }
+    };
+
+    //! the scope of an audio callback on the calling thread. Callbacks nest; the counts are the outermost one's
+    struct Callback
+    {
+        Callback()
+        {
+            auto& s = state();
+            if (s.depth++ == 0) { s.counts = Counts {}; }
+        }
+
+        ~Callback() { --state().depth; }
+
+        Callback(Callback const&) = delete;
+        Callback& operator=(Callback const&) = delete;
+
+        //! what happened on this thread since the outermost callback began
+        Counts counts() const { return state().counts; }
+    };
+
+    //! whether malloc/free and the pthread locks are watched, besides operator new and delete
+    static constexpr bool hooksLibc = REDSP_REALTIME_GUARD_HOOKS_LIBC != 0;
+
+    //! runs `@param f` as an audio callback and returns what it did
+    template <typename F>
+    static Counts run(F&& f)
+    {
+        Callback callback;
+        f();
+        return callback.counts();
+    }
+
+    //! runs `@param f` as an audio callback, and fails `@param test` if it allocated, deallocated or locked
+    template <typename F>
+    static void expectSafe(juce::UnitTest& test, juce::String const& what, F&& f)
+    {
+        auto const counts = run(f);
+        test.expect(counts.clean(), what + " isn't realtime safe: " + counts.describe());
+    }
+
+    // called by the replacements
+    static void allocation() { if (state().depth > 0) { ++state().counts.allocations; } }
+    static void deallocation() { if (state().depth > 0) { ++state().counts.deallocations; } }
+    static void lock() { if (state().depth > 0) { ++state().counts.locks; } }
+
+private:
+    struct State
+    {
+        int depth;
+        Counts counts;
+    };
+
+    //! constant-initialized, so it's safe to touch from inside malloc
+    static State& state()
+    {
+        static thread_local State s {};
+        return s;
+    }
+};
+
+#if REDSP_REALTIME_GUARD_HOOKS_LIBC
+
+extern "C" {
+
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void __libc_free(void*);
+
+void* malloc(size_t size) noexcept
+{
+    RealtimeGuard::allocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    RealtimeGuard::allocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) noexcept
+{
+    RealtimeGuard::allocation();
+    return __libc_realloc(p, size);
+}
+
+void free(void* p) noexcept
+{
+    if (p != nullptr) { RealtimeGuard::deallocation(); }
+    __libc_free(p);
+}
+
+} // extern "C"
+
+namespace redsp_realtime_guard {
+
+//! the next definition of `@param name` after ours, looked up on first use. `@param cache` is constant-initialized, so
+//! this takes no lock (a static initialized from dlsym would, in a function that may be the lock)
+template <typename Function>
+Function next(std::atomic<Function>& cache, char const* name)
+{
+    auto f = cache.load(std::memory_order_relaxed);
+    if (f == nullptr)
+    {
+        f = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+        cache.store(f, std::memory_order_relaxed);
+    }
+    return f;
+}
+
+inline void* raw_malloc(size_t size) { return __libc_malloc(size); }
+inline void raw_free(void* p) { __libc_free(p); }
+
+} // namespace redsp_realtime_guard
+
+extern "C" {
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    static std::atomic<int (*)(pthread_mutex_t*)> resolved { nullptr };
+    auto const f = redsp_realtime_guard::next(resolved, "pthread_mutex_lock");
+    RealtimeGuard::lock();
+    return f(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+{
+    static std::atomic<int (*)(pthread_rwlock_t*)> resolved { nullptr };
+    auto const f = redsp_realtime_guard::next(resolved, "pthread_rwlock_rdlock");
+    RealtimeGuard::lock();
+    return f(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+{
+    static std::atomic<int (*)(pthread_rwlock_t*)> resolved { nullptr };
+    auto const f = redsp_realtime_guard::next(resolved, "pthread_rwlock_wrlock");
+    RealtimeGuard::lock();
+    return f(lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    static std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*)> resolved { nullptr };
+    auto const f = redsp_realtime_guard::next(resolved, "pthread_cond_wait");
+    RealtimeGuard::lock();
+    return f(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, timespec const* time)
+{
+    static std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*, timespec const*)> resolved { nullptr };
+    auto const f = redsp_realtime_guard::next(resolved, "pthread_cond_timedwait");
+    RealtimeGuard::lock();
+    return f(cond, mutex, time);
+}
+
+} // extern "C"
+
+#else
+
+namespace redsp_realtime_guard {
+
+inline void* raw_malloc(size_t size) { return std::malloc(size); }
+inline void raw_free(void* p) { std::free(p); }
+
+} // namespace redsp_realtime_guard
+
+#endif // REDSP_REALTIME_GUARD_HOOKS_LIBC
+
+void* operator new(size_t size)
+{
+    RealtimeGuard::allocation();
+    if (auto* p = redsp_realtime_guard::raw_malloc(size == 0 ? 1 : size)) { return p; }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    RealtimeGuard::allocation();
+    return redsp_realtime_guard::raw_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* p) noexcept
+{
+    if (p != nullptr) { RealtimeGuard::deallocation(); }
+    redsp_realtime_guard::raw_free(p);
+}
+
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { operator delete(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { operator delete(p); }
+
+#endif // REDSP_REALTIMEGUARD_HEADERGUARD
@@ -0,0 +1,301 @@
+#ifndef REDSP_REALTIMETESTS_HEADERGUARD
+#define REDSP_REALTIMETESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include "test_helpers.h"
+#include "realtime_guard.h"
+#include "../source/redsp.h"
+
+#pragma once
+
+using namespace juce;
+
+/**
+ * Every processor's audio-thread calls (process, and the setters a host automates) under a RealtimeGuard: none may
+ * allocate, free or block on a lock once prepared.
+ */
+struct RealtimeTest : public RedspTest
+{
+    RealtimeTest() : RedspTest("Realtime", "Realtime") { }
+
+private:
+    static constexpr int block = 64, blocks = 8;
+
+    template <typename T>
+    struct Planar
+    {
+        std::vector<std::vector<T>> data;
+        std::vector<T*> pointers;
+
+        Planar(int channels, int length, Random& random)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                std::vector<T> x(static_cast<size_t>(length));
+                for (auto& v : x) { v = static_cast<T>(random.nextDouble() - 0.5); }
+                data.push_back(x);
+            }
+            for (auto& d : data) { pointers.push_back(d.data()); }
+        }
+
+        T** io() { return pointers.data(); }
+        T const* const* in() const { return const_cast<T const* const*>(pointers.data()); }
+        T* operator[](size_t c) { return data[c].data(); }
+    };
+
+    struct TanhShape { template <typename T> T operator()(T x) const { return redsp::math::tanh_fast(x); } };
+    struct HardClip { double operator()(double x) const { return redsp::math::clip(-1.0, 1.0, x); } };
+    struct HardClipAd1 { double operator()(double x) const { return std::abs(x) <= 1.0 ? 0.5 * x * x : std::abs(x) - 0.5; } };
+    struct Spectral { void operator()(double* re, double* im, int bins, int) { for (int k = bins / 2; k < bins; ++k) { re[k] = im[k] = 0; } } };
+
+    //! runs `@param f` `blocks` times as an audio callback and fails if any of them wasn't realtime safe
+    template <typename F>
+    void expectSafe(String const& what, F&& f)
+    {
+        RealtimeGuard::expectSafe(*this, what, [&f] { for (int b = 0; b < blocks; ++b) { f(); } });
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("guard");
+            // explicit calls, which unlike new expressions the compiler mayn't elide
+            auto counts = RealtimeGuard::run([] { ::operator delete(::operator new(16)); });
+            expectEquals(static_cast<int>(counts.allocations), 1);
+            expectEquals(static_cast<int>(counts.deallocations), 1);
+
+            std::vector<int> outside(16);
+            expect(RealtimeGuard::run([] { }).clean());
+
+            if (RealtimeGuard::hooksLibc)
+            {
+                void* (*volatile allocate)(size_t) = std::malloc;
+                void (*volatile release)(void*) = std::free;
+                counts = RealtimeGuard::run([&] { release(allocate(16)); });
+                expectEquals(static_cast<int>(counts.allocations), 1);
+                expectEquals(static_cast<int>(counts.deallocations), 1);
+
+                std::mutex mutex;
+                expectEquals(static_cast<int>(RealtimeGuard::run([&] { mutex.lock(); mutex.unlock(); }).locks), 1);
+                expect(RealtimeGuard::run([&] { if (mutex.try_lock()) { mutex.unlock(); } }).clean());
+            }
+        }
+
+        {
+            beginTest("biquad");
+            Planar<double> x(2, block, random), y(2, block, random);
+            redsp::biquad<double, double, 2> f;
+            f.reset();
+            expectSafe("biquad", [&] {
+                f.calc_lp(0.1, 0.7);
+                f.process(x.io(), block);
+                f.process_optimized(x.io(), block);
+                f.process_optimized(x.io(), y.io(), block);
+            });
+        }
+
+        {
+            beginTest("svf");
+            using svf_type = redsp::svf<double, 2, double>;
+            Planar<double> x(2, block, random);
+            svf_type f(48000.0);
+            expectSafe("svf", [&] {
+                f.calc_unsafe(1000.0, 0.7);
+                f.process<svf_type::SVFType::Lowpass>(x.io(), block);
+                f.process<svf_type::SVFType::Highpass>(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("fir");
+            Planar<double> x(2, block, random), y(1, block * 4, random);
+            auto const h = redsp::kaiser_lowpass<double>(32, 0.2);
+            redsp::fir<double, 32, 2> fixed;
+            redsp::fir<double, 0, 2> runtime;
+            runtime.set_coefficients(h);
+            redsp::fir_decimator<double, 2> decimator;
+            decimator.set_coefficients(h);
+            redsp::fir_interpolator<double, 4> interpolator;
+            interpolator.set_coefficients(h);
+            expectSafe("fir", [&] {
+                fixed.set_coefficients(h);
+                fixed.process(x.io(), block);
+                runtime.process(x.io(), block);
+                decimator.process(x[0], y[0], block);
+                interpolator.process(x[1], y[0], block);
+            });
+        }
+
+        {
+            beginTest("ladder");
+            Planar<double> x(2, block, random), frames(1, block * 4, random);
+            redsp::ladder<double, 2> f;
+            redsp::ladder_voices<double, 4> voices;
+            expectSafe("ladder", [&] {
+                f.set_cutoff(0.05);
+                f.set_resonance(0.5);
+                f.process(x.io(), block);
+                voices.set_cutoff(1, 0.1);
+                voices.process(frames[0], block);
+            });
+        }
+
+        {
+            beginTest("integrators");
+            Planar<double> x(2, block, random);
+            redsp::tpt_one_pole<double, 2> one_pole;
+            redsp::leaky_integrator<double, 2> leaky;
+            redsp::dc_blocker<double, 2> blocker;
+            redsp::filter_chain<redsp::dc_blocker<double, 2>, redsp::biquad<double, double, 2>> chain;
+            chain.get<1>().calc_lp(0.1, 0.7);
+            expectSafe("integrators", [&] {
+                one_pole.set_cutoff(0.01);
+                one_pole.process(x.io(), block);
+                leaky.set_time_constant(0.1, 48000.0);
+                leaky.process(x.io(), block);
+                blocker.process(x.io(), block);
+                chain.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("delay_line");
+            Planar<double> x(2, block, random);
+            redsp::delay_line<double, redsp::delay_interpolation::lagrange3, 2> line;
+            line.prepare(1000, block);
+            expectSafe("delay_line", [&] {
+                line.set_delay(500.5);
+                line.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("fdn_reverb");
+            Planar<double> x(2, block, random);
+            redsp::fdn_reverb<double> reverb;
+            reverb.prepare(48000.0, block);
+            expectSafe("fdn_reverb", [&] {
+                reverb.set_decay(2.0);
+                reverb.set_damping(5000.0);
+                reverb.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("dynamics");
+            Planar<double> x(2, block, random);
+            redsp::envelope_follower<double, 2> follower;
+            redsp::compressor<double, 2> comp;
+            comp.prepare(48000.0, block, 0.005);
+            expectSafe("dynamics", [&] {
+                follower.set_times(0.001, 0.1, 48000.0);
+                follower.process(x.io(), block);
+                comp.set_threshold(-20.0);
+                comp.set_lookahead(0.002);
+                comp.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("metering");
+            Planar<float> x(2, block, random);
+            redsp::loudness_meter<float, 2> loudness;
+            redsp::true_peak_meter<float, 2> peak;
+            redsp::metering_engine<float, 2> engine;
+            engine.prepare(48000.0, block);
+            expectSafe("metering", [&] {
+                loudness.process(x.in(), block);
+                peak.process(x.in(), block);
+                engine.push(x.in(), block);
+            });
+            expectSafe("metering_engine::update", [&] { engine.update(); });
+        }
+
+        {
+            beginTest("nonlinear");
+            Planar<double> x(2, block, random);
+            redsp::waveshaper<double, TanhShape, 2> shaper;
+            redsp::table_waveshaper<double> table;
+            table.prepare([](double v) { return std::tanh(v); }, -4.0, 4.0);
+            redsp::adaa<double, HardClip, HardClipAd1, redsp::no_antiderivative, 2> antialiased;
+            expectSafe("nonlinear", [&] {
+                shaper.process(x.io(), block);
+                table.process(x[0], block);
+                antialiased.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("oversampled");
+            Planar<double> x(2, block, random);
+            redsp::oversampled<redsp::waveshaper<double, TanhShape, 2>, 4> linear;
+            linear.prepare(block);
+            redsp::oversampled<redsp::waveshaper<double, TanhShape, 2>, 4, redsp::oversampling_phase::minimum> minimum;
+            minimum.prepare(block);
+            expectSafe("oversampled", [&] {
+                linear.process(x.io(), block);
+                minimum.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("resampler");
+            Planar<double> x(1, block, random), y(1, block * 2, random);
+            redsp::resampler<double> r;
+            r.prepare(48000.0, 44100.0, block);
+            expectSafe("resampler", [&] {
+                r.process(x[0], block, y[0], block * 2);
+                r.set_ratio(48000.0, 44000.0);
+            });
+        }
+
+        {
+            beginTest("fft");
+            std::vector<double> re(256), im(256), out_re(256), out_im(256);
+            for (auto& v : re) { v = random.nextDouble(); }
+            redsp::fft<double> f(8);
+            Planar<double> x(2, block, random);
+            auto s = redsp::make_stft<double, 2>(Spectral {});
+            s.prepare(8, 256, 64);
+            expectSafe("fft", [&] {
+                f.forward(re.data(), im.data(), out_re.data(), out_im.data());
+                f.inverse(out_re.data(), out_im.data(), re.data(), im.data());
+                f.forward_real(re.data(), out_re.data(), out_im.data());
+                f.inverse_real(out_re.data(), out_im.data(), re.data());
+                s.process(x.io(), block);
+            });
+        }
+
+        {
+            beginTest("convolution");
+            Planar<double> x(1, block, random), ir(1, 20000, random);
+            redsp::uniform_convolver<double> uniform;
+            uniform.prepare(ir[0], 4096, block);
+            redsp::nonuniform_convolver<double> inline_tails, threaded;
+            inline_tails.prepare(ir[0], 20000, block, false);
+            threaded.prepare(ir[0], 20000, block, true);
+            expectSafe("convolution", [&] {
+                uniform.process(x[0], block);
+                inline_tails.process(x[0], block);
+                threaded.process(x[0], block);
+            });
+
+            // the threaded segments hand off once every 16 blocks, so run two of their blocks in one callback: one
+            // handoff submits a job and the next collects it
+            auto const segment = redsp::nonuniform_convolver<double>::growth * threaded.block_size();
+            expect(threaded.tail_segments() > 0 && inline_tails.tail_segments() > 0);
+            RealtimeGuard::expectSafe(*this, "convolution handoff", [&] {
+                for (int done = 0; done <= 2 * segment; done += block)
+                {
+                    inline_tails.process(x[0], block);
+                    threaded.process(x[0], block);
+                }
+            });
+        }
+    }
+};
+
+#endif // REDSP_REALTIMETESTS_HEADERGUARD
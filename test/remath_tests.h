@@ -0,0 +1,266 @@
+#ifndef REDSP_REMATHTESTS_HEADERGUARD
+#define REDSP_REMATHTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "../source/internal/remath.h"
+
+#pragma once
+
+using namespace juce;
+
+/**
+ * Measures every tier of every remath function against a long double reference over the domain it's meant for, in ULPs
+ * (of the type under test), absolute and relative error, and fails if one exceeds its budget. The domains and budgets
+ * below are the documented contract of each function; the measured errors are logged, so the fastest tier that meets
+ * an error budget can be picked from the table.
+ * Inputs are spread evenly over the representable values of the domain rather than over the reals, so small magnitudes
+ * get as many as large ones. Set REDSP_REMATH_EXHAUSTIVE to try every float in each float domain instead (slow).
+ */
+struct RemathTest : public UnitTest
+{
+    RemathTest() : UnitTest("Remath", "Math") { }
+
+private:
+    //! the most error allowed; 0 leaves that measure unchecked
+    struct Budget
+    {
+        double ulps, absolute, relative;
+    };
+
+    struct Error
+    {
+        double ulps = 0, absolute = 0, relative = 0;
+        long double worst = 0;
+        std::uint64_t samples = 0;
+    };
+
+    //! a key that orders the values of T as integers, so stepping it by 1 steps to the next representable value
+    template <typename T>
+    static std::int64_t key(T x)
+    {
+        using bits_type = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+        bits_type bits;
+        std::memcpy(&bits, &x, sizeof(T));
+        auto const sign = bits_type(1) << (8 * sizeof(T) - 1);
+        auto const magnitude = static_cast<std::int64_t>(bits & ~sign);
+        return (bits & sign) != 0 ? -magnitude : magnitude;
+    }
+
+    template <typename T>
+    static T fromKey(std::int64_t k)
+    {
+        using bits_type = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+        auto const sign = bits_type(1) << (8 * sizeof(T) - 1);
+        auto const bits = k < 0 ? (static_cast<bits_type>(-k) | sign) : static_cast<bits_type>(k);
+        T x;
+        std::memcpy(&x, &bits, sizeof(T));
+        return x;
+    }
+
+    //! the spacing of T's values around `@param r`
+    template <typename T>
+    static long double ulp(long double r)
+    {
+        auto const e = std::max(std::ilogb(std::fabs(r)), std::numeric_limits<T>::min_exponent - 1);
+        return std::ldexp(1.0L, e - std::numeric_limits<T>::digits + 1);
+    }
+
+    //! whether long double has enough more precision than T to measure its ULPs
+    template <typename T>
+    static constexpr bool referenceIsFiner() { return std::numeric_limits<long double>::digits >= std::numeric_limits<T>::digits + 8; }
+
+    /**
+     * The worst errors of `@param f` against `@param reference` over about `@param samples` values of T spread evenly
+     * over [`@param lo`, `@param hi`], or every value if `@param samples` is 0.
+     */
+    template <typename T, typename F, typename R>
+    static Error measure(F&& f, R&& reference, T lo, T hi, std::uint64_t samples)
+    {
+        Error error;
+        auto const first = key(lo), last = key(hi);
+        auto const count = static_cast<std::uint64_t>(last - first) + 1;
+        auto const stride = static_cast<std::int64_t>(samples == 0 ? 1 : std::max<std::uint64_t>(1, count / samples));
+        for (auto k = first;; k = k + stride > last && k != last ? last : k + stride)
+        {
+            auto const x = fromKey<T>(k);
+            auto const r = reference(static_cast<long double>(x));
+            auto const y = static_cast<long double>(f(x));
+            if (std::isfinite(r))
+            {
+                auto const absolute = std::fabs(y - r);
+                auto const relative = absolute / std::max(std::fabs(r), static_cast<long double>(std::numeric_limits<T>::min()));
+                auto const ulps = absolute / ulp<T>(r);
+                if (ulps > error.ulps) { error.worst = x; }
+                error.ulps = std::max(error.ulps, static_cast<double>(ulps));
+                error.absolute = std::max(error.absolute, static_cast<double>(absolute));
+                error.relative = std::max(error.relative, static_cast<double>(relative));
+                ++error.samples;
+            }
+            if (k == last) { break; }
+        }
+        return error;
+    }
+
+    template <typename T>
+    static char const* typeName() { return std::is_same<T, float>::value ? "float" : "double"; }
+
+    template <typename T, typename F, typename R>
+    void check(String const& function, F&& f, R&& reference, T lo, T hi, Budget budget)
+    {
+        auto const exhaustive = std::is_same<T, float>::value && std::getenv("REDSP_REMATH_EXHAUSTIVE") != nullptr;
+        auto const e = measure<T>(f, reference, lo, hi, exhaustive ? 0 : 200000);
+        auto const what = function + "<" + typeName<T>() + "> on [" + String(static_cast<double>(lo)) + ", "
+                          + String(static_cast<double>(hi)) + "]";
+        logMessage(what.paddedRight(' ', 48) + String(e.ulps, 2).paddedLeft(' ', 12) + " ulp "
+                   + String(e.absolute, 3, true).paddedLeft(' ', 11) + " abs " + String(e.relative, 3, true).paddedLeft(' ', 11)
+                   + " rel, worst at " + String(static_cast<double>(e.worst), 10));
+
+        expect(e.samples > 0, what + ": nothing to measure");
+        if (budget.ulps > 0 && referenceIsFiner<T>())
+        {
+            expect(e.ulps <= budget.ulps, what + ": " + String(e.ulps) + " ulps, over " + String(budget.ulps));
+        }
+        if (budget.absolute > 0) { expect(e.absolute <= budget.absolute, what + ": absolute error " + String(e.absolute) + ", over " + String(budget.absolute)); }
+        if (budget.relative > 0) { expect(e.relative <= budget.relative, what + ": relative error " + String(e.relative) + ", over " + String(budget.relative)); }
+    }
+
+    //! I0 by its power series, in long double and to convergence
+    static long double besselI0(long double x)
+    {
+        long double sum = 1, term = 1;
+        for (int i = 1; i < 500 && term > std::numeric_limits<long double>::epsilon() * sum; ++i)
+        {
+            auto const t = x / (2.0L * i);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    /**
+     * Each function's contract: the domain it's meant for, and the error it's allowed there. The library tiers are
+     * held to a couple of ULPs; the approximations to what their comments promise.
+     */
+    template <typename T>
+    void functions()
+    {
+        using m = redsp::math;
+        auto const sinl = [](long double x) { return std::sin(x); };
+        auto const cosl = [](long double x) { return std::cos(x); };
+        auto const tanl = [](long double x) { return std::tan(x); };
+        auto const tanhl = [](long double x) { return std::tanh(x); };
+        auto const twopi = T(6.283185307179586);
+        Budget const library { 2, 0, 0 };
+
+        // sin and cos: any argument, though a long way from 0 the library's range reduction sets the cost
+        check<T>("sin", [](T x) { return m::sin(x); }, sinl, -twopi, twopi, library);
+        check<T>("sin_fast", [](T x) { return m::sin_fast(x); }, sinl, -twopi, twopi, library);
+        check<T>("sin_faster", [](T x) { return m::sin_faster(x); }, sinl, -twopi, twopi, library);
+        check<T>("cos", [](T x) { return m::cos(x); }, cosl, -twopi, twopi, library);
+        check<T>("cos_fast", [](T x) { return m::cos_fast(x); }, cosl, -twopi, twopi, library);
+        check<T>("cos_faster", [](T x) { return m::cos_faster(x); }, cosl, -twopi, twopi, library);
+
+        // tan: up to just short of pi/2, which is where tan(pi f) takes a cutoff f of 0.46 fs (fast) or 0.32 fs (faster)
+        check<T>("tan", [](T x) { return m::tan(x); }, tanl, T(-1.5), T(1.5), library);
+        check<T>("tan_fast", [](T x) { return m::tan_fast(x); }, tanl, T(-1.45), T(1.45), { 0, 0, 5.0e-5 });
+        check<T>("tan_faster", [](T x) { return m::tan_faster(x); }, tanl, T(-1), T(1), { 0, 0, 1.2e-3 });
+
+        // tanh: everywhere; beyond +-20 it's 1 to within any type here
+        check<T>("tanh", [](T x) { return m::tanh(x); }, tanhl, T(-20), T(20), { 3, 0, 0 });
+        check<T>("tanh_fast", [](T x) { return m::tanh_fast(x); }, tanhl, T(-20), T(20), { 0, 0.024, 0 });
+        check<T>("tanh_faster", [](T x) { return m::tanh_faster(x); }, tanhl, T(-20), T(20), { 0, 0.12, 0 });
+
+        // log2 and 2^x: the normal floats, which is all they handle even for double
+        check<T>("log_fast", [](T x) { return m::log_fast(x); }, [](long double x) { return std::log2(x); },
+                 static_cast<T>(std::numeric_limits<float>::min()), static_cast<T>(std::numeric_limits<float>::max()), { 0, 2.0e-4, 0 });
+        check<T>("exp2_fast", [](T x) { return m::exp2_fast(x); }, [](long double x) { return std::exp2(x); },
+                 T(-126), T(127), { 0, 0, 1.0e-4 });
+
+        // the compile time versions: correctly rounded or nearly, for both types, where coefficients get designed
+        check<T>("sin_constexpr", [](T x) { return m::sin_constexpr(x); }, sinl, T(-1.0e6), T(1.0e6), { 1, 0, 0 });
+        check<T>("cos_constexpr", [](T x) { return m::cos_constexpr(x); }, cosl, T(-1.0e6), T(1.0e6), { 1, 0, 0 });
+        check<T>("tan_constexpr", [](T x) { return m::tan_constexpr(x); }, tanl, T(-1.5), T(1.5), { 1, 0, 0 });
+        check<T>("exp_constexpr", [](T x) { return m::exp_constexpr(x); }, [](long double x) { return std::exp(x); },
+                 std::is_same<T, float>::value ? T(-87) : T(-708), std::is_same<T, float>::value ? T(88) : T(709), { 1, 0, 0 });
+
+        // I0: the range Kaiser windows use (beta up to 50)
+        check<T>("bessel_i0", [](T x) { return m::bessel_i0(x); }, besselI0, T(0), T(50),
+                 { std::is_same<T, float>::value ? 1.0 : 0, 0, std::is_same<T, float>::value ? 0 : 1.0e-12 });
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("sampling");
+            // the keys step through every representable value, across zero and from sign to sign
+            expect(key(0.0f) == key(-0.0f));
+            expect(key(std::nextafter(0.0f, 1.0f)) == key(0.0f) + 1);
+            expect(key(std::nextafter(1.0, 2.0)) == key(1.0) + 1);
+            expect(key(-1.0f) < key(-0.5f) && key(-0.5f) < key(0.5f));
+            expectEquals(fromKey<float>(key(-3.25f)), -3.25f);
+            expectEquals(fromKey<double>(key(1.0e-300)), 1.0e-300);
+            expect(ulp<float>(1.0L) == static_cast<long double>(std::numeric_limits<float>::epsilon()));
+            expect(ulp<double>(1.5L) == static_cast<long double>(std::numeric_limits<double>::epsilon()));
+            expect(ulp<float>(0.0L) == static_cast<long double>(std::numeric_limits<float>::denorm_min()));
+
+            // every float in [1, 2) is 2^23 of them; a sampled run includes both ends
+            auto const all = measure<float>([](float x) { return x; }, [](long double x) { return x; }, 1.0f, 2.0f, 0);
+            expectEquals(static_cast<int>(all.samples), (1 << 23) + 1);
+            auto const some = measure<float>([](float x) { return x; }, [](long double x) { return x; }, 1.0f, 2.0f, 1000);
+            expect(some.samples >= 1000 && some.samples <= 1002);
+            // and an error of one step is one ulp
+            auto const off = measure<float>([](float x) { return std::nextafter(x, 3.0f); }, [](long double x) { return x; }, 1.0f, 1.5f, 100);
+            expectEquals(off.ulps, 1.0);
+        }
+
+        {
+            beginTest("constexpr");
+            // these have to be constant expressions to compile at all
+            static constexpr double values[] = {
+                redsp::math::sin_constexpr(0.5), redsp::math::cos_constexpr(-2.0), redsp::math::tan_constexpr(1.0),
+                redsp::math::exp_constexpr(-3.0), redsp::math::e<double>()
+            };
+            expectWithinAbsoluteError(values[0], std::sin(0.5), 1.0e-16);
+            expectWithinAbsoluteError(values[1], std::cos(-2.0), 1.0e-16);
+            expectWithinAbsoluteError(values[2], std::tan(1.0), 1.0e-15);
+            expectWithinAbsoluteError(values[3], std::exp(-3.0), 1.0e-17);
+            expectEquals(values[4], std::exp(1.0));
+            expectEquals(redsp::math::exp_constexpr(1000.0), std::numeric_limits<double>::infinity());
+            expectEquals(redsp::math::exp_constexpr(-1000.0), 0.0);
+            expectEquals(redsp::math::exp_constexpr(0.0f), 1.0f);
+        }
+
+        {
+            beginTest("constants");
+            // the nearest float and double to pi, and twice and half that
+            expectEquals(redsp::math::pi<float>(), 3.14159274101257324f);
+            expectEquals(redsp::math::pi<double>(), 3.141592653589793116);
+            expectEquals(redsp::math::twopi<double>(), 6.283185307179586232);
+            expectEquals(redsp::math::halfpi<float>(), 1.57079637050628662f);
+            expect(std::abs(redsp::math::pi<long double>() - std::acos(-1.0L)) <= std::numeric_limits<long double>::epsilon() * 2);
+            expectEquals(redsp::math::e<float>(), 2.71828174591064453f);
+        }
+
+        if (! referenceIsFiner<double>())
+        {
+            logMessage("long double is no finer than double here, so double ULPs go unchecked");
+        }
+
+        {
+            beginTest("float");
+            functions<float>();
+        }
+
+        {
+            beginTest("double");
+            functions<double>();
+        }
+    }
+};
+
+#endif // REDSP_REMATHTESTS_HEADERGUARD
@@ -0,0 +1,278 @@
+#ifndef REDSP_RENDERTESTS_HEADERGUARD
+#define REDSP_RENDERTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+#include "../render/render_chain.h"
+#include "../render/render_io.h"
+#include "../render/renderer.h"
+#include "../render/batch_renderer.h"
+
+#pragma once
+
+using namespace juce;
+
+struct RenderTest : public RedspTest
+{
+    RenderTest() : RedspTest("Render", "Render") { }
+
+private:
+    std::vector<std::vector<float>> noise(int channels, int frames)
+    {
+        std::vector<std::vector<float>> x(static_cast<size_t>(channels), std::vector<float>(static_cast<size_t>(frames)));
+        for (auto& c : x) { for (auto& v : c) { v = static_cast<float>(1.8 * random.nextDouble() - 0.9); } }
+        return x;
+    }
+
+    static std::vector<float*> pointers(std::vector<std::vector<float>>& x)
+    {
+        std::vector<float*> p;
+        for (auto& c : x) { p.push_back(c.data()); }
+        return p;
+    }
+
+    //! a file of `@param frames` frames of noise in `@param format`, as WAV or not
+    void writeNoise(File const& f, RenderFormat const& format, int frames, bool wav)
+    {
+        auto x = noise(format.channels, frames);
+        auto px = pointers(x);
+        StreamSink sink;
+        expect(sink.open(f, format, wav, frames), sink.error);
+        expect(sink.write(px.data(), frames), sink.error);
+        expect(sink.close(), sink.error);
+    }
+
+    void runTest() override
+    {
+        TemporaryFile temporary(".wav");
+        auto const file = temporary.getFile();
+
+        {
+            beginTest("round trip");
+            int const channels = 3, frames = 5000;
+            auto x = noise(channels, frames);
+            auto px = pointers(x);
+            for (auto encoding : { RenderFormat::Encoding::int16, RenderFormat::Encoding::int24, RenderFormat::Encoding::int32,
+                                   RenderFormat::Encoding::float32, RenderFormat::Encoding::float64 })
+            {
+                for (auto wav : { true, false })
+                {
+                    RenderFormat format;
+                    format.encoding = encoding;
+                    format.channels = channels;
+                    format.sampleRate = 44100.0;
+                    auto const what = String(RenderFormat::name(encoding)) + (wav ? " wav" : " raw");
+
+                    StreamSink sink;
+                    expect(sink.open(file, format, wav, 777), sink.error);
+                    for (int done = 0; done < frames; done += 1000)
+                    {
+                        float const* block[channels] = { px[0] + done, px[1] + done, px[2] + done };
+                        expect(sink.write(block, std::min(1000, frames - done)), sink.error);
+                    }
+                    expect(sink.close(), sink.error);
+
+                    MappedSource source;
+                    // a window smaller than a page, and not a whole number of reads, so it slides often and unaligned
+                    source.windowBytes = 1000;
+                    expect(wav ? source.openWav(file) : source.openRaw(file, format), source.error);
+                    expectEquals(static_cast<int>(source.lengthInFrames()), frames, what);
+                    expect(source.getFormat().encoding == encoding, what);
+                    expectEquals(source.getFormat().channels, channels, what);
+                    expectEquals(source.getFormat().sampleRate, 44100.0, what);
+
+                    auto y = noise(channels, frames + 10);
+                    auto py = pointers(y);
+                    int read = 0;
+                    for (int n; (n = source.read(py.data(), 333)) > 0; read += n)
+                    {
+                        for (auto& p : py) { p += n; }
+                    }
+                    expectEquals(read, frames, what);
+
+                    auto const tolerance = format.isFloat() ? 0.0f : 0.5f / static_cast<float>(1 << (8 * format.bytesPerSample() - 1)) + 1.0e-7f;
+                    float worst = 0;
+                    for (size_t c = 0; c < channels; ++c)
+                    {
+                        for (size_t i = 0; i < frames; ++i) { worst = std::max(worst, std::abs(x[c][i] - y[c][i])); }
+                    }
+                    expectLessOrEqual(worst, tolerance, what);
+                }
+            }
+        }
+
+        {
+            beginTest("chain");
+            RenderChain chain;
+            expect(chain.parse("biquad:hp:30, svf:lp:4000:2,gain:-6", 48000.0, 2), chain.error);
+            expectEquals(static_cast<int>(chain.channels[1].stages.size()), 3);
+            expect(chain.parse("", 48000.0, 2));
+            expect(! chain.parse("biquad:lp:30000", 48000.0, 2));
+            expect(! chain.parse("biquad:xx:1000", 48000.0, 2));
+            expect(! chain.parse("svf:lp:12000:0.7", 48000.0, 2), "an unstable svf");
+            expect(! chain.parse("gain:loud", 48000.0, 2));
+            expect(! chain.parse("ladder:lp:1000", 48000.0, 2));
+
+            // each channel has a filter of its own, matching one run directly
+            expect(chain.parse("biquad:lp:1000:0.5,gain:6", 48000.0, 2), chain.error);
+            auto x = noise(2, 4096);
+            auto expected = x;
+            redsp::biquad<float, double> direct[2];
+            for (size_t c = 0; c < 2; ++c)
+            {
+                direct[c].calc_lp(1000.0, 48000.0, 0.5);
+                direct[c].reset();
+            }
+            auto px = pointers(x);
+            for (int done = 0; done < 4096; done += 512)
+            {
+                float* block[2] = { px[0] + done, px[1] + done };
+                chain.process(block, 512);
+            }
+            auto const g = static_cast<float>(std::pow(10.0, 6.0 / 20.0));
+            for (size_t c = 0; c < 2; ++c)
+            {
+                direct[c].process_optimized(expected[c].data(), 4096);
+                for (size_t i = 0; i < 4096; ++i) { expectWithinAbsoluteError(x[c][i], g * expected[c][i], 1.0e-6f); }
+            }
+        }
+
+        {
+            beginTest("renderer");
+            RenderFormat format;
+            format.channels = 2;
+            auto x = noise(2, 10000);
+            auto px = pointers(x);
+            TemporaryFile input(".raw");
+            StreamSink write;
+            expect(write.open(input.getFile(), format, false, 10000));
+            expect(write.write(px.data(), 10000));
+            expect(write.close());
+
+            MappedSource source;
+            source.windowBytes = 4096;
+            expect(source.openRaw(input.getFile(), format));
+            RenderChain chain;
+            expect(chain.parse("gain:-6.0206", format.sampleRate, format.channels));
+            StreamSink sink;
+            expect(sink.open(file, format, true, 100));
+            Renderer::Stats stats;
+            String error;
+            expect(Renderer::render(source, chain, sink, 100, stats, error), error);
+            expect(sink.close());
+            expectEquals(static_cast<int>(stats.frames), 10000);
+            expectWithinAbsoluteError(stats.seconds(), 10000.0 / 48000.0, 1.0e-12);
+
+            MappedSource output;
+            expect(output.openWav(file), output.error);
+            auto y = noise(2, 10000);
+            auto py = pointers(y);
+            expectEquals(output.read(py.data(), 20000), 10000);
+            for (size_t c = 0; c < 2; ++c)
+            {
+                for (size_t i = 0; i < 10000; ++i) { expectWithinAbsoluteError(y[c][i], 0.5f * x[c][i], 1.0e-6f); }
+            }
+        }
+
+        {
+            beginTest("pool");
+            RenderPool pool(3, 16);
+            expectEquals(static_cast<int>(pool.slots()), 3);
+            expectEquals(static_cast<int>(pool.floatsPerSlot()), 16);
+            std::atomic<int> inUse { 0 }, most { 0 };
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 8; ++t)
+            {
+                threads.emplace_back([&]
+                {
+                    for (int i = 0; i < 200; ++i)
+                    {
+                        auto lease = pool.acquire();
+                        auto const now = ++inUse;
+                        for (auto m = most.load(); now > m && ! most.compare_exchange_weak(m, now);) { }
+                        lease.data()[0] = static_cast<float>(i);
+                        --inUse;
+                    }
+                });
+            }
+            for (auto& t : threads) { t.join(); }
+            expectLessOrEqual(most.load(), 3);
+            expectLessOrEqual(static_cast<int>(pool.peakInUse()), 3);
+        }
+
+        {
+            beginTest("batch");
+            auto const root = File::getSpecialLocation(File::tempDirectory).getNonexistentChildFile("redsp_batch", "");
+            auto const inputs = root.getChildFile("in"), outputs = root.getChildFile("out");
+            expect(inputs.createDirectory() && outputs.createDirectory());
+            TemporaryFile expected;
+            BatchRenderer::Settings settings;
+            settings.chain = "biquad:hp:40,svf:lp:3000:1.5,gain:-2";
+            settings.threads = 4;
+            settings.block = 64;
+            settings.encoding = RenderFormat::Encoding::int24;
+            settings.raw.channels = 3;
+            // a slot of three 4KiB buffers, so the files take many windows each and every task waits its turn
+            settings.windowBytes = 4096;
+            settings.memoryBytes = 3 * 4096;
+
+            juce::Array<File> files;
+            for (int i = 0; i < 6; ++i)
+            {
+                RenderFormat format;
+                format.channels = 1 + i % 3;
+                format.encoding = i % 2 ? RenderFormat::Encoding::int16 : RenderFormat::Encoding::float32;
+                auto const wav = i != 5;
+                if (! wav) { format = settings.raw; }
+                auto const f = inputs.getChildFile("file" + String(i) + (wav ? ".wav" : ".raw"));
+                writeNoise(f, format, 3000 + 517 * i, wav);
+                files.add(f);
+            }
+            files.add(inputs.getChildFile("missing.wav"));
+
+            auto const summary = BatchRenderer::render(files, outputs, settings);
+            expectEquals(static_cast<int>(summary.items.size()), 7);
+            expectEquals(summary.failures, 1);
+            expect(! summary.items.back().ok());
+            expectEquals(static_cast<int>(summary.slots), 1);
+            expectEquals(static_cast<int>(summary.peakSlots), 1);
+
+            // every file matches rendering it on its own
+            for (size_t i = 0; i + 1 < summary.items.size(); ++i)
+            {
+                auto const& item = summary.items[i];
+                expect(item.ok(), item.error);
+                auto const wav = BatchRenderer::isWav(item.input);
+                MappedSource source, batched, single;
+                expect(wav ? source.openWav(item.input) : source.openRaw(item.input, settings.raw));
+                auto format = source.getFormat();
+                format.encoding = settings.encoding;
+                RenderChain chain;
+                expect(chain.parse(settings.chain, format.sampleRate, format.channels));
+                StreamSink sink;
+                expect(sink.open(expected.getFile(), format, wav, settings.block));
+                Renderer::Stats stats;
+                String error;
+                expect(Renderer::render(source, chain, sink, settings.block, stats, error), error);
+                expect(sink.close());
+                expectEquals(static_cast<int>(item.stats.frames), static_cast<int>(stats.frames));
+
+                expect(wav ? batched.openWav(item.output) : batched.openRaw(item.output, format), batched.error);
+                expect(wav ? single.openWav(expected.getFile()) : single.openRaw(expected.getFile(), format));
+                expectEquals(static_cast<int>(batched.lengthInFrames()), static_cast<int>(stats.frames));
+                expect(batched.getFormat().encoding == settings.encoding);
+                auto a = noise(format.channels, static_cast<int>(stats.frames)), b = a;
+                auto pa = pointers(a), pb = pointers(b);
+                batched.read(pa.data(), static_cast<int>(stats.frames));
+                single.read(pb.data(), static_cast<int>(stats.frames));
+                expect(a == b, item.input.getFileName() + " differs from rendering it alone");
+            }
+            root.deleteRecursively();
+        }
+    }
+};
+
+#endif // REDSP_RENDERTESTS_HEADERGUARD
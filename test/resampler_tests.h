@@ -0,0 +1,127 @@
+#ifndef REDSP_RESAMPLERTESTS_HEADERGUARD
+#define REDSP_RESAMPLERTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/resampling/resampler.h"
+
+#pragma once
+
+using namespace juce;
+
+struct ResamplerTest : public RedspTest
+{
+    ResamplerTest() : RedspTest("Resampler", "Resampling") { }
+
+private:
+    //! streams `input` through in random block sizes, pulling after every push
+    std::vector<double> run(redsp::resampler<double>& r, std::vector<double> const& input)
+    {
+        std::vector<double> output;
+        std::vector<double> chunk(1024);
+        for (size_t done = 0; done < input.size();)
+        {
+            auto len = std::min(input.size() - done, static_cast<size_t>(random.nextInt(300) + 1));
+            expectEquals(r.push(input.data() + done, static_cast<int>(len)), static_cast<int>(len));
+            done += len;
+
+            auto expected = r.available();
+            auto got = r.pull(chunk.data(), static_cast<int>(chunk.size()));
+            expectEquals(got, expected);
+            output.insert(output.end(), chunk.begin(), chunk.begin() + got);
+        }
+        return output;
+    }
+
+    static std::vector<double> sine(double f, size_t n)
+    {
+        std::vector<double> x(n);
+        for (size_t i = 0; i < n; ++i) { x[i] = std::sin(2.0 * redsp::math::pi<double>() * f * i); }
+        return x;
+    }
+
+    void expectSineConverted(double in_rate, double out_rate, double freq)
+    {
+        redsp::resampler<double> r;
+        r.prepare(in_rate, out_rate, 512);
+        auto input = sine(freq / in_rate, 20000);
+        auto output = run(r, input);
+
+        // everything up to latency() samples from the end of the input has come out
+        auto const expected = (static_cast<double>(input.size() - static_cast<size_t>(r.latency())) * out_rate) / in_rate;
+        expectWithinAbsoluteError(static_cast<double>(output.size()), expected, 2.0);
+
+        // output n sits at input time n * in_rate / out_rate; skip the start, where the input jumps in from silence
+        double worst = 0;
+        for (size_t n = 200; n < output.size(); ++n)
+        {
+            auto t = static_cast<double>(n) * in_rate / out_rate;
+            worst = std::max(worst, std::abs(output[n] - std::sin(2.0 * redsp::math::pi<double>() * freq / in_rate * t)));
+        }
+        expectLessThan(worst, 1.0e-3);
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("upsample_44k1_to_48k");
+            expectSineConverted(44100.0, 48000.0, 1000.0);
+            expectSineConverted(44100.0, 48000.0, 15000.0);
+        }
+        {
+            beginTest("downsample_96k_to_48k");
+            expectSineConverted(96000.0, 48000.0, 5000.0);
+        }
+        {
+            beginTest("downsample_rejects_aliases");
+            // 30kHz can't be represented at 48kHz; it would alias to 18kHz
+            redsp::resampler<double> r;
+            r.prepare(96000.0, 48000.0, 512);
+            auto output = run(r, sine(30000.0 / 96000.0, 20000));
+            double worst = 0;
+            for (size_t n = 200; n < output.size(); ++n) { worst = std::max(worst, std::abs(output[n])); }
+            expectLessThan(worst, 1.0e-3);
+        }
+        {
+            beginTest("tables_shared");
+            redsp::resampler<double> a, b, c;
+            a.prepare(44100.0, 48000.0, 64);
+            b.prepare(44100.0, 48000.0, 256);
+            c.prepare(96000.0, 48000.0, 64);
+            expect(a.filter_table() == b.filter_table());
+            expect(a.filter_table() != c.filter_table());
+            // a lower cutoff needs a longer filter for the same number of zero crossings
+            expectGreaterThan(c.filter_table()->taps, a.filter_table()->taps);
+        }
+        {
+            beginTest("input_needed");
+            redsp::resampler<double> r;
+            r.prepare(44100.0, 48000.0, 4096);
+            auto input = sine(0.01, 4096);
+            std::vector<double> out(64);
+            int used = 0;
+            for (int i = 0; i < 20; ++i)
+            {
+                auto need = r.input_needed(64);
+                r.push(input.data() + used, need);
+                used += need;
+                expectGreaterOrEqual(r.available(), 64);
+                expectEquals(r.pull(out.data(), 64), 64);
+                expectEquals(r.input_needed(0), 0);
+            }
+        }
+        {
+            beginTest("overfull_push_rejected");
+            redsp::resampler<double> r;
+            r.prepare(48000.0, 48000.0, 100);
+            std::vector<double> x(1000, 0.0);
+            auto taken = r.push(x.data(), 1000);
+            expectLessThan(taken, 1000);
+            std::vector<double> out(1000);
+            auto got = r.process(x.data() + taken, 1000 - taken, out.data(), static_cast<int>(out.size()));
+            expectGreaterThan(got, 0);
+        }
+    }
+};
+
+#endif // REDSP_RESAMPLERTESTS_HEADERGUARD
@@ -0,0 +1,122 @@
+#ifndef REDSP_REVERBTESTS_HEADERGUARD
+#define REDSP_REVERBTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/reverb/fdn_reverb.h"
+
+#pragma once
+
+using namespace juce;
+
+struct ReverbTest : public RedspTest
+{
+    ReverbTest() : RedspTest("FDN reverb", "Reverb") { }
+
+private:
+    static double rms(std::vector<double> const& x, size_t start, size_t length)
+    {
+        double sum = 0;
+        for (size_t i = start; i < start + length; ++i) { sum += x[i] * x[i]; }
+        return std::sqrt(sum / static_cast<double>(length));
+    }
+
+    //! impulse response of the left output, in random block sizes
+    template <typename Reverb>
+    std::vector<double> impulseResponse(Reverb& reverb, size_t length)
+    {
+        std::vector<double> l(length, 0.0), r(length, 0.0);
+        l[0] = r[0] = 1.0;
+        for (size_t done = 0; done < length;)
+        {
+            auto len = std::min(length - done, static_cast<size_t>(random.nextInt(512) + 1));
+            reverb.process(l.data() + done, r.data() + done, l.data() + done, r.data() + done, static_cast<int>(len));
+            done += len;
+        }
+        return l;
+    }
+
+    template <typename Reverb>
+    void expectDecayRate()
+    {
+        // with the damping out of the way the level should fall 60dB every decay time, i.e. 30dB per second here
+        Reverb reverb;
+        reverb.prepare(48000.0, 512);
+        reverb.set_decay(2.0);
+        reverb.set_damping(24000.0);
+        auto ir = impulseResponse(reverb, 48000 * 3);
+
+        auto early = rms(ir, 24000, 24000);
+        auto late = rms(ir, 72000, 24000);
+        expectWithinAbsoluteError(20.0 * std::log10(late / early), -30.0, 3.0);
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("hadamard_decay_rate");
+            expectDecayRate<redsp::fdn_reverb<double, 8>>();
+            expectDecayRate<redsp::fdn_reverb<double, 16>>();
+        }
+        {
+            beginTest("householder_decay_rate");
+            expectDecayRate<redsp::fdn_reverb<double, 8, redsp::fdn_matrix::householder>>();
+        }
+        {
+            beginTest("damping_shortens_highs");
+            redsp::fdn_reverb<double, 8> bright, dark;
+            bright.prepare(48000.0, 256);
+            dark.prepare(48000.0, 256);
+            bright.set_damping(20000.0);
+            dark.set_damping(2000.0);
+            auto b = impulseResponse(bright, 48000);
+            auto d = impulseResponse(dark, 48000);
+            expectLessThan(rms(d, 24000, 24000), rms(b, 24000, 24000));
+        }
+        {
+            beginTest("block_size_independent");
+            redsp::fdn_reverb<double, 8> a, b;
+            a.prepare(44100.0, 1024);
+            b.prepare(44100.0, 1024);
+            auto ia = impulseResponse(a, 20000);
+            auto ib = impulseResponse(b, 20000);
+            for (size_t i = 0; i < ia.size(); ++i) { expectWithinAbsoluteError(ia[i], ib[i], 1.0e-12); }
+        }
+        {
+            beginTest("delays_mutually_prime");
+            redsp::fdn_reverb<double, 16> reverb;
+            reverb.prepare(48000.0, 64, 0.5);
+            for (size_t i = 0; i < 16; ++i)
+            {
+                for (size_t j = i + 1; j < 16; ++j)
+                {
+                    auto a = reverb.delay(i), b = reverb.delay(j);
+                    while (b != 0) { auto t = a % b; a = b; b = t; }
+                    expectEquals(a, 1);
+                }
+            }
+        }
+        {
+            beginTest("stable_with_long_decay");
+            redsp::fdn_reverb<float, 8> reverb;
+            reverb.prepare(48000.0, 128);
+            reverb.set_decay(1000.0);
+            std::vector<float> l(128), r(128);
+            float peak = 0;
+            for (int block = 0; block < 48000 * 5 / 128; ++block)
+            {
+                for (size_t i = 0; i < l.size(); ++i)
+                {
+                    l[i] = block < 10 ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+                    r[i] = block < 10 ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+                }
+                reverb.process(l.data(), r.data(), l.data(), r.data(), 128);
+                for (auto v : l) { peak = std::max(peak, std::abs(v)); }
+            }
+            expectLessThan(peak, 10.0f);
+            expect(std::isfinite(peak));
+        }
+    }
+};
+
+#endif // REDSP_REVERBTESTS_HEADERGUARD
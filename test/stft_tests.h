@@ -0,0 +1,111 @@
+#ifndef REDSP_STFTTESTS_HEADERGUARD
+#define REDSP_STFTTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include "test_helpers.h"
+#include "../source/fft/stft.h"
+
+#pragma once
+
+using namespace juce;
+
+struct STFTTest : public RedspTest
+{
+    STFTTest() : RedspTest("STFT", "FFT") { }
+
+private:
+    //! leaves the spectrum alone, counting frames
+    struct counter
+    {
+        int* frames;
+        void operator()(double*, double*, int, int) { ++*frames; }
+    };
+
+    template <typename Stft>
+    void runInRandomBlocks(Stft& s, std::vector<double>& x, int channel = 0)
+    {
+        for (size_t done = 0; done < x.size();)
+        {
+            auto len = std::min(x.size() - done, static_cast<size_t>(random.nextInt(200) + 1));
+            s.process(x.data() + done, static_cast<int>(len), channel);
+            done += len;
+        }
+    }
+
+    void expectIdentity(int order, int window_size, int hop, redsp::stft_window window)
+    {
+        int frames = 0;
+        auto s = redsp::make_stft<double, 2>(counter { &frames });
+        s.prepare(order, window_size, hop, window);
+        expectEquals(s.latency(), window_size - 1);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            auto x = randomSignal(8192);
+            auto y = x;
+            runInRandomBlocks(s, y, ch);
+
+            auto const L = static_cast<size_t>(s.latency());
+            for (size_t i = L; i < y.size(); ++i) { expectWithinAbsoluteError(y[i], x[i - L], 1.0e-12); }
+        }
+        expectEquals(frames, 2 * (8192 / hop));
+    }
+
+    void runTest() override
+    {
+        {
+            beginTest("identity_sqrt_hann_half_overlap");
+            expectIdentity(10, 1024, 512, redsp::stft_window::sqrt_hann);
+        }
+        {
+            beginTest("identity_hann_quarter_hop");
+            expectIdentity(9, 512, 128, redsp::stft_window::hann);
+        }
+        {
+            beginTest("identity_zero_padded");
+            expectIdentity(11, 1000, 250, redsp::stft_window::sqrt_hann);
+        }
+        {
+            beginTest("latency_reported");
+            int frames = 0;
+            auto s = redsp::make_stft<double>(counter { &frames });
+            s.prepare(8, 256, 64, redsp::stft_window::hann);
+            std::vector<double> x(2048, 0.0);
+            x[300] = 1.0;
+            runInRandomBlocks(s, x);
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                expectWithinAbsoluteError(x[i], i == 300 + static_cast<size_t>(s.latency()) ? 1.0 : 0.0, 1.0e-12);
+            }
+        }
+        {
+            beginTest("spectral_gate");
+            // clearing everything but the bins around 32 leaves only the tone sitting on bin 32 (the hann window spreads
+            // it over bins 31 to 33)
+            auto s = redsp::make_stft<double>([](double* re, double* im, int bins, int)
+            {
+                for (int k = 0; k < bins; ++k)
+                {
+                    if (k < 28 || k > 36) { re[k] = im[k] = 0; }
+                }
+            });
+            s.prepare(10, 1024, 256, redsp::stft_window::hann);
+            std::vector<double> x(8192);
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                x[i] = std::sin(2.0 * redsp::math::pi<double>() * 32.0 / 1024.0 * i)
+                       + 0.5 * std::sin(2.0 * redsp::math::pi<double>() * 200.0 / 1024.0 * i);
+            }
+            auto y = x;
+            runInRandomBlocks(s, y);
+
+            auto const L = static_cast<size_t>(s.latency());
+            for (size_t i = 2048; i < y.size(); ++i)
+            {
+                expectWithinAbsoluteError(y[i], std::sin(2.0 * redsp::math::pi<double>() * 32.0 / 1024.0 * (i - L)), 1.0e-3);
+            }
+        }
+    }
+};
+
+#endif // REDSP_STFTTESTS_HEADERGUARD
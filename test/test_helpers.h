@@ -0,0 +1,34 @@
+#ifndef REDSP_TESTHELPERS_HEADERGUARD
+#define REDSP_TESTHELPERS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+#pragma once
+
+using namespace juce;
+
+/**
+ * The base of the suites that draw random inputs. UnitTest::getRandom() hands out a copy of the runner's generator,
+ * seeded the same way on every call, so drawing from it repeatedly gives the same number each time. This takes one copy
+ * before each run and keeps it in `random`, so a suite gets a sequence that's still reproducible from the runner's seed.
+ */
+struct RedspTest : public UnitTest
+{
+    RedspTest(String const& suite, String const& group) : UnitTest(suite, group) { }
+
+    void initialise() override { random = getRandom(); }
+
+protected:
+    Random random;
+
+    //! `@param n` samples of uniform noise in [-`@param amplitude`, `@param amplitude`)
+    std::vector<double> randomSignal(size_t n, double amplitude = 1.0)
+    {
+        std::vector<double> x(n);
+        for (auto& v : x) { v = amplitude * (random.nextDouble() * 2.0 - 1.0); }
+        return x;
+    }
+};
+
+#endif // REDSP_TESTHELPERS_HEADERGUARD
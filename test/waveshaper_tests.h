@@ -0,0 +1,56 @@
+#ifndef REDSP_WAVESHAPERTESTS_HEADERGUARD
+#define REDSP_WAVESHAPERTESTS_HEADERGUARD
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include "test_helpers.h"
+#include "../source/nonlinear/waveshaper.h"
+
+#pragma once
+
+using namespace juce;
+
+struct WaveshaperTest : public RedspTest
+{
+    WaveshaperTest() : RedspTest("Waveshaper", "Nonlinear") { }
+
+private:
+    void runTest() override
+    {
+        {
+            beginTest("functor_matches_function");
+            auto shaper = redsp::make_waveshaper<float>([](float x) { return x / (1.0f + std::abs(x)); });
+            std::vector<float> in(257), out(257);
+            for (auto& s : in) { s = random.nextFloat() * 8.0f - 4.0f; }
+            shaper.process(in.data(), out.data(), static_cast<int>(in.size()));
+            for (size_t i = 0; i < in.size(); ++i) { expectEquals(out[i], in[i] / (1.0f + std::abs(in[i]))); }
+        }
+        {
+            beginTest("table_interpolates_curve");
+            std::function<double(double)> curve = [](double x) { return std::tanh(x); };
+            redsp::table_waveshaper<double> shaper;
+            shaper.prepare(curve, -4.0, 4.0, 1024);
+
+            // linear interpolation error is bounded by h^2/8 * max|f''| (~0.77 for tanh)
+            auto h = 8.0 / 1023.0;
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto x = random.nextDouble() * 8.0 - 4.0;
+                expectWithinAbsoluteError(shaper.process(x), std::tanh(x), h * h / 8.0 * 0.8);
+            }
+            // grid points are exact
+            expectWithinAbsoluteError(shaper.process(-4.0), std::tanh(-4.0), 1.0e-12);
+            expectWithinAbsoluteError(shaper.process(4.0), std::tanh(4.0), 1.0e-12);
+        }
+        {
+            beginTest("table_clamps_outside_range");
+            redsp::table_waveshaper<float> shaper;
+            shaper.prepare([](float x) { return 2.0f * x; }, -1.0f, 1.0f, 16);
+            expectWithinAbsoluteError(shaper.process(5.0f), 2.0f, 1.0e-6f);
+            expectWithinAbsoluteError(shaper.process(-5.0f), -2.0f, 1.0e-6f);
+            expectWithinAbsoluteError(shaper.process(0.3f), 0.6f, 1.0e-6f);
+        }
+    }
+};
+
+#endif // REDSP_WAVESHAPERTESTS_HEADERGUARD